@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "gl.h"
 #include "gl-matrix.h"
 #include "gl_compat.h"
@@ -50,121 +52,574 @@ int VprintGlError(char *file, int line) {
 
 #define printOpenGLError() VprintGlError(__FILE__, __LINE__)
 
-void vrms_gl_draw_mesh_color(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
-    GLuint shader_id = (GLuint)render.shader_id;
-    glUseProgram(shader_id);
-printOpenGLError();
+// glGetError stalls on the driver, so the draw paths only check for errors
+// in builds with VRMS_GL_DEBUG.
+#ifdef VRMS_GL_DEBUG
+#define checkOpenGLError() VprintGlError(__FILE__, __LINE__)
+#else
+#define checkOpenGLError()
+#endif
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.vertex_id);
-    GLuint b_vertex = glGetAttribLocation(shader_id, "b_vertex");
-    glVertexAttribPointer(b_vertex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_vertex);
-printOpenGLError();
+// GLES 2 has no instanced arrays or vertex array objects, so those builds
+// always loop and rebind attributes themselves.
+#if !defined(RASPBERRYPI) && !defined(EGLGBM)
+#define VRMS_GL_INSTANCING
+#define VRMS_GL_VAO
+#endif
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.normal_id);
-    GLuint b_normal = glGetAttribLocation(shader_id, "b_normal");
-    glVertexAttribPointer(b_normal, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_normal);
-printOpenGLError();
+#define VRMS_GL_MAX_SHADERS         16
+#define VRMS_GL_MAX_ATTRIBUTES      16
+#define VRMS_GL_VAO_CACHE_SIZE      256
+#define VRMS_GL_INSTANCE_BYTES      65536
+#define VRMS_GL_UNKNOWN             0xffffffff
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.color_id);
-    GLuint b_color = glGetAttribLocation(shader_id, "b_color");
-    glVertexAttribPointer(b_color, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_color);
-printOpenGLError();
+// Attribute and uniform locations of a linked shader.
+typedef struct vrms_gl_shader {
+    GLuint id;
+    GLint b_vertex;
+    GLint b_normal;
+    GLint b_color;
+    GLint b_uv;
+    GLint b_model;
+    GLint s_tex;
+    GLint m_mvp;
+    GLint m_m;
+    GLint m_p;
+    GLint m_v;
+    uint32_t eye;
+} vrms_gl_shader_t;
 
-    GLuint m_mvp = glGetUniformLocation(shader_id, "m_mvp");
-    glUniformMatrix4fv(m_mvp, 1, GL_FALSE, matrix.mvp);
-printOpenGLError();
+// A vertex array object for one shader and set of buffers.
+typedef struct vrms_gl_vao {
+    GLuint id;
+    GLuint shader_id;
+    GLuint buffers[4];
+} vrms_gl_vao_t;
 
-    GLuint m_mv = glGetUniformLocation(shader_id, "m_mv");
-    glUniformMatrix4fv(m_mv, 1, GL_FALSE, matrix.mv);
-printOpenGLError();
+// What the draw calls last bound on the render thread, so unchanged state
+// is not sent again. VRMS_GL_UNKNOWN means GL has to be asked to bind. The
+// attribute arrays track the default vertex array object only.
+typedef struct vrms_gl_state {
+    GLuint program;
+    GLuint vao;
+    GLuint array_buffer;
+    GLuint element_buffer;
+    GLuint texture_2d;
+    GLuint texture_cube;
+    GLuint active_texture;
+    GLuint attribute_buffers[VRMS_GL_MAX_ATTRIBUTES];
+    GLint attribute_sizes[VRMS_GL_MAX_ATTRIBUTES];
+} vrms_gl_state_t;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)render.index_id);
-    glDrawElements(GL_TRIANGLES, (GLuint)render.nr_indicies, GL_UNSIGNED_SHORT, NULL);
+// View and projection of the eye being drawn. Programs keep uniform values,
+// so each shader is only sent them the first time it is used for an eye.
+typedef struct vrms_gl_eye {
+    uint32_t eye;
+    float p[16];
+    float v[16];
+} vrms_gl_eye_t;
+
+static vrms_gl_shader_t shaders[VRMS_GL_MAX_SHADERS];
+static uint32_t nr_shaders = 0;
+#ifdef VRMS_GL_VAO
+static vrms_gl_vao_t vaos[VRMS_GL_VAO_CACHE_SIZE];
+#endif
+static vrms_gl_state_t state;
+static vrms_gl_eye_t eye;
+static uint32_t frame = 0;
+
+#ifdef VRMS_GL_INSTANCING
+// Where a draw's model matrices were put in the instance buffer this frame.
+typedef struct vrms_gl_instances {
+    float* models;
+    uint32_t count;
+    GLintptr offset;
+} vrms_gl_instances_t;
+
+// The instance buffer is filled as the first eye draws and read again by
+// the others, so each draw's matrices go up once per frame.
+typedef struct vrms_gl_instance_buffer {
+    GLuint id;
+    uint32_t frame;
+    GLsizeiptr size;
+    GLsizeiptr used;
+    vrms_gl_instances_t* uploads;
+    uint32_t nr_uploads;
+    uint32_t uploads_size;
+} vrms_gl_instance_buffer_t;
+
+static vrms_gl_instance_buffer_t instance_buffer;
+#endif
+
+void vrms_gl_reset_state() {
+    uint32_t i;
+
+    state.program = VRMS_GL_UNKNOWN;
+    state.vao = VRMS_GL_UNKNOWN;
+    state.array_buffer = VRMS_GL_UNKNOWN;
+    state.element_buffer = VRMS_GL_UNKNOWN;
+    state.texture_2d = VRMS_GL_UNKNOWN;
+    state.texture_cube = VRMS_GL_UNKNOWN;
+    state.active_texture = VRMS_GL_UNKNOWN;
+    for (i = 0; i < VRMS_GL_MAX_ATTRIBUTES; i++) {
+        state.attribute_buffers[i] = VRMS_GL_UNKNOWN;
+    }
+}
+
+static void vrms_gl_use_program(GLuint program) {
+    if (state.program != program) {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+static void vrms_gl_bind_array_buffer(GLuint buffer_id) {
+    if (state.array_buffer != buffer_id) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+        state.array_buffer = buffer_id;
+    }
+}
+
+static void vrms_gl_bind_element_buffer(GLuint buffer_id) {
+    if (state.element_buffer != buffer_id) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_id);
+        state.element_buffer = buffer_id;
+    }
+}
+
+// Textures are always drawn from unit 1, which s_tex is set to when the
+// shader is added.
+static void vrms_gl_bind_texture(GLenum target, GLuint texture_id) {
+    GLuint* bound = (GL_TEXTURE_CUBE_MAP == target) ? &state.texture_cube : &state.texture_2d;
+
+    if (state.active_texture != GL_TEXTURE1) {
+        glActiveTexture(GL_TEXTURE1);
+        state.active_texture = GL_TEXTURE1;
+    }
+    if (*bound != texture_id) {
+        glBindTexture(target, texture_id);
+        *bound = texture_id;
+    }
+}
+
+uint8_t vrms_gl_has_instancing() {
+#ifdef VRMS_GL_INSTANCING
+    static int8_t supported = -1;
+    const char* version;
+    const char* extensions;
+    int major = 0, minor = 0;
+
+    if (supported < 0) {
+        supported = 0;
+        version = (const char*)glGetString(GL_VERSION);
+        extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (version && (sscanf(version, "%d.%d", &major, &minor) == 2) && ((major > 3) || (major == 3 && minor >= 3))) {
+            supported = 1;
+        }
+        else if (extensions && strstr(extensions, "GL_ARB_instanced_arrays") && strstr(extensions, "GL_ARB_draw_instanced")) {
+            supported = 1;
+        }
+        debug_print("C|DEBUG|gl.c|vrms_gl_has_instancing(): %s\n", supported ? "yes" : "no");
+    }
+    return (uint8_t)supported;
+#else
+    return 0;
+#endif
+}
+
+#ifdef VRMS_GL_VAO
+static uint8_t vrms_gl_has_vao() {
+    static int8_t supported = -1;
+    const char* version;
+    const char* extensions;
+    int major = 0, minor = 0;
+
+    if (supported < 0) {
+        supported = 0;
+        version = (const char*)glGetString(GL_VERSION);
+        extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (version && (sscanf(version, "%d.%d", &major, &minor) == 2) && (major >= 3)) {
+            supported = 1;
+        }
+        else if (extensions && strstr(extensions, "GL_ARB_vertex_array_object")) {
+            supported = 1;
+        }
+        debug_print("C|DEBUG|gl.c|vrms_gl_has_vao(): %s\n", supported ? "yes" : "no");
+    }
+    return (uint8_t)supported;
+}
+#endif
+
+void vrms_gl_add_shader(uint32_t shader_id) {
+    vrms_gl_shader_t* shader;
+    uint32_t i;
+
+    for (i = 0; i < nr_shaders; i++) {
+        if (shaders[i].id == (GLuint)shader_id) {
+            return;
+        }
+    }
+    if (nr_shaders >= VRMS_GL_MAX_SHADERS) {
+        debug_print("C|DEBUG|gl.c|vrms_gl_add_shader(): too many shaders\n");
+        return;
+    }
+
+    shader = &shaders[nr_shaders++];
+    shader->id = (GLuint)shader_id;
+    shader->b_vertex = glGetAttribLocation(shader->id, "b_vertex");
+    shader->b_normal = glGetAttribLocation(shader->id, "b_normal");
+    shader->b_color = glGetAttribLocation(shader->id, "b_color");
+    shader->b_uv = glGetAttribLocation(shader->id, "b_uv");
+    shader->b_model = glGetAttribLocation(shader->id, "b_model");
+    shader->s_tex = glGetUniformLocation(shader->id, "s_tex");
+    shader->m_mvp = glGetUniformLocation(shader->id, "m_mvp");
+    shader->m_m = glGetUniformLocation(shader->id, "m_m");
+    shader->m_p = glGetUniformLocation(shader->id, "m_p");
+    shader->m_v = glGetUniformLocation(shader->id, "m_v");
+
+    if (shader->s_tex >= 0) {
+        glUseProgram(shader->id);
+        glUniform1i(shader->s_tex, 1);
+        state.program = VRMS_GL_UNKNOWN;
+    }
 printOpenGLError();
+}
+
+static vrms_gl_shader_t* vrms_gl_get_shader(GLuint shader_id) {
+    uint32_t i;
+
+    for (i = 0; i < nr_shaders; i++) {
+        if (shaders[i].id == shader_id) {
+            return &shaders[i];
+        }
+    }
+    // Shaders not added when they were linked are picked up on first use.
+    vrms_gl_add_shader(shader_id);
+    return (nr_shaders && (shaders[nr_shaders - 1].id == shader_id)) ? &shaders[nr_shaders - 1] : NULL;
+}
+
+void vrms_gl_begin_frame() {
+    frame++;
+    if (0 == frame) {
+        frame = 1;
+    }
+}
+
+void vrms_gl_set_eye(float* projection_matrix, float* view_matrix) {
+    eye.eye++;
+    if (0 == eye.eye) {
+        eye.eye = 1;
+    }
+    mat4_copy(eye.p, projection_matrix);
+    mat4_copy(eye.v, view_matrix);
+}
+
+static void vrms_gl_use_shader(vrms_gl_shader_t* shader) {
+    vrms_gl_use_program(shader->id);
+    if (shader->eye == eye.eye) {
+        return;
+    }
+    if (shader->m_p >= 0) {
+        glUniformMatrix4fv(shader->m_p, 1, GL_FALSE, eye.p);
+    }
+    if (shader->m_v >= 0) {
+        glUniformMatrix4fv(shader->m_v, 1, GL_FALSE, eye.v);
+    }
+    shader->eye = eye.eye;
+}
+
+static void vrms_gl_attribute_pointer(GLint location, GLuint buffer_id, GLint size) {
+    vrms_gl_bind_array_buffer(buffer_id);
+    glVertexAttribPointer((GLuint)location, size, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray((GLuint)location);
+}
+
+// Points an attribute of the default vertex array object at a buffer unless
+// it is already.
+static void vrms_gl_attribute(GLint location, GLuint buffer_id, GLint size) {
+    if ((location < 0) || (0 == buffer_id)) {
+        return;
+    }
+    if ((location < VRMS_GL_MAX_ATTRIBUTES) && (state.attribute_buffers[location] == buffer_id) && (state.attribute_sizes[location] == size)) {
+        return;
+    }
+    vrms_gl_attribute_pointer(location, buffer_id, size);
+    if (location < VRMS_GL_MAX_ATTRIBUTES) {
+        state.attribute_buffers[location] = buffer_id;
+        state.attribute_sizes[location] = size;
+    }
+}
+
+static void vrms_gl_bind_vao(GLuint vao_id) {
+#ifdef VRMS_GL_VAO
+    if (state.vao != vao_id) {
+        glBindVertexArray(vao_id);
+        state.vao = vao_id;
+        // The element buffer binding belongs to the vertex array object.
+        state.element_buffer = VRMS_GL_UNKNOWN;
+    }
+#endif
+}
+
+#ifdef VRMS_GL_VAO
+// Returns the vertex array object for the buffers, building it the first
+// time. buffers holds vertex, normal, color or uv and index ids.
+static GLuint vrms_gl_get_vao(vrms_gl_shader_t* shader, GLuint buffers[4], GLint extra_location, GLint extra_size) {
+    vrms_gl_vao_t* vao;
+    uint32_t hash;
+    uint8_t i;
+
+    hash = 2166136261u ^ shader->id;
+    for (i = 0; i < 4; i++) {
+        hash = (hash ^ buffers[i]) * 16777619u;
+    }
+    vao = &vaos[(hash ^ (hash >> 16)) % VRMS_GL_VAO_CACHE_SIZE];
+
+    if (vao->id && (vao->shader_id == shader->id) && (0 == memcmp(vao->buffers, buffers, sizeof(vao->buffers)))) {
+        return vao->id;
+    }
+    if (vao->id) {
+        if (state.vao == vao->id) {
+            vrms_gl_bind_vao(0);
+        }
+        glDeleteVertexArrays(1, &vao->id);
+    }
+
+    glGenVertexArrays(1, &vao->id);
+    vao->shader_id = shader->id;
+    memcpy(vao->buffers, buffers, sizeof(vao->buffers));
+
+    vrms_gl_bind_vao(vao->id);
+    if (buffers[0] && (shader->b_vertex >= 0)) {
+        vrms_gl_attribute_pointer(shader->b_vertex, buffers[0], 3);
+    }
+    if (buffers[1] && (shader->b_normal >= 0)) {
+        vrms_gl_attribute_pointer(shader->b_normal, buffers[1], 3);
+    }
+    if (buffers[2] && (extra_location >= 0)) {
+        vrms_gl_attribute_pointer(extra_location, buffers[2], extra_size);
+    }
+    vrms_gl_bind_element_buffer(buffers[3]);
+checkOpenGLError();
+
+    return vao->id;
+}
+#endif
+
+// Binds the vertex attributes and index buffer of a mesh for a shader. The
+// third buffer is the color or, when textured, the uv buffer.
+static void vrms_gl_bind_mesh(vrms_gl_shader_t* shader, vrms_gl_render_t* render, uint8_t textured) {
+    GLuint buffers[4];
+    GLint extra_location = textured ? shader->b_uv : shader->b_color;
+    GLint extra_size = textured ? 2 : 4;
+
+    buffers[0] = (GLuint)render->vertex_id;
+    buffers[1] = (GLuint)render->normal_id;
+    buffers[2] = (GLuint)(textured ? render->uv_id : render->color_id);
+    buffers[3] = (GLuint)render->index_id;
+
+#ifdef VRMS_GL_VAO
+    if (vrms_gl_has_vao()) {
+        vrms_gl_bind_vao(vrms_gl_get_vao(shader, buffers, extra_location, extra_size));
+        state.element_buffer = buffers[3];
+        return;
+    }
+#endif
+
+    vrms_gl_attribute(shader->b_vertex, buffers[0], 3);
+    vrms_gl_attribute(shader->b_normal, buffers[1], 3);
+    vrms_gl_attribute(extra_location, buffers[2], extra_size);
+    vrms_gl_bind_element_buffer(buffers[3]);
+}
 
+void vrms_gl_end_draws() {
+    vrms_gl_bind_vao(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-printOpenGLError();
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    vrms_gl_reset_state();
+checkOpenGLError();
+}
+
+static void vrms_gl_draw_mesh(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint8_t textured) {
+    vrms_gl_shader_t* shader = vrms_gl_get_shader((GLuint)render.shader_id);
+    if (!shader) {
+        return;
+    }
+
+    vrms_gl_use_shader(shader);
+    vrms_gl_bind_mesh(shader, &render, textured);
+    if (textured) {
+        vrms_gl_bind_texture(GL_TEXTURE_2D, (GLuint)render.texture_id);
+    }
+
+    glUniformMatrix4fv(shader->m_m, 1, GL_FALSE, matrix.m);
+
+    glDrawElements(GL_TRIANGLES, (GLuint)render.nr_indicies, GL_UNSIGNED_SHORT, NULL);
+checkOpenGLError();
+}
+
+void vrms_gl_draw_mesh_color(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+    vrms_gl_draw_mesh(render, matrix, 0);
 }
 
 void vrms_gl_draw_mesh_texture(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
-    GLuint shader_id = (GLuint)render.shader_id;
-    glUseProgram(shader_id);
-printOpenGLError();
+    vrms_gl_draw_mesh(render, matrix, 1);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.vertex_id);
-    GLuint b_vertex = glGetAttribLocation(shader_id, "b_vertex");
-    glVertexAttribPointer(b_vertex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_vertex);
-printOpenGLError();
+#ifdef VRMS_GL_INSTANCING
+// Returns the offset of models in the instance buffer, uploading them if no
+// earlier eye has this frame, or -1 if they could not be uploaded. A frame
+// that outgrows the buffer orphans it for a larger one and uploads again.
+static GLintptr vrms_gl_upload_instances(float* models, uint32_t count) {
+    GLsizeiptr bytes = count * 16 * sizeof(float);
+    vrms_gl_instances_t* uploads;
+    vrms_gl_instances_t* upload;
+    uint32_t size;
+    uint32_t i;
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.normal_id);
-    GLuint b_normal = glGetAttribLocation(shader_id, "b_normal");
-    glVertexAttribPointer(b_normal, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_normal);
-printOpenGLError();
+    if (!instance_buffer.id) {
+        glGenBuffers(1, &instance_buffer.id);
+    }
+    vrms_gl_bind_array_buffer(instance_buffer.id);
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.uv_id);
-    GLuint b_uv = glGetAttribLocation(shader_id, "b_uv");
-    glVertexAttribPointer(b_uv, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_uv);
-printOpenGLError();
+    if (instance_buffer.frame != frame) {
+        instance_buffer.frame = frame;
+        instance_buffer.used = 0;
+        instance_buffer.nr_uploads = 0;
+        if (instance_buffer.size) {
+            glBufferData(GL_ARRAY_BUFFER, instance_buffer.size, NULL, GL_STREAM_DRAW);
+        }
+    }
 
-    GLuint s_tex = glGetUniformLocation(shader_id, "s_tex");
-    glActiveTexture(GL_TEXTURE1);
-    glUniform1i(s_tex, 1);
-    glBindTexture(GL_TEXTURE_2D, (GLuint)render.texture_id);
-printOpenGLError();
+    for (i = 0; i < instance_buffer.nr_uploads; i++) {
+        upload = &instance_buffer.uploads[i];
+        if ((upload->models == models) && (upload->count == count)) {
+            return upload->offset;
+        }
+    }
 
-    GLuint m_mvp = glGetUniformLocation(shader_id, "m_mvp");
-    glUniformMatrix4fv(m_mvp, 1, GL_FALSE, matrix.mvp);
-printOpenGLError();
+    if (instance_buffer.nr_uploads == instance_buffer.uploads_size) {
+        size = instance_buffer.uploads_size ? instance_buffer.uploads_size * 2 : 64;
+        uploads = realloc(instance_buffer.uploads, size * sizeof(vrms_gl_instances_t));
+        if (!uploads) {
+            debug_print("C|DEBUG|gl.c|vrms_gl_upload_instances(): unable to grow uploads to %d\n", size);
+            return -1;
+        }
+        instance_buffer.uploads = uploads;
+        instance_buffer.uploads_size = size;
+    }
 
-    GLuint m_mv = glGetUniformLocation(shader_id, "m_mv");
-    glUniformMatrix4fv(m_mv, 1, GL_FALSE, matrix.mv);
-printOpenGLError();
+    if ((instance_buffer.used + bytes) > instance_buffer.size) {
+        size = instance_buffer.size ? instance_buffer.size * 2 : VRMS_GL_INSTANCE_BYTES;
+        while (size < (instance_buffer.used + bytes)) {
+            size *= 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        instance_buffer.size = size;
+        instance_buffer.used = 0;
+        instance_buffer.nr_uploads = 0;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)render.index_id);
-    glDrawElements(GL_TRIANGLES, (GLuint)render.nr_indicies, GL_UNSIGNED_SHORT, NULL);
-printOpenGLError();
+    upload = &instance_buffer.uploads[instance_buffer.nr_uploads++];
+    upload->models = models;
+    upload->count = count;
+    upload->offset = instance_buffer.used;
+    glBufferSubData(GL_ARRAY_BUFFER, upload->offset, bytes, models);
+    instance_buffer.used += bytes;
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return upload->offset;
 }
+#endif
 
-void vrms_gl_draw_skybox(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+static void vrms_gl_draw_mesh_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint8_t textured, uint32_t instanced_shader_id, float* models, uint32_t count) {
     GLuint shader_id = (GLuint)render.shader_id;
-    glUseProgram(shader_id);
-printOpenGLError();
-    glDisable(GL_DEPTH_TEST);
+    vrms_gl_shader_t* shader;
+    uint32_t i;
+#ifdef VRMS_GL_INSTANCING
+    GLintptr offset = -1;
+#endif
 
-    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)render.vertex_id);
-    GLuint b_vertex = glGetAttribLocation(shader_id, "b_vertex");
-    glVertexAttribPointer(b_vertex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_vertex);
-printOpenGLError();
+    if (instanced_shader_id && vrms_gl_has_instancing()) {
+        shader_id = (GLuint)instanced_shader_id;
+    }
+    shader = vrms_gl_get_shader(shader_id);
+    if (!shader) {
+        return;
+    }
 
-    GLuint s_tex = glGetUniformLocation(shader_id, "s_tex");
-    glActiveTexture(GL_TEXTURE1);
-    glUniform1i(s_tex, 1);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, (GLuint)render.texture_id);
-printOpenGLError();
+    vrms_gl_use_shader(shader);
+    vrms_gl_bind_mesh(shader, &render, textured);
+    if (textured) {
+        vrms_gl_bind_texture(GL_TEXTURE_2D, (GLuint)render.texture_id);
+    }
+checkOpenGLError();
 
-    GLuint m_mvp = glGetUniformLocation(shader_id, "m_mvp");
-    glUniformMatrix4fv(m_mvp, 1, GL_FALSE, matrix.mvp);
-printOpenGLError();
+#ifdef VRMS_GL_INSTANCING
+    if ((shader_id == (GLuint)instanced_shader_id) && (shader->b_model >= 0)) {
+        offset = vrms_gl_upload_instances(models, count);
+    }
+    if (offset >= 0) {
+        // The model matrices are per instance attributes, uploaded once a
+        // frame, and the shader combines them with the view and projection
+        // itself.
+        GLuint b_model = (GLuint)shader->b_model;
+        for (i = 0; i < 4; i++) {
+            glVertexAttribPointer(b_model + i, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (void*)(offset + (i * 4 * sizeof(float))));
+            glEnableVertexAttribArray(b_model + i);
+            glVertexAttribDivisor(b_model + i, 1);
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, (GLuint)render.nr_indicies, GL_UNSIGNED_SHORT, NULL, count);
+checkOpenGLError();
+
+        for (i = 0; i < 4; i++) {
+            glVertexAttribDivisor(b_model + i, 0);
+            glDisableVertexAttribArray(b_model + i);
+            if ((b_model + i) < VRMS_GL_MAX_ATTRIBUTES) {
+                state.attribute_buffers[b_model + i] = VRMS_GL_UNKNOWN;
+            }
+        }
+    }
+    else
+#endif
+    {
+        // No instancing, so draw once per matrix but keep everything else
+        // bound across the draws.
+        for (i = 0; i < count; i++) {
+            glUniformMatrix4fv(shader->m_m, 1, GL_FALSE, &models[i * 16]);
+            glDrawElements(GL_TRIANGLES, (GLuint)render.nr_indicies, GL_UNSIGNED_SHORT, NULL);
+        }
+checkOpenGLError();
+    }
+}
+
+void vrms_gl_draw_mesh_color_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count) {
+    vrms_gl_draw_mesh_instanced(render, matrix, 0, instanced_shader_id, models, count);
+}
+
+void vrms_gl_draw_mesh_texture_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count) {
+    vrms_gl_draw_mesh_instanced(render, matrix, 1, instanced_shader_id, models, count);
+}
+
+void vrms_gl_draw_skybox(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+    vrms_gl_shader_t* shader = vrms_gl_get_shader((GLuint)render.shader_id);
+    if (!shader) {
+        return;
+    }
+
+    vrms_gl_use_shader(shader);
+    glDisable(GL_DEPTH_TEST);
+
+    vrms_gl_bind_mesh(shader, &render, 0);
+    vrms_gl_bind_texture(GL_TEXTURE_CUBE_MAP, (GLuint)render.texture_id);
+    glUniformMatrix4fv(shader->m_mvp, 1, GL_FALSE, matrix.mvp);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)render.index_id);
     glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, NULL);
-printOpenGLError();
+checkOpenGLError();
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glEnable(GL_DEPTH_TEST);
 }
 
@@ -187,48 +642,61 @@ void vrms_gl_load_buffer(uint8_t* buffer, uint32_t* destination, uint32_t size,
     }
 }
 
-void vrms_gl_load_texture_buffer(uint8_t* buffer, uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type) {
-    GLint ifmt;
-    GLenum dfmt;
-    GLenum bfmt;
-    uint32_t part_offset;
-    uint32_t off;
-    uint8_t* tmp;
-
+static uint8_t vrms_gl_texture_format(vrms_texture_format_t format, GLint* ifmt, GLenum* dfmt, GLenum* bfmt) {
     switch (format) {
         case VRMS_FORMAT_BGR888:
-            ifmt = GL_RGB8;
-            dfmt = GL_RGB;
-            bfmt = GL_UNSIGNED_BYTE;
+            *ifmt = GL_RGB8;
+            *dfmt = GL_RGB;
+            *bfmt = GL_UNSIGNED_BYTE;
             break;
         case VRMS_FORMAT_XBGR8888:
-            ifmt = GL_RGBA8;
-            dfmt = GL_RGBA;
-            bfmt = GL_UNSIGNED_BYTE;
+            *ifmt = GL_RGBA8;
+            *dfmt = GL_RGBA;
+            *bfmt = GL_UNSIGNED_BYTE;
             break;
         case VRMS_FORMAT_ABGR8888:
-            ifmt = GL_RGBA8;
-            dfmt = GL_RGBA;
-            bfmt = GL_UNSIGNED_BYTE;
+            *ifmt = GL_RGBA8;
+            *dfmt = GL_RGBA;
+            *bfmt = GL_UNSIGNED_BYTE;
             break;
         //case VRMS_FORMAT_RGB888:
-        //    ifmt = GL_RGB8;
-        //    dfmt = GL_BGR;
-        //    bfmt = GL_UNSIGNED_BYTE;
+        //    *ifmt = GL_RGB8;
+        //    *dfmt = GL_BGR;
+        //    *bfmt = GL_UNSIGNED_BYTE;
         //    break;
         case VRMS_FORMAT_XRGB8888:
-            ifmt = GL_RGBA8;
-            dfmt = GL_BGRA;
-            bfmt = GL_UNSIGNED_BYTE;
+            *ifmt = GL_RGBA8;
+            *dfmt = GL_BGRA;
+            *bfmt = GL_UNSIGNED_BYTE;
             break;
         case VRMS_FORMAT_ARGB8888:
-            ifmt = GL_RGBA8;
-            dfmt = GL_BGRA;
-            bfmt = GL_UNSIGNED_BYTE;
+            *ifmt = GL_RGBA8;
+            *dfmt = GL_BGRA;
+            *bfmt = GL_UNSIGNED_BYTE;
             break;
         default:
             debug_print("texture format unrecognized: %d\n", format);
-            break;
+            return 0;
+    }
+    return 1;
+}
+
+uint32_t vrms_gl_texture_row_size(uint32_t width, vrms_texture_format_t format) {
+    uint32_t bytes_per_pixel = (VRMS_FORMAT_BGR888 == format) ? 3 : 4;
+    // Rows start on the default GL_UNPACK_ALIGNMENT of 4 bytes.
+    return ((width * bytes_per_pixel) + 3) & ~3;
+}
+
+void vrms_gl_load_texture_buffer(uint8_t* buffer, uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type) {
+    GLint ifmt;
+    GLenum dfmt;
+    GLenum bfmt;
+    uint32_t part_offset;
+    uint32_t off;
+    uint8_t* tmp;
+
+    if (!vrms_gl_texture_format(format, &ifmt, &dfmt, &bfmt)) {
+        return;
     }
 
     switch (type) {
@@ -285,6 +753,140 @@ void vrms_gl_load_texture_buffer(uint8_t* buffer, uint32_t* destination, uint32_
     }
 }
 
+void vrms_gl_create_texture(uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format) {
+    GLint ifmt;
+    GLenum dfmt;
+    GLenum bfmt;
+
+    *destination = 0;
+    if (!vrms_gl_texture_format(format, &ifmt, &dfmt, &bfmt)) {
+        return;
+    }
+
+    glGenTextures(1, destination);
+    glBindTexture(GL_TEXTURE_2D, *destination);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, ifmt, width, height, 0, dfmt, bfmt, NULL);
+    if (0 == *destination) {
+        debug_print("unable to create gl texture\n");
+        printOpenGLError();
+    }
+}
+
+void vrms_gl_load_texture_rows(uint32_t gl_id, uint8_t* buffer, uint32_t width, uint32_t first_row, uint32_t nr_rows, vrms_texture_format_t format) {
+    GLint ifmt;
+    GLenum dfmt;
+    GLenum bfmt;
+
+    if (!vrms_gl_texture_format(format, &ifmt, &dfmt, &bfmt)) {
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, gl_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, width, nr_rows, dfmt, bfmt, &buffer[first_row * vrms_gl_texture_row_size(width, format)]);
+}
+
+void vrms_gl_delete_texture(uint32_t* gl_id) {
+    glDeleteTextures(1, gl_id);
+    state.texture_2d = VRMS_GL_UNKNOWN;
+    state.texture_cube = VRMS_GL_UNKNOWN;
+}
+
+void vrms_gl_update_buffer(uint8_t* buffer, uint32_t gl_id, uint32_t offset, uint32_t size, vrms_data_type_t type) {
+    GLenum target = (VRMS_UINT16 == type) ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+
+    glBindBuffer(target, gl_id);
+    glBufferSubData(target, offset, size, &buffer[offset]);
+}
+
+void vrms_gl_update_texture(uint8_t* buffer, uint32_t gl_id, uint32_t image_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vrms_texture_format_t format) {
+    GLint ifmt;
+    GLenum dfmt;
+    GLenum bfmt;
+    uint32_t row_size;
+
+    if (!vrms_gl_texture_format(format, &ifmt, &dfmt, &bfmt)) {
+        return;
+    }
+
+    row_size = vrms_gl_texture_row_size(image_width, format);
+
+    glBindTexture(GL_TEXTURE_2D, gl_id);
+#ifdef GL_UNPACK_ROW_LENGTH
+    uint32_t bytes_per_pixel = (VRMS_FORMAT_BGR888 == format) ? 3 : 4;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image_width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, dfmt, bfmt, &buffer[(y * row_size) + (x * bytes_per_pixel)]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+    // Without GL_UNPACK_ROW_LENGTH rows can only go up whole.
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, image_width, height, dfmt, bfmt, &buffer[y * row_size]);
+#endif
+}
+
+void* vrms_gl_fence() {
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    return (void*)fence;
+#else
+    glFinish();
+    return NULL;
+#endif
+}
+
+uint8_t vrms_gl_fence_done(void* fence) {
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    GLenum status;
+    if (!fence) {
+        return 1;
+    }
+    status = glClientWaitSync((GLsync)fence, 0, 0);
+    if (GL_WAIT_FAILED == status) {
+        debug_print("fence wait failed\n");
+printOpenGLError();
+        return 1;
+    }
+    return (GL_TIMEOUT_EXPIRED == status) ? 0 : 1;
+#else
+    return 1;
+#endif
+}
+
+void vrms_gl_fence_destroy(void* fence) {
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    if (fence) {
+        glDeleteSync((GLsync)fence);
+    }
+#endif
+}
+
 void vrms_gl_delete_buffer(uint32_t* gl_id) {
+#ifdef VRMS_GL_VAO
+    uint32_t i, j;
+
+    // GL hands out deleted names again, so drop the vertex array objects
+    // built on this buffer.
+    for (i = 0; i < VRMS_GL_VAO_CACHE_SIZE; i++) {
+        if (!vaos[i].id) {
+            continue;
+        }
+        for (j = 0; j < 4; j++) {
+            if (vaos[i].buffers[j] == (GLuint)*gl_id) {
+                if (state.vao == vaos[i].id) {
+                    vrms_gl_bind_vao(0);
+                }
+                glDeleteVertexArrays(1, &vaos[i].id);
+                memset(&vaos[i], 0, sizeof(vrms_gl_vao_t));
+                break;
+            }
+        }
+    }
+#endif
     glDeleteBuffers(1, gl_id);
+    vrms_gl_reset_state();
 }
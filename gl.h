@@ -25,16 +25,66 @@ typedef struct vrms_gl_matrix {
     uint8_t realized;
 } vrms_gl_matrix_t;
 
+// Looks up the attribute and uniform locations of a linked shader once, so
+// draws with it do not have to.
+void vrms_gl_add_shader(uint32_t shader_id);
+
+// The draw calls skip binds GL already has. Reset before drawing if other
+// code may have touched GL state, and end a run of draws so that code finds
+// nothing bound.
+void vrms_gl_reset_state();
+void vrms_gl_end_draws();
+
+// Starts a frame. Instanced draws upload their model matrices for the first
+// eye and reuse them for the others until the next frame starts.
+void vrms_gl_begin_frame();
+
+// Sets the view and projection for the draws that follow. Shaders get them
+// once per eye as m_p and m_v, so draws only send the model matrix as m_m.
+void vrms_gl_set_eye(float* projection_matrix, float* view_matrix);
+
 void vrms_gl_draw_mesh_color(vrms_gl_render_t render, vrms_gl_matrix_t matrix);
 
 void vrms_gl_draw_mesh_texture(vrms_gl_render_t render, vrms_gl_matrix_t matrix);
 
+// Draws count copies of a mesh, one for each model matrix in models. With
+// instanced arrays available the matrices are uploaded once and drawn with
+// instanced_shader_id in a single call, otherwise render.shader_id is used
+// in a loop with the mesh bound once.
+void vrms_gl_draw_mesh_color_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count);
+
+void vrms_gl_draw_mesh_texture_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count);
+
+uint8_t vrms_gl_has_instancing();
+
 void vrms_gl_draw_skybox(vrms_gl_render_t render, vrms_gl_matrix_t matrix);
 
 void vrms_gl_load_buffer(uint8_t* buffer, uint32_t* destination, uint32_t size, vrms_data_type_t type);
 
 void vrms_gl_load_texture_buffer(uint8_t* buffer, uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type);
 
+// Bytes in one row of a texture as GL unpacks it.
+uint32_t vrms_gl_texture_row_size(uint32_t width, vrms_texture_format_t format);
+
+// Allocates an empty 2D texture for vrms_gl_load_texture_rows() to fill in
+// a few rows at a time. buffer is the whole image.
+void vrms_gl_create_texture(uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format);
+void vrms_gl_load_texture_rows(uint32_t gl_id, uint8_t* buffer, uint32_t width, uint32_t first_row, uint32_t nr_rows, vrms_texture_format_t format);
+
+// Reload part of a buffer or texture already on the GPU. buffer is the
+// whole of the client's data and the texture is always 2D.
+void vrms_gl_update_buffer(uint8_t* buffer, uint32_t gl_id, uint32_t offset, uint32_t size, vrms_data_type_t type);
+void vrms_gl_update_texture(uint8_t* buffer, uint32_t gl_id, uint32_t image_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vrms_texture_format_t format);
+
+// Marks the end of the GL commands issued so far on this context. Where
+// sync objects are missing the commands are finished before returning and
+// the fence is NULL.
+void* vrms_gl_fence();
+uint8_t vrms_gl_fence_done(void* fence);
+void vrms_gl_fence_destroy(void* fence);
+
 void vrms_gl_delete_buffer(uint32_t* gl_id);
 
+void vrms_gl_delete_texture(uint32_t* gl_id);
+
 #endif
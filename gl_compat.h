@@ -19,9 +19,13 @@
 #define GL_TEXTURE_WRAP_R  0x8072
 #define GL_TEXTURE_BASE_LEVEL 0x813C
 #define GL_TEXTURE_MAX_LEVEL  0x813D
+#elif HEADLESS
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
 #else /* GLUT */
 #define GL_GLEXT_PROTOTYPES
 #include <GL/glut.h>
-#endif /* RASPBERRYPI EGLGBM */
+#endif /* RASPBERRYPI EGLGBM HEADLESS */
 
 #endif
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <string.h>
+#include "gl.h"
+#include "gl_null.h"
+#include "gl_compat.h"
+
+#define DEBUG 0
+#define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+
+static vrms_gl_null_stats_t stats;
+static GLuint next_id = 0;
+
+vrms_gl_null_stats_t* vrms_gl_null_stats() {
+    return &stats;
+}
+
+static void vrms_gl_null_gen(GLsizei n, GLuint* ids) {
+    GLsizei i;
+    for (i = 0; i < n; i++) {
+        ids[i] = ++next_id;
+    }
+}
+
+void vrms_gl_add_shader(uint32_t shader_id) {
+}
+
+void vrms_gl_reset_state() {
+}
+
+void vrms_gl_end_draws() {
+}
+
+void vrms_gl_begin_frame() {
+}
+
+void vrms_gl_set_eye(float* projection_matrix, float* view_matrix) {
+    stats.eyes++;
+}
+
+void vrms_gl_draw_mesh_color(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+    stats.draws++;
+    stats.indicies += render.nr_indicies;
+}
+
+void vrms_gl_draw_mesh_texture(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+    stats.draws++;
+    stats.indicies += render.nr_indicies;
+}
+
+void vrms_gl_draw_mesh_color_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count) {
+    stats.instanced_draws++;
+    stats.instances += count;
+    stats.indicies += (uint64_t)render.nr_indicies * count;
+}
+
+void vrms_gl_draw_mesh_texture_instanced(vrms_gl_render_t render, vrms_gl_matrix_t matrix, uint32_t instanced_shader_id, float* models, uint32_t count) {
+    stats.instanced_draws++;
+    stats.instances += count;
+    stats.indicies += (uint64_t)render.nr_indicies * count;
+}
+
+uint8_t vrms_gl_has_instancing() {
+    return 1;
+}
+
+void vrms_gl_draw_skybox(vrms_gl_render_t render, vrms_gl_matrix_t matrix) {
+    stats.skybox_draws++;
+}
+
+void vrms_gl_load_buffer(uint8_t* buffer, uint32_t* destination, uint32_t size, vrms_data_type_t type) {
+    *destination = ++next_id;
+    stats.buffers_loaded++;
+    stats.buffer_bytes += size;
+    debug_print("C|DEBUG|gl_null.c|vrms_gl_load_buffer(): loaded GL id: %d\n", *destination);
+}
+
+uint32_t vrms_gl_texture_row_size(uint32_t width, vrms_texture_format_t format) {
+    uint32_t bytes_per_pixel = (VRMS_FORMAT_BGR888 == format) ? 3 : 4;
+    return ((width * bytes_per_pixel) + 3) & ~3;
+}
+
+void vrms_gl_load_texture_buffer(uint8_t* buffer, uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type) {
+    *destination = ++next_id;
+    stats.textures_loaded++;
+    stats.texture_bytes += (uint64_t)vrms_gl_texture_row_size(width, format) * height;
+}
+
+void vrms_gl_create_texture(uint32_t* destination, uint32_t width, uint32_t height, vrms_texture_format_t format) {
+    *destination = ++next_id;
+    stats.textures_loaded++;
+}
+
+void vrms_gl_load_texture_rows(uint32_t gl_id, uint8_t* buffer, uint32_t width, uint32_t first_row, uint32_t nr_rows, vrms_texture_format_t format) {
+    stats.texture_bytes += (uint64_t)vrms_gl_texture_row_size(width, format) * nr_rows;
+}
+
+void vrms_gl_update_buffer(uint8_t* buffer, uint32_t gl_id, uint32_t offset, uint32_t size, vrms_data_type_t type) {
+    stats.buffer_updates++;
+    stats.update_bytes += size;
+}
+
+void vrms_gl_update_texture(uint8_t* buffer, uint32_t gl_id, uint32_t image_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vrms_texture_format_t format) {
+    stats.texture_updates++;
+    stats.update_bytes += (uint64_t)vrms_gl_texture_row_size(width, format) * height;
+}
+
+// Nothing is ever in flight.
+void* vrms_gl_fence() {
+    stats.fences++;
+    return NULL;
+}
+
+uint8_t vrms_gl_fence_done(void* fence) {
+    return 1;
+}
+
+void vrms_gl_fence_destroy(void* fence) {
+}
+
+void vrms_gl_delete_buffer(uint32_t* gl_id) {
+    stats.deletes++;
+    *gl_id = 0;
+}
+
+void vrms_gl_delete_texture(uint32_t* gl_id) {
+    stats.deletes++;
+    *gl_id = 0;
+}
+
+// The GL calls opengl_stereo.c and ogl_shader_loader.c make directly. Names
+// are handed out so objects look created, and shaders always compile.
+
+void glActiveTexture(GLenum texture) {
+}
+
+void glBeginQuery(GLenum target, GLuint id) {
+}
+
+void glEndQuery(GLenum target) {
+}
+
+void glGenQueries(GLsizei n, GLuint* ids) {
+    vrms_gl_null_gen(n, ids);
+}
+
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params) {
+    *params = 0;
+}
+
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params) {
+    *params = 0;
+}
+
+void glBindBuffer(GLenum target, GLuint buffer) {
+}
+
+void glGenBuffers(GLsizei n, GLuint* buffers) {
+    vrms_gl_null_gen(n, buffers);
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer) {
+}
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    vrms_gl_null_gen(n, framebuffers);
+}
+
+GLenum glCheckFramebufferStatus(GLenum target) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+    vrms_gl_null_gen(n, renderbuffers);
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
+}
+
+void glBindTexture(GLenum target, GLuint texture) {
+}
+
+void glGenTextures(GLsizei n, GLuint* textures) {
+    vrms_gl_null_gen(n, textures);
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels) {
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+}
+
+void glClear(GLbitfield mask) {
+}
+
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) {
+}
+
+void glEnable(GLenum cap) {
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+}
+
+void glEnableVertexAttribArray(GLuint index) {
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+}
+
+GLenum glGetError(void) {
+    return GL_NO_ERROR;
+}
+
+// Old enough that no optional paths are taken.
+const GLubyte* glGetString(GLenum name) {
+    switch (name) {
+        case GL_VERSION:
+            return (const GLubyte*)"2.1 null";
+        case GL_SHADING_LANGUAGE_VERSION:
+            return (const GLubyte*)"1.20 null";
+        default:
+            return (const GLubyte*)"";
+    }
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name) {
+    return -1;
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+    return -1;
+}
+
+void glUseProgram(GLuint program) {
+}
+
+void glUniform1i(GLint location, GLint v0) {
+}
+
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+}
+
+GLuint glCreateShader(GLenum type) {
+    return ++next_id;
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+}
+
+void glCompileShader(GLuint shader) {
+}
+
+void glDeleteShader(GLuint shader) {
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    *params = (GL_COMPILE_STATUS == pname) ? GL_TRUE : 0;
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (bufSize > 0) {
+        infoLog[0] = '\0';
+    }
+}
+
+GLuint glCreateProgram(void) {
+    return ++next_id;
+}
+
+void glAttachShader(GLuint program, GLuint shader) {
+}
+
+void glLinkProgram(GLuint program) {
+}
+
+void glDeleteProgram(GLuint program) {
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    *params = (GL_LINK_STATUS == pname) ? GL_TRUE : 0;
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (bufSize > 0) {
+        infoLog[0] = '\0';
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef VRMS_GL_NULL_H
+#define VRMS_GL_NULL_H
+
+#include <stdint.h>
+
+// Stands in for gl.c when there is no GPU. Every vrms_gl_ entry point only
+// counts what it was asked to do, and the plain GL calls made by
+// opengl_stereo.c and ogl_shader_loader.c succeed without doing anything.
+typedef struct vrms_gl_null_stats {
+    uint64_t eyes;
+    uint64_t draws;
+    uint64_t instanced_draws;
+    uint64_t instances;
+    uint64_t skybox_draws;
+    uint64_t indicies;
+    uint64_t buffers_loaded;
+    uint64_t buffer_bytes;
+    uint64_t textures_loaded;
+    uint64_t texture_bytes;
+    uint64_t buffer_updates;
+    uint64_t texture_updates;
+    uint64_t update_bytes;
+    uint64_t deletes;
+    uint64_t fences;
+} vrms_gl_null_stats_t;
+
+vrms_gl_null_stats_t* vrms_gl_null_stats();
+
+#endif
@@ -13,9 +13,6 @@
 
 vrms_runtime_t* vrms_runtime;
 
-#define NANO_SECOND_MULTIPLIER 1000000
-const long INNER_LOOP_INTERVAL_MS = 50 * NANO_SECOND_MULTIPLIER;
-
 int32_t main(int argc, char **argv) {
     int minor_v, major_v;
     uint32_t width, height;
@@ -136,15 +133,10 @@ int32_t main(int argc, char **argv) {
 
     vrms_runtime = vrms_runtime_init((int)width, (int)height, physical_width);
 
-    struct timespec ts;
-    ts.tv_sec = 0;
-    ts.tv_nsec = INNER_LOOP_INTERVAL_MS;
-
     while (GL_TRUE) {
-        vrms_runtime_display(vrms_runtime);
+        vrms_runtime_frame(vrms_runtime);
         eglSwapBuffers(display, surface);
-        vrms_runtime_process(vrms_runtime);
-        nanosleep(&ts, NULL);
+        vrms_runtime_frame_presented(vrms_runtime);
     }
 
     vrms_runtime_end(vrms_runtime);
@@ -15,9 +15,6 @@
 
 vrms_runtime_t* vrms_runtime;
 
-#define NANO_SECOND_MULTIPLIER 1000000
-const long INNER_LOOP_INTERVAL_MS = 50 * NANO_SECOND_MULTIPLIER;
-
 #define DEBUG 1
 #define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
 
@@ -36,7 +33,9 @@ typedef struct eglkms_context {
     GLuint fb;
     struct gbm_bo* buff_obj[2];
     EGLDisplay egl_display;
+    EGLConfig egl_config;
     EGLContext egl_context;
+    EGLContext egl_upload_context;
     EGLSurface egl_surface;
 //    EGLImageKHR khr_image[2];
 } eglkms_context_t;
@@ -45,6 +44,24 @@ typedef struct eglkms_context {
 //    ;
 //}
 
+// The upload context has no surface of its own, which needs
+// EGL_KHR_surfaceless_context. Without it uploads stay on the render thread.
+uint8_t upload_make_current(void* data) {
+    eglkms_context_t* context = (eglkms_context_t*)data;
+    // The bound API is per thread.
+    eglBindAPI(EGL_OPENGL_API);
+    return eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context->egl_upload_context) ? 1 : 0;
+}
+
+void upload_context(eglkms_context_t* context) {
+    context->egl_upload_context = eglCreateContext(context->egl_display, context->egl_config, context->egl_context, NULL);
+    if (!context->egl_upload_context) {
+        fprintf(stderr, "failed to create upload context\n");
+        return;
+    }
+    vrms_runtime_start_upload_thread(vrms_runtime, upload_make_current, context);
+}
+
 void render_loop(eglkms_context_t* context) {
     struct gbm_bo *previous_bo;
     uint32_t previous_fb;
@@ -53,17 +70,15 @@ void render_loop(eglkms_context_t* context) {
     uint32_t handle;
     uint32_t pitch;
     uint32_t fb;
-    struct timespec ts;
-
-    ts.tv_sec = 0;
-    ts.tv_nsec = INNER_LOOP_INTERVAL_MS;
 
     double physical_width = 1.7;
     vrms_runtime = vrms_runtime_init(context->width, context->height, physical_width);
+    vrms_runtime_set_refresh_rate(vrms_runtime, context->kms_mode.vrefresh);
+    upload_context(context);
 
     quit = 0;
     do {
-        vrms_runtime_display(vrms_runtime);
+        vrms_runtime_frame(vrms_runtime);
         eglSwapBuffers(context->egl_display, context->egl_surface);
         bo = gbm_surface_lock_front_buffer(context->gbm_surface);
         handle = gbm_bo_get_handle(bo).u32;
@@ -78,8 +93,7 @@ void render_loop(eglkms_context_t* context) {
         }
         previous_bo = bo;
         previous_fb = fb;
-        vrms_runtime_process(vrms_runtime);
-        nanosleep(&ts, NULL);
+        vrms_runtime_frame_presented(vrms_runtime);
     } while (!quit);
 }
 
@@ -116,6 +130,7 @@ void egl_context(eglkms_context_t* context) {
     eglBindAPI(EGL_OPENGL_API);
 
     eglChooseConfig(context->egl_display, attributes, &config, 1, &num_config);
+    context->egl_config = config;
     context->egl_context = eglCreateContext(context->egl_display, config, EGL_NO_CONTEXT, NULL);
     if (!context->egl_context) {
         fprintf(stderr, "failed to create context\n");
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <GL/glut.h>
+#include <GL/glx.h>
+#include <X11/Xlib.h>
 #include "gl-matrix.h"
 #include "runtime.h"
 
@@ -11,6 +13,14 @@
 vrms_runtime_t* vrms_runtime;
 float view_matrix[16];
 
+typedef struct upload_context {
+    Display* display;
+    GLXDrawable drawable;
+    GLXContext context;
+} upload_context_t;
+
+upload_context_t upload_context;
+
 GLvoid reshape(int w, int h) {
     vrms_runtime_reshape(vrms_runtime, w, h);
 }
@@ -38,13 +48,47 @@ GLvoid display(GLvoid) {
     glutSwapBuffers();
 }
 
-void do_timer(int timer_event) {
-    vrms_runtime_process(vrms_runtime);
-    glutPostRedisplay();
-    glutTimerFunc(10, do_timer, 1);
+// Runs whenever GLUT is idle, the runtime sleeps until the frame is due.
+void frame(void) {
+    vrms_runtime_frame(vrms_runtime);
+    glutSwapBuffers();
+    vrms_runtime_frame_presented(vrms_runtime);
+}
+
+uint8_t upload_make_current(void* data) {
+    upload_context_t* context = (upload_context_t*)data;
+    return glXMakeCurrent(context->display, context->drawable, context->context) ? 1 : 0;
+}
+
+// Creates a second context sharing objects with the window's so buffers
+// and textures can be uploaded from another thread.
+void initUploadContext() {
+    GLXContext render_context = glXGetCurrentContext();
+    GLXFBConfig* configs;
+    int attributes[] = { GLX_FBCONFIG_ID, 0, None };
+    int nr_configs;
+
+    upload_context.display = glXGetCurrentDisplay();
+    upload_context.drawable = glXGetCurrentDrawable();
+    glXQueryContext(upload_context.display, render_context, GLX_FBCONFIG_ID, &attributes[1]);
+    configs = glXChooseFBConfig(upload_context.display, DefaultScreen(upload_context.display), attributes, &nr_configs);
+    if (!configs || (nr_configs < 1)) {
+        fprintf(stderr, "no fbconfig for upload context\n");
+        return;
+    }
+    upload_context.context = glXCreateNewContext(upload_context.display, configs[0], GLX_RGBA_TYPE, render_context, True);
+    XFree(configs);
+    if (!upload_context.context) {
+        fprintf(stderr, "unable to create upload context\n");
+        return;
+    }
+
+    vrms_runtime_start_upload_thread(vrms_runtime, upload_make_current, &upload_context);
 }
 
 void initWindowingSystem(int *argc, char **argv, int width, int height) {
+    // The upload thread makes GLX calls of its own.
+    XInitThreads();
     glutInit(argc, argv);
     glutInitWindowSize(width, height);
     glutInitDisplayMode(GLUT_RGBA|GLUT_DOUBLE|GLUT_DEPTH);
@@ -52,7 +96,7 @@ void initWindowingSystem(int *argc, char **argv, int width, int height) {
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutPassiveMotionFunc(motion);
-    glutTimerFunc(10, do_timer, 1);
+    glutIdleFunc(frame);
 
     //const GLubyte* extensions = glGetString(GL_EXTENSIONS);
     //fprintf(stderr, "extensions: %s\n", extensions);
@@ -68,6 +112,7 @@ void init(int *argc, char **argv) {
 
     initWindowingSystem(argc, argv, width, height);
     vrms_runtime = vrms_runtime_init(width, height, physical_width);
+    initUploadContext();
 }
 
 int32_t main(int argc, char **argv) {
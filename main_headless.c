@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "runtime.h"
+#ifdef VRMS_NULL_GL
+#include "gl_null.h"
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "gl_compat.h"
+#endif
+
+// Runs the server without a display for a fixed number of frames and
+// writes what each frame cost to a JSON report:
+//
+//     headless-server --frames 600 --report out.json
+//
+// Frames are drawn back to back unless --refresh gives a rate to pace to.
+//
+// The null-server build of this file needs no GPU at all, see gl_null.h.
+
+#define DEBUG 1
+#define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+
+#define HEADLESS_WIDTH 1152
+#define HEADLESS_HEIGHT 648
+#define HEADLESS_FRAMES 300
+
+vrms_runtime_t* vrms_runtime;
+
+typedef struct headless_report {
+    uint32_t frames;
+    uint64_t wall_usec;
+    uint64_t cpu_usec;
+    uint64_t max_frame_usec;
+} headless_report_t;
+
+#ifndef VRMS_NULL_GL
+typedef struct headless_context {
+    EGLDisplay egl_display;
+    EGLConfig egl_config;
+    EGLContext egl_context;
+    EGLContext egl_upload_context;
+    EGLSurface egl_surface;
+    uint8_t surfaceless;
+} headless_context_t;
+
+// Mesa's surfaceless platform needs neither a display server nor a GPU,
+// llvmpipe renders into the pbuffer. Other EGLs get their default display.
+uint8_t headless_egl_init(headless_context_t* context, int width, int height) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+    const char* extensions;
+    EGLint num_config;
+    EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    EGLint surface_attributes[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+
+    context->egl_display = EGL_NO_DISPLAY;
+    extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            context->egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+    }
+    if (EGL_NO_DISPLAY == context->egl_display) {
+        context->egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (!eglInitialize(context->egl_display, NULL, NULL)) {
+        fprintf(stderr, "eglInitialize failed\n");
+        return 0;
+    }
+    extensions = eglQueryString(context->egl_display, EGL_EXTENSIONS);
+    context->surfaceless = (extensions && strstr(extensions, "EGL_KHR_surfaceless_context")) ? 1 : 0;
+
+    eglBindAPI(EGL_OPENGL_API);
+    if (!eglChooseConfig(context->egl_display, config_attributes, &context->egl_config, 1, &num_config) || (num_config < 1)) {
+        fprintf(stderr, "no pbuffer config\n");
+        return 0;
+    }
+    context->egl_context = eglCreateContext(context->egl_display, context->egl_config, EGL_NO_CONTEXT, NULL);
+    if (!context->egl_context) {
+        fprintf(stderr, "failed to create context\n");
+        return 0;
+    }
+    context->egl_surface = eglCreatePbufferSurface(context->egl_display, context->egl_config, surface_attributes);
+    if (!context->egl_surface) {
+        fprintf(stderr, "failed to create pbuffer\n");
+        return 0;
+    }
+    if (!eglMakeCurrent(context->egl_display, context->egl_surface, context->egl_surface, context->egl_context)) {
+        fprintf(stderr, "failed to make context current\n");
+        return 0;
+    }
+    debug_print("version: %s\n", eglQueryString(context->egl_display, EGL_VERSION));
+    return 1;
+}
+
+uint8_t upload_make_current(void* data) {
+    headless_context_t* context = (headless_context_t*)data;
+    // The bound API is per thread.
+    eglBindAPI(EGL_OPENGL_API);
+    return eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context->egl_upload_context) ? 1 : 0;
+}
+
+// The upload context has no surface of its own, which needs
+// EGL_KHR_surfaceless_context. Without it uploads stay on the render thread.
+void upload_context(headless_context_t* context) {
+    if (!context->surfaceless) {
+        return;
+    }
+    context->egl_upload_context = eglCreateContext(context->egl_display, context->egl_config, context->egl_context, NULL);
+    if (!context->egl_upload_context) {
+        fprintf(stderr, "failed to create upload context\n");
+        return;
+    }
+    vrms_runtime_start_upload_thread(vrms_runtime, upload_make_current, context);
+}
+
+void headless_egl_end(headless_context_t* context) {
+    eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(context->egl_display, context->egl_surface);
+    eglDestroyContext(context->egl_display, context->egl_context);
+    eglTerminate(context->egl_display);
+}
+#endif /* VRMS_NULL_GL */
+
+uint64_t usec_of(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+void render_loop(headless_report_t* report, uint32_t frames) {
+    uint64_t wall_start, cpu_start, frame_start, frame_usec;
+    uint32_t i;
+
+    wall_start = usec_of(CLOCK_MONOTONIC);
+    cpu_start = usec_of(CLOCK_PROCESS_CPUTIME_ID);
+    for (i = 0; i < frames; i++) {
+        frame_start = usec_of(CLOCK_MONOTONIC);
+        vrms_runtime_frame(vrms_runtime);
+#ifndef VRMS_NULL_GL
+        // Count the frame when GL has done it, as a swap would.
+        glFinish();
+#endif
+        vrms_runtime_frame_presented(vrms_runtime);
+        frame_usec = usec_of(CLOCK_MONOTONIC) - frame_start;
+        if (frame_usec > report->max_frame_usec) {
+            report->max_frame_usec = frame_usec;
+        }
+    }
+    report->frames = frames;
+    report->cpu_usec = usec_of(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    report->wall_usec = usec_of(CLOCK_MONOTONIC) - wall_start;
+}
+
+uint8_t write_report(char* filename, headless_report_t* report, int width, int height) {
+    FILE* f = filename ? fopen(filename, "w") : stdout;
+    uint32_t frames = report->frames ? report->frames : 1;
+#ifdef VRMS_NULL_GL
+    vrms_gl_null_stats_t* stats = vrms_gl_null_stats();
+#endif
+
+    if (!f) {
+        fprintf(stderr, "could not open report: %s\n", filename);
+        return 0;
+    }
+
+    fprintf(f, "{\n");
+#ifdef VRMS_NULL_GL
+    fprintf(f, "    \"backend\": \"null\",\n");
+#else
+    fprintf(f, "    \"backend\": \"egl\",\n");
+#endif
+    fprintf(f, "    \"width\": %d,\n", width);
+    fprintf(f, "    \"height\": %d,\n", height);
+    fprintf(f, "    \"frames\": %u,\n", report->frames);
+    fprintf(f, "    \"wall_usec\": %llu,\n", (unsigned long long)report->wall_usec);
+    fprintf(f, "    \"cpu_usec\": %llu,\n", (unsigned long long)report->cpu_usec);
+    fprintf(f, "    \"wall_usec_per_frame\": %.2f,\n", (double)report->wall_usec / frames);
+    fprintf(f, "    \"cpu_usec_per_frame\": %.2f,\n", (double)report->cpu_usec / frames);
+    fprintf(f, "    \"max_frame_usec\": %llu", (unsigned long long)report->max_frame_usec);
+#ifdef VRMS_NULL_GL
+    fprintf(f, ",\n    \"gl\": {\n");
+    fprintf(f, "        \"eyes\": %llu,\n", (unsigned long long)stats->eyes);
+    fprintf(f, "        \"draws\": %llu,\n", (unsigned long long)stats->draws);
+    fprintf(f, "        \"instanced_draws\": %llu,\n", (unsigned long long)stats->instanced_draws);
+    fprintf(f, "        \"instances\": %llu,\n", (unsigned long long)stats->instances);
+    fprintf(f, "        \"skybox_draws\": %llu,\n", (unsigned long long)stats->skybox_draws);
+    fprintf(f, "        \"indicies\": %llu,\n", (unsigned long long)stats->indicies);
+    fprintf(f, "        \"buffers_loaded\": %llu,\n", (unsigned long long)stats->buffers_loaded);
+    fprintf(f, "        \"buffer_bytes\": %llu,\n", (unsigned long long)stats->buffer_bytes);
+    fprintf(f, "        \"textures_loaded\": %llu,\n", (unsigned long long)stats->textures_loaded);
+    fprintf(f, "        \"texture_bytes\": %llu,\n", (unsigned long long)stats->texture_bytes);
+    fprintf(f, "        \"buffer_updates\": %llu,\n", (unsigned long long)stats->buffer_updates);
+    fprintf(f, "        \"texture_updates\": %llu,\n", (unsigned long long)stats->texture_updates);
+    fprintf(f, "        \"update_bytes\": %llu,\n", (unsigned long long)stats->update_bytes);
+    fprintf(f, "        \"deletes\": %llu,\n", (unsigned long long)stats->deletes);
+    fprintf(f, "        \"fences\": %llu\n", (unsigned long long)stats->fences);
+    fprintf(f, "    }");
+#endif
+    fprintf(f, "\n}\n");
+
+    if (filename) {
+        fclose(f);
+    }
+    return 1;
+}
+
+void usage(char* name) {
+    fprintf(stderr, "usage: %s [--frames N] [--report out.json] [--refresh HZ]\n", name);
+}
+
+int32_t main(int argc, char **argv) {
+    headless_report_t report;
+    uint32_t frames = HEADLESS_FRAMES;
+    char* report_file = NULL;
+    double refresh = 0.0;
+    int width = HEADLESS_WIDTH;
+    int height = HEADLESS_HEIGHT;
+    double physical_width = 1.347;
+    int i;
+#ifndef VRMS_NULL_GL
+    headless_context_t context;
+#endif
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && ((i + 1) < argc)) {
+            frames = strtoul(argv[++i], NULL, 10);
+        }
+        else if (!strcmp(argv[i], "--report") && ((i + 1) < argc)) {
+            report_file = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--refresh") && ((i + 1) < argc)) {
+            refresh = strtod(argv[++i], NULL);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+#ifndef VRMS_NULL_GL
+    memset(&context, 0, sizeof(headless_context_t));
+    if (!headless_egl_init(&context, width, height)) {
+        return 1;
+    }
+#endif
+
+    vrms_runtime = vrms_runtime_init(width, height, physical_width);
+    vrms_runtime_set_refresh_rate(vrms_runtime, refresh);
+#ifndef VRMS_NULL_GL
+    upload_context(&context);
+#endif
+
+    memset(&report, 0, sizeof(headless_report_t));
+    render_loop(&report, frames);
+
+    vrms_runtime_end(vrms_runtime);
+#ifndef VRMS_NULL_GL
+    headless_egl_end(&context);
+#endif
+
+    return write_report(report_file, &report, width, height) ? 0 : 1;
+}
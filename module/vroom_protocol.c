@@ -292,6 +292,68 @@ uint32_t receive_set_skybox(vrms_module_t* module, uint8_t* in_buf, uint32_t len
     return id;
 }
 
+uint32_t receive_update_data(vrms_module_t* module, uint8_t* in_buf, uint32_t length, uint32_t* error) {
+    uint32_t id;
+    UpdateData* msg;
+
+    if (!module) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_data(): server not initialized");
+        fprintf(stderr, "server not initialized\n");
+        return 0;
+    }
+
+    msg = update_data__unpack(NULL, length, in_buf);
+    if (!msg) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_data(): error unpacking incoming message");
+        return 0;
+    }
+
+    id = module->interface.update_data(module, msg->scene_id, msg->data_id, msg->offset, msg->length);
+    if (0 == id) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_data(): unknown object, bad range or server busy");
+    }
+    else {
+        *error = VRMS_OK;
+    }
+
+    free(msg);
+    return id;
+}
+
+uint32_t receive_update_texture(vrms_module_t* module, uint8_t* in_buf, uint32_t length, uint32_t* error) {
+    uint32_t id;
+    UpdateTexture* msg;
+
+    if (!module) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_texture(): server not initialized");
+        fprintf(stderr, "server not initialized\n");
+        return 0;
+    }
+
+    msg = update_texture__unpack(NULL, length, in_buf);
+    if (!msg) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_texture(): error unpacking incoming message");
+        return 0;
+    }
+
+    id = module->interface.update_texture(module, msg->scene_id, msg->texture_id, msg->x, msg->y, msg->width, msg->height);
+    if (0 == id) {
+        *error = VRMS_INVALIDREQUEST;
+        module->interface.error(module, "receive_update_texture(): unknown object, bad range or server busy");
+    }
+    else {
+        *error = VRMS_OK;
+    }
+
+    free(msg);
+    return id;
+}
+
 uint32_t receive_destroy_object(vrms_module_t* module, uint8_t* in_buf, uint32_t length, uint32_t* error) {
     if (!module) {
         *error = VRMS_INVALIDREQUEST;
@@ -472,6 +534,12 @@ static void client_cb(EV_P_ ev_io *w, int revents) {
         case VRMS_SETSKYBOX:
             id = receive_set_skybox(module, in_buf, length_r, &error);
             break;
+        case VRMS_UPDATEDATA:
+            id = receive_update_data(module, in_buf, length_r, &error);
+            break;
+        case VRMS_UPDATETEXTURE:
+            id = receive_update_texture(module, in_buf, length_r, &error);
+            break;
         default:
             id = 0;
             error = VRMS_INVALIDREQUEST;
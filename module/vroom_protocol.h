@@ -11,7 +11,9 @@ typedef enum vroom_protocol_type {
     VRMS_DESTROYOBJECT,
     VRMS_ATTACHMEMORY,
     VRMS_RUNPROGRAM,
-    VRMS_SETSKYBOX
+    VRMS_SETSKYBOX,
+    VRMS_UPDATEDATA,
+    VRMS_UPDATETEXTURE
 } vroom_protocol_type_t;
 
 typedef enum vroom_protocol_error {
@@ -16,6 +16,7 @@ vrms_object_t* vrms_object_memory_create(uint32_t fd, void* address, uint32_t si
     object_memory->fd = fd;
     object_memory->address = address;
     object_memory->size = size;
+    object_memory->refs = 1;
     object->object.object_memory = object_memory;
 
     return object;
@@ -38,7 +39,7 @@ vrms_object_t* vrms_object_data_create(uint32_t memory_id, uint32_t memory_offse
     return object;
 }
 
-vrms_object_t* vrms_object_texture_create(uint32_t memory_length, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type) {
+vrms_object_t* vrms_object_texture_create(uint32_t data_id, uint32_t memory_length, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type) {
     vrms_object_t* object = vrms_object_create();
     object->type = VRMS_OBJECT_TEXTURE;
     object->realized = 0;
@@ -46,6 +47,7 @@ vrms_object_t* vrms_object_texture_create(uint32_t memory_length, uint32_t width
     vrms_object_texture_t* object_texture = SAFEMALLOC(sizeof(vrms_object_texture_t));
     memset(object_texture, 0, sizeof(vrms_object_texture_t));
 
+    object_texture->data_id = data_id;
     object_texture->memory_length = memory_length;
     object_texture->width = width;
     object_texture->height = height;
@@ -79,3 +81,107 @@ vrms_object_t* vrms_object_create() {
     object->type = VRMS_OBJECT_INVALID;
     return object;
 }
+
+vrms_object_table_t* vrms_object_table_create() {
+    vrms_object_table_t* table = SAFEMALLOC(sizeof(vrms_object_table_t));
+    memset(table, 0, sizeof(vrms_object_table_t));
+    pthread_mutex_init(&table->lock, NULL);
+
+    // Slot 0 is never handed out so that no object gets id 0.
+    table->nr_slots = 1;
+
+    return table;
+}
+
+void vrms_object_table_destroy(vrms_object_table_t* table) {
+    uint32_t i;
+    for (i = 0; i < VRMS_OBJECT_NR_CHUNKS; i++) {
+        free(table->chunks[i]);
+    }
+    pthread_mutex_destroy(&table->lock);
+    free(table);
+}
+
+static vrms_object_slot_t* vrms_object_table_slot(vrms_object_table_t* table, uint32_t index) {
+    vrms_object_slot_t* chunk = __atomic_load_n(&table->chunks[index >> VRMS_OBJECT_CHUNK_BITS], __ATOMIC_ACQUIRE);
+    if (!chunk) {
+        return NULL;
+    }
+    return &chunk[index & (VRMS_OBJECT_CHUNK_SIZE - 1)];
+}
+
+uint32_t vrms_object_table_add(vrms_object_table_t* table, vrms_object_t* object) {
+    vrms_object_slot_t* slot;
+    vrms_object_slot_t* chunk;
+    uint32_t index;
+
+    pthread_mutex_lock(&table->lock);
+    if (table->free_slot) {
+        index = table->free_slot;
+        slot = vrms_object_table_slot(table, index);
+        table->free_slot = slot->next_free;
+    }
+    else {
+        index = table->nr_slots;
+        if (index > VRMS_OBJECT_INDEX_MASK) {
+            pthread_mutex_unlock(&table->lock);
+            return 0;
+        }
+        if (!table->chunks[index >> VRMS_OBJECT_CHUNK_BITS]) {
+            chunk = SAFEMALLOC(sizeof(vrms_object_slot_t) * VRMS_OBJECT_CHUNK_SIZE);
+            memset(chunk, 0, sizeof(vrms_object_slot_t) * VRMS_OBJECT_CHUNK_SIZE);
+            __atomic_store_n(&table->chunks[index >> VRMS_OBJECT_CHUNK_BITS], chunk, __ATOMIC_RELEASE);
+        }
+        slot = vrms_object_table_slot(table, index);
+        table->nr_slots++;
+    }
+
+    slot->next_free = 0;
+    object->id = (slot->generation << VRMS_OBJECT_INDEX_BITS) | index;
+    __atomic_store_n(&slot->object, object, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&table->lock);
+
+    return object->id;
+}
+
+vrms_object_t* vrms_object_table_get(vrms_object_table_t* table, uint32_t id) {
+    vrms_object_slot_t* slot;
+    vrms_object_t* object;
+
+    slot = vrms_object_table_slot(table, id & VRMS_OBJECT_INDEX_MASK);
+    if (!slot) {
+        return NULL;
+    }
+    object = __atomic_load_n(&slot->object, __ATOMIC_ACQUIRE);
+    if (!object || (object->id != id)) {
+        return NULL;
+    }
+    return object;
+}
+
+vrms_object_t* vrms_object_table_remove(vrms_object_table_t* table, uint32_t id) {
+    vrms_object_slot_t* slot;
+    vrms_object_t* object;
+    uint32_t index = id & VRMS_OBJECT_INDEX_MASK;
+
+    pthread_mutex_lock(&table->lock);
+    object = vrms_object_table_get(table, id);
+    if (object) {
+        slot = vrms_object_table_slot(table, index);
+        __atomic_store_n(&slot->object, NULL, __ATOMIC_RELEASE);
+        slot->generation = (slot->generation + 1) & (0xffffffff >> VRMS_OBJECT_INDEX_BITS);
+        slot->next_free = table->free_slot;
+        table->free_slot = index;
+    }
+    pthread_mutex_unlock(&table->lock);
+
+    return object;
+}
+
+vrms_object_t* vrms_object_table_at(vrms_object_table_t* table, uint32_t index) {
+    vrms_object_slot_t* slot = vrms_object_table_slot(table, index);
+    if (!slot) {
+        return NULL;
+    }
+    return __atomic_load_n(&slot->object, __ATOMIC_ACQUIRE);
+}
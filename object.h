@@ -1,10 +1,16 @@
+#include <pthread.h>
 #include "gl.h"
 #include "vroom.h"
 
+typedef struct vrms_scene vrms_scene_t;
+
+// refs counts the scene's own reference and the uploads still reading the
+// memory off the render thread. It is unmapped when the last one goes.
 typedef struct vrms_object_memory {
     uint32_t fd;
     void* address;
     uint32_t size;
+    uint32_t refs;
 } vrms_object_memory_t;
 
 typedef struct vrms_object_data {
@@ -16,6 +22,7 @@ typedef struct vrms_object_data {
 } vrms_object_data_t;
 
 typedef struct vrms_object_texture {
+    uint32_t data_id;
     uint32_t memory_length;
     uint32_t width;
     uint32_t height;
@@ -32,11 +39,13 @@ typedef struct vrms_object {
     uint32_t id;
     vrms_object_type_t type;
     uint32_t gl_id;
+    uint32_t gl_loaded;
     uint8_t realized;
     union {
         vrms_object_memory_t* object_memory;
         vrms_object_data_t* object_data;
         vrms_object_texture_t* object_texture;
+        vrms_scene_t* object_scene;
     } object;
 } vrms_object_t;
 
@@ -46,7 +55,7 @@ vrms_object_t* vrms_object_memory_create(uint32_t fd, void* address, uint32_t si
 
 vrms_object_t* vrms_object_data_create(uint32_t memory_id, uint32_t memory_offset, uint32_t memory_length, vrms_data_type_t type);
 
-vrms_object_t* vrms_object_texture_create(uint32_t memory_length, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type);
+vrms_object_t* vrms_object_texture_create(uint32_t data_id, uint32_t memory_length, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type);
 
 void vrms_object_memory_destroy(vrms_object_memory_t* memory);
 
@@ -55,3 +64,48 @@ void vrms_object_data_destroy(vrms_object_data_t* data);
 void vrms_object_texture_destroy(vrms_object_texture_t* texture);
 
 void vrms_object_matrix_destroy(vrms_object_matrix_t* matrix);
+
+// Object ids are handles into a scene's object table: the low bits index a
+// slot and the high bits hold the slot's generation. A slot's generation
+// moves on every time its object is removed, so ids of destroyed objects
+// stop resolving even once the slot is reused.
+#define VRMS_OBJECT_INDEX_BITS      20
+#define VRMS_OBJECT_INDEX_MASK      ((1 << VRMS_OBJECT_INDEX_BITS) - 1)
+#define VRMS_OBJECT_CHUNK_BITS      10
+#define VRMS_OBJECT_CHUNK_SIZE      (1 << VRMS_OBJECT_CHUNK_BITS)
+#define VRMS_OBJECT_NR_CHUNKS       (1 << (VRMS_OBJECT_INDEX_BITS - VRMS_OBJECT_CHUNK_BITS))
+
+typedef struct vrms_object_slot {
+    vrms_object_t* object;
+    uint32_t generation;
+    uint32_t next_free;
+} vrms_object_slot_t;
+
+// Slots are allocated a chunk at a time and never move, so lookups need no
+// lock. Adding and removing objects is serialised on the table lock.
+typedef struct vrms_object_table {
+    vrms_object_slot_t* chunks[VRMS_OBJECT_NR_CHUNKS];
+    uint32_t nr_slots;
+    uint32_t free_slot;
+    pthread_mutex_t lock;
+} vrms_object_table_t;
+
+vrms_object_table_t* vrms_object_table_create();
+
+// Frees the table but not the objects left in it.
+void vrms_object_table_destroy(vrms_object_table_t* table);
+
+// Stores an object and sets its id. Returns the id, or 0 if the table is
+// full.
+uint32_t vrms_object_table_add(vrms_object_table_t* table, vrms_object_t* object);
+
+// Returns the object for an id, or NULL if there is none or the id is stale.
+vrms_object_t* vrms_object_table_get(vrms_object_table_t* table, uint32_t id);
+
+// Takes an object out of the table and returns it, or NULL if the id does
+// not resolve. The slot goes back on the free list.
+vrms_object_t* vrms_object_table_remove(vrms_object_table_t* table, uint32_t id);
+
+// Returns the object in slot index, for walking the table from 1 up to
+// nr_slots.
+vrms_object_t* vrms_object_table_at(vrms_object_table_t* table, uint32_t index);
@@ -26,10 +26,27 @@ static char texture_vert[] = "shaders/120/model/texture_vert.glsl";
 static char texture_frag[] = "shaders/120/model/texture_frag.glsl";
 static char cubemap_vert[] = "shaders/120/model/cubemap_vert.glsl";
 static char cubemap_frag[] = "shaders/120/model/cubemap_frag.glsl";
+static char color_instanced_vert[] = "shaders/120/model/color_instanced_vert.glsl";
+static char color_instanced_frag[] = "shaders/120/model/color_instanced_frag.glsl";
+static char texture_instanced_vert[] = "shaders/120/model/texture_instanced_vert.glsl";
+static char texture_instanced_frag[] = "shaders/120/model/texture_instanced_frag.glsl";
 #endif /* RASPBERRYPI */
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
+#if !defined(RASPBERRYPI) && !defined(EGLGBM)
+#define OSTEREO_TIMER_QUERY
+#endif
+
+// The render scale steps down after OSTEREO_SCALE_DOWN_FRAMES frames over
+// the target and up after OSTEREO_SCALE_UP_FRAMES frames under the low
+// watermark, so it does not flip back and forth around the target.
+#define OSTEREO_SCALE_STEP 0.05
+#define OSTEREO_SCALE_DOWN_FRAMES 3
+#define OSTEREO_SCALE_UP_FRAMES 60
+#define OSTEREO_SCALE_HIGH_WATERMARK 0.95
+#define OSTEREO_SCALE_LOW_WATERMARK 0.75
+
 int printGlError(char *file, int line) {
     GLenum glErr;
     int retCode = 0;
@@ -79,101 +96,183 @@ void opengl_stereo_load_screen_shader(opengl_stereo* ostereo) {
     ostereo->color_shader_id = ogl_shader_loader_load(color_vert, color_frag);
     ostereo->texture_shader_id = ogl_shader_loader_load(texture_vert, texture_frag);
     ostereo->cubemap_shader_id = ogl_shader_loader_load(cubemap_vert, cubemap_frag);
+#ifndef RASPBERRYPI
+    ostereo->color_instanced_shader_id = ogl_shader_loader_load(color_instanced_vert, color_instanced_frag);
+    ostereo->texture_instanced_shader_id = ogl_shader_loader_load(texture_instanced_vert, texture_instanced_frag);
+#endif /* RASPBERRYPI */
+}
+
+// The lens distortion is baked into a grid per eye. Each vertex carries its
+// screen position, one distorted texture coordinate per color channel and a
+// fade that blacks out what falls outside the lens.
+#define OSTEREO_MESH_SIZE 32
+#define OSTEREO_MESH_VERTEX_FLOATS 9
+#define OSTEREO_MESH_CUTOFF 1.15
+
+static void opengl_stereo_distort(float* uv, double x, double y, double d, double power) {
+    double radius = (d > 0.0) ? pow(d, power) / d : 0.0;
+    uv[0] = 0.5 * (x * radius + 1.0);
+    uv[1] = 0.5 * (y * radius + 1.0);
+}
+
+// u and v run over the eye in [0, 1]. shift moves the lens center within
+// the eye and offset places the eye within the screen plane.
+static GLfloat* opengl_stereo_store_eye_mesh(opengl_stereo* ostereo, GLfloat* verts, double width, double offset, double shift) {
+    double u, v, x, y, d;
+    int i, j;
+
+    for (j = 0; j <= OSTEREO_MESH_SIZE; j++) {
+        for (i = 0; i <= OSTEREO_MESH_SIZE; i++) {
+            u = (double)i / OSTEREO_MESH_SIZE;
+            v = (double)j / OSTEREO_MESH_SIZE;
+            x = 2.0 * (u - shift) - 1.0;
+            y = 2.0 * v - 1.0;
+            d = sqrt(x * x + y * y);
+
+            verts[0] = offset + width * u;
+            verts[1] = 2.0 * v;
+            opengl_stereo_distort(&verts[2], x, y, d, ostereo->barrel_power - ostereo->chromatic_aberration);
+            opengl_stereo_distort(&verts[4], x, y, d, ostereo->barrel_power);
+            opengl_stereo_distort(&verts[6], x, y, d, ostereo->barrel_power + ostereo->chromatic_aberration);
+            verts[8] = (d < OSTEREO_MESH_CUTOFF) ? 1.0f : 0.0f;
+
+            // Both eyes share one texture, map into this eye's half.
+            if (ostereo->mode == OSTEREO_MODE_SIDE_BY_SIDE) {
+                if ((verts[4] < 0.0f) || (verts[4] > 1.0f)) {
+                    verts[8] = 0.0f;
+                }
+                verts[2] = 0.5f * (verts[2] + offset);
+                verts[4] = 0.5f * (verts[4] + offset);
+                verts[6] = 0.5f * (verts[6] + offset);
+            }
+            verts += OSTEREO_MESH_VERTEX_FLOATS;
+        }
+    }
+    return verts;
+}
+
+static GLushort* opengl_stereo_store_eye_indicies(GLushort* indicies, GLushort base) {
+    GLushort row = OSTEREO_MESH_SIZE + 1;
+    GLushort i, j, k;
+
+    for (j = 0; j < OSTEREO_MESH_SIZE; j++) {
+        for (i = 0; i < OSTEREO_MESH_SIZE; i++) {
+            k = base + j * row + i;
+            indicies[0] = k;
+            indicies[1] = k + 1;
+            indicies[2] = k + row;
+            indicies[3] = k + 1;
+            indicies[4] = k + row;
+            indicies[5] = k + row + 1;
+            indicies += 6;
+        }
+    }
+    return indicies;
 }
 
+// Regenerated on every reshape, the screen pass then only samples the
+// texture at the interpolated coordinates.
 void opengl_stereo_store_screen_plane(opengl_stereo* ostereo) {
     GLfloat* verts;
-    GLfloat* uvs;
     GLushort* indicies;
-    int voff;
-    GLuint buff_size, vert_size, text_size, indi_size;
-
-    // TODO: No need for malloc here, just init static arrays and discard.
-    vert_size = sizeof(GLfloat) * 12;
-    text_size = sizeof(GLfloat) * 8;
-    indi_size = sizeof(GLuint) * 6;
-    buff_size = vert_size + text_size;
-
-    ostereo->screen_text_offset = vert_size;
-
-    verts = SAFEMALLOC(vert_size);
-    uvs = SAFEMALLOC(text_size);
-    indicies = SAFEMALLOC(indi_size);
-
-    voff = 0;
-
-    verts[voff + 0] = 0.0f;
-    verts[voff + 1] = 0.0f;
-    verts[voff + 2] = 0.0f;
-    voff += 3;
-    verts[voff + 0] = 2.0f;
-    verts[voff + 1] = 0.0f;
-    verts[voff + 2] = 0.0f;
-    voff += 3;
-    verts[voff + 0] = 0.0f;
-    verts[voff + 1] = 2.0f;
-    verts[voff + 2] = 0.0f;
-    voff += 3;
-    verts[voff + 0] = 2.0f;
-    verts[voff + 1] = 2.0f;
-    verts[voff + 2] = 0.0f;
-
-    voff = 0;
-    indicies[voff + 0] = 0;
-    indicies[voff + 1] = 1;
-    indicies[voff + 2] = 2;
-    indicies[voff + 3] = 1;
-    indicies[voff + 4] = 2;
-    indicies[voff + 5] = 3;
-
-    voff = 0;
-    uvs[voff + 0] = 0.0f;
-    uvs[voff + 1] = 0.0f;
-    voff += 2;
-    uvs[voff + 0] = 1.0f;
-    uvs[voff + 1] = 0.0f;
-    voff += 2;
-    uvs[voff + 0] = 0.0f;
-    uvs[voff + 1] = 1.0f;
-    voff += 2;
-    uvs[voff + 0] = 1.0f;
-    uvs[voff + 1] = 1.0f;
-
-    glGenBuffers(1, &ostereo->screen_plane_vdb);
+    GLfloat* vend;
+    GLushort* iend;
+    int nr_eyes, nr_verts, nr_indicies;
+
+    nr_eyes = (ostereo->mode == OSTEREO_MODE_SIDE_BY_SIDE) ? 2 : 1;
+    nr_verts = nr_eyes * (OSTEREO_MESH_SIZE + 1) * (OSTEREO_MESH_SIZE + 1);
+    nr_indicies = nr_eyes * OSTEREO_MESH_SIZE * OSTEREO_MESH_SIZE * 6;
+
+    verts = SAFEMALLOC(sizeof(GLfloat) * OSTEREO_MESH_VERTEX_FLOATS * nr_verts);
+    indicies = SAFEMALLOC(sizeof(GLushort) * nr_indicies);
+
+    if (nr_eyes == 2) {
+        vend = opengl_stereo_store_eye_mesh(ostereo, verts, 1.0, 0.0, 0.5 * ostereo->texture_shift);
+        vend = opengl_stereo_store_eye_mesh(ostereo, vend, 1.0, 1.0, -0.5 * ostereo->texture_shift);
+        iend = opengl_stereo_store_eye_indicies(indicies, 0);
+        iend = opengl_stereo_store_eye_indicies(iend, nr_verts / 2);
+    }
+    else {
+        // Stereo shifts each eye in the screen matrix instead.
+        vend = opengl_stereo_store_eye_mesh(ostereo, verts, 2.0, 0.0, 0.0);
+        iend = opengl_stereo_store_eye_indicies(indicies, 0);
+    }
+
+    if (!ostereo->screen_plane_vdb) {
+        glGenBuffers(1, &ostereo->screen_plane_vdb);
+        glGenBuffers(1, &ostereo->screen_plane_idb);
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, ostereo->screen_plane_vdb);
-    glBufferData(GL_ARRAY_BUFFER, buff_size, NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vert_size, verts);
-    glBufferSubData(GL_ARRAY_BUFFER, vert_size, text_size, uvs);
+    glBufferData(GL_ARRAY_BUFFER, (vend - verts) * sizeof(GLfloat), verts, GL_STATIC_DRAW);
 
-    glGenBuffers(1, &ostereo->screen_plane_idb);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ostereo->screen_plane_idb);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indi_size, indicies, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (iend - indicies) * sizeof(GLushort), indicies, GL_STATIC_DRAW);
+
+    ostereo->screen_plane_nr_indicies = nr_indicies;
 
     free(verts);
-    free(uvs);
     free(indicies);
 }
 
-void opengl_stereo_render_screen_plane(opengl_stereo* ostereo) {
-    GLuint b_vertex, b_text;
+static void opengl_stereo_screen_attribute(opengl_stereo* ostereo, const char* name, GLint size, int offset) {
+    GLint attribute = glGetAttribLocation(ostereo->screen_shader_program_id, name);
+    if (attribute < 0) {
+        return;
+    }
+    glVertexAttribPointer(attribute, size, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * OSTEREO_MESH_VERTEX_FLOATS, BUFFER_OFFSET(sizeof(GLfloat) * offset));
+    glEnableVertexAttribArray(attribute);
+}
 
+void opengl_stereo_render_screen_plane(opengl_stereo* ostereo) {
     glBindBuffer(GL_ARRAY_BUFFER, ostereo->screen_plane_vdb);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ostereo->screen_plane_idb);
 
-    b_vertex = glGetAttribLocation(ostereo->screen_shader_program_id, "b_vertex" );
-    glVertexAttribPointer(b_vertex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(b_vertex);
+    opengl_stereo_screen_attribute(ostereo, "b_vertex", 2, 0);
+    opengl_stereo_screen_attribute(ostereo, "b_text_r", 2, 2);
+    opengl_stereo_screen_attribute(ostereo, "b_text_g", 2, 4);
+    opengl_stereo_screen_attribute(ostereo, "b_text_b", 2, 6);
+    opengl_stereo_screen_attribute(ostereo, "b_fade", 1, 8);
+
+    glDrawElements(GL_TRIANGLES, ostereo->screen_plane_nr_indicies, GL_UNSIGNED_SHORT, NULL);
+}
 
-    b_text = glGetAttribLocation(ostereo->screen_shader_program_id, "b_text" );
-    glVertexAttribPointer(b_text, 2, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(ostereo->screen_text_offset));
-    glEnableVertexAttribArray(b_text);
+// The eyes are drawn into the lower left render_width by render_height of
+// their part of the render texture.
+void opengl_stereo_update_render_size(opengl_stereo* ostereo) {
+    ostereo->render_width = ostereo->width * ostereo->render_scale;
+    ostereo->render_height = ostereo->height * ostereo->render_scale;
+    if (ostereo->render_width > ostereo->texture_width) {
+        ostereo->render_width = ostereo->texture_width;
+    }
+    if (ostereo->render_height > ostereo->texture_height) {
+        ostereo->render_height = ostereo->texture_height;
+    }
+}
 
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL);
+// The screen mesh covers the whole render texture, scale it down to the
+// part that was drawn to.
+void opengl_stereo_set_uv_scale(opengl_stereo* ostereo) {
+    GLint uv_scale = glGetUniformLocation(ostereo->screen_shader_program_id, "uv_scale");
+    glUniform2f(uv_scale, (GLfloat)ostereo->render_width / ostereo->texture_width, (GLfloat)ostereo->render_height / ostereo->texture_height);
 }
 
 void opengl_stereo_create_render_texture(opengl_stereo* ostereo) {
     GLuint depthRenderBuffer;
     GLenum status;
+    GLsizei width, height;
+
+    ostereo->texture_width = ostereo->width * ostereo->max_render_scale;
+    ostereo->texture_height = ostereo->height * ostereo->max_render_scale;
+    opengl_stereo_update_render_size(ostereo);
+
+    width = ostereo->texture_width;
+    height = ostereo->texture_height;
+
+    // Side by side holds both eyes.
+    if (ostereo->mode == OSTEREO_MODE_SIDE_BY_SIDE) {
+        width *= 2;
+    }
 
     glGenFramebuffers(1, &ostereo->screen_buffer);
     glGenTextures(1, &ostereo->screen_texture);
@@ -185,11 +284,11 @@ void opengl_stereo_create_render_texture(opengl_stereo* ostereo) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ostereo->width, ostereo->height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
 
     glGenRenderbuffers(1, &depthRenderBuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, depthRenderBuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, ostereo->width, ostereo->height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderBuffer);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ostereo->screen_texture, 0);
 
@@ -260,7 +359,7 @@ void opengl_stereo_reshape(opengl_stereo* ostereo, int w, int h) {
     if (h == 0) {
         h = 1;
     }
-    if (ostereo->mode == OSTEREO_MODE_STEREO) {
+    if ((ostereo->mode == OSTEREO_MODE_STEREO) || (ostereo->mode == OSTEREO_MODE_SIDE_BY_SIDE)) {
         ostereo->width = w / 2;
     }
     else {
@@ -269,6 +368,8 @@ void opengl_stereo_reshape(opengl_stereo* ostereo, int w, int h) {
     ostereo->height = h;
     ostereo->aspect = ostereo->width / ostereo->height;
     opengl_stereo_set_frustum(ostereo);
+    opengl_stereo_update_render_size(ostereo);
+    opengl_stereo_store_screen_plane(ostereo);
 }
 
 void opengl_stereo_render_left_scene(opengl_stereo* ostereo) {
@@ -279,7 +380,7 @@ void opengl_stereo_render_left_scene(opengl_stereo* ostereo) {
 
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-    glViewport(0, 0, ostereo->width, ostereo->height);
+    glViewport(0, 0, ostereo->render_width, ostereo->render_height);
 
     mat4_identity(ostereo->view_matrix);
     mat4_identity(ostereo->model_matrix);
@@ -292,9 +393,6 @@ void opengl_stereo_render_left_scene(opengl_stereo* ostereo) {
 
     glUseProgram(ostereo->screen_shader_program_id);
 
-    ostereo->barrel_power_id = glGetUniformLocation(ostereo->screen_shader_program_id, "barrel_power");
-    glUniform1f(ostereo->barrel_power_id, 1.1f);
-
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     //glClearColor(0.0f, 0.8f, 0.8f, 1.0f);
     //glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
@@ -304,6 +402,7 @@ void opengl_stereo_render_left_scene(opengl_stereo* ostereo) {
 
     m_projection = glGetUniformLocation(ostereo->screen_shader_program_id, "m_projection");
     glUniformMatrix4fv(m_projection, 1, GL_FALSE, ostereo->screen_matrix);
+    opengl_stereo_set_uv_scale(ostereo);
 
     glViewport(0, 0, ostereo->width, ostereo->height);
 
@@ -323,7 +422,7 @@ void opengl_stereo_render_right_scene(opengl_stereo* ostereo) {
 
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-    glViewport(0, 0, ostereo->width, ostereo->height);
+    glViewport(0, 0, ostereo->render_width, ostereo->render_height);
 
     mat4_identity(ostereo->view_matrix);
     mat4_identity(ostereo->model_matrix);
@@ -336,9 +435,6 @@ void opengl_stereo_render_right_scene(opengl_stereo* ostereo) {
 
     glUseProgram(ostereo->screen_shader_program_id);
 
-    ostereo->barrel_power_id = glGetUniformLocation(ostereo->screen_shader_program_id, "barrel_power");
-    glUniform1f(ostereo->barrel_power_id, 1.1f);
-
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     //glClearColor(0.0f, 0.8f, 0.8f, 1.0f);
     //glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
@@ -348,6 +444,7 @@ void opengl_stereo_render_right_scene(opengl_stereo* ostereo) {
 
     m_projection = glGetUniformLocation(ostereo->screen_shader_program_id, "m_projection");
     glUniformMatrix4fv(m_projection, 1, GL_FALSE, ostereo->screen_matrix);
+    opengl_stereo_set_uv_scale(ostereo);
 
     glViewport(ostereo->width, 0, ostereo->width, ostereo->height);
 
@@ -387,6 +484,59 @@ void opengl_stereo_render_stereo_scene(opengl_stereo* ostereo) {
     opengl_stereo_render_right_scene(ostereo);
 }
 
+void opengl_stereo_set_eye(opengl_stereo* ostereo, opengl_stereo_camera* camera) {
+    mat4_identity(ostereo->view_matrix);
+    mat4_identity(ostereo->model_matrix);
+
+    mat4_copy(ostereo->projection_matrix, camera->projection_matrix);
+    mat4_multiply(ostereo->view_matrix, ostereo->hmd_matrix);
+    mat4_translatef(ostereo->view_matrix, camera->model_translation, 0.0, ostereo->depthZ);
+}
+
+// Both eyes are drawn into one double width buffer with a single clear,
+// switching viewport between them, then one distortion pass draws the
+// whole buffer to the window.
+void opengl_stereo_render_side_by_side_scene(opengl_stereo* ostereo) {
+    GLint tex0;
+    GLuint m_projection;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, ostereo->screen_buffer);
+    glViewport(0, 0, ostereo->texture_width * 2, ostereo->texture_height);
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+
+    glViewport(0, 0, ostereo->render_width, ostereo->render_height);
+    opengl_stereo_set_eye(ostereo, &ostereo->left_camera);
+    ostereo->draw_scene_callback(ostereo, ostereo->draw_scene_callback_data);
+
+    // The right eye starts where the scaled left eye ends, so both eyes
+    // stay in the same fraction of their half of the texture.
+    glViewport(ostereo->render_width, 0, ostereo->render_width, ostereo->render_height);
+    opengl_stereo_set_eye(ostereo, &ostereo->right_camera);
+    ostereo->draw_scene_callback(ostereo, ostereo->draw_scene_callback_data);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, ostereo->width * 2, ostereo->height);
+    glClearColor(0.0f, 0.8f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(ostereo->screen_shader_program_id);
+
+    mat4_identity(ostereo->screen_matrix);
+    mat4_translatef(ostereo->screen_matrix, -1.0, -1.0, 0.0);
+
+    m_projection = glGetUniformLocation(ostereo->screen_shader_program_id, "m_projection");
+    glUniformMatrix4fv(m_projection, 1, GL_FALSE, ostereo->screen_matrix);
+    opengl_stereo_set_uv_scale(ostereo);
+
+    tex0 = glGetUniformLocation(ostereo->screen_shader_program_id, "tex0");
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(tex0, 0);
+    glBindTexture(GL_TEXTURE_2D, ostereo->screen_texture);
+
+    opengl_stereo_render_screen_plane(ostereo);
+}
+
 /*
     display(): (one buffer)
         opengl_stereo_render_left_scene():
@@ -400,12 +550,119 @@ void opengl_stereo_render_stereo_scene(opengl_stereo* ostereo) {
             glUseProgram(screen) <-- Rendering a texture
             opengl_stereo_render_buffer_to_window()
 */
+#ifdef OSTEREO_TIMER_QUERY
+static uint8_t opengl_stereo_has_timer_query() {
+    static int8_t supported = -1;
+    const char* version;
+    const char* extensions;
+    int major = 0, minor = 0;
+
+    if (supported < 0) {
+        supported = 0;
+        version = (const char*)glGetString(GL_VERSION);
+        extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (version && (sscanf(version, "%d.%d", &major, &minor) == 2) && ((major > 3) || ((major == 3) && (minor >= 3)))) {
+            supported = 1;
+        }
+        else if (extensions && strstr(extensions, "GL_ARB_timer_query")) {
+            supported = 1;
+        }
+    }
+    return (uint8_t)supported;
+}
+#endif /* OSTEREO_TIMER_QUERY */
+
+// Two queries are used in turn so reading last frame's result does not
+// wait for the GPU.
+void opengl_stereo_begin_frame_query(opengl_stereo* ostereo) {
+#ifdef OSTEREO_TIMER_QUERY
+    GLuint query;
+    GLuint available = 0;
+    GLuint64 elapsed;
+
+    if (!opengl_stereo_has_timer_query()) {
+        return;
+    }
+    if (!ostereo->frame_queries[0]) {
+        glGenQueries(2, ostereo->frame_queries);
+    }
+    query = ostereo->frame_queries[ostereo->frame_number % 2];
+    if (ostereo->frame_number >= 2) {
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            ostereo->gpu_usec = elapsed / 1000.0;
+        }
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+#endif /* OSTEREO_TIMER_QUERY */
+}
+
+void opengl_stereo_end_frame_query(opengl_stereo* ostereo) {
+#ifdef OSTEREO_TIMER_QUERY
+    if (opengl_stereo_has_timer_query()) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+#endif /* OSTEREO_TIMER_QUERY */
+    ostereo->frame_number++;
+}
+
+void opengl_stereo_frame_time(opengl_stereo* ostereo, uint32_t usec) {
+    double frame_usec = usec;
+    double scale = ostereo->render_scale;
+
+    // Only drawing gets cheaper at a lower resolution, so GPU time is used
+    // where the driver measures it.
+    if (ostereo->gpu_usec > 0.0) {
+        frame_usec = ostereo->gpu_usec;
+    }
+    // Smooth out single slow frames.
+    ostereo->frame_usec += (frame_usec - ostereo->frame_usec) / 8.0;
+
+    if (ostereo->frame_usec > (ostereo->target_usec * OSTEREO_SCALE_HIGH_WATERMARK)) {
+        ostereo->render_scale_votes = (ostereo->render_scale_votes > 0) ? -1 : ostereo->render_scale_votes - 1;
+    }
+    else if (ostereo->frame_usec < (ostereo->target_usec * OSTEREO_SCALE_LOW_WATERMARK)) {
+        ostereo->render_scale_votes = (ostereo->render_scale_votes < 0) ? 1 : ostereo->render_scale_votes + 1;
+    }
+    else {
+        ostereo->render_scale_votes = 0;
+    }
+
+    if (ostereo->render_scale_votes <= -OSTEREO_SCALE_DOWN_FRAMES) {
+        scale -= OSTEREO_SCALE_STEP;
+    }
+    else if (ostereo->render_scale_votes >= OSTEREO_SCALE_UP_FRAMES) {
+        scale += OSTEREO_SCALE_STEP;
+    }
+    else {
+        return;
+    }
+    ostereo->render_scale_votes = 0;
+
+    if (scale < ostereo->min_render_scale) {
+        scale = ostereo->min_render_scale;
+    }
+    if (scale > ostereo->max_render_scale) {
+        scale = ostereo->max_render_scale;
+    }
+    if (scale != ostereo->render_scale) {
+        ostereo->render_scale = scale;
+        opengl_stereo_update_render_size(ostereo);
+    }
+}
+
 void opengl_stereo_display(opengl_stereo* ostereo) {
     if (!ostereo->draw_scene_callback) {
         fprintf(stderr, "opengl_stereo_ERROR: draw_scene_callback not attached\n");
         return;
     }
+    if (ostereo->record_scene_callback) {
+        ostereo->record_scene_callback(ostereo, ostereo->draw_scene_callback_data);
+    }
+    opengl_stereo_begin_frame_query(ostereo);
     ostereo->scene_renderer(ostereo);
+    opengl_stereo_end_frame_query(ostereo);
 }
 
 void opengl_stereo_draw_scene_callback(opengl_stereo* ostereo, ostereo_draw_scene_callback_t callback, void* callback_data) {
@@ -418,6 +675,10 @@ void opengl_stereo_draw_scene_callback(opengl_stereo* ostereo, ostereo_draw_scen
     ostereo->draw_scene_callback_data = callback_data;
 }
 
+void opengl_stereo_record_scene_callback(opengl_stereo* ostereo, ostereo_draw_scene_callback_t callback) {
+    ostereo->record_scene_callback = callback;
+}
+
 void initGL(opengl_stereo* ostereo) {
     glEnable(GL_DEPTH_TEST);
     //glMatrixMode(GL_PROJECTION);
@@ -459,6 +720,12 @@ void opengl_stereo_load_defaults(opengl_stereo* ostereo) {
     ostereo->nearZ = 0.1;
     ostereo->farZ = 300.0;
     ostereo->screenZ = 100.0;
+    ostereo->barrel_power = 1.1;
+    ostereo->chromatic_aberration = 0.01;
+    ostereo->render_scale = 1.0;
+    ostereo->min_render_scale = 0.5;
+    ostereo->max_render_scale = 1.0;
+    ostereo->target_usec = 1000000.0 / 60.0;
 }
 
 void opengl_stereo_init(opengl_stereo* ostereo, int width, int height, double physical_width, opengl_stereo_mode_t mode) {
@@ -472,8 +739,12 @@ void opengl_stereo_init(opengl_stereo* ostereo, int width, int height, double ph
         ostereo->width = width;
         ostereo->scene_renderer = opengl_stereo_render_mono_scene;
     }
+    else if (mode == OSTEREO_MODE_SIDE_BY_SIDE) {
+        ostereo->width = width / 2;
+        ostereo->scene_renderer = opengl_stereo_render_side_by_side_scene;
+    }
     else {
-        fprintf(stderr, "INVALID MODE! (OSTEREO_MODE_STEREO or OSTEREO_MODE_MONO)\n");
+        fprintf(stderr, "INVALID MODE! (OSTEREO_MODE_STEREO, OSTEREO_MODE_MONO or OSTEREO_MODE_SIDE_BY_SIDE)\n");
         return;
     }
     ostereo->height = height;
@@ -1,6 +1,7 @@
 #ifndef OPENGL_STEREO_H
 #define OPENGL_STEREO_H
 
+#include <stdint.h>
 #include "gl_compat.h"
 
 typedef struct opengl_stereo_camera {
@@ -12,9 +13,13 @@ typedef struct opengl_stereo opengl_stereo;
 
 typedef void (*ostereo_draw_scene_callback_t)(opengl_stereo* ostereo, void* data);
 
+// STEREO draws and distorts each eye in turn through a shared eye sized
+// buffer. SIDE_BY_SIDE draws both eyes into one double width buffer and
+// distorts them in a single pass.
 typedef enum opengl_stereo_mode {
     OSTEREO_MODE_STEREO = 0x00,
-    OSTEREO_MODE_MONO = 0x01
+    OSTEREO_MODE_MONO = 0x01,
+    OSTEREO_MODE_SIDE_BY_SIDE = 0x02
 } opengl_stereo_mode_t;
 
 typedef struct opengl_stereo {
@@ -32,32 +37,58 @@ typedef struct opengl_stereo {
     double texture_shift;
     GLuint screen_plane_vdb;
     GLuint screen_plane_idb;
-    GLuint screen_text_offset;
+    GLuint screen_plane_nr_indicies;
     float screen_matrix[16];
     GLuint screen_shader_program_id;
     GLuint color_shader_id;
     GLuint texture_shader_id;
     GLuint cubemap_shader_id;
+    GLuint color_instanced_shader_id;
+    GLuint texture_instanced_shader_id;
     float model_matrix[16];
     float view_matrix[16];
     float hmd_matrix[16];
     float projection_matrix[16];
     ostereo_draw_scene_callback_t draw_scene_callback;
+    ostereo_draw_scene_callback_t record_scene_callback;
     void (*scene_renderer)(opengl_stereo* ostereo);
     void* draw_scene_callback_data;
-    GLuint barrel_power_id;
+    double barrel_power;
+    double chromatic_aberration;
     opengl_stereo_camera left_camera;
     opengl_stereo_camera right_camera;
     opengl_stereo_camera skybox_camera;
     GLuint screen_buffer;
     GLuint screen_texture;
+    GLsizei texture_width;
+    GLsizei texture_height;
+    GLsizei render_width;
+    GLsizei render_height;
+    double render_scale;
+    double min_render_scale;
+    double max_render_scale;
+    double target_usec;
+    double frame_usec;
+    double gpu_usec;
+    int32_t render_scale_votes;
+    GLuint frame_queries[2];
+    uint32_t frame_number;
 } opengl_stereo;
 
 void opengl_stereo_draw_scene_callback(opengl_stereo* ostereo, ostereo_draw_scene_callback_t callback, void* callback_data);
+// Called once a frame before the scene is drawn for each eye.
+void opengl_stereo_record_scene_callback(opengl_stereo* ostereo, ostereo_draw_scene_callback_t callback);
 void opengl_stereo_reshape(opengl_stereo* ostereo, int w, int h);
 void opengl_stereo_display(opengl_stereo* ostereo);
 void opengl_stereo_init(opengl_stereo* ostereo, int width, int height, double physical_width, opengl_stereo_mode_t mode);
 
+// Feeds the wall clock time of the last frame to the resolution controller.
+// The eyes are drawn into a part of the render texture between
+// min_render_scale and max_render_scale, shrinking when frames run over
+// target_usec and growing back once they are well under it. GPU time is
+// used instead where the driver has timer queries to measure it.
+void opengl_stereo_frame_time(opengl_stereo* ostereo, uint32_t usec);
+
 double opengl_stereo_get_config_value(opengl_stereo* ostereo, char* name);
 void opengl_stereo_set_config_value(opengl_stereo* ostereo, char* name, double value);
 
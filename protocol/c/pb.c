@@ -437,6 +437,92 @@ void   destroy_object__free_unpacked
   assert(message->base.descriptor == &destroy_object__descriptor);
   protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
 }
+void   update_data__init
+                     (UpdateData         *message)
+{
+  static UpdateData init_value = UPDATE_DATA__INIT;
+  *message = init_value;
+}
+size_t update_data__get_packed_size
+                     (const UpdateData *message)
+{
+  assert(message->base.descriptor == &update_data__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t update_data__pack
+                     (const UpdateData *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &update_data__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t update_data__pack_to_buffer
+                     (const UpdateData *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &update_data__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+UpdateData *
+       update_data__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (UpdateData *)
+     protobuf_c_message_unpack (&update_data__descriptor,
+                                allocator, len, data);
+}
+void   update_data__free_unpacked
+                     (UpdateData *message,
+                      ProtobufCAllocator *allocator)
+{
+  assert(message->base.descriptor == &update_data__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   update_texture__init
+                     (UpdateTexture         *message)
+{
+  static UpdateTexture init_value = UPDATE_TEXTURE__INIT;
+  *message = init_value;
+}
+size_t update_texture__get_packed_size
+                     (const UpdateTexture *message)
+{
+  assert(message->base.descriptor == &update_texture__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t update_texture__pack
+                     (const UpdateTexture *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &update_texture__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t update_texture__pack_to_buffer
+                     (const UpdateTexture *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &update_texture__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+UpdateTexture *
+       update_texture__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (UpdateTexture *)
+     protobuf_c_message_unpack (&update_texture__descriptor,
+                                allocator, len, data);
+}
+void   update_texture__free_unpacked
+                     (UpdateTexture *message,
+                      ProtobufCAllocator *allocator)
+{
+  assert(message->base.descriptor == &update_texture__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
 static const ProtobufCFieldDescriptor reply__field_descriptors[2] =
 {
   {
@@ -1133,3 +1219,183 @@ const ProtobufCMessageDescriptor destroy_object__descriptor =
   (ProtobufCMessageInit) destroy_object__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
+static const ProtobufCFieldDescriptor update_data__field_descriptors[4] =
+{
+  {
+    "scene_id",
+    1,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateData, scene_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "data_id",
+    2,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateData, data_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "offset",
+    3,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateData, offset),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "length",
+    4,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateData, length),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned update_data__field_indices_by_name[] = {
+  1,   /* field[1] = data_id */
+  3,   /* field[3] = length */
+  2,   /* field[2] = offset */
+  0,   /* field[0] = scene_id */
+};
+static const ProtobufCIntRange update_data__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 4 }
+};
+const ProtobufCMessageDescriptor update_data__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "UpdateData",
+  "UpdateData",
+  "UpdateData",
+  "",
+  sizeof(UpdateData),
+  4,
+  update_data__field_descriptors,
+  update_data__field_indices_by_name,
+  1,  update_data__number_ranges,
+  (ProtobufCMessageInit) update_data__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor update_texture__field_descriptors[6] =
+{
+  {
+    "scene_id",
+    1,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, scene_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "texture_id",
+    2,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, texture_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "x",
+    3,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, x),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "y",
+    4,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, y),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "width",
+    5,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, width),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "height",
+    6,
+    PROTOBUF_C_LABEL_REQUIRED,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(UpdateTexture, height),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned update_texture__field_indices_by_name[] = {
+  5,   /* field[5] = height */
+  0,   /* field[0] = scene_id */
+  1,   /* field[1] = texture_id */
+  4,   /* field[4] = width */
+  2,   /* field[2] = x */
+  3,   /* field[3] = y */
+};
+static const ProtobufCIntRange update_texture__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 6 }
+};
+const ProtobufCMessageDescriptor update_texture__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "UpdateTexture",
+  "UpdateTexture",
+  "UpdateTexture",
+  "",
+  sizeof(UpdateTexture),
+  6,
+  update_texture__field_descriptors,
+  update_texture__field_indices_by_name,
+  1,  update_texture__number_ranges,
+  (ProtobufCMessageInit) update_texture__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
@@ -25,6 +25,8 @@ typedef struct _AttachMemory AttachMemory;
 typedef struct _RunProgram RunProgram;
 typedef struct _SetSkybox SetSkybox;
 typedef struct _DestroyObject DestroyObject;
+typedef struct _UpdateData UpdateData;
+typedef struct _UpdateTexture UpdateTexture;
 
 
 /* --- enums --- */
@@ -175,6 +177,34 @@ struct  _DestroyObject
     , 0, 0 }
 
 
+struct  _UpdateData
+{
+  ProtobufCMessage base;
+  int32_t scene_id;
+  int32_t data_id;
+  int32_t offset;
+  int32_t length;
+};
+#define UPDATE_DATA__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&update_data__descriptor) \
+    , 0, 0, 0, 0 }
+
+
+struct  _UpdateTexture
+{
+  ProtobufCMessage base;
+  int32_t scene_id;
+  int32_t texture_id;
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+};
+#define UPDATE_TEXTURE__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&update_texture__descriptor) \
+    , 0, 0, 0, 0, 0, 0 }
+
+
 /* Reply methods */
 void   reply__init
                      (Reply         *message);
@@ -365,6 +395,44 @@ DestroyObject *
 void   destroy_object__free_unpacked
                      (DestroyObject *message,
                       ProtobufCAllocator *allocator);
+/* UpdateData methods */
+void   update_data__init
+                     (UpdateData         *message);
+size_t update_data__get_packed_size
+                     (const UpdateData   *message);
+size_t update_data__pack
+                     (const UpdateData   *message,
+                      uint8_t             *out);
+size_t update_data__pack_to_buffer
+                     (const UpdateData   *message,
+                      ProtobufCBuffer     *buffer);
+UpdateData *
+       update_data__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   update_data__free_unpacked
+                     (UpdateData *message,
+                      ProtobufCAllocator *allocator);
+/* UpdateTexture methods */
+void   update_texture__init
+                     (UpdateTexture         *message);
+size_t update_texture__get_packed_size
+                     (const UpdateTexture   *message);
+size_t update_texture__pack
+                     (const UpdateTexture   *message,
+                      uint8_t             *out);
+size_t update_texture__pack_to_buffer
+                     (const UpdateTexture   *message,
+                      ProtobufCBuffer     *buffer);
+UpdateTexture *
+       update_texture__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   update_texture__free_unpacked
+                     (UpdateTexture *message,
+                      ProtobufCAllocator *allocator);
 /* --- per-message closures --- */
 
 typedef void (*Reply_Closure)
@@ -397,6 +465,12 @@ typedef void (*SetSkybox_Closure)
 typedef void (*DestroyObject_Closure)
                  (const DestroyObject *message,
                   void *closure_data);
+typedef void (*UpdateData_Closure)
+                 (const UpdateData *message,
+                  void *closure_data);
+typedef void (*UpdateTexture_Closure)
+                 (const UpdateTexture *message,
+                  void *closure_data);
 
 /* --- services --- */
 
@@ -416,6 +490,8 @@ extern const ProtobufCMessageDescriptor attach_memory__descriptor;
 extern const ProtobufCMessageDescriptor run_program__descriptor;
 extern const ProtobufCMessageDescriptor set_skybox__descriptor;
 extern const ProtobufCMessageDescriptor destroy_object__descriptor;
+extern const ProtobufCMessageDescriptor update_data__descriptor;
+extern const ProtobufCMessageDescriptor update_texture__descriptor;
 
 PROTOBUF_C__END_DECLS
 
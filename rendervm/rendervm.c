@@ -2,7 +2,9 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "rendervm.h"
+#include "rendervm_simd.h"
 
 #define NCODE(vm)           program[vm->pc++]
 #define CTRL_PUSH(vm, v)    vm->ctrl_stack[++vm->ctrl_sp] = v
@@ -21,12 +23,6 @@
 #define FLOAT_PUSH(vm, v)   vm->float_stack[++vm->float_sp] = v
 #define FLOAT_POP(vm)       vm->float_stack[vm->float_sp--]
 #define FLOAT_PEEK(vm, v)   vm->float_stack[v]
-#define VEC2_PUSH(vm, v)    vm->vec2_stack[++vm->vec2_sp] = v
-#define VEC2_POP(vm)        vm->vec2_stack[vm->vec2_sp--]
-#define VEC2_PEEK(vm, v)    vm->vec2_stack[v]
-#define MAT4_PUSH(vm, v)    vm->mat4_stack[++vm->vec2_sp] = v
-#define MAT4_POP(vm)        vm->mat4_stack[vm->vec2_sp--]
-#define MAT4_PEEK(vm, v)    vm->mat4_stack[v]
 
 typedef union {
     float f;
@@ -208,856 +204,2524 @@ const rendervm_opcode_info_t opcode_info[] = {
     {"[unused]", 0x00}
 };
 
-uint8_t rendervm_exec(rendervm_t* vm, uint8_t* program, uint16_t length) {
-    uint16_t opcode;
-    uint8_t u80, u81, u82, u83;
-    uint16_t u160, u161;
-    uint32_t u320, u321;
-    float fl0, fl1;
-    float* flp0;
+uint8_t rendervm_operand_length(uint8_t opcode) {
+    switch (opcode) {
+        case VM_UINT8_POP:
+        case VM_UINT8_DUP:
+        case VM_UINT8_ADDN:
+        case VM_UINT8_PUSH:
+        case VM_UINT16_POP:
+        case VM_UINT16_DUP:
+        case VM_UINT32_POP:
+        case VM_UINT32_DUP:
+        case VM_UINT32_REG_GET:
+        case VM_UINT32_REG_SET:
+        case VM_FLOAT_POP:
+        case VM_FLOAT_DUP:
+        case VM_VEC2_POP:
+        case VM_VEC2_DUP:
+        case VM_VEC3_POP:
+        case VM_VEC3_DUP:
+        case VM_VEC4_POP:
+        case VM_VEC4_DUP:
+        case VM_MAT2_POP:
+        case VM_MAT2_DUP:
+        case VM_MAT3_POP:
+        case VM_MAT3_DUP:
+        case VM_MAT4_POP:
+        case VM_MAT4_DUP:
+            return 1;
+        case VM_CALL:
+        case VM_JUMP:
+        case VM_UINT8_JUMPEM:
+        case VM_UINT8_JUMPNZ:
+        case VM_UINT8_JUMPZ:
+        case VM_UINT16_JUMPEM:
+        case VM_UINT16_ADDN:
+        case VM_UINT16_JUMPNZ:
+        case VM_UINT16_JUMPZ:
+        case VM_UINT16_PUSH:
+        case VM_UINT32_JUMPEM:
+        case VM_UINT32_JUMPNZ:
+        case VM_UINT32_JUMPZ:
+        case VM_FLOAT_JUMPEM:
+        case VM_FLOAT_JUMPNZ:
+        case VM_FLOAT_JUMPZ:
+        case VM_VEC2_JUMPEM:
+        case VM_VEC3_JUMPEM:
+        case VM_VEC4_JUMPEM:
+        case VM_MAT2_JUMPEM:
+        case VM_MAT3_JUMPEM:
+        case VM_MAT4_JUMPEM:
+            return 2;
+        case VM_UINT32_ADDN:
+        case VM_UINT32_PUSH:
+        case VM_FLOAT_ADDN:
+        case VM_FLOAT_PUSH:
+            return 4;
+        default:
+            return 0;
+    }
+}
 
-    if (!vm->running) {
-        return vm->running;
+uint8_t rendervm_opcode_is_branch(uint8_t opcode) {
+    switch (opcode) {
+        case VM_CALL:
+        case VM_JUMP:
+        case VM_UINT8_JUMPEM:
+        case VM_UINT8_JUMPNZ:
+        case VM_UINT8_JUMPZ:
+        case VM_UINT16_JUMPEM:
+        case VM_UINT16_JUMPNZ:
+        case VM_UINT16_JUMPZ:
+        case VM_UINT32_JUMPEM:
+        case VM_UINT32_JUMPNZ:
+        case VM_UINT32_JUMPZ:
+        case VM_FLOAT_JUMPEM:
+        case VM_FLOAT_JUMPNZ:
+        case VM_FLOAT_JUMPZ:
+        case VM_VEC2_JUMPEM:
+        case VM_VEC3_JUMPEM:
+        case VM_VEC4_JUMPEM:
+        case VM_MAT2_JUMPEM:
+        case VM_MAT3_JUMPEM:
+        case VM_MAT4_JUMPEM:
+            return 1;
+        default:
+            return 0;
     }
+}
 
-    if (vm->pc >= length) {
-        rendervm_reset(vm);
-        return 0;
+// Stacks tracked by the verifier and the checked interpreter.
+#define VM_S_CTRL   0
+#define VM_S_UINT8  1
+#define VM_S_UINT16 2
+#define VM_S_UINT32 3
+#define VM_S_FLOAT  4
+#define VM_S_VEC2   5
+#define VM_S_VEC3   6
+#define VM_S_VEC4   7
+#define VM_S_MAT2   8
+#define VM_S_MAT3   9
+#define VM_S_MAT4   10
+#define VM_S__COUNT 11
+
+// Floats per entry of each stack, one for the scalar stacks.
+const uint8_t stack_stride[VM_S__COUNT] = {1, 1, 1, 1, 1, 2, 4, 4, 8, 12, 16};
+
+typedef struct rendervm_vector_type {
+    uint8_t first;
+    uint8_t last;
+    uint8_t stack;
+    uint8_t cols;
+    uint8_t rows;
+} rendervm_vector_type_t;
+
+// Opcode ranges of the vector and matrix types. Each range starts with
+// POP, DUP, SWAP, JUMPEM, STORE, LOAD, ADD, SUB, MUL and EQ in that order.
+const rendervm_vector_type_t vector_types[] = {
+    {VM_VEC2_POP, VM_VEC2_MULMAT4, VM_S_VEC2, 1, 2},
+    {VM_VEC3_POP, VM_VEC3_MULMAT4, VM_S_VEC3, 1, 3},
+    {VM_VEC4_POP, VM_VEC4_MULMAT4, VM_S_VEC4, 1, 4},
+    {VM_MAT2_POP, VM_MAT2_TRANSP, VM_S_MAT2, 2, 2},
+    {VM_MAT3_POP, VM_MAT3_TRANSP, VM_S_MAT3, 3, 3},
+    {VM_MAT4_POP, VM_MAT4_TRANSP, VM_S_MAT4, 4, 4}
+};
+
+#define VM_VECTOR_POP       0
+#define VM_VECTOR_DUP       1
+#define VM_VECTOR_SWAP      2
+#define VM_VECTOR_JUMPEM    3
+#define VM_VECTOR_STORE     4
+#define VM_VECTOR_LOAD      5
+#define VM_VECTOR_ADD       6
+#define VM_VECTOR_SUB       7
+#define VM_VECTOR_MUL       8
+#define VM_VECTOR_EQ        9
+
+const rendervm_vector_type_t* rendervm_vector_type(uint8_t opcode) {
+    uint8_t i;
+    for (i = 0; i < (sizeof(vector_types) / sizeof(vector_types[0])); i++) {
+        if (opcode >= vector_types[i].first && opcode <= vector_types[i].last) {
+            return &vector_types[i];
+        }
     }
+    return NULL;
+}
 
-    opcode = NCODE(vm);
+typedef struct rendervm_stack_effect {
+    uint16_t pop[VM_S__COUNT];
+    uint16_t push[VM_S__COUNT];
+} rendervm_stack_effect_t;
+
+void rendervm_vector_stack_effect(const rendervm_vector_type_t* type, uint8_t opcode, uint8_t n, rendervm_stack_effect_t* effect) {
+    uint8_t s = type->stack;
+
+    switch (opcode - type->first) {
+        case VM_VECTOR_POP:
+            effect->pop[s] = n;
+            return;
+        case VM_VECTOR_DUP:
+            effect->pop[s] = n;
+            effect->push[s] = n * 2;
+            return;
+        case VM_VECTOR_SWAP:
+            effect->pop[s] = 2;
+            effect->push[s] = 2;
+            return;
+        case VM_VECTOR_JUMPEM:
+            return;
+        case VM_VECTOR_STORE:
+            effect->pop[s] = 1;
+            effect->pop[VM_S_UINT16] = 1;
+            return;
+        case VM_VECTOR_LOAD:
+            effect->pop[VM_S_UINT16] = 1;
+            effect->push[s] = 1;
+            return;
+        case VM_VECTOR_ADD:
+        case VM_VECTOR_SUB:
+        case VM_VECTOR_MUL:
+            effect->pop[s] = 2;
+            effect->push[s] = 1;
+            return;
+        case VM_VECTOR_EQ:
+            effect->pop[s] = 2;
+            effect->push[VM_S_UINT8] = 1;
+            return;
+    }
 
     switch (opcode) {
-        case VM_HALT:
-            vm->pc = 0;
-            vm->running = 0;
+        case VM_VEC2_EXPLODE:
+        case VM_VEC3_EXPLODE:
+        case VM_VEC4_EXPLODE:
+        case VM_MAT2_EXPLODE:
+        case VM_MAT3_EXPLODE:
+        case VM_MAT4_EXPLODE:
+            effect->pop[s] = 1;
+            effect->push[VM_S_FLOAT] = type->cols * type->rows;
             break;
-        case VM_YIELD:
-            vm->running = 0;
+        case VM_VEC2_IMPLODE:
+        case VM_VEC3_IMPLODE:
+        case VM_VEC4_IMPLODE:
+        case VM_MAT2_IMPLODE:
+        case VM_MAT3_IMPLODE:
+        case VM_MAT4_IMPLODE:
+            effect->pop[VM_S_FLOAT] = type->cols * type->rows;
+            effect->push[s] = 1;
+            break;
+        case VM_VEC2_MULMAT2:
+        case VM_VEC2_MULMAT3:
+        case VM_VEC2_MULMAT4:
+        case VM_VEC3_MULMAT3:
+        case VM_VEC3_MULMAT4:
+        case VM_VEC4_MULMAT4:
+            effect->pop[s] = 1;
+            effect->push[s] = 1;
+            effect->pop[(opcode == VM_VEC2_MULMAT2) ? VM_S_MAT2 : (opcode == VM_VEC2_MULMAT3 || opcode == VM_VEC3_MULMAT3) ? VM_S_MAT3 : VM_S_MAT4] = 1;
+            break;
+        case VM_MAT2_IDENT:
+        case VM_MAT3_IDENT:
+        case VM_MAT4_IDENT:
+            effect->push[s] = 1;
+            break;
+        case VM_MAT2_ROTATE:
+        case VM_MAT3_ROTATE:
+        case VM_MAT4_ROTATEX:
+        case VM_MAT4_ROTATEY:
+        case VM_MAT4_ROTATEZ:
+            effect->pop[VM_S_FLOAT] = 1;
+            effect->pop[s] = 1;
+            effect->push[s] = 1;
             break;
+        case VM_MAT2_SCALE:
+        case VM_MAT3_SCALE:
+        case VM_MAT3_TRANSL:
+        case VM_MAT4_SCALE:
+        case VM_MAT4_TRANSL:
+            effect->pop[(s == VM_S_MAT4) ? VM_S_VEC3 : VM_S_VEC2] = 1;
+            effect->pop[s] = 1;
+            effect->push[s] = 1;
+            break;
+        case VM_MAT2_TRANSP:
+        case VM_MAT3_TRANSP:
+        case VM_MAT4_TRANSP:
+            effect->pop[s] = 1;
+            effect->push[s] = 1;
+            break;
+    }
+}
+
+// Fills in how many entries an opcode pops from and pushes to each stack.
+// Returns 0 for undefined opcodes, which makes a program unverifiable.
+// Callback opcodes are assumed to leave the stacks alone.
+uint8_t rendervm_stack_effect(uint8_t opcode, uint8_t n, rendervm_stack_effect_t* effect) {
+    const rendervm_vector_type_t* type;
+
+    memset(effect, 0, sizeof(rendervm_stack_effect_t));
+    switch (opcode) {
+        case VM_HALT:
+        case VM_YIELD:
         case VM_RESET:
-            rendervm_reset(vm);
+        case VM_JUMP:
+        case VM_UINT8_JUMPEM:
+        case VM_UINT16_JUMPEM:
+        case VM_UINT32_JUMPEM:
+        case VM_FLOAT_JUMPEM:
             break;
         case VM_CALL:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            u160 = UINT16_MAKE(vm);
-            CTRL_PUSH(vm, vm->pc);
-            vm->pc = u160;
+            effect->push[VM_S_CTRL] = 1;
             break;
         case VM_RETURN:
-            vm->pc = CTRL_POP(vm);
-            break;
-        case VM_JUMP:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            u160 = UINT16_MAKE(vm);
-            vm->pc = u160;
+            effect->pop[VM_S_CTRL] = 1;
             break;
         case VM_UINT8_POP:
-            u80 = NCODE(vm);
-            for (u81 = 0; u81 < u80; u81++) {
-                u82 = UINT8_POP(vm);
-            }
+            effect->pop[VM_S_UINT8] = n;
             break;
         case VM_UINT8_DUP:
-            u80 = NCODE(vm);
-            u81 = vm->uint8_sp;
-            for (u82 = u80; u82 > 0; u82--) {
-                u83 = UINT8_PEEK(vm, (u81 - (u82 - 1)));
-                UINT8_PUSH(vm, u83);
-            }
+            effect->pop[VM_S_UINT8] = n;
+            effect->push[VM_S_UINT8] = n * 2;
             break;
         case VM_UINT8_SWAP:
-            u80 = UINT8_POP(vm);
-            u81 = UINT8_POP(vm);
-            UINT8_PUSH(vm, u80);
-            UINT8_PUSH(vm, u81);
-            break;
-        case VM_UINT8_JUMPEM:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (vm->uint8_sp == VM_MAX_ADDR) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_UINT8] = 2;
+            effect->push[VM_S_UINT8] = 2;
             break;
         case VM_UINT8_STORE:
-            u80 = UINT8_POP(vm);
-            u160 = UINT16_POP(vm);
-            if (u160 >= vm->uint8_memory_size) {
-                rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
-                break;
-            }
-            vm->uint8_memory[u160] = u80;
+            effect->pop[VM_S_UINT8] = 1;
+            effect->pop[VM_S_UINT16] = 1;
             break;
         case VM_UINT8_LOAD:
-            if (vm->flags & MEMORY_ATTACH_UINT8) {
-                u160 = UINT16_POP(vm);
-                u80 = vm->uint8_memory[u160];
-                UINT8_PUSH(vm, u80);
-            }
-            // else raise exception
+            effect->pop[VM_S_UINT16] = 1;
+            effect->push[VM_S_UINT8] = 1;
             break;
         case VM_UINT8_ADD:
-            u80 = UINT8_POP(vm);
-            u81 = UINT8_POP(vm);
-            UINT8_PUSH(vm, (u81 + u80));
-            break;
         case VM_UINT8_SUB:
-            u80 = UINT8_POP(vm);
-            u81 = UINT8_POP(vm);
-            UINT8_PUSH(vm, (u81 - u80));
-            break;
         case VM_UINT8_MUL:
-            u80 = UINT8_POP(vm);
-            u81 = UINT8_POP(vm);
-            UINT8_PUSH(vm, (u81 * u80));
-            break;
         case VM_UINT8_EQ:
-            u80 = UINT8_POP(vm);
-            u81 = UINT8_POP(vm);
-            UINT8_PUSH(vm, (u81 == u80 ? 1 : 0));
+            effect->pop[VM_S_UINT8] = 2;
+            effect->push[VM_S_UINT8] = 1;
             break;
         case VM_UINT8_ADDN:
-            u80 = NCODE(vm);
-            vm->uint8_stack[vm->uint8_sp] += u80;
+            effect->pop[VM_S_UINT8] = 1;
+            effect->push[VM_S_UINT8] = 1;
             break;
         case VM_UINT8_JUMPNZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT8_POP(vm)) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
-            break;
         case VM_UINT8_JUMPZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT8_POP(vm) == 0) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_UINT8] = 1;
             break;
         case VM_UINT8_PUSH:
-            u80 = NCODE(vm);
-            UINT8_PUSH(vm, u80);
+            effect->push[VM_S_UINT8] = 1;
             break;
         case VM_UINT16_POP:
-            u80 = NCODE(vm);
-            for (u81 = 0; u81 < u80; u81++) {
-                u160 = UINT16_POP(vm);
-            }
+            effect->pop[VM_S_UINT16] = n;
             break;
         case VM_UINT16_DUP:
-            u80 = NCODE(vm);
-            u81 = vm->uint16_sp;
-            for (u82 = u80; u82 > 0; u82--) {
-                u160 = UINT16_PEEK(vm, (u81 - (u82 - 1)));
-                UINT16_PUSH(vm, u160);
-            }
+            effect->pop[VM_S_UINT16] = n;
+            effect->push[VM_S_UINT16] = n * 2;
             break;
         case VM_UINT16_SWAP:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            UINT16_PUSH(vm, u160);
-            UINT16_PUSH(vm, u161);
-            break;
-        case VM_UINT16_JUMPEM:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (vm->uint16_sp == VM_MAX_ADDR) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
-            break;
         case VM_UINT16_STORE:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            if (u161 >= vm->uint16_memory_size) {
-                rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
-                break;
-            }
-            vm->uint16_memory[u161] = u160;
+            effect->pop[VM_S_UINT16] = 2;
+            effect->push[VM_S_UINT16] = (opcode == VM_UINT16_SWAP) ? 2 : 0;
             break;
         case VM_UINT16_LOAD:
-            if (vm->flags & MEMORY_ATTACH_UINT16) {
-                u160 = UINT16_POP(vm);
-                u161 = vm->uint16_memory[u160];
-                UINT16_PUSH(vm, u161);
-            }
+        case VM_UINT16_ADDN:
+            effect->pop[VM_S_UINT16] = 1;
+            effect->push[VM_S_UINT16] = 1;
             break;
         case VM_UINT16_ADD:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            UINT16_PUSH(vm, (u161 + u160));
-            break;
         case VM_UINT16_SUB:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            UINT16_PUSH(vm, (u161 - u160));
-            break;
         case VM_UINT16_MUL:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            UINT16_PUSH(vm, (u161 * u160));
-            break;
         case VM_UINT16_EQ:
-            u160 = UINT16_POP(vm);
-            u161 = UINT16_POP(vm);
-            UINT16_PUSH(vm, (u161 == u160 ? 1 : 0));
-            break;
-        case VM_UINT16_ADDN:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            u160 = UINT16_MAKE(vm);
-            vm->uint16_stack[vm->uint16_sp] += u160;
+            effect->pop[VM_S_UINT16] = 2;
+            effect->push[VM_S_UINT16] = 1;
             break;
         case VM_UINT16_JUMPNZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT16_POP(vm)) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
-            break;
         case VM_UINT16_JUMPZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT16_POP(vm) == 0) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_UINT16] = 1;
             break;
         case VM_UINT16_MOVE_UINT8:
-            UINT16_PUSH(vm, UINT8_POP(vm));
+            effect->pop[VM_S_UINT8] = 1;
+            effect->push[VM_S_UINT16] = 1;
             break;
         case VM_UINT16_PUSH:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            u160 = UINT16_MAKE(vm);
-            UINT16_PUSH(vm, u160);
+            effect->push[VM_S_UINT16] = 1;
             break;
         case VM_UINT32_POP:
-            u80 = NCODE(vm);
-            for (u81 = 0; u81 < u80; u81++) {
-                u320 = UINT32_POP(vm);
-            }
+            effect->pop[VM_S_UINT32] = n;
             break;
         case VM_UINT32_DUP:
-            u80 = NCODE(vm);
-            u81 = vm->uint32_sp;
-            for (u82 = u80; u82 > 0; u82--) {
-                u320 = UINT32_PEEK(vm, (u81 - (u82 - 1)));
-                UINT32_PUSH(vm, u320);
-            }
+            effect->pop[VM_S_UINT32] = n;
+            effect->push[VM_S_UINT32] = n * 2;
             break;
         case VM_UINT32_SWAP:
-            u320 = UINT32_POP(vm);
-            u321 = UINT32_POP(vm);
-            UINT32_PUSH(vm, u320);
-            UINT32_PUSH(vm, u321);
-            break;
-        case VM_UINT32_JUMPEM:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (vm->uint32_sp == VM_MAX_ADDR) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_UINT32] = 2;
+            effect->push[VM_S_UINT32] = 2;
             break;
         case VM_UINT32_STORE:
-            u320 = UINT32_POP(vm);
-            u161 = UINT16_POP(vm);
-            if (u161 >= vm->uint32_memory_size) {
-                rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
-                break;
-            }
-            vm->uint32_memory[u161] = u320;
+            effect->pop[VM_S_UINT32] = 1;
+            effect->pop[VM_S_UINT16] = 1;
             break;
         case VM_UINT32_LOAD:
-            if (vm->flags & MEMORY_ATTACH_UINT32) {
-                u160 = UINT16_POP(vm);
-                u320 = vm->uint32_memory[u160];
-                UINT32_PUSH(vm, u320);
-            }
+            effect->pop[VM_S_UINT16] = 1;
+            effect->push[VM_S_UINT32] = 1;
             break;
         case VM_UINT32_ADD:
-            u320 = UINT32_POP(vm);
-            u321 = UINT32_POP(vm);
-            UINT32_PUSH(vm, (u321 + u320));
-            break;
         case VM_UINT32_SUB:
-            u320 = UINT32_POP(vm);
-            u321 = UINT32_POP(vm);
-            UINT32_PUSH(vm, (u321 - u320));
-            break;
         case VM_UINT32_MUL:
-            u320 = UINT32_POP(vm);
-            u321 = UINT32_POP(vm);
-            UINT32_PUSH(vm, (u321 * u320));
-            break;
         case VM_UINT32_EQ:
-            u320 = UINT32_POP(vm);
-            u321 = UINT32_POP(vm);
-            UINT32_PUSH(vm, (u321 == u320 ? 1 : 0));
+            effect->pop[VM_S_UINT32] = 2;
+            effect->push[VM_S_UINT32] = 1;
             break;
         case VM_UINT32_ADDN:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            vm->b2 = NCODE(vm);
-            vm->b3 = NCODE(vm);
-            u320 = UINT32_MAKE(vm);
-            vm->uint32_stack[vm->uint32_sp] += u320;
+            effect->pop[VM_S_UINT32] = 1;
+            effect->push[VM_S_UINT32] = 1;
             break;
         case VM_UINT32_JUMPNZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT32_POP(vm)) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
-            break;
         case VM_UINT32_JUMPZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (UINT32_POP(vm) == 0) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+        case VM_UINT32_REG_SET:
+            effect->pop[VM_S_UINT32] = 1;
             break;
         case VM_UINT32_MOVE_UINT8:
-            UINT32_PUSH(vm, UINT8_POP(vm));
-            vm->running = 0;
+            effect->pop[VM_S_UINT8] = 1;
+            effect->push[VM_S_UINT32] = 1;
             break;
         case VM_UINT32_PUSH:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            vm->b2 = NCODE(vm);
-            vm->b3 = NCODE(vm);
-            u320 = UINT32_MAKE(vm);
-            UINT32_PUSH(vm, u320);
-            break;
         case VM_UINT32_REG_GET:
-            u80 = NCODE(vm);
-            if (u80 > 9) break;
-            UINT32_PUSH(vm, vm->draw_reg[u80]);
-            break;
-        case VM_UINT32_REG_SET:
-            u80 = NCODE(vm);
-            if (u80 > 9) break;
-            vm->draw_reg[u80] = UINT32_POP(vm);
+            effect->push[VM_S_UINT32] = 1;
             break;
         case VM_FLOAT_POP:
-            u80 = NCODE(vm);
-            for (u81 = 0; u81 < u80; u81++) {
-                fl0 = FLOAT_POP(vm);
-            }
+            effect->pop[VM_S_FLOAT] = n;
             break;
         case VM_FLOAT_DUP:
-            u80 = NCODE(vm);
-            u81 = vm->float_sp;
-            for (u82 = u80; u82 > 0; u82--) {
-                fl0 = FLOAT_PEEK(vm, (u81 - (u82 - 1)));
-                FLOAT_PUSH(vm, fl0);
-            }
+            effect->pop[VM_S_FLOAT] = n;
+            effect->push[VM_S_FLOAT] = n * 2;
             break;
         case VM_FLOAT_SWAP:
-            fl0 = FLOAT_POP(vm);
-            fl1 = FLOAT_POP(vm);
-            FLOAT_PUSH(vm, fl0);
-            FLOAT_PUSH(vm, fl1);
-            break;
-        case VM_FLOAT_JUMPEM:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (vm->float_sp == VM_MAX_ADDR) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_FLOAT] = 2;
+            effect->push[VM_S_FLOAT] = 2;
             break;
         case VM_FLOAT_STORE:
-            fl0 = FLOAT_POP(vm);
-            u161 = UINT16_POP(vm);
-            if (u161 >= vm->float_memory_size) {
-                rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
-                break;
-            }
-            vm->float_memory[u161] = fl0;
+            effect->pop[VM_S_FLOAT] = 1;
+            effect->pop[VM_S_UINT16] = 1;
             break;
         case VM_FLOAT_LOAD:
-            if (vm->flags & MEMORY_ATTACH_FLOAT) {
-                u160 = UINT16_POP(vm);
-                if (u160 > vm->float_memory_size) {
-                    printf("FLOAT_LOAD: address exceeds size");
-                    vm->running = 0;
-                    break;
-                }
-                fl0 = vm->float_memory[u160];
-                FLOAT_PUSH(vm, fl0);
-            }
+            effect->pop[VM_S_UINT16] = 1;
+            effect->push[VM_S_FLOAT] = 1;
             break;
         case VM_FLOAT_ADD:
-            fl0 = FLOAT_POP(vm);
-            fl1 = FLOAT_POP(vm);
-            FLOAT_PUSH(vm, (fl1 + fl0));
-            break;
         case VM_FLOAT_SUB:
-            fl0 = FLOAT_POP(vm);
-            fl1 = FLOAT_POP(vm);
-            FLOAT_PUSH(vm, (fl1 - fl0));
-            break;
         case VM_FLOAT_MUL:
-            fl0 = FLOAT_POP(vm);
-            fl1 = FLOAT_POP(vm);
-            FLOAT_PUSH(vm, (fl1 * fl0));
-            break;
         case VM_FLOAT_EQ:
-            fl0 = FLOAT_POP(vm);
-            fl1 = FLOAT_POP(vm);
-            FLOAT_PUSH(vm, (fl1 == fl0 ? 1 : 0));
+            effect->pop[VM_S_FLOAT] = 2;
+            effect->push[VM_S_FLOAT] = 1;
             break;
         case VM_FLOAT_ADDN:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            vm->b2 = NCODE(vm);
-            vm->b3 = NCODE(vm);
-            fl0 = FLOAT_MAKE(vm);
-            vm->float_stack[vm->float_sp] += fl0;
+            effect->pop[VM_S_FLOAT] = 1;
+            effect->push[VM_S_FLOAT] = 1;
             break;
         case VM_FLOAT_JUMPNZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (FLOAT_POP(vm)) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
-            break;
         case VM_FLOAT_JUMPZ:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            if (FLOAT_POP(vm) == 0.0f) {
-                u160 = UINT16_MAKE(vm);
-                vm->pc = u160;
-            }
+            effect->pop[VM_S_FLOAT] = 1;
             break;
         case VM_FLOAT_PUSH:
-            vm->b0 = NCODE(vm);
-            vm->b1 = NCODE(vm);
-            vm->b2 = NCODE(vm);
-            vm->b3 = NCODE(vm);
-            fl0 = FLOAT_MAKE(vm);
-            FLOAT_PUSH(vm, fl0);
+            effect->push[VM_S_FLOAT] = 1;
             break;
-        case VM_VEC2_POP:
-            u80 = NCODE(vm);
-            for (u81 = 0; u81 < u80; u81++) {
-                vm->vec2_sp -= 2;
+        default:
+            type = rendervm_vector_type(opcode);
+            if (type) {
+                rendervm_vector_stack_effect(type, opcode, n, effect);
             }
+            else if (opcode < VM__CALLBACK) {
+                return 0;
+            }
+            // Callbacks work on the draw registers.
             break;
-        case VM_VEC2_DUP:
-            u80 = NCODE(vm);
-            u80 = u80 * 2;
-            if (u80 > 128) {
-                // exception
-                vm->running = 0;
+    }
+    return 1;
+}
+
+// Stack depth from a stack pointer, where VM_MAX_ADDR means empty.
+#define STACK_DEPTH(sp) ((uint8_t)((sp) + 1))
+
+uint8_t rendervm_check(rendervm_t* vm, uint8_t* program, uint16_t length, uint8_t opcode) {
+    rendervm_stack_effect_t effect;
+    uint16_t depth[VM_S__COUNT];
+    uint8_t oplen;
+    uint8_t i;
+
+    oplen = rendervm_operand_length(opcode);
+    if ((vm->pc + oplen) > length) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return 0;
+    }
+
+    if (!rendervm_stack_effect(opcode, oplen ? program[vm->pc] : 0, &effect)) {
+        rendervm_exception(vm, VM_X_INV_OPCODE);
+        return 0;
+    }
+
+    depth[VM_S_CTRL] = STACK_DEPTH(vm->ctrl_sp);
+    depth[VM_S_UINT8] = STACK_DEPTH(vm->uint8_sp);
+    depth[VM_S_UINT16] = STACK_DEPTH(vm->uint16_sp);
+    depth[VM_S_UINT32] = STACK_DEPTH(vm->uint32_sp);
+    depth[VM_S_FLOAT] = STACK_DEPTH(vm->float_sp);
+    depth[VM_S_VEC2] = STACK_DEPTH(vm->vec2_sp) / stack_stride[VM_S_VEC2];
+    depth[VM_S_VEC3] = STACK_DEPTH(vm->vec3_sp) / stack_stride[VM_S_VEC3];
+    depth[VM_S_VEC4] = STACK_DEPTH(vm->vec4_sp) / stack_stride[VM_S_VEC4];
+    depth[VM_S_MAT2] = STACK_DEPTH(vm->mat2_sp) / stack_stride[VM_S_MAT2];
+    depth[VM_S_MAT3] = STACK_DEPTH(vm->mat3_sp) / stack_stride[VM_S_MAT3];
+    depth[VM_S_MAT4] = STACK_DEPTH(vm->mat4_sp) / stack_stride[VM_S_MAT4];
+
+    for (i = 0; i < VM_S__COUNT; i++) {
+        if (depth[i] < effect.pop[i]) {
+            rendervm_exception(vm, VM_X_STACK_UNDERFLOW);
+            return 0;
+        }
+        if ((depth[i] - effect.pop[i] + effect.push[i]) > (VM_MAX_ADDR / stack_stride[i])) {
+            rendervm_exception(vm, VM_X_STACK_OVERFLOW);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+typedef struct rendervm_verify_state {
+    uint8_t visited;
+    uint8_t depth[VM_S__COUNT];
+} rendervm_verify_state_t;
+
+uint8_t rendervm_verify_fail(rendervm_verify_t* result, rendervm_verify_error_t error, uint16_t pc, uint8_t opcode) {
+    result->error = error;
+    result->pc = pc;
+    result->opcode = opcode;
+    return 0;
+}
+
+// Propagates the stack depths after an instruction to one of its successors.
+// Returns 0 if the successor was already reached with different depths.
+uint8_t rendervm_verify_merge(rendervm_verify_state_t* states, uint16_t* worklist, uint16_t* worklist_size, uint16_t length, uint16_t pc, uint8_t* depth) {
+    rendervm_verify_state_t* state;
+
+    // Running off the end resets the VM.
+    if (pc >= length) {
+        return 1;
+    }
+
+    state = &states[pc];
+    if (state->visited) {
+        return memcmp(state->depth, depth, VM_S__COUNT) ? 0 : 1;
+    }
+
+    state->visited = 1;
+    memcpy(state->depth, depth, VM_S__COUNT);
+    worklist[(*worklist_size)++] = pc;
+    return 1;
+}
+
+uint8_t rendervm_verify(uint8_t* program, uint16_t length, rendervm_verify_t* result) {
+    rendervm_verify_state_t* states;
+    rendervm_stack_effect_t effect;
+    uint16_t* worklist;
+    uint16_t worklist_size = 0;
+    uint16_t* returns;
+    uint16_t nr_returns = 0;
+    uint8_t* boundary;
+    uint8_t depth[VM_S__COUNT];
+    uint8_t empty[VM_S__COUNT];
+    uint8_t opcode, oplen, n, ok;
+    uint16_t pc, next_pc, target;
+    uint16_t i;
+    int32_t d;
+
+    memset(result, 0, sizeof(rendervm_verify_t));
+    memset(empty, 0, VM_S__COUNT);
+
+    boundary = malloc(length + 1);
+    memset(boundary, 0, length + 1);
+    returns = malloc(sizeof(uint16_t) * (length + 1));
+    worklist = malloc(sizeof(uint16_t) * (length + 1));
+    states = malloc(sizeof(rendervm_verify_state_t) * (length + 1));
+    memset(states, 0, sizeof(rendervm_verify_state_t) * (length + 1));
+
+    ok = 1;
+
+    // First pass: instruction boundaries, operands and call return sites.
+    pc = 0;
+    while (ok && (pc < length)) {
+        opcode = program[pc];
+        oplen = rendervm_operand_length(opcode);
+        if ((pc + 1 + oplen) > length) {
+            ok = rendervm_verify_fail(result, VM_V_TRUNCATED, pc, opcode);
+            break;
+        }
+        if ((opcode == VM_UINT32_REG_GET || opcode == VM_UINT32_REG_SET) && (program[pc + 1] > 9)) {
+            ok = rendervm_verify_fail(result, VM_V_BAD_REGISTER, pc, opcode);
+            break;
+        }
+        boundary[pc] = 1;
+        if (opcode == VM_CALL) {
+            returns[nr_returns++] = pc + 1 + oplen;
+        }
+        pc += 1 + oplen;
+    }
+
+    // Second pass: every static jump lands on an instruction or past the end.
+    pc = 0;
+    while (ok && (pc < length)) {
+        opcode = program[pc];
+        oplen = rendervm_operand_length(opcode);
+        if (rendervm_opcode_is_branch(opcode)) {
+            target = ((program[pc + 2] << 8) | program[pc + 1]);
+            if ((target < length) && !boundary[target]) {
+                ok = rendervm_verify_fail(result, VM_V_BAD_TARGET, pc, opcode);
                 break;
             }
-            u81 = vm->vec2_sp;
-            for (u82 = u80; u82 > 0; u82--) {
-                fl0 = VEC2_PEEK(vm, (u81 - (u82 - 1)));
-                VEC2_PUSH(vm, fl0);
+        }
+        pc += 1 + oplen;
+    }
+
+    // Third pass: stack depths along every path from the entry point, which
+    // starts with all stacks empty.
+    if (ok && (length > 0)) {
+        rendervm_verify_merge(states, worklist, &worklist_size, length, 0, empty);
+    }
+    while (ok && worklist_size) {
+        pc = worklist[--worklist_size];
+        opcode = program[pc];
+        oplen = rendervm_operand_length(opcode);
+        n = oplen ? program[pc + 1] : 0;
+        next_pc = pc + 1 + oplen;
+        target = (oplen >= 2) ? ((program[pc + 2] << 8) | program[pc + 1]) : 0;
+
+        if (!rendervm_stack_effect(opcode, n, &effect)) {
+            ok = rendervm_verify_fail(result, VM_V_UNVERIFIABLE, pc, opcode);
+            break;
+        }
+
+        for (i = 0; i < VM_S__COUNT; i++) {
+            d = states[pc].depth[i];
+            if (d < effect.pop[i]) {
+                ok = rendervm_verify_fail(result, VM_V_STACK_UNDERFLOW, pc, opcode);
+                break;
+            }
+            d = d - effect.pop[i] + effect.push[i];
+            if (d > (VM_MAX_ADDR / stack_stride[i])) {
+                ok = rendervm_verify_fail(result, VM_V_STACK_OVERFLOW, pc, opcode);
+                break;
             }
+            depth[i] = d;
+        }
+        if (!ok) {
             break;
-        case VM_VEC2_SWAP:
-            printf("VEC2_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
+        }
+
+        switch (opcode) {
+            case VM_HALT:
+                // The next run starts again at the top with whatever is
+                // left on the stacks.
+                ok = rendervm_verify_merge(states, worklist, &worklist_size, length, 0, depth);
+                break;
+            case VM_RESET:
+                break;
+            case VM_CALL:
+            case VM_JUMP:
+                ok = rendervm_verify_merge(states, worklist, &worklist_size, length, target, depth);
+                break;
+            case VM_RETURN:
+                for (i = 0; ok && (i < nr_returns); i++) {
+                    ok = rendervm_verify_merge(states, worklist, &worklist_size, length, returns[i], depth);
+                }
+                break;
+            case VM_UINT8_JUMPEM:
+            case VM_UINT16_JUMPEM:
+            case VM_UINT32_JUMPEM:
+            case VM_FLOAT_JUMPEM:
+            case VM_VEC2_JUMPEM:
+            case VM_VEC3_JUMPEM:
+            case VM_VEC4_JUMPEM:
+            case VM_MAT2_JUMPEM:
+            case VM_MAT3_JUMPEM:
+            case VM_MAT4_JUMPEM:
+                // Stack depths are known here, so only one way is taken.
+                i = (opcode == VM_UINT8_JUMPEM) ? VM_S_UINT8 : (opcode == VM_UINT16_JUMPEM) ? VM_S_UINT16 : (opcode == VM_UINT32_JUMPEM) ? VM_S_UINT32 : (opcode == VM_FLOAT_JUMPEM) ? VM_S_FLOAT : rendervm_vector_type(opcode)->stack;
+                ok = rendervm_verify_merge(states, worklist, &worklist_size, length, depth[i] ? next_pc : target, depth);
+                break;
+            default:
+                if (rendervm_opcode_is_branch(opcode)) {
+                    ok = rendervm_verify_merge(states, worklist, &worklist_size, length, target, depth);
+                }
+                if (ok) {
+                    ok = rendervm_verify_merge(states, worklist, &worklist_size, length, next_pc, depth);
+                }
+                break;
+        }
+        if (!ok) {
+            rendervm_verify_fail(result, VM_V_STACK_MISMATCH, pc, opcode);
+        }
+    }
+
+    free(states);
+    free(worklist);
+    free(returns);
+    free(boundary);
+
+    return ok;
+}
+
+const char* rendervm_verify_error2str(rendervm_verify_error_t error) {
+    switch (error) {
+        case VM_V_OK:
+            return "ok";
+        case VM_V_TRUNCATED:
+            return "truncated operand";
+        case VM_V_BAD_TARGET:
+            return "jump into the middle of an instruction";
+        case VM_V_BAD_REGISTER:
+            return "register index out of range";
+        case VM_V_STACK_UNDERFLOW:
+            return "stack underflow";
+        case VM_V_STACK_OVERFLOW:
+            return "stack overflow";
+        case VM_V_STACK_MISMATCH:
+            return "stack depth differs between paths";
+        case VM_V_UNVERIFIABLE:
+            return "opcode can not be verified";
+    }
+    return "unknown";
+}
+
+typedef struct rendervm_vector_stack {
+    const rendervm_vector_type_t* type;
+    uint8_t stride;
+    uint8_t pitch;
+    float* stack;
+    uint8_t* sp;
+    float* memory;
+    uint32_t memory_size;
+} rendervm_vector_stack_t;
+
+void rendervm_vector_stack(rendervm_t* vm, uint8_t opcode, rendervm_vector_stack_t* vs) {
+    vs->type = rendervm_vector_type(opcode);
+    vs->stride = stack_stride[vs->type->stack];
+    vs->pitch = vs->stride / vs->type->cols;
+
+    switch (vs->type->stack) {
+        case VM_S_VEC2:
+            vs->stack = vm->vec2_stack;
+            vs->sp = &vm->vec2_sp;
+            vs->memory = vm->vec2_memory;
+            vs->memory_size = vm->vec2_memory_size;
+            break;
+        case VM_S_VEC3:
+            vs->stack = vm->vec3_stack;
+            vs->sp = &vm->vec3_sp;
+            vs->memory = vm->vec3_memory;
+            vs->memory_size = vm->vec3_memory_size;
+            break;
+        case VM_S_VEC4:
+            vs->stack = vm->vec4_stack;
+            vs->sp = &vm->vec4_sp;
+            vs->memory = vm->vec4_memory;
+            vs->memory_size = vm->vec4_memory_size;
+            break;
+        case VM_S_MAT2:
+            vs->stack = vm->mat2_stack;
+            vs->sp = &vm->mat2_sp;
+            vs->memory = vm->mat2_memory;
+            vs->memory_size = vm->mat2_memory_size;
+            break;
+        case VM_S_MAT3:
+            vs->stack = vm->mat3_stack;
+            vs->sp = &vm->mat3_sp;
+            vs->memory = vm->mat3_memory;
+            vs->memory_size = vm->mat3_memory_size;
             break;
-        case VM_VEC2_JUMPEM:
-            printf("VEC2_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
+        default:
+            vs->stack = vm->mat4_stack;
+            vs->sp = &vm->mat4_sp;
+            vs->memory = vm->mat4_memory;
+            vs->memory_size = vm->mat4_memory_size;
             break;
-        case VM_VEC2_STORE:
-            printf("VEC2_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
+    }
+}
+
+// Entry k places below the top of a vector stack, 0 being the top.
+float* rendervm_vector_peek(rendervm_vector_stack_t* vs, uint8_t k) {
+    return &vs->stack[(uint8_t)(*vs->sp + 1 - ((k + 1) * vs->stride))];
+}
+
+// The popped entry stays valid until the next push.
+float* rendervm_vector_pop(rendervm_vector_stack_t* vs) {
+    float* entry = rendervm_vector_peek(vs, 0);
+    *vs->sp -= vs->stride;
+    return entry;
+}
+
+float* rendervm_vector_push(rendervm_vector_stack_t* vs) {
+    *vs->sp += vs->stride;
+    return rendervm_vector_peek(vs, 0);
+}
+
+// Attached memory is packed, so every column is copied on its own and the
+// padding on the stack is kept at zero.
+void rendervm_vector_load(rendervm_vector_stack_t* vs, float* entry, uint16_t addr) {
+    float* mem = &vs->memory[(uint32_t)addr * vs->type->cols * vs->type->rows];
+    uint8_t c;
+
+    memset(entry, 0, vs->stride * sizeof(float));
+    for (c = 0; c < vs->type->cols; c++) {
+        memcpy(&entry[c * vs->pitch], &mem[c * vs->type->rows], vs->type->rows * sizeof(float));
+    }
+}
+
+void rendervm_vector_store(rendervm_vector_stack_t* vs, float* entry, uint16_t addr) {
+    float* mem = &vs->memory[(uint32_t)addr * vs->type->cols * vs->type->rows];
+    uint8_t c;
+
+    for (c = 0; c < vs->type->cols; c++) {
+        memcpy(&mem[c * vs->type->rows], &entry[c * vs->pitch], vs->type->rows * sizeof(float));
+    }
+}
+
+// v' = M * v, where vec2 and vec3 are extended to points with w = 1 when
+// the matrix is larger than the vector.
+void rendervm_vector_mulmat(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs, ms;
+    float in[4] __attribute__((aligned(16)));
+    float out[4] __attribute__((aligned(16)));
+    float* v;
+    float* m;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    rendervm_vector_stack(vm, (opcode == VM_VEC2_MULMAT2) ? VM_MAT2_POP : (opcode == VM_VEC2_MULMAT3 || opcode == VM_VEC3_MULMAT3) ? VM_MAT3_POP : VM_MAT4_POP, &ms);
+
+    v = rendervm_vector_pop(&vs);
+    m = rendervm_vector_pop(&ms);
+
+    memset(in, 0, sizeof(in));
+    memcpy(in, v, vs.type->rows * sizeof(float));
+    if (ms.type->cols > vs.type->rows) {
+        in[ms.type->cols - 1] = 1.0f;
+    }
+
+    rendervm_simd_mulvec(out, m, in, ms.type->cols);
+
+    v = rendervm_vector_push(&vs);
+    memset(v, 0, vs.stride * sizeof(float));
+    memcpy(v, out, vs.type->rows * sizeof(float));
+}
+
+// M' = M * T for the rotate, scale and translate opcodes.
+void rendervm_matrix_transform(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t ms, vs;
+    float t[16] __attribute__((aligned(16)));
+    float* v = NULL;
+    float* m;
+    float c = 1.0f, s = 0.0f;
+    uint8_t i;
+
+    rendervm_vector_stack(vm, opcode, &ms);
+
+    switch (opcode) {
+        case VM_MAT2_ROTATE:
+        case VM_MAT3_ROTATE:
+        case VM_MAT4_ROTATEX:
+        case VM_MAT4_ROTATEY:
+        case VM_MAT4_ROTATEZ:
+            s = FLOAT_POP(vm);
+            c = cosf(s);
+            s = sinf(s);
             break;
-        case VM_VEC2_LOAD:
-            if (vm->flags & MEMORY_ATTACH_VEC2) {
-            }
+        default:
+            rendervm_vector_stack(vm, (ms.type->stack == VM_S_MAT4) ? VM_VEC3_POP : VM_VEC2_POP, &vs);
+            v = rendervm_vector_pop(&vs);
             break;
-        case VM_VEC2_ADD:
-            printf("VEC2_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
+    }
+
+    memset(t, 0, sizeof(t));
+    for (i = 0; i < ms.type->cols; i++) {
+        t[i * 5] = 1.0f;
+    }
+
+    switch (opcode) {
+        case VM_MAT2_ROTATE:
+        case VM_MAT3_ROTATE:
+        case VM_MAT4_ROTATEZ:
+            t[0] = c;
+            t[1] = s;
+            t[4] = -s;
+            t[5] = c;
             break;
-        case VM_VEC2_SUB:
-            printf("VEC2_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
+        case VM_MAT4_ROTATEX:
+            t[5] = c;
+            t[6] = s;
+            t[9] = -s;
+            t[10] = c;
             break;
-        case VM_VEC2_MUL:
-            printf("VEC2_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
+        case VM_MAT4_ROTATEY:
+            t[0] = c;
+            t[2] = -s;
+            t[8] = s;
+            t[10] = c;
             break;
-        case VM_VEC2_EQ:
-            printf("VEC2_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
+        case VM_MAT2_SCALE:
+        case VM_MAT3_SCALE:
+        case VM_MAT4_SCALE:
+            for (i = 0; i < vs.type->rows; i++) {
+                t[i * 5] = v[i];
+            }
             break;
-        case VM_VEC2_EXPLODE:
-            printf("VEC2_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
+        case VM_MAT3_TRANSL:
+        case VM_MAT4_TRANSL:
+            for (i = 0; i < vs.type->rows; i++) {
+                t[(ms.type->cols - 1) * 4 + i] = v[i];
+            }
             break;
+    }
+
+    m = rendervm_vector_peek(&ms, 0);
+    rendervm_simd_mulmat(m, m, t, ms.type->cols);
+}
+
+// The vector and matrix opcodes other than JUMPEM, one function per kind of
+// opcode so the threaded code and the JIT can call them without decoding
+// the program again. n is the operand of POP and DUP, ignored otherwise.
+void rendervm_vector_op_pop(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    *vs.sp -= n * vs.stride;
+}
+
+void rendervm_vector_op_dup(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    uint16_t i;
+    uint8_t sp;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    sp = *vs.sp;
+    for (i = n * vs.stride; i > 0; i--) {
+        vs.stack[++(*vs.sp)] = vs.stack[(uint8_t)(sp - (i - 1))];
+    }
+}
+
+void rendervm_vector_op_swap(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float tmp[16] __attribute__((aligned(16)));
+    float* a;
+    float* b;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    a = rendervm_vector_peek(&vs, 0);
+    b = rendervm_vector_peek(&vs, 1);
+    memcpy(tmp, a, vs.stride * sizeof(float));
+    memcpy(a, b, vs.stride * sizeof(float));
+    memcpy(b, tmp, vs.stride * sizeof(float));
+}
+
+void rendervm_vector_op_store(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* v;
+    uint16_t addr;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    v = rendervm_vector_pop(&vs);
+    addr = UINT16_POP(vm);
+    if (addr >= vs.memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return;
+    }
+    rendervm_vector_store(&vs, v, addr);
+}
+
+void rendervm_vector_op_load(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    uint16_t addr;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    addr = UINT16_POP(vm);
+    if (addr >= vs.memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return;
+    }
+    rendervm_vector_load(&vs, rendervm_vector_push(&vs), addr);
+}
+
+void rendervm_vector_op_add(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* a;
+    float* b;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    a = rendervm_vector_pop(&vs);
+    b = rendervm_vector_pop(&vs);
+    rendervm_simd_add(rendervm_vector_push(&vs), b, a, vs.stride);
+}
+
+void rendervm_vector_op_sub(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* a;
+    float* b;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    a = rendervm_vector_pop(&vs);
+    b = rendervm_vector_pop(&vs);
+    rendervm_simd_sub(rendervm_vector_push(&vs), b, a, vs.stride);
+}
+
+// Vectors multiply component wise, matrices as matrices.
+void rendervm_vector_op_mul(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* a;
+    float* b;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    a = rendervm_vector_pop(&vs);
+    b = rendervm_vector_pop(&vs);
+    if (vs.type->cols > 1) {
+        rendervm_simd_mulmat(rendervm_vector_push(&vs), b, a, vs.type->cols);
+    }
+    else {
+        rendervm_simd_mul(rendervm_vector_push(&vs), b, a, vs.stride);
+    }
+}
+
+void rendervm_vector_op_eq(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* a;
+    float* b;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    a = rendervm_vector_pop(&vs);
+    b = rendervm_vector_pop(&vs);
+    UINT8_PUSH(vm, rendervm_simd_eq(b, a, vs.stride));
+}
+
+void rendervm_vector_op_explode(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* v;
+    uint8_t c, r;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    v = rendervm_vector_pop(&vs);
+    for (c = 0; c < vs.type->cols; c++) {
+        for (r = 0; r < vs.type->rows; r++) {
+            FLOAT_PUSH(vm, v[c * vs.pitch + r]);
+        }
+    }
+}
+
+void rendervm_vector_op_implode(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* v;
+    uint8_t c, r;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    v = rendervm_vector_push(&vs);
+    memset(v, 0, vs.stride * sizeof(float));
+    for (c = vs.type->cols; c > 0; c--) {
+        for (r = vs.type->rows; r > 0; r--) {
+            v[(c - 1) * vs.pitch + (r - 1)] = FLOAT_POP(vm);
+        }
+    }
+}
+
+void rendervm_matrix_op_ident(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+    float* m;
+    uint8_t c;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    m = rendervm_vector_push(&vs);
+    memset(m, 0, vs.stride * sizeof(float));
+    for (c = 0; c < vs.type->cols; c++) {
+        m[c * vs.pitch + c] = 1.0f;
+    }
+}
+
+void rendervm_matrix_op_transp(rendervm_t* vm, uint8_t opcode, uint8_t n) {
+    rendervm_vector_stack_t vs;
+
+    rendervm_vector_stack(vm, opcode, &vs);
+    rendervm_simd_transpose(rendervm_vector_peek(&vs, 0), vs.type->cols);
+}
+
+rendervm_vector_op_t rendervm_vector_op(uint8_t opcode) {
+    const rendervm_vector_type_t* type = rendervm_vector_type(opcode);
+
+    if (type == NULL) {
+        return NULL;
+    }
+
+    switch (opcode - type->first) {
+        case VM_VECTOR_POP:
+            return &rendervm_vector_op_pop;
+        case VM_VECTOR_DUP:
+            return &rendervm_vector_op_dup;
+        case VM_VECTOR_SWAP:
+            return &rendervm_vector_op_swap;
+        case VM_VECTOR_JUMPEM:
+            return NULL;
+        case VM_VECTOR_STORE:
+            return &rendervm_vector_op_store;
+        case VM_VECTOR_LOAD:
+            return &rendervm_vector_op_load;
+        case VM_VECTOR_ADD:
+            return &rendervm_vector_op_add;
+        case VM_VECTOR_SUB:
+            return &rendervm_vector_op_sub;
+        case VM_VECTOR_MUL:
+            return &rendervm_vector_op_mul;
+        case VM_VECTOR_EQ:
+            return &rendervm_vector_op_eq;
+    }
+
+    switch (opcode) {
+        case VM_VEC2_EXPLODE:
+        case VM_VEC3_EXPLODE:
+        case VM_VEC4_EXPLODE:
+        case VM_MAT2_EXPLODE:
+        case VM_MAT3_EXPLODE:
+        case VM_MAT4_EXPLODE:
+            return &rendervm_vector_op_explode;
         case VM_VEC2_IMPLODE:
-            printf("VEC2_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
+        case VM_VEC3_IMPLODE:
+        case VM_VEC4_IMPLODE:
+        case VM_MAT2_IMPLODE:
+        case VM_MAT3_IMPLODE:
+        case VM_MAT4_IMPLODE:
+            return &rendervm_vector_op_implode;
         case VM_VEC2_MULMAT2:
-            printf("VEC2_MULMAT2: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_VEC2_MULMAT3:
-            printf("VEC2_MULMAT3: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_VEC2_MULMAT4:
-            printf("VEC2_MULMAT4: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_POP:
-            printf("VEC3_POP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_DUP:
-            printf("VEC3_DUP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_SWAP:
-            printf("VEC3_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_JUMPEM:
-            printf("VEC3_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_STORE:
-            printf("VEC3_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_LOAD:
-            printf("VEC3_LOAD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_ADD:
-            printf("VEC3_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_SUB:
-            printf("VEC3_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_MUL:
-            printf("VEC3_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_EQ:
-            printf("VEC3_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_EXPLODE:
-            printf("VEC3_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC3_IMPLODE:
-            printf("VEC3_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_VEC3_MULMAT3:
-            printf("VEC3_MULMAT3: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_VEC3_MULMAT4:
-            printf("VEC3_MULMAT4: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_POP:
-            printf("VEC4_POP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_DUP:
-            printf("VEC4_DUP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_SWAP:
-            printf("VEC4_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_JUMPEM:
-            printf("VEC4_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_STORE:
-            printf("VEC4_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_LOAD:
-            printf("VEC4_LOAD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_ADD:
-            printf("VEC4_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_SUB:
-            printf("VEC4_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_MUL:
-            printf("VEC4_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_EQ:
-            printf("VEC4_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_EXPLODE:
-            printf("VEC4_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_VEC4_IMPLODE:
-            printf("VEC4_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_VEC4_MULMAT4:
-            printf("VEC4_MULMAT4: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_POP:
-            printf("MAT2_POP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_DUP:
-            printf("MAT2_DUP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_SWAP:
-            printf("MAT2_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_JUMPEM:
-            printf("MAT2_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_STORE:
-            printf("MAT2_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_LOAD:
-            printf("MAT2_LOAD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_ADD:
-            printf("MAT2_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_SUB:
-            printf("MAT2_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_MUL:
-            printf("MAT2_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_EQ:
-            printf("MAT2_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_EXPLODE:
-            printf("MAT2_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
+            return &rendervm_vector_mulmat;
         case VM_MAT2_IDENT:
-            printf("MAT2_IDENT: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_IMPLODE:
-            printf("MAT2_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_ROTATE:
-            printf("MAT2_ROTATE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_SCALE:
-            printf("MAT2_SCALE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT2_TRANSP:
-            printf("MAT2_TRANSP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_POP:
-            printf("MAT3_POP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_DUP:
-            printf("MAT3_DUP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_SWAP:
-            printf("MAT3_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_JUMPEM:
-            printf("MAT3_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_STORE:
-            printf("MAT3_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_LOAD:
-            printf("MAT3_LOAD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_ADD:
-            printf("MAT3_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_SUB:
-            printf("MAT3_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_MUL:
-            printf("MAT3_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_EQ:
-            printf("MAT3_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_EXPLODE:
-            printf("MAT3_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
         case VM_MAT3_IDENT:
-            printf("MAT3_IDENT: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_IMPLODE:
-            printf("MAT3_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_ROTATE:
-            printf("MAT3_ROTATE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_SCALE:
-            printf("MAT3_SCALE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT3_TRANSL:
-            printf("MAT3_TRANSL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
+        case VM_MAT4_IDENT:
+            return &rendervm_matrix_op_ident;
+        case VM_MAT2_TRANSP:
         case VM_MAT3_TRANSP:
-            printf("MAT3_TRANSP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_POP:
-            printf("MAT4_POP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_DUP:
-            printf("MAT4_DUP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_SWAP:
-            printf("MAT4_SWAP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_JUMPEM:
-            printf("MAT4_JUMPEM: UNIMPLEMENTED\n");
-            vm->running = 0;
+        case VM_MAT4_TRANSP:
+            return &rendervm_matrix_op_transp;
+        default:
+            return &rendervm_matrix_transform;
+    }
+}
+
+static inline void rendervm_profile_hit(rendervm_profile_t* profile, uint16_t pc, uint8_t opcode) {
+    if (pc < profile->length) {
+        profile->pc_hits[pc]++;
+        profile->opcode_count[opcode]++;
+        profile->cycles++;
+    }
+}
+
+uint8_t rendervm_run(rendervm_t* vm, uint8_t* program, uint16_t length, uint32_t budget) {
+    uint16_t opcode;
+    uint8_t u80, u81, u82, u83;
+    uint16_t u160, u161;
+    uint32_t u320, u321;
+    float fl0, fl1;
+    rendervm_vector_stack_t vs;
+    uint32_t executed = 0;
+
+    while (executed < budget) {
+        if (!vm->running) {
             break;
-        case VM_MAT4_STORE:
-            printf("MAT4_STORE: UNIMPLEMENTED\n");
-            vm->running = 0;
+        }
+
+        if (vm->pc >= length) {
+            rendervm_reset(vm);
+            vm->cycles += executed;
+            return 0;
+        }
+
+        if (vm->profile) {
+            rendervm_profile_hit(vm->profile, vm->pc, program[vm->pc]);
+        }
+
+        opcode = NCODE(vm);
+
+        if (vm->checked && !rendervm_check(vm, program, length, opcode)) {
             break;
-        case VM_MAT4_LOAD:
-            if (vm->flags & MEMORY_ATTACH_MAT4) {
+        }
+
+        switch (opcode) {
+            case VM_HALT:
+                vm->pc = 0;
+                vm->running = 0;
+                break;
+            case VM_YIELD:
+                vm->running = 0;
+                break;
+            case VM_RESET:
+                rendervm_reset(vm);
+                break;
+            case VM_CALL:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                u160 = UINT16_MAKE(vm);
+                CTRL_PUSH(vm, vm->pc);
+                vm->pc = u160;
+                break;
+            case VM_RETURN:
+                vm->pc = CTRL_POP(vm);
+                break;
+            case VM_JUMP:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                u160 = UINT16_MAKE(vm);
+                vm->pc = u160;
+                break;
+            case VM_UINT8_POP:
+                u80 = NCODE(vm);
+                for (u81 = 0; u81 < u80; u81++) {
+                    u82 = UINT8_POP(vm);
+                }
+                break;
+            case VM_UINT8_DUP:
+                u80 = NCODE(vm);
+                u81 = vm->uint8_sp;
+                for (u82 = u80; u82 > 0; u82--) {
+                    u83 = UINT8_PEEK(vm, (u81 - (u82 - 1)));
+                    UINT8_PUSH(vm, u83);
+                }
+                break;
+            case VM_UINT8_SWAP:
+                u80 = UINT8_POP(vm);
+                u81 = UINT8_POP(vm);
+                UINT8_PUSH(vm, u80);
+                UINT8_PUSH(vm, u81);
+                break;
+            case VM_UINT8_JUMPEM:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (vm->uint8_sp == VM_MAX_ADDR) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT8_STORE:
+                u80 = UINT8_POP(vm);
                 u160 = UINT16_POP(vm);
-                if (u160 > vm->mat4_memory_size) {
-                    printf("MAT4_LOAD: address exceeds size");
-                    vm->running = 0;
+                if (u160 >= vm->uint8_memory_size) {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                    break;
+                }
+                vm->uint8_memory[u160] = u80;
+                break;
+            case VM_UINT8_LOAD:
+                if (vm->flags & MEMORY_ATTACH_UINT8) {
+                    u160 = UINT16_POP(vm);
+                    if (u160 >= vm->uint8_memory_size) {
+                        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                        break;
+                    }
+                    u80 = vm->uint8_memory[u160];
+                    UINT8_PUSH(vm, u80);
+                }
+                else {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                }
+                break;
+            case VM_UINT8_ADD:
+                u80 = UINT8_POP(vm);
+                u81 = UINT8_POP(vm);
+                UINT8_PUSH(vm, (u81 + u80));
+                break;
+            case VM_UINT8_SUB:
+                u80 = UINT8_POP(vm);
+                u81 = UINT8_POP(vm);
+                UINT8_PUSH(vm, (u81 - u80));
+                break;
+            case VM_UINT8_MUL:
+                u80 = UINT8_POP(vm);
+                u81 = UINT8_POP(vm);
+                UINT8_PUSH(vm, (u81 * u80));
+                break;
+            case VM_UINT8_EQ:
+                u80 = UINT8_POP(vm);
+                u81 = UINT8_POP(vm);
+                UINT8_PUSH(vm, (u81 == u80 ? 1 : 0));
+                break;
+            case VM_UINT8_ADDN:
+                u80 = NCODE(vm);
+                vm->uint8_stack[vm->uint8_sp] += u80;
+                break;
+            case VM_UINT8_JUMPNZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT8_POP(vm)) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT8_JUMPZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT8_POP(vm) == 0) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT8_PUSH:
+                u80 = NCODE(vm);
+                UINT8_PUSH(vm, u80);
+                break;
+            case VM_UINT16_POP:
+                u80 = NCODE(vm);
+                for (u81 = 0; u81 < u80; u81++) {
+                    u160 = UINT16_POP(vm);
+                }
+                break;
+            case VM_UINT16_DUP:
+                u80 = NCODE(vm);
+                u81 = vm->uint16_sp;
+                for (u82 = u80; u82 > 0; u82--) {
+                    u160 = UINT16_PEEK(vm, (u81 - (u82 - 1)));
+                    UINT16_PUSH(vm, u160);
+                }
+                break;
+            case VM_UINT16_SWAP:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                UINT16_PUSH(vm, u160);
+                UINT16_PUSH(vm, u161);
+                break;
+            case VM_UINT16_JUMPEM:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (vm->uint16_sp == VM_MAX_ADDR) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT16_STORE:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                if (u161 >= vm->uint16_memory_size) {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                    break;
+                }
+                vm->uint16_memory[u161] = u160;
+                break;
+            case VM_UINT16_LOAD:
+                if (vm->flags & MEMORY_ATTACH_UINT16) {
+                    u160 = UINT16_POP(vm);
+                    if (u160 >= vm->uint16_memory_size) {
+                        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                        break;
+                    }
+                    u161 = vm->uint16_memory[u160];
+                    UINT16_PUSH(vm, u161);
+                }
+                else {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                }
+                break;
+            case VM_UINT16_ADD:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                UINT16_PUSH(vm, (u161 + u160));
+                break;
+            case VM_UINT16_SUB:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                UINT16_PUSH(vm, (u161 - u160));
+                break;
+            case VM_UINT16_MUL:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                UINT16_PUSH(vm, (u161 * u160));
+                break;
+            case VM_UINT16_EQ:
+                u160 = UINT16_POP(vm);
+                u161 = UINT16_POP(vm);
+                UINT16_PUSH(vm, (u161 == u160 ? 1 : 0));
+                break;
+            case VM_UINT16_ADDN:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                u160 = UINT16_MAKE(vm);
+                vm->uint16_stack[vm->uint16_sp] += u160;
+                break;
+            case VM_UINT16_JUMPNZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT16_POP(vm)) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT16_JUMPZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT16_POP(vm) == 0) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT16_MOVE_UINT8:
+                UINT16_PUSH(vm, UINT8_POP(vm));
+                break;
+            case VM_UINT16_PUSH:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                u160 = UINT16_MAKE(vm);
+                UINT16_PUSH(vm, u160);
+                break;
+            case VM_UINT32_POP:
+                u80 = NCODE(vm);
+                for (u81 = 0; u81 < u80; u81++) {
+                    u320 = UINT32_POP(vm);
+                }
+                break;
+            case VM_UINT32_DUP:
+                u80 = NCODE(vm);
+                u81 = vm->uint32_sp;
+                for (u82 = u80; u82 > 0; u82--) {
+                    u320 = UINT32_PEEK(vm, (u81 - (u82 - 1)));
+                    UINT32_PUSH(vm, u320);
+                }
+                break;
+            case VM_UINT32_SWAP:
+                u320 = UINT32_POP(vm);
+                u321 = UINT32_POP(vm);
+                UINT32_PUSH(vm, u320);
+                UINT32_PUSH(vm, u321);
+                break;
+            case VM_UINT32_JUMPEM:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (vm->uint32_sp == VM_MAX_ADDR) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT32_STORE:
+                u320 = UINT32_POP(vm);
+                u161 = UINT16_POP(vm);
+                if (u161 >= vm->uint32_memory_size) {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
                     break;
                 }
-                u161 = u160 * 16;
-                flp0 = &vm->mat4_memory[u161];
-                MAT4_PUSH(vm, flp0);
-            }
-            else {
-                printf("MAT4_LOAD: memory not attached\n");
-            }
-            break;
-        case VM_MAT4_ADD:
-            printf("MAT4_ADD: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_SUB:
-            printf("MAT4_SUB: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_MUL:
-            printf("MAT4_MUL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_EQ:
-            printf("MAT4_EQ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_EXPLODE:
-            printf("MAT4_EXPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_IDENT:
-            printf("MAT4_IDENT: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_IMPLODE:
-            printf("MAT4_IMPLODE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_ROTATEX:
-            printf("MAT4_ROTATEX: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_ROTATEY:
-            printf("MAT4_ROTATEY: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_ROTATEZ:
-            printf("MAT4_ROTATEZ: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_SCALE:
-            printf("MAT4_SCALE: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_TRANSL:
-            printf("MAT4_TRANSL: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        case VM_MAT4_TRANSP:
-            printf("MAT4_TRANSP: UNIMPLEMENTED\n");
-            vm->running = 0;
-            break;
-        default:
-            if (vm->callback != NULL) {
-                vm->callback(vm, opcode, vm->user_data);
-            }
-            break;
+                vm->uint32_memory[u161] = u320;
+                break;
+            case VM_UINT32_LOAD:
+                if (vm->flags & MEMORY_ATTACH_UINT32) {
+                    u160 = UINT16_POP(vm);
+                    if (u160 >= vm->uint32_memory_size) {
+                        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                        break;
+                    }
+                    u320 = vm->uint32_memory[u160];
+                    UINT32_PUSH(vm, u320);
+                }
+                else {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                }
+                break;
+            case VM_UINT32_ADD:
+                u320 = UINT32_POP(vm);
+                u321 = UINT32_POP(vm);
+                UINT32_PUSH(vm, (u321 + u320));
+                break;
+            case VM_UINT32_SUB:
+                u320 = UINT32_POP(vm);
+                u321 = UINT32_POP(vm);
+                UINT32_PUSH(vm, (u321 - u320));
+                break;
+            case VM_UINT32_MUL:
+                u320 = UINT32_POP(vm);
+                u321 = UINT32_POP(vm);
+                UINT32_PUSH(vm, (u321 * u320));
+                break;
+            case VM_UINT32_EQ:
+                u320 = UINT32_POP(vm);
+                u321 = UINT32_POP(vm);
+                UINT32_PUSH(vm, (u321 == u320 ? 1 : 0));
+                break;
+            case VM_UINT32_ADDN:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                vm->b2 = NCODE(vm);
+                vm->b3 = NCODE(vm);
+                u320 = UINT32_MAKE(vm);
+                vm->uint32_stack[vm->uint32_sp] += u320;
+                break;
+            case VM_UINT32_JUMPNZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT32_POP(vm)) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT32_JUMPZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (UINT32_POP(vm) == 0) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_UINT32_MOVE_UINT8:
+                UINT32_PUSH(vm, UINT8_POP(vm));
+                vm->running = 0;
+                break;
+            case VM_UINT32_PUSH:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                vm->b2 = NCODE(vm);
+                vm->b3 = NCODE(vm);
+                u320 = UINT32_MAKE(vm);
+                UINT32_PUSH(vm, u320);
+                break;
+            case VM_UINT32_REG_GET:
+                u80 = NCODE(vm);
+                if (u80 > 9) break;
+                UINT32_PUSH(vm, vm->draw_reg[u80]);
+                break;
+            case VM_UINT32_REG_SET:
+                u80 = NCODE(vm);
+                if (u80 > 9) break;
+                vm->draw_reg[u80] = UINT32_POP(vm);
+                break;
+            case VM_FLOAT_POP:
+                u80 = NCODE(vm);
+                for (u81 = 0; u81 < u80; u81++) {
+                    fl0 = FLOAT_POP(vm);
+                }
+                break;
+            case VM_FLOAT_DUP:
+                u80 = NCODE(vm);
+                u81 = vm->float_sp;
+                for (u82 = u80; u82 > 0; u82--) {
+                    fl0 = FLOAT_PEEK(vm, (u81 - (u82 - 1)));
+                    FLOAT_PUSH(vm, fl0);
+                }
+                break;
+            case VM_FLOAT_SWAP:
+                fl0 = FLOAT_POP(vm);
+                fl1 = FLOAT_POP(vm);
+                FLOAT_PUSH(vm, fl0);
+                FLOAT_PUSH(vm, fl1);
+                break;
+            case VM_FLOAT_JUMPEM:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (vm->float_sp == VM_MAX_ADDR) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_FLOAT_STORE:
+                fl0 = FLOAT_POP(vm);
+                u161 = UINT16_POP(vm);
+                if (u161 >= vm->float_memory_size) {
+                    rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+                    break;
+                }
+                vm->float_memory[u161] = fl0;
+                break;
+            case VM_FLOAT_LOAD:
+                if (vm->flags & MEMORY_ATTACH_FLOAT) {
+                    u160 = UINT16_POP(vm);
+                    if (u160 >= vm->float_memory_size) {
+                        printf("FLOAT_LOAD: address exceeds size");
+                        vm->running = 0;
+                        break;
+                    }
+                    fl0 = vm->float_memory[u160];
+                    FLOAT_PUSH(vm, fl0);
+                }
+                break;
+            case VM_FLOAT_ADD:
+                fl0 = FLOAT_POP(vm);
+                fl1 = FLOAT_POP(vm);
+                FLOAT_PUSH(vm, (fl1 + fl0));
+                break;
+            case VM_FLOAT_SUB:
+                fl0 = FLOAT_POP(vm);
+                fl1 = FLOAT_POP(vm);
+                FLOAT_PUSH(vm, (fl1 - fl0));
+                break;
+            case VM_FLOAT_MUL:
+                fl0 = FLOAT_POP(vm);
+                fl1 = FLOAT_POP(vm);
+                FLOAT_PUSH(vm, (fl1 * fl0));
+                break;
+            case VM_FLOAT_EQ:
+                fl0 = FLOAT_POP(vm);
+                fl1 = FLOAT_POP(vm);
+                FLOAT_PUSH(vm, (fl1 == fl0 ? 1 : 0));
+                break;
+            case VM_FLOAT_ADDN:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                vm->b2 = NCODE(vm);
+                vm->b3 = NCODE(vm);
+                fl0 = FLOAT_MAKE(vm);
+                vm->float_stack[vm->float_sp] += fl0;
+                break;
+            case VM_FLOAT_JUMPNZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (FLOAT_POP(vm)) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_FLOAT_JUMPZ:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                if (FLOAT_POP(vm) == 0.0f) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_FLOAT_PUSH:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                vm->b2 = NCODE(vm);
+                vm->b3 = NCODE(vm);
+                fl0 = FLOAT_MAKE(vm);
+                FLOAT_PUSH(vm, fl0);
+                break;
+            case VM_VEC2_POP:
+            case VM_VEC3_POP:
+            case VM_VEC4_POP:
+            case VM_MAT2_POP:
+            case VM_MAT3_POP:
+            case VM_MAT4_POP:
+                rendervm_vector_op_pop(vm, opcode, NCODE(vm));
+                break;
+            case VM_VEC2_DUP:
+            case VM_VEC3_DUP:
+            case VM_VEC4_DUP:
+            case VM_MAT2_DUP:
+            case VM_MAT3_DUP:
+            case VM_MAT4_DUP:
+                rendervm_vector_op_dup(vm, opcode, NCODE(vm));
+                break;
+            case VM_VEC2_SWAP:
+            case VM_VEC3_SWAP:
+            case VM_VEC4_SWAP:
+            case VM_MAT2_SWAP:
+            case VM_MAT3_SWAP:
+            case VM_MAT4_SWAP:
+                rendervm_vector_op_swap(vm, opcode, 0);
+                break;
+            case VM_VEC2_JUMPEM:
+            case VM_VEC3_JUMPEM:
+            case VM_VEC4_JUMPEM:
+            case VM_MAT2_JUMPEM:
+            case VM_MAT3_JUMPEM:
+            case VM_MAT4_JUMPEM:
+                vm->b0 = NCODE(vm);
+                vm->b1 = NCODE(vm);
+                rendervm_vector_stack(vm, opcode, &vs);
+                if (*vs.sp == VM_MAX_ADDR) {
+                    u160 = UINT16_MAKE(vm);
+                    vm->pc = u160;
+                }
+                break;
+            case VM_VEC2_STORE:
+            case VM_VEC3_STORE:
+            case VM_VEC4_STORE:
+            case VM_MAT2_STORE:
+            case VM_MAT3_STORE:
+            case VM_MAT4_STORE:
+                rendervm_vector_op_store(vm, opcode, 0);
+                break;
+            case VM_VEC2_LOAD:
+            case VM_VEC3_LOAD:
+            case VM_VEC4_LOAD:
+            case VM_MAT2_LOAD:
+            case VM_MAT3_LOAD:
+            case VM_MAT4_LOAD:
+                rendervm_vector_op_load(vm, opcode, 0);
+                break;
+            case VM_VEC2_ADD:
+            case VM_VEC3_ADD:
+            case VM_VEC4_ADD:
+            case VM_MAT2_ADD:
+            case VM_MAT3_ADD:
+            case VM_MAT4_ADD:
+                rendervm_vector_op_add(vm, opcode, 0);
+                break;
+            case VM_VEC2_SUB:
+            case VM_VEC3_SUB:
+            case VM_VEC4_SUB:
+            case VM_MAT2_SUB:
+            case VM_MAT3_SUB:
+            case VM_MAT4_SUB:
+                rendervm_vector_op_sub(vm, opcode, 0);
+                break;
+            case VM_VEC2_MUL:
+            case VM_VEC3_MUL:
+            case VM_VEC4_MUL:
+            case VM_MAT2_MUL:
+            case VM_MAT3_MUL:
+            case VM_MAT4_MUL:
+                rendervm_vector_op_mul(vm, opcode, 0);
+                break;
+            case VM_VEC2_EQ:
+            case VM_VEC3_EQ:
+            case VM_VEC4_EQ:
+            case VM_MAT2_EQ:
+            case VM_MAT3_EQ:
+            case VM_MAT4_EQ:
+                rendervm_vector_op_eq(vm, opcode, 0);
+                break;
+            case VM_VEC2_EXPLODE:
+            case VM_VEC3_EXPLODE:
+            case VM_VEC4_EXPLODE:
+            case VM_MAT2_EXPLODE:
+            case VM_MAT3_EXPLODE:
+            case VM_MAT4_EXPLODE:
+                rendervm_vector_op_explode(vm, opcode, 0);
+                break;
+            case VM_VEC2_IMPLODE:
+            case VM_VEC3_IMPLODE:
+            case VM_VEC4_IMPLODE:
+            case VM_MAT2_IMPLODE:
+            case VM_MAT3_IMPLODE:
+            case VM_MAT4_IMPLODE:
+                rendervm_vector_op_implode(vm, opcode, 0);
+                break;
+            case VM_VEC2_MULMAT2:
+            case VM_VEC2_MULMAT3:
+            case VM_VEC2_MULMAT4:
+            case VM_VEC3_MULMAT3:
+            case VM_VEC3_MULMAT4:
+            case VM_VEC4_MULMAT4:
+                rendervm_vector_mulmat(vm, opcode, 0);
+                break;
+            case VM_MAT2_IDENT:
+            case VM_MAT3_IDENT:
+            case VM_MAT4_IDENT:
+                rendervm_matrix_op_ident(vm, opcode, 0);
+                break;
+            case VM_MAT2_ROTATE:
+            case VM_MAT2_SCALE:
+            case VM_MAT3_ROTATE:
+            case VM_MAT3_SCALE:
+            case VM_MAT3_TRANSL:
+            case VM_MAT4_ROTATEX:
+            case VM_MAT4_ROTATEY:
+            case VM_MAT4_ROTATEZ:
+            case VM_MAT4_SCALE:
+            case VM_MAT4_TRANSL:
+                rendervm_matrix_transform(vm, opcode, 0);
+                break;
+            case VM_MAT2_TRANSP:
+            case VM_MAT3_TRANSP:
+            case VM_MAT4_TRANSP:
+                rendervm_matrix_op_transp(vm, opcode, 0);
+                break;
+            default:
+                if (vm->callback != NULL) {
+                    vm->callback(vm, opcode, vm->user_data);
+                }
+                break;
+        }
+        vm->last_opcode = opcode;
+        vm->next_opcode = (vm->pc < length) ? program[vm->pc] : VM_HALT;
+        executed++;
+    }
+
+    vm->cycles += executed;
+
+    return vm->running;
+}
+
+uint8_t rendervm_exec(rendervm_t* vm, uint8_t* program, uint16_t length) {
+    return rendervm_run(vm, program, length, 1);
+}
+
+rendervm_code_t* rendervm_code_create(uint8_t* program, uint16_t length) {
+    rendervm_code_t* code;
+    rendervm_insn_t* insn;
+    float_convert_t tmp;
+    uint32_t pc;
+    uint16_t idx;
+    uint8_t oplen;
+    uint8_t* arg;
+
+    code = malloc(sizeof(rendervm_code_t));
+    memset(code, 0, sizeof(rendervm_code_t));
+
+    // Take a private copy so a client rewriting its program memory can not
+    // change the code out from under the decoded instructions. Verify the
+    // copy, code->program, as the original may change after this.
+    code->length = length;
+    code->program = malloc(length + 1);
+    memcpy(code->program, program, length);
+    code->program[length] = VM_HALT;
+
+    code->pc_map = malloc(sizeof(uint16_t) * (length + 1));
+    memset(code->pc_map, 0xff, sizeof(uint16_t) * (length + 1));
+
+    // Every instruction is at least one byte long, so length + 1 entries
+    // leaves room for the end of program sentinel.
+    code->insns = malloc(sizeof(rendervm_insn_t) * (length + 1));
+    memset(code->insns, 0, sizeof(rendervm_insn_t) * (length + 1));
+
+    pc = 0;
+    idx = 0;
+    while (pc < length) {
+        insn = &code->insns[idx];
+        insn->opcode = code->program[pc];
+        insn->pc = pc;
+        oplen = rendervm_operand_length(insn->opcode);
+        if ((pc + 1 + oplen) > length) {
+            // Truncated operand at the end of the program.
+            rendervm_code_destroy(code);
+            return NULL;
+        }
+        arg = &code->program[pc + 1];
+        switch (oplen) {
+            case 1:
+                insn->u8 = arg[0];
+                break;
+            case 2:
+                insn->u16 = ((arg[1] << 8) | arg[0]);
+                break;
+            case 4:
+                tmp.u = ((arg[3] << 24) | (arg[2] << 16) | (arg[1] << 8) | arg[0]);
+                insn->u32 = tmp.u;
+                break;
+        }
+        insn->next_pc = pc + 1 + oplen;
+        code->pc_map[pc] = idx;
+        pc = insn->next_pc;
+        idx++;
+    }
+    code->nr_insns = idx;
+    code->pc_map[length] = idx;
+
+    insn = &code->insns[idx];
+    insn->opcode = VM_HALT;
+    insn->pc = length;
+    insn->next_pc = length;
+
+    // Resolve jump targets to instruction indexes. Targets past the end of the
+    // program resolve to the sentinel, which ends the program like the byte
+    // interpreter does. Jumps into the middle of an instruction can not be
+    // represented, so such programs are left to the byte interpreter.
+    for (idx = 0; idx < code->nr_insns; idx++) {
+        insn = &code->insns[idx];
+        if (!rendervm_opcode_is_branch(insn->opcode)) {
+            continue;
+        }
+        if (insn->u16 >= length) {
+            insn->target = code->nr_insns;
+            continue;
+        }
+        if (0xffff == code->pc_map[insn->u16]) {
+            rendervm_code_destroy(code);
+            return NULL;
+        }
+        insn->target = code->pc_map[insn->u16];
+    }
+
+    return code;
+}
+
+void rendervm_code_destroy(rendervm_code_t* code) {
+    free(code->insns);
+    free(code->pc_map);
+    free(code->program);
+    free(code);
+}
+
+#define THREADED_DISPATCH() do { if (executed == budget) goto exhausted; executed++; prev = last; last = ip; if (profile) rendervm_profile_hit(profile, ip->pc, ip->opcode); goto *ip->handler; } while (0)
+#define THREADED_NEXT()     do { ip++; THREADED_DISPATCH(); } while (0)
+#define THREADED_GOTO(i)    do { ip = &insns[(i)]; THREADED_DISPATCH(); } while (0)
+#define THREADED_STOP(npc)  do { vm->pc = (npc); goto stopped; } while (0)
+
+uint8_t rendervm_run_code(rendervm_t* vm, rendervm_code_t* code, uint32_t budget) {
+    static void* handlers[256] = {
+        [0x00 ... 0xff] = &&op_fallback,
+        [VM_HALT] = &&op_halt,
+        [VM_YIELD] = &&op_yield,
+        [VM_RESET] = &&op_reset,
+        [VM_CALL] = &&op_call,
+        [VM_RETURN] = &&op_return,
+        [VM_JUMP] = &&op_jump,
+        [VM_UINT8_POP] = &&op_uint8_pop,
+        [VM_UINT8_DUP] = &&op_uint8_dup,
+        [VM_UINT8_SWAP] = &&op_uint8_swap,
+        [VM_UINT8_JUMPEM] = &&op_uint8_jumpem,
+        [VM_UINT8_STORE] = &&op_uint8_store,
+        [VM_UINT8_LOAD] = &&op_uint8_load,
+        [VM_UINT8_ADD] = &&op_uint8_add,
+        [VM_UINT8_SUB] = &&op_uint8_sub,
+        [VM_UINT8_MUL] = &&op_uint8_mul,
+        [VM_UINT8_EQ] = &&op_uint8_eq,
+        [VM_UINT8_ADDN] = &&op_uint8_addn,
+        [VM_UINT8_JUMPNZ] = &&op_uint8_jumpnz,
+        [VM_UINT8_JUMPZ] = &&op_uint8_jumpz,
+        [VM_UINT8_PUSH] = &&op_uint8_push,
+        [VM_UINT16_POP] = &&op_uint16_pop,
+        [VM_UINT16_DUP] = &&op_uint16_dup,
+        [VM_UINT16_SWAP] = &&op_uint16_swap,
+        [VM_UINT16_JUMPEM] = &&op_uint16_jumpem,
+        [VM_UINT16_STORE] = &&op_uint16_store,
+        [VM_UINT16_LOAD] = &&op_uint16_load,
+        [VM_UINT16_ADD] = &&op_uint16_add,
+        [VM_UINT16_SUB] = &&op_uint16_sub,
+        [VM_UINT16_MUL] = &&op_uint16_mul,
+        [VM_UINT16_EQ] = &&op_uint16_eq,
+        [VM_UINT16_ADDN] = &&op_uint16_addn,
+        [VM_UINT16_JUMPNZ] = &&op_uint16_jumpnz,
+        [VM_UINT16_JUMPZ] = &&op_uint16_jumpz,
+        [VM_UINT16_MOVE_UINT8] = &&op_uint16_move_uint8,
+        [VM_UINT16_PUSH] = &&op_uint16_push,
+        [VM_UINT32_POP] = &&op_uint32_pop,
+        [VM_UINT32_DUP] = &&op_uint32_dup,
+        [VM_UINT32_SWAP] = &&op_uint32_swap,
+        [VM_UINT32_JUMPEM] = &&op_uint32_jumpem,
+        [VM_UINT32_STORE] = &&op_uint32_store,
+        [VM_UINT32_LOAD] = &&op_uint32_load,
+        [VM_UINT32_ADD] = &&op_uint32_add,
+        [VM_UINT32_SUB] = &&op_uint32_sub,
+        [VM_UINT32_MUL] = &&op_uint32_mul,
+        [VM_UINT32_EQ] = &&op_uint32_eq,
+        [VM_UINT32_ADDN] = &&op_uint32_addn,
+        [VM_UINT32_JUMPNZ] = &&op_uint32_jumpnz,
+        [VM_UINT32_JUMPZ] = &&op_uint32_jumpz,
+        [VM_UINT32_MOVE_UINT8] = &&op_uint32_move_uint8,
+        [VM_UINT32_PUSH] = &&op_uint32_push,
+        [VM_UINT32_REG_GET] = &&op_uint32_reg_get,
+        [VM_UINT32_REG_SET] = &&op_uint32_reg_set,
+        [VM_FLOAT_POP] = &&op_float_pop,
+        [VM_FLOAT_DUP] = &&op_float_dup,
+        [VM_FLOAT_SWAP] = &&op_float_swap,
+        [VM_FLOAT_JUMPEM] = &&op_float_jumpem,
+        [VM_FLOAT_STORE] = &&op_float_store,
+        [VM_FLOAT_LOAD] = &&op_float_load,
+        [VM_FLOAT_ADD] = &&op_float_add,
+        [VM_FLOAT_SUB] = &&op_float_sub,
+        [VM_FLOAT_MUL] = &&op_float_mul,
+        [VM_FLOAT_EQ] = &&op_float_eq,
+        [VM_FLOAT_ADDN] = &&op_float_addn,
+        [VM_FLOAT_JUMPNZ] = &&op_float_jumpnz,
+        [VM_FLOAT_JUMPZ] = &&op_float_jumpz,
+        [VM_FLOAT_PUSH] = &&op_float_push,
+        [VM_VEC2_POP] = &&op_vector_pop,
+        [VM_VEC3_POP] = &&op_vector_pop,
+        [VM_VEC4_POP] = &&op_vector_pop,
+        [VM_MAT2_POP] = &&op_vector_pop,
+        [VM_MAT3_POP] = &&op_vector_pop,
+        [VM_MAT4_POP] = &&op_vector_pop,
+        [VM_VEC2_DUP] = &&op_vector_dup,
+        [VM_VEC3_DUP] = &&op_vector_dup,
+        [VM_VEC4_DUP] = &&op_vector_dup,
+        [VM_MAT2_DUP] = &&op_vector_dup,
+        [VM_MAT3_DUP] = &&op_vector_dup,
+        [VM_MAT4_DUP] = &&op_vector_dup,
+        [VM_VEC2_SWAP] = &&op_vector_swap,
+        [VM_VEC3_SWAP] = &&op_vector_swap,
+        [VM_VEC4_SWAP] = &&op_vector_swap,
+        [VM_MAT2_SWAP] = &&op_vector_swap,
+        [VM_MAT3_SWAP] = &&op_vector_swap,
+        [VM_MAT4_SWAP] = &&op_vector_swap,
+        [VM_VEC2_JUMPEM] = &&op_vector_jumpem,
+        [VM_VEC3_JUMPEM] = &&op_vector_jumpem,
+        [VM_VEC4_JUMPEM] = &&op_vector_jumpem,
+        [VM_MAT2_JUMPEM] = &&op_vector_jumpem,
+        [VM_MAT3_JUMPEM] = &&op_vector_jumpem,
+        [VM_MAT4_JUMPEM] = &&op_vector_jumpem,
+        [VM_VEC2_STORE] = &&op_vector_store,
+        [VM_VEC3_STORE] = &&op_vector_store,
+        [VM_VEC4_STORE] = &&op_vector_store,
+        [VM_MAT2_STORE] = &&op_vector_store,
+        [VM_MAT3_STORE] = &&op_vector_store,
+        [VM_MAT4_STORE] = &&op_vector_store,
+        [VM_VEC2_LOAD] = &&op_vector_load,
+        [VM_VEC3_LOAD] = &&op_vector_load,
+        [VM_VEC4_LOAD] = &&op_vector_load,
+        [VM_MAT2_LOAD] = &&op_vector_load,
+        [VM_MAT3_LOAD] = &&op_vector_load,
+        [VM_MAT4_LOAD] = &&op_vector_load,
+        [VM_VEC2_ADD] = &&op_vector_add,
+        [VM_VEC3_ADD] = &&op_vector_add,
+        [VM_VEC4_ADD] = &&op_vector_add,
+        [VM_MAT2_ADD] = &&op_vector_add,
+        [VM_MAT3_ADD] = &&op_vector_add,
+        [VM_MAT4_ADD] = &&op_vector_add,
+        [VM_VEC2_SUB] = &&op_vector_sub,
+        [VM_VEC3_SUB] = &&op_vector_sub,
+        [VM_VEC4_SUB] = &&op_vector_sub,
+        [VM_MAT2_SUB] = &&op_vector_sub,
+        [VM_MAT3_SUB] = &&op_vector_sub,
+        [VM_MAT4_SUB] = &&op_vector_sub,
+        [VM_VEC2_MUL] = &&op_vector_mul,
+        [VM_VEC3_MUL] = &&op_vector_mul,
+        [VM_VEC4_MUL] = &&op_vector_mul,
+        [VM_MAT2_MUL] = &&op_vector_mul,
+        [VM_MAT3_MUL] = &&op_vector_mul,
+        [VM_MAT4_MUL] = &&op_vector_mul,
+        [VM_VEC2_EQ] = &&op_vector_eq,
+        [VM_VEC3_EQ] = &&op_vector_eq,
+        [VM_VEC4_EQ] = &&op_vector_eq,
+        [VM_MAT2_EQ] = &&op_vector_eq,
+        [VM_MAT3_EQ] = &&op_vector_eq,
+        [VM_MAT4_EQ] = &&op_vector_eq,
+        [VM_VEC2_EXPLODE] = &&op_vector_explode,
+        [VM_VEC3_EXPLODE] = &&op_vector_explode,
+        [VM_VEC4_EXPLODE] = &&op_vector_explode,
+        [VM_MAT2_EXPLODE] = &&op_vector_explode,
+        [VM_MAT3_EXPLODE] = &&op_vector_explode,
+        [VM_MAT4_EXPLODE] = &&op_vector_explode,
+        [VM_VEC2_IMPLODE] = &&op_vector_implode,
+        [VM_VEC3_IMPLODE] = &&op_vector_implode,
+        [VM_VEC4_IMPLODE] = &&op_vector_implode,
+        [VM_MAT2_IMPLODE] = &&op_vector_implode,
+        [VM_MAT3_IMPLODE] = &&op_vector_implode,
+        [VM_MAT4_IMPLODE] = &&op_vector_implode,
+        [VM_VEC2_MULMAT2] = &&op_vector_mulmat,
+        [VM_VEC2_MULMAT3] = &&op_vector_mulmat,
+        [VM_VEC2_MULMAT4] = &&op_vector_mulmat,
+        [VM_VEC3_MULMAT3] = &&op_vector_mulmat,
+        [VM_VEC3_MULMAT4] = &&op_vector_mulmat,
+        [VM_VEC4_MULMAT4] = &&op_vector_mulmat,
+        [VM_MAT2_IDENT] = &&op_matrix_ident,
+        [VM_MAT3_IDENT] = &&op_matrix_ident,
+        [VM_MAT4_IDENT] = &&op_matrix_ident,
+        [VM_MAT2_ROTATE] = &&op_matrix_transform,
+        [VM_MAT2_SCALE] = &&op_matrix_transform,
+        [VM_MAT3_ROTATE] = &&op_matrix_transform,
+        [VM_MAT3_SCALE] = &&op_matrix_transform,
+        [VM_MAT3_TRANSL] = &&op_matrix_transform,
+        [VM_MAT4_ROTATEX] = &&op_matrix_transform,
+        [VM_MAT4_ROTATEY] = &&op_matrix_transform,
+        [VM_MAT4_ROTATEZ] = &&op_matrix_transform,
+        [VM_MAT4_SCALE] = &&op_matrix_transform,
+        [VM_MAT4_TRANSL] = &&op_matrix_transform,
+        [VM_MAT2_TRANSP] = &&op_matrix_transp,
+        [VM_MAT3_TRANSP] = &&op_matrix_transp,
+        [VM_MAT4_TRANSP] = &&op_matrix_transp,
+        [(VM_MAT4_TRANSP + 1) ... 0xff] = &&op_callback
+    };
+    rendervm_insn_t* insns = code->insns;
+    rendervm_insn_t* ip;
+    rendervm_insn_t* last = NULL;
+    rendervm_insn_t* prev = NULL;
+    rendervm_profile_t* profile = vm->profile;
+    uint32_t executed = 0;
+    uint32_t cycles;
+    uint8_t u80, u81, u82, u83;
+    uint16_t u160, u161;
+    uint32_t u320, u321;
+    float fl0, fl1;
+    rendervm_vector_stack_t vs;
+
+    if (!code->linked) {
+        for (u160 = 0; u160 < code->nr_insns; u160++) {
+            insns[u160].handler = handlers[insns[u160].opcode];
+        }
+        insns[code->nr_insns].handler = &&op_end;
+        code->linked = 1;
+    }
+
+    if (!vm->running) {
+        return 0;
+    }
+
+    if (vm->pc >= code->length) {
+        ip = &insns[code->nr_insns];
+    }
+    else if (0xffff == code->pc_map[vm->pc]) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return 0;
+    }
+    else {
+        ip = &insns[code->pc_map[vm->pc]];
+    }
+
+    THREADED_DISPATCH();
+
+op_end:
+    // Running off the end of the program is not an instruction, so it does
+    // not count against the budget.
+    executed--;
+    rendervm_reset(vm);
+    if (prev) {
+        vm->last_opcode = prev->opcode;
+        vm->next_opcode = VM_HALT;
+    }
+    vm->cycles += executed;
+    return 0;
+
+op_halt:
+    vm->running = 0;
+    THREADED_STOP(0);
+op_yield:
+    vm->running = 0;
+    THREADED_STOP(ip->next_pc);
+op_reset:
+    rendervm_reset(vm);
+    THREADED_GOTO(0);
+op_call:
+    CTRL_PUSH(vm, ip->next_pc);
+    THREADED_GOTO(ip->target);
+op_return:
+    u160 = CTRL_POP(vm);
+    if (u160 >= code->length) {
+        THREADED_GOTO(code->nr_insns);
+    }
+    if (0xffff == code->pc_map[u160]) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(u160);
+    }
+    THREADED_GOTO(code->pc_map[u160]);
+op_jump:
+    THREADED_GOTO(ip->target);
+
+op_uint8_pop:
+    vm->uint8_sp -= ip->u8;
+    THREADED_NEXT();
+op_uint8_dup:
+    u81 = vm->uint8_sp;
+    for (u82 = ip->u8; u82 > 0; u82--) {
+        u83 = UINT8_PEEK(vm, (u81 - (u82 - 1)));
+        UINT8_PUSH(vm, u83);
+    }
+    THREADED_NEXT();
+op_uint8_swap:
+    u80 = UINT8_POP(vm);
+    u81 = UINT8_POP(vm);
+    UINT8_PUSH(vm, u80);
+    UINT8_PUSH(vm, u81);
+    THREADED_NEXT();
+op_uint8_jumpem:
+    if (vm->uint8_sp == VM_MAX_ADDR) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint8_store:
+    u80 = UINT8_POP(vm);
+    u160 = UINT16_POP(vm);
+    if (u160 >= vm->uint8_memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    vm->uint8_memory[u160] = u80;
+    THREADED_NEXT();
+op_uint8_load:
+    if (vm->flags & MEMORY_ATTACH_UINT8) {
+        u160 = UINT16_POP(vm);
+        if (u160 >= vm->uint8_memory_size) {
+            rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+            THREADED_STOP(ip->next_pc);
+        }
+        u80 = vm->uint8_memory[u160];
+        UINT8_PUSH(vm, u80);
+    }
+    else {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    THREADED_NEXT();
+op_uint8_add:
+    u80 = UINT8_POP(vm);
+    u81 = UINT8_POP(vm);
+    UINT8_PUSH(vm, (u81 + u80));
+    THREADED_NEXT();
+op_uint8_sub:
+    u80 = UINT8_POP(vm);
+    u81 = UINT8_POP(vm);
+    UINT8_PUSH(vm, (u81 - u80));
+    THREADED_NEXT();
+op_uint8_mul:
+    u80 = UINT8_POP(vm);
+    u81 = UINT8_POP(vm);
+    UINT8_PUSH(vm, (u81 * u80));
+    THREADED_NEXT();
+op_uint8_eq:
+    u80 = UINT8_POP(vm);
+    u81 = UINT8_POP(vm);
+    UINT8_PUSH(vm, (u81 == u80 ? 1 : 0));
+    THREADED_NEXT();
+op_uint8_addn:
+    vm->uint8_stack[vm->uint8_sp] += ip->u8;
+    THREADED_NEXT();
+op_uint8_jumpnz:
+    if (UINT8_POP(vm)) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint8_jumpz:
+    if (UINT8_POP(vm) == 0) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint8_push:
+    UINT8_PUSH(vm, ip->u8);
+    THREADED_NEXT();
+
+op_uint16_pop:
+    vm->uint16_sp -= ip->u8;
+    THREADED_NEXT();
+op_uint16_dup:
+    u81 = vm->uint16_sp;
+    for (u82 = ip->u8; u82 > 0; u82--) {
+        u160 = UINT16_PEEK(vm, (u81 - (u82 - 1)));
+        UINT16_PUSH(vm, u160);
+    }
+    THREADED_NEXT();
+op_uint16_swap:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    UINT16_PUSH(vm, u160);
+    UINT16_PUSH(vm, u161);
+    THREADED_NEXT();
+op_uint16_jumpem:
+    if (vm->uint16_sp == VM_MAX_ADDR) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint16_store:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    if (u161 >= vm->uint16_memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    vm->uint16_memory[u161] = u160;
+    THREADED_NEXT();
+op_uint16_load:
+    if (vm->flags & MEMORY_ATTACH_UINT16) {
+        u160 = UINT16_POP(vm);
+        if (u160 >= vm->uint16_memory_size) {
+            rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+            THREADED_STOP(ip->next_pc);
+        }
+        u161 = vm->uint16_memory[u160];
+        UINT16_PUSH(vm, u161);
+    }
+    else {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    THREADED_NEXT();
+op_uint16_add:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    UINT16_PUSH(vm, (u161 + u160));
+    THREADED_NEXT();
+op_uint16_sub:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    UINT16_PUSH(vm, (u161 - u160));
+    THREADED_NEXT();
+op_uint16_mul:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    UINT16_PUSH(vm, (u161 * u160));
+    THREADED_NEXT();
+op_uint16_eq:
+    u160 = UINT16_POP(vm);
+    u161 = UINT16_POP(vm);
+    UINT16_PUSH(vm, (u161 == u160 ? 1 : 0));
+    THREADED_NEXT();
+op_uint16_addn:
+    vm->uint16_stack[vm->uint16_sp] += ip->u16;
+    THREADED_NEXT();
+op_uint16_jumpnz:
+    if (UINT16_POP(vm)) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint16_jumpz:
+    if (UINT16_POP(vm) == 0) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint16_move_uint8:
+    UINT16_PUSH(vm, UINT8_POP(vm));
+    THREADED_NEXT();
+op_uint16_push:
+    UINT16_PUSH(vm, ip->u16);
+    THREADED_NEXT();
+
+op_uint32_pop:
+    vm->uint32_sp -= ip->u8;
+    THREADED_NEXT();
+op_uint32_dup:
+    u81 = vm->uint32_sp;
+    for (u82 = ip->u8; u82 > 0; u82--) {
+        u320 = UINT32_PEEK(vm, (u81 - (u82 - 1)));
+        UINT32_PUSH(vm, u320);
+    }
+    THREADED_NEXT();
+op_uint32_swap:
+    u320 = UINT32_POP(vm);
+    u321 = UINT32_POP(vm);
+    UINT32_PUSH(vm, u320);
+    UINT32_PUSH(vm, u321);
+    THREADED_NEXT();
+op_uint32_jumpem:
+    if (vm->uint32_sp == VM_MAX_ADDR) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint32_store:
+    u320 = UINT32_POP(vm);
+    u161 = UINT16_POP(vm);
+    if (u161 >= vm->uint32_memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    vm->uint32_memory[u161] = u320;
+    THREADED_NEXT();
+op_uint32_load:
+    if (vm->flags & MEMORY_ATTACH_UINT32) {
+        u160 = UINT16_POP(vm);
+        if (u160 >= vm->uint32_memory_size) {
+            rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+            THREADED_STOP(ip->next_pc);
+        }
+        u320 = vm->uint32_memory[u160];
+        UINT32_PUSH(vm, u320);
+    }
+    else {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    THREADED_NEXT();
+op_uint32_add:
+    u320 = UINT32_POP(vm);
+    u321 = UINT32_POP(vm);
+    UINT32_PUSH(vm, (u321 + u320));
+    THREADED_NEXT();
+op_uint32_sub:
+    u320 = UINT32_POP(vm);
+    u321 = UINT32_POP(vm);
+    UINT32_PUSH(vm, (u321 - u320));
+    THREADED_NEXT();
+op_uint32_mul:
+    u320 = UINT32_POP(vm);
+    u321 = UINT32_POP(vm);
+    UINT32_PUSH(vm, (u321 * u320));
+    THREADED_NEXT();
+op_uint32_eq:
+    u320 = UINT32_POP(vm);
+    u321 = UINT32_POP(vm);
+    UINT32_PUSH(vm, (u321 == u320 ? 1 : 0));
+    THREADED_NEXT();
+op_uint32_addn:
+    vm->uint32_stack[vm->uint32_sp] += ip->u32;
+    THREADED_NEXT();
+op_uint32_jumpnz:
+    if (UINT32_POP(vm)) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint32_jumpz:
+    if (UINT32_POP(vm) == 0) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_uint32_move_uint8:
+    UINT32_PUSH(vm, UINT8_POP(vm));
+    vm->running = 0;
+    THREADED_STOP(ip->next_pc);
+op_uint32_push:
+    UINT32_PUSH(vm, ip->u32);
+    THREADED_NEXT();
+op_uint32_reg_get:
+    if (ip->u8 <= 9) {
+        UINT32_PUSH(vm, vm->draw_reg[ip->u8]);
+    }
+    THREADED_NEXT();
+op_uint32_reg_set:
+    if (ip->u8 <= 9) {
+        vm->draw_reg[ip->u8] = UINT32_POP(vm);
+    }
+    THREADED_NEXT();
+
+op_float_pop:
+    vm->float_sp -= ip->u8;
+    THREADED_NEXT();
+op_float_dup:
+    u81 = vm->float_sp;
+    for (u82 = ip->u8; u82 > 0; u82--) {
+        fl0 = FLOAT_PEEK(vm, (u81 - (u82 - 1)));
+        FLOAT_PUSH(vm, fl0);
+    }
+    THREADED_NEXT();
+op_float_swap:
+    fl0 = FLOAT_POP(vm);
+    fl1 = FLOAT_POP(vm);
+    FLOAT_PUSH(vm, fl0);
+    FLOAT_PUSH(vm, fl1);
+    THREADED_NEXT();
+op_float_jumpem:
+    if (vm->float_sp == VM_MAX_ADDR) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_float_store:
+    fl0 = FLOAT_POP(vm);
+    u161 = UINT16_POP(vm);
+    if (u161 >= vm->float_memory_size) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        THREADED_STOP(ip->next_pc);
+    }
+    vm->float_memory[u161] = fl0;
+    THREADED_NEXT();
+op_float_load:
+    if (vm->flags & MEMORY_ATTACH_FLOAT) {
+        u160 = UINT16_POP(vm);
+        if (u160 >= vm->float_memory_size) {
+            vm->running = 0;
+            THREADED_STOP(ip->next_pc);
+        }
+        FLOAT_PUSH(vm, vm->float_memory[u160]);
+    }
+    THREADED_NEXT();
+op_float_add:
+    fl0 = FLOAT_POP(vm);
+    fl1 = FLOAT_POP(vm);
+    FLOAT_PUSH(vm, (fl1 + fl0));
+    THREADED_NEXT();
+op_float_sub:
+    fl0 = FLOAT_POP(vm);
+    fl1 = FLOAT_POP(vm);
+    FLOAT_PUSH(vm, (fl1 - fl0));
+    THREADED_NEXT();
+op_float_mul:
+    fl0 = FLOAT_POP(vm);
+    fl1 = FLOAT_POP(vm);
+    FLOAT_PUSH(vm, (fl1 * fl0));
+    THREADED_NEXT();
+op_float_eq:
+    fl0 = FLOAT_POP(vm);
+    fl1 = FLOAT_POP(vm);
+    FLOAT_PUSH(vm, (fl1 == fl0 ? 1 : 0));
+    THREADED_NEXT();
+op_float_addn:
+    vm->float_stack[vm->float_sp] += ip->f;
+    THREADED_NEXT();
+op_float_jumpnz:
+    if (FLOAT_POP(vm)) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_float_jumpz:
+    if (FLOAT_POP(vm) == 0.0f) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_float_push:
+    FLOAT_PUSH(vm, ip->f);
+    THREADED_NEXT();
+
+op_vector_pop:
+    rendervm_vector_op_pop(vm, ip->opcode, ip->u8);
+    THREADED_NEXT();
+op_vector_dup:
+    rendervm_vector_op_dup(vm, ip->opcode, ip->u8);
+    THREADED_NEXT();
+op_vector_swap:
+    rendervm_vector_op_swap(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_jumpem:
+    rendervm_vector_stack(vm, ip->opcode, &vs);
+    if (*vs.sp == VM_MAX_ADDR) {
+        THREADED_GOTO(ip->target);
+    }
+    THREADED_NEXT();
+op_vector_store:
+    rendervm_vector_op_store(vm, ip->opcode, 0);
+    if (!vm->running) {
+        THREADED_STOP(ip->next_pc);
+    }
+    THREADED_NEXT();
+op_vector_load:
+    rendervm_vector_op_load(vm, ip->opcode, 0);
+    if (!vm->running) {
+        THREADED_STOP(ip->next_pc);
+    }
+    THREADED_NEXT();
+op_vector_add:
+    rendervm_vector_op_add(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_sub:
+    rendervm_vector_op_sub(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_mul:
+    rendervm_vector_op_mul(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_eq:
+    rendervm_vector_op_eq(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_explode:
+    rendervm_vector_op_explode(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_implode:
+    rendervm_vector_op_implode(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_vector_mulmat:
+    rendervm_vector_mulmat(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_matrix_ident:
+    rendervm_matrix_op_ident(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_matrix_transform:
+    rendervm_matrix_transform(vm, ip->opcode, 0);
+    THREADED_NEXT();
+op_matrix_transp:
+    rendervm_matrix_op_transp(vm, ip->opcode, 0);
+    THREADED_NEXT();
+
+op_callback:
+    if (vm->callback != NULL) {
+        vm->callback(vm, ip->opcode, vm->user_data);
+        if (!vm->running) {
+            THREADED_STOP(ip->next_pc);
+        }
+    }
+    THREADED_NEXT();
+
+op_fallback:
+    // Opcodes without a threaded handler are single stepped through the
+    // byte interpreter on the private copy of the program.
+    vm->pc = ip->pc;
+    cycles = vm->cycles;
+    vm->profile = NULL;
+    rendervm_run(vm, code->program, code->length, 1);
+    vm->profile = profile;
+    vm->cycles = cycles;
+    if (!vm->running) {
+        goto stopped;
     }
-    vm->last_opcode = opcode;
-    vm->next_opcode = program[vm->pc];
+    if (vm->pc >= code->length) {
+        THREADED_GOTO(code->nr_insns);
+    }
+    if (0xffff == code->pc_map[vm->pc]) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        goto stopped;
+    }
+    THREADED_GOTO(code->pc_map[vm->pc]);
 
+exhausted:
+    vm->pc = ip->pc;
+stopped:
+    if (last) {
+        vm->last_opcode = last->opcode;
+    }
+    vm->next_opcode = code->program[vm->pc < code->length ? vm->pc : code->length];
+    vm->cycles += executed;
     return vm->running;
 }
 
@@ -1129,6 +2793,17 @@ uint8_t rendervm_next_opcode(rendervm_t* vm) {
     return vm->next_opcode;
 }
 
+uint8_t rendervm_resume(rendervm_t* vm) {
+    if (VM_X_ALL_OK == vm->exception) {
+        vm->running = 1;
+    }
+    return vm->running;
+}
+
+void rendervm_interrupt(rendervm_t* vm) {
+    vm->running = 0;
+}
+
 uint8_t rendervm_has_exception(rendervm_t* vm) {
     return (VM_X_ALL_OK == vm->exception) ? 0 : 1;
 }
@@ -1143,6 +2818,62 @@ void rendervm_attach_callback(rendervm_t* vm, rendervm_callback_t callback, void
     vm->user_data = user_data;
 }
 
+uint8_t rendervm_profile_enable(rendervm_t* vm, uint16_t length) {
+    rendervm_profile_t* profile = malloc(sizeof(rendervm_profile_t));
+    if (!profile) {
+        return 0;
+    }
+    memset(profile, 0, sizeof(rendervm_profile_t));
+
+    profile->pc_hits = calloc(length ? length : 1, sizeof(uint64_t));
+    if (!profile->pc_hits) {
+        free(profile);
+        return 0;
+    }
+    profile->length = length;
+
+    rendervm_profile_disable(vm);
+    vm->profile = profile;
+    return 1;
+}
+
+void rendervm_profile_disable(rendervm_t* vm) {
+    if (vm->profile) {
+        free(vm->profile->pc_hits);
+        free(vm->profile);
+        vm->profile = NULL;
+    }
+}
+
+void rendervm_profile_write(rendervm_t* vm, uint8_t* program, uint16_t length, FILE* out) {
+    rendervm_profile_t* profile = vm->profile;
+    uint32_t i;
+
+    if (!profile) {
+        return;
+    }
+    if (length > profile->length) {
+        length = profile->length;
+    }
+
+    fprintf(out, "cycles %llu\n", (unsigned long long)profile->cycles);
+    fprintf(out, "program");
+    for (i = 0; i < length; i++) {
+        fprintf(out, " %02x", program[i]);
+    }
+    fprintf(out, "\n");
+    for (i = 0; i < 256; i++) {
+        if (profile->opcode_count[i]) {
+            fprintf(out, "opcode 0x%02x %llu\n", i, (unsigned long long)profile->opcode_count[i]);
+        }
+    }
+    for (i = 0; i < length; i++) {
+        if (profile->pc_hits[i]) {
+            fprintf(out, "pc %u %llu\n", i, (unsigned long long)profile->pc_hits[i]);
+        }
+    }
+}
+
 uint8_t rendervm_opcode2arglen(rendervm_opcode_t opcode) {
     return opcode_info[opcode].arg_byte_length;
 }
@@ -1152,23 +2883,51 @@ const char* rendervm_opcode2str(rendervm_opcode_t opcode) {
 }
 
 void rendervm_reset(rendervm_t* vm) {
-    memset(vm->ctrl_stack, 0, VM_STACK_SIZE);
+    memset(vm->ctrl_stack, 0, VM_STACK_SIZE * sizeof(uint16_t));
 
     vm->pc = 0;
     vm->running = 1;
+    vm->exception = VM_X_ALL_OK;
 
     vm->ctrl_sp = VM_MAX_ADDR;
     vm->uint8_sp = VM_MAX_ADDR;
     vm->uint16_sp = VM_MAX_ADDR;
     vm->uint32_sp = VM_MAX_ADDR;
     vm->float_sp = VM_MAX_ADDR;
+    vm->vec2_sp = VM_MAX_ADDR;
+    vm->vec3_sp = VM_MAX_ADDR;
+    vm->vec4_sp = VM_MAX_ADDR;
+    vm->mat2_sp = VM_MAX_ADDR;
+    vm->mat3_sp = VM_MAX_ADDR;
+    vm->mat4_sp = VM_MAX_ADDR;
 }
 
 void rendervm_destroy(rendervm_t* vm) {
     free(vm->ctrl_stack);
+    free(vm->uint8_stack);
+    free(vm->uint16_stack);
+    free(vm->uint32_stack);
+    free(vm->float_stack);
+    free(vm->vec2_stack);
+    free(vm->vec3_stack);
+    free(vm->vec4_stack);
+    free(vm->mat2_stack);
+    free(vm->mat3_stack);
+    free(vm->mat4_stack);
+    rendervm_profile_disable(vm);
     free(vm);
 }
 
+// Vector and matrix stacks get one extra mat4 of slack, so an entry that
+// wraps around the top of the stack still stays inside the allocation.
+#define VM_VECTOR_STACK_SIZE ((VM_STACK_SIZE + 16) * sizeof(float))
+
+float* rendervm_vector_stack_create() {
+    float* stack = aligned_alloc(16, VM_VECTOR_STACK_SIZE);
+    memset(stack, 0, VM_VECTOR_STACK_SIZE);
+    return stack;
+}
+
 rendervm_t* rendervm_create() {
     rendervm_t* vm = malloc(sizeof(rendervm_t));
     memset(vm, 0, sizeof(rendervm_t));
@@ -1187,38 +2946,27 @@ rendervm_t* rendervm_create() {
     vm->mat3_sp = VM_MAX_ADDR;
     vm->mat4_sp = VM_MAX_ADDR;
 
-    vm->ctrl_stack = malloc(VM_STACK_SIZE);
-    memset(vm->ctrl_stack, 0, VM_STACK_SIZE);
+    vm->ctrl_stack = malloc(VM_STACK_SIZE * sizeof(uint16_t));
+    memset(vm->ctrl_stack, 0, VM_STACK_SIZE * sizeof(uint16_t));
 
     vm->uint8_stack = malloc(VM_STACK_SIZE);
     memset(vm->uint8_stack, 0, VM_STACK_SIZE);
 
-    vm->uint16_stack = malloc(VM_STACK_SIZE);
-    memset(vm->uint16_stack, 0, VM_STACK_SIZE);
-
-    vm->uint32_stack = malloc(VM_STACK_SIZE);
-    memset(vm->uint32_stack, 0, VM_STACK_SIZE);
-
-    vm->float_stack = malloc(VM_STACK_SIZE);
-    memset(vm->float_stack, 0, VM_STACK_SIZE);
-
-    vm->vec2_stack = malloc(VM_STACK_SIZE);
-    memset(vm->vec2_stack, 0, VM_STACK_SIZE);
-
-    vm->vec3_stack = malloc(VM_STACK_SIZE);
-    memset(vm->vec3_stack, 0, VM_STACK_SIZE);
-
-    vm->vec4_stack = malloc(VM_STACK_SIZE);
-    memset(vm->vec4_stack, 0, VM_STACK_SIZE);
+    vm->uint16_stack = malloc(VM_STACK_SIZE * sizeof(uint16_t));
+    memset(vm->uint16_stack, 0, VM_STACK_SIZE * sizeof(uint16_t));
 
-    vm->mat2_stack = malloc(VM_STACK_SIZE);
-    memset(vm->mat2_stack, 0, VM_STACK_SIZE);
+    vm->uint32_stack = malloc(VM_STACK_SIZE * sizeof(uint32_t));
+    memset(vm->uint32_stack, 0, VM_STACK_SIZE * sizeof(uint32_t));
 
-    vm->mat3_stack = malloc(VM_STACK_SIZE);
-    memset(vm->mat3_stack, 0, VM_STACK_SIZE);
+    vm->float_stack = malloc(VM_STACK_SIZE * sizeof(float));
+    memset(vm->float_stack, 0, VM_STACK_SIZE * sizeof(float));
 
-    vm->mat4_stack = malloc(VM_STACK_SIZE);
-    memset(vm->mat4_stack, 0, VM_STACK_SIZE);
+    vm->vec2_stack = rendervm_vector_stack_create();
+    vm->vec3_stack = rendervm_vector_stack_create();
+    vm->vec4_stack = rendervm_vector_stack_create();
+    vm->mat2_stack = rendervm_vector_stack_create();
+    vm->mat3_stack = rendervm_vector_stack_create();
+    vm->mat4_stack = rendervm_vector_stack_create();
 
     return vm;
 }
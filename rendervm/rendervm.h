@@ -1,6 +1,7 @@
 #ifndef RENDERVM_H
 #define RENDERVM_H
 
+#include <stdio.h>
 #include <stdint.h>
 
 #define VM_MAX_ADDR      255
@@ -20,12 +21,63 @@
 typedef enum rendervm_exception {
     VM_X_ALL_OK         = 0x00,
     VM_X_INV_OPCODE     = 0x01,
-    VM_X_OUT_OF_BOUNDS  = 0x02
+    VM_X_OUT_OF_BOUNDS  = 0x02,
+    VM_X_STACK_UNDERFLOW = 0x03,
+    VM_X_STACK_OVERFLOW = 0x04
 } rendervm_exception_t;
 
+typedef enum rendervm_verify_error {
+    VM_V_OK                 = 0x00,
+    VM_V_TRUNCATED          = 0x01,
+    VM_V_BAD_TARGET         = 0x02,
+    VM_V_BAD_REGISTER       = 0x03,
+    VM_V_STACK_UNDERFLOW    = 0x04,
+    VM_V_STACK_OVERFLOW     = 0x05,
+    VM_V_STACK_MISMATCH     = 0x06,
+    VM_V_UNVERIFIABLE       = 0x07
+} rendervm_verify_error_t;
+
+typedef struct rendervm_verify {
+    rendervm_verify_error_t error;
+    uint16_t pc;
+    uint8_t opcode;
+} rendervm_verify_t;
+
 typedef struct rendervm rendervm_t;
 typedef enum rendervm_opcode rendervm_opcode_t;
 
+typedef struct rendervm_insn {
+    void* handler;
+    uint16_t pc;
+    uint16_t next_pc;
+    uint16_t target;
+    uint16_t u16;
+    uint8_t opcode;
+    uint8_t u8;
+    union {
+        uint32_t u32;
+        float f;
+    };
+} rendervm_insn_t;
+
+typedef struct rendervm_code {
+    uint8_t* program;
+    uint16_t length;
+    rendervm_insn_t* insns;
+    uint16_t nr_insns;
+    uint16_t* pc_map;
+    uint8_t linked;
+} rendervm_code_t;
+
+// Execution counts kept while profiling: how often each opcode ran and how
+// often the instruction at each pc of the program did.
+typedef struct rendervm_profile {
+    uint64_t opcode_count[256];
+    uint64_t* pc_hits;
+    uint16_t length;
+    uint64_t cycles;
+} rendervm_profile_t;
+
 typedef void (*rendervm_callback_t)(rendervm_t* vm, rendervm_opcode_t opcode, void* user_data);
 
 typedef struct rendervm {
@@ -50,6 +102,10 @@ typedef struct rendervm {
     float* float_stack;
     uint8_t float_sp;
 
+    // The vector and matrix stacks are 16 byte aligned float arrays and
+    // their stack pointers count floats. Entries are padded to whole SIMD
+    // lanes: vec3 and vec4 take 4 floats and matrices take 4 per column, so
+    // mat2 takes 8, mat3 12 and mat4 16. vec2 entries stay 2 floats wide.
     float* vec2_stack;
     uint8_t vec2_sp;
 
@@ -65,7 +121,7 @@ typedef struct rendervm {
     float* mat3_stack;
     uint8_t mat3_sp;
 
-    float** mat4_stack;
+    float* mat4_stack;
     uint8_t mat4_sp;
 
     uint8_t b0;
@@ -104,14 +160,20 @@ typedef struct rendervm {
     uint32_t mat4_memory_size;
 
     rendervm_exception_t exception;
+    uint8_t checked;
     uint8_t running;
     uint8_t last_opcode;
     uint8_t next_opcode;
+    uint32_t cycles;
+
+    rendervm_profile_t* profile;
 
     void* user_data;
     rendervm_callback_t callback;
 } rendervm_t;
 
+typedef void (*rendervm_vector_op_t)(rendervm_t* vm, uint8_t opcode, uint8_t n);
+
 typedef enum rendervm_opcode {
     VM_HALT = 0x00,
     VM_YIELD = 0x01,
@@ -273,6 +335,8 @@ typedef enum rendervm_opcode {
     VM_MAT4_SCALE = 0x9d,
     VM_MAT4_TRANSL = 0x9e,
     VM_MAT4_TRANSP = 0x9f,
+    // Opcodes from here up are not run by the VM but handed to its callback.
+    VM__CALLBACK = 0xc8,
     VM__INSEND = 0xff
 } rendervm_opcode_t;
 
@@ -284,17 +348,63 @@ uint8_t rendervm_last_opcode(rendervm_t* vm);
 
 uint8_t rendervm_next_opcode(rendervm_t* vm);
 
-//uint8_t rendervm_resume(rendervm_t* vm);
+uint8_t rendervm_resume(rendervm_t* vm);
 
 void rendervm_reset(rendervm_t* vm);
 
 uint8_t rendervm_exec(rendervm_t* vm, uint8_t* program, uint16_t length);
 
+// Executes up to budget instructions without returning to the caller. Stops
+// early on YIELD, HALT, an exception or the end of the program. Returns 1 if
+// the budget ran out with the VM still running, 0 otherwise.
+// With vm->checked set, operands and stack depths are checked before each
+// opcode, for programs that did not pass rendervm_verify().
+uint8_t rendervm_run(rendervm_t* vm, uint8_t* program, uint16_t length, uint32_t budget);
+
+// Checks a program before it is run: operands, jump targets, register
+// indexes and the depth of each stack along every path from the start.
+// Verified programs can not under or overflow a stack, so they can run
+// without runtime checks. On failure result holds the error and its pc.
+uint8_t rendervm_verify(uint8_t* program, uint16_t length, rendervm_verify_t* result);
+
+const char* rendervm_verify_error2str(rendervm_verify_error_t error);
+
+// Decodes a program once into an instruction array with operands unpacked
+// and jump targets resolved. Returns NULL if the program can not be decoded
+// (truncated operands or jumps into the middle of an instruction). The code
+// holds its own copy of the program, which is what should be verified.
+rendervm_code_t* rendervm_code_create(uint8_t* program, uint16_t length);
+
+void rendervm_code_destroy(rendervm_code_t* code);
+
+// Same as rendervm_run() but executes decoded code with threaded dispatch.
+uint8_t rendervm_run_code(rendervm_t* vm, rendervm_code_t* code, uint32_t budget);
+
+// Returns the function that executes a vector or matrix opcode on the
+// stacks, where n is the operand of POP and DUP. NULL for the vector JUMPEMs
+// and every other opcode.
+rendervm_vector_op_t rendervm_vector_op(uint8_t opcode);
+
+// Starts profiling a program of length bytes, clearing any earlier counts.
+// Returns 0 if the counters could not be allocated. Without a profile the
+// engines only pay one test per instruction. The JIT hands over to threaded
+// code while a profile is attached.
+uint8_t rendervm_profile_enable(rendervm_t* vm, uint16_t length);
+
+void rendervm_profile_disable(rendervm_t* vm);
+
+// Writes the profile and the program it was taken from as text, for
+// rendervmasm --profile to print as annotated disassembly.
+void rendervm_profile_write(rendervm_t* vm, uint8_t* program, uint16_t length, FILE* out);
+
 uint8_t rendervm_opcode2arglen(rendervm_opcode_t opcode);
 
 const char* rendervm_opcode2str(rendervm_opcode_t opcode);
 
-//void rendervm_interrupt(rendervm_t* vm);
+// Stops the VM so that rendervm_resume() carries on where it left off, the
+// same as a YIELD would. Called from the callback, the run returns once that
+// opcode is done.
+void rendervm_interrupt(rendervm_t* vm);
 
 uint8_t rendervm_has_exception(rendervm_t* vm);
 
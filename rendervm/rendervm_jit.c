@@ -0,0 +1,731 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include "rendervm.h"
+#include "rendervm_jit.h"
+
+#if defined(__x86_64__)
+
+// Register use in generated code:
+//   rbx  rendervm_t* vm
+//   r12d instructions left in the budget
+//   r13  rendervm_code_t* code
+//   r14  rendervm_jit_t* jit
+// All four are callee saved so helpers can be called without spilling.
+
+#define JIT_INSN_MAX    96
+#define JIT_STUB_MAX    16
+
+#define FIX_INSN        0
+#define FIX_BUDGET      1
+#define FIX_EPILOGUE    2
+
+typedef uint32_t (*rendervm_jit_entry_t)(rendervm_t* vm, rendervm_jit_t* jit, uint32_t budget, uint8_t* start);
+
+typedef struct rendervm_jit_fixup {
+    uint32_t pos;
+    uint16_t idx;
+    uint8_t kind;
+} rendervm_jit_fixup_t;
+
+typedef struct rendervm_jit_emit {
+    uint8_t* buf;
+    uint32_t pos;
+    rendervm_jit_fixup_t* fixups;
+    uint32_t nr_fixups;
+} rendervm_jit_emit_t;
+
+void jit_emit8(rendervm_jit_emit_t* e, uint8_t b) {
+    e->buf[e->pos++] = b;
+}
+
+void jit_emit16(rendervm_jit_emit_t* e, uint16_t v) {
+    memcpy(&e->buf[e->pos], &v, 2);
+    e->pos += 2;
+}
+
+void jit_emit32(rendervm_jit_emit_t* e, uint32_t v) {
+    memcpy(&e->buf[e->pos], &v, 4);
+    e->pos += 4;
+}
+
+void jit_emit64(rendervm_jit_emit_t* e, uint64_t v) {
+    memcpy(&e->buf[e->pos], &v, 8);
+    e->pos += 8;
+}
+
+void jit_emit_bytes(rendervm_jit_emit_t* e, const uint8_t* bytes, uint8_t length) {
+    memcpy(&e->buf[e->pos], bytes, length);
+    e->pos += length;
+}
+
+void jit_emit_rel32(rendervm_jit_emit_t* e, uint8_t kind, uint16_t idx) {
+    rendervm_jit_fixup_t* fixup = &e->fixups[e->nr_fixups++];
+    fixup->pos = e->pos;
+    fixup->kind = kind;
+    fixup->idx = idx;
+    jit_emit32(e, 0);
+}
+
+// jmp rel32
+void jit_jmp(rendervm_jit_emit_t* e, uint8_t kind, uint16_t idx) {
+    jit_emit8(e, 0xe9);
+    jit_emit_rel32(e, kind, idx);
+}
+
+// jz rel32 / jnz rel32
+void jit_jcc(rendervm_jit_emit_t* e, uint8_t cc, uint8_t kind, uint16_t idx) {
+    jit_emit8(e, 0x0f);
+    jit_emit8(e, cc);
+    jit_emit_rel32(e, kind, idx);
+}
+
+#define JCC_Z   0x84
+#define JCC_NZ  0x85
+
+// mov byte [rbx+disp], imm8
+void jit_store8_vm(rendervm_jit_emit_t* e, uint32_t disp, uint8_t v) {
+    jit_emit8(e, 0xc6);
+    jit_emit8(e, 0x83);
+    jit_emit32(e, disp);
+    jit_emit8(e, v);
+}
+
+// mov word [rbx+disp], imm16
+void jit_store16_vm(rendervm_jit_emit_t* e, uint32_t disp, uint16_t v) {
+    jit_emit8(e, 0x66);
+    jit_emit8(e, 0xc7);
+    jit_emit8(e, 0x83);
+    jit_emit32(e, disp);
+    jit_emit16(e, v);
+}
+
+// mov rax, imm64; call rax
+void jit_call(rendervm_jit_emit_t* e, void* fn) {
+    jit_emit8(e, 0x48);
+    jit_emit8(e, 0xb8);
+    jit_emit64(e, (uint64_t)(uintptr_t)fn);
+    jit_emit8(e, 0xff);
+    jit_emit8(e, 0xd0);
+}
+
+// mov rdi, rbx
+void jit_arg_vm(rendervm_jit_emit_t* e) {
+    static const uint8_t code[] = {0x48, 0x89, 0xdf};
+    jit_emit_bytes(e, code, sizeof(code));
+}
+
+// Loads the stack pointer into eax and the stack base into rcx:
+// movzx eax, byte [rbx+sp]; mov rcx, [rbx+stack]
+void jit_load_stack(rendervm_jit_emit_t* e, uint32_t sp, uint32_t stack) {
+    jit_emit8(e, 0x0f);
+    jit_emit8(e, 0xb6);
+    jit_emit8(e, 0x83);
+    jit_emit32(e, sp);
+    jit_emit8(e, 0x48);
+    jit_emit8(e, 0x8b);
+    jit_emit8(e, 0x8b);
+    jit_emit32(e, stack);
+}
+
+// inc al / dec al, then mov byte [rbx+sp], al
+void jit_move_sp(rendervm_jit_emit_t* e, uint32_t sp, uint8_t up) {
+    jit_emit8(e, 0xfe);
+    jit_emit8(e, up ? 0xc0 : 0xc8);
+    jit_emit8(e, 0x88);
+    jit_emit8(e, 0x83);
+    jit_emit32(e, sp);
+}
+
+// Element size of a stack as an SIB scale and its operand size prefix.
+#define W8  0
+#define W16 1
+#define W32 2
+
+void jit_prefix(rendervm_jit_emit_t* e, uint8_t w) {
+    if (w == W16) {
+        jit_emit8(e, 0x66);
+    }
+}
+
+// Emits "op reg, [rcx+rax*scale]" style memory operands for register
+// reg (0 = eax, 2 = edx, 6 = esi).
+void jit_modrm_stack(rendervm_jit_emit_t* e, uint8_t reg, uint8_t w) {
+    jit_emit8(e, 0x04 | (reg << 3));
+    jit_emit8(e, (w << 6) | 0x01);
+}
+
+// Reads the top of stack into edx, zero extended.
+void jit_read_top(rendervm_jit_emit_t* e, uint8_t w) {
+    if (w == W8) {
+        jit_emit8(e, 0x0f);
+        jit_emit8(e, 0xb6);
+    }
+    else if (w == W16) {
+        jit_emit8(e, 0x0f);
+        jit_emit8(e, 0xb7);
+    }
+    else {
+        jit_emit8(e, 0x8b);
+    }
+    jit_modrm_stack(e, 2, w);
+}
+
+// Writes edx to the top of stack.
+void jit_write_top(rendervm_jit_emit_t* e, uint8_t w) {
+    jit_prefix(e, w);
+    jit_emit8(e, (w == W8) ? 0x88 : 0x89);
+    jit_modrm_stack(e, 2, w);
+}
+
+// Pushes an immediate to a stack.
+void jit_push_imm(rendervm_jit_emit_t* e, uint32_t sp, uint32_t stack, uint8_t w, uint32_t v) {
+    jit_load_stack(e, sp, stack);
+    jit_move_sp(e, sp, 1);
+    jit_prefix(e, w);
+    jit_emit8(e, (w == W8) ? 0xc6 : 0xc7);
+    jit_modrm_stack(e, 0, w);
+    if (w == W8) {
+        jit_emit8(e, v);
+    }
+    else if (w == W16) {
+        jit_emit16(e, v);
+    }
+    else {
+        jit_emit32(e, v);
+    }
+}
+
+// Pops the top of a stack into edx.
+void jit_pop_edx(rendervm_jit_emit_t* e, uint32_t sp, uint32_t stack, uint8_t w) {
+    jit_load_stack(e, sp, stack);
+    jit_read_top(e, w);
+    jit_move_sp(e, sp, 0);
+}
+
+// Pops the top two entries and pushes the result of op, where op is ADD,
+// SUB or MUL, the same way the interpreter does.
+void jit_binop(rendervm_jit_emit_t* e, uint32_t sp, uint32_t stack, uint8_t w, uint8_t op) {
+    jit_load_stack(e, sp, stack);
+    jit_read_top(e, w);
+    jit_move_sp(e, sp, 0);
+    if (op == 2) {
+        // movzx/mov esi, [second]; imul esi, edx; mov [second], esi
+        if (w == W8) {
+            jit_emit8(e, 0x0f);
+            jit_emit8(e, 0xb6);
+        }
+        else if (w == W16) {
+            jit_emit8(e, 0x0f);
+            jit_emit8(e, 0xb7);
+        }
+        else {
+            jit_emit8(e, 0x8b);
+        }
+        jit_modrm_stack(e, 6, w);
+        jit_emit8(e, 0x0f);
+        jit_emit8(e, 0xaf);
+        jit_emit8(e, 0xf2);
+        if (w == W8) {
+            jit_emit8(e, 0x40);
+        }
+        jit_prefix(e, w);
+        jit_emit8(e, (w == W8) ? 0x88 : 0x89);
+        jit_modrm_stack(e, 6, w);
+        return;
+    }
+    // add/sub [second], edx
+    jit_prefix(e, w);
+    if (op == 0) {
+        jit_emit8(e, (w == W8) ? 0x00 : 0x01);
+    }
+    else {
+        jit_emit8(e, (w == W8) ? 0x28 : 0x29);
+    }
+    jit_modrm_stack(e, 2, w);
+}
+
+// add [top], imm
+void jit_addn(rendervm_jit_emit_t* e, uint32_t sp, uint32_t stack, uint8_t w, uint32_t v) {
+    jit_load_stack(e, sp, stack);
+    jit_prefix(e, w);
+    jit_emit8(e, (w == W8) ? 0x80 : 0x81);
+    jit_modrm_stack(e, 0, w);
+    if (w == W8) {
+        jit_emit8(e, v);
+    }
+    else if (w == W16) {
+        jit_emit16(e, v);
+    }
+    else {
+        jit_emit32(e, v);
+    }
+}
+
+// Runs one instruction through the byte interpreter for opcodes without
+// native code. Returns 0 if the VM stopped.
+uint8_t rendervm_jit_step(rendervm_t* vm, rendervm_code_t* code, uint16_t pc) {
+    uint32_t cycles = vm->cycles;
+    vm->pc = pc;
+    rendervm_run(vm, code->program, code->length, 1);
+    vm->cycles = cycles;
+    return vm->running;
+}
+
+uint8_t rendervm_jit_pop_float(rendervm_t* vm) {
+    return (vm->float_stack[vm->float_sp--] != 0.0f) ? 1 : 0;
+}
+
+// FLOAT_LOAD the way the interpreter does it. Returns 0 if the VM stopped.
+uint8_t rendervm_jit_float_load(rendervm_t* vm) {
+    uint16_t addr;
+
+    if (vm->flags & MEMORY_ATTACH_FLOAT) {
+        addr = vm->uint16_stack[vm->uint16_sp--];
+        if (addr >= vm->float_memory_size) {
+            vm->running = 0;
+            return 0;
+        }
+        vm->float_stack[++vm->float_sp] = vm->float_memory[addr];
+    }
+    return 1;
+}
+
+// Returns the native address to continue at after RETURN.
+uint8_t* rendervm_jit_return(rendervm_t* vm, rendervm_jit_t* jit) {
+    rendervm_code_t* code = jit->code;
+    uint16_t pc = vm->ctrl_stack[vm->ctrl_sp--];
+    if (pc >= code->length) {
+        return jit->labels[code->nr_insns];
+    }
+    if (0xffff == code->pc_map[pc]) {
+        vm->pc = pc;
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return jit->epilogue;
+    }
+    return jit->labels[code->pc_map[pc]];
+}
+
+void rendervm_jit_end(rendervm_t* vm, rendervm_jit_t* jit) {
+    rendervm_reset(vm);
+    vm->next_opcode = VM_HALT;
+    jit->ended = 1;
+}
+
+#define VM_OFF(field) ((uint32_t)offsetof(rendervm_t, field))
+
+void rendervm_jit_emit_insn(rendervm_jit_emit_t* e, rendervm_t* vm, rendervm_code_t* code, uint16_t idx) {
+    rendervm_insn_t* insn = &code->insns[idx];
+    static const uint8_t test_budget[] = {0x45, 0x85, 0xe4};
+    static const uint8_t dec_budget[] = {0x41, 0xff, 0xcc};
+    static const uint8_t test_edx[] = {0x85, 0xd2};
+    static const uint8_t test_al[] = {0x84, 0xc0};
+    static const uint8_t mov_rsi_r14[] = {0x4c, 0x89, 0xf6};
+    static const uint8_t mov_rsi_r13[] = {0x4c, 0x89, 0xee};
+    static const uint8_t jmp_rax[] = {0xff, 0xe0};
+    rendervm_vector_op_t vector_op;
+    uint32_t sp = 0, stack = 0;
+    uint8_t w = W8;
+
+    // Budget check, counted the same way as the interpreters.
+    jit_emit_bytes(e, test_budget, sizeof(test_budget));
+    jit_jcc(e, JCC_Z, FIX_BUDGET, idx);
+    jit_emit_bytes(e, dec_budget, sizeof(dec_budget));
+    jit_store8_vm(e, VM_OFF(last_opcode), insn->opcode);
+
+    if (insn->opcode >= VM_UINT8_POP && insn->opcode <= VM_UINT8_PUSH) {
+        sp = VM_OFF(uint8_sp);
+        stack = VM_OFF(uint8_stack);
+        w = W8;
+    }
+    else if (insn->opcode >= VM_UINT16_POP && insn->opcode <= VM_UINT16_PUSH) {
+        sp = VM_OFF(uint16_sp);
+        stack = VM_OFF(uint16_stack);
+        w = W16;
+    }
+    else if (insn->opcode >= VM_UINT32_POP && insn->opcode <= VM_UINT32_REG_SET) {
+        sp = VM_OFF(uint32_sp);
+        stack = VM_OFF(uint32_stack);
+        w = W32;
+    }
+    else if (insn->opcode >= VM_FLOAT_POP && insn->opcode <= VM_FLOAT_PUSH) {
+        sp = VM_OFF(float_sp);
+        stack = VM_OFF(float_stack);
+        w = W32;
+    }
+
+    switch (insn->opcode) {
+        case VM_HALT:
+            jit_store8_vm(e, VM_OFF(running), 0);
+            jit_store16_vm(e, VM_OFF(pc), 0);
+            jit_jmp(e, FIX_EPILOGUE, 0);
+            return;
+        case VM_YIELD:
+            jit_store8_vm(e, VM_OFF(running), 0);
+            jit_store16_vm(e, VM_OFF(pc), insn->next_pc);
+            jit_jmp(e, FIX_EPILOGUE, 0);
+            return;
+        case VM_RESET:
+            jit_arg_vm(e);
+            jit_call(e, &rendervm_reset);
+            jit_jmp(e, FIX_INSN, 0);
+            return;
+        case VM_CALL:
+            jit_load_stack(e, VM_OFF(ctrl_sp), VM_OFF(ctrl_stack));
+            jit_move_sp(e, VM_OFF(ctrl_sp), 1);
+            jit_emit8(e, 0x66);
+            jit_emit8(e, 0xc7);
+            jit_modrm_stack(e, 0, W16);
+            jit_emit16(e, insn->next_pc);
+            jit_jmp(e, FIX_INSN, insn->target);
+            return;
+        case VM_RETURN:
+            jit_arg_vm(e);
+            jit_emit_bytes(e, mov_rsi_r14, sizeof(mov_rsi_r14));
+            jit_call(e, &rendervm_jit_return);
+            jit_emit_bytes(e, jmp_rax, sizeof(jmp_rax));
+            return;
+        case VM_JUMP:
+            jit_jmp(e, FIX_INSN, insn->target);
+            return;
+        case VM_VEC2_JUMPEM:
+        case VM_VEC3_JUMPEM:
+        case VM_VEC4_JUMPEM:
+        case VM_MAT2_JUMPEM:
+        case VM_MAT3_JUMPEM:
+        case VM_MAT4_JUMPEM:
+            sp = (insn->opcode == VM_VEC2_JUMPEM) ? VM_OFF(vec2_sp) : (insn->opcode == VM_VEC3_JUMPEM) ? VM_OFF(vec3_sp) : (insn->opcode == VM_VEC4_JUMPEM) ? VM_OFF(vec4_sp) :
+                 (insn->opcode == VM_MAT2_JUMPEM) ? VM_OFF(mat2_sp) : (insn->opcode == VM_MAT3_JUMPEM) ? VM_OFF(mat3_sp) : VM_OFF(mat4_sp);
+            // fall through
+        case VM_UINT8_JUMPEM:
+        case VM_UINT16_JUMPEM:
+        case VM_UINT32_JUMPEM:
+        case VM_FLOAT_JUMPEM:
+            // cmp byte [rbx+sp], VM_MAX_ADDR; je target
+            jit_emit8(e, 0x80);
+            jit_emit8(e, 0xbb);
+            jit_emit32(e, sp);
+            jit_emit8(e, VM_MAX_ADDR);
+            jit_jcc(e, JCC_Z, FIX_INSN, insn->target);
+            return;
+        case VM_UINT8_JUMPNZ:
+        case VM_UINT16_JUMPNZ:
+        case VM_UINT32_JUMPNZ:
+            jit_pop_edx(e, sp, stack, w);
+            jit_emit_bytes(e, test_edx, sizeof(test_edx));
+            jit_jcc(e, JCC_NZ, FIX_INSN, insn->target);
+            return;
+        case VM_UINT8_JUMPZ:
+        case VM_UINT16_JUMPZ:
+        case VM_UINT32_JUMPZ:
+            jit_pop_edx(e, sp, stack, w);
+            jit_emit_bytes(e, test_edx, sizeof(test_edx));
+            jit_jcc(e, JCC_Z, FIX_INSN, insn->target);
+            return;
+        case VM_FLOAT_JUMPNZ:
+        case VM_FLOAT_JUMPZ:
+            jit_arg_vm(e);
+            jit_call(e, &rendervm_jit_pop_float);
+            jit_emit_bytes(e, test_al, sizeof(test_al));
+            jit_jcc(e, (insn->opcode == VM_FLOAT_JUMPNZ) ? JCC_NZ : JCC_Z, FIX_INSN, insn->target);
+            return;
+        case VM_UINT8_POP:
+        case VM_UINT16_POP:
+        case VM_UINT32_POP:
+        case VM_FLOAT_POP:
+            // sub byte [rbx+sp], n
+            jit_emit8(e, 0x80);
+            jit_emit8(e, 0xab);
+            jit_emit32(e, sp);
+            jit_emit8(e, insn->u8);
+            return;
+        case VM_UINT8_PUSH:
+            jit_push_imm(e, sp, stack, w, insn->u8);
+            return;
+        case VM_UINT16_PUSH:
+            jit_push_imm(e, sp, stack, w, insn->u16);
+            return;
+        case VM_UINT32_PUSH:
+        case VM_FLOAT_PUSH:
+            jit_push_imm(e, sp, stack, w, insn->u32);
+            return;
+        case VM_UINT8_ADDN:
+            jit_addn(e, sp, stack, w, insn->u8);
+            return;
+        case VM_UINT16_ADDN:
+            jit_addn(e, sp, stack, w, insn->u16);
+            return;
+        case VM_UINT32_ADDN:
+            jit_addn(e, sp, stack, w, insn->u32);
+            return;
+        case VM_UINT8_ADD:
+        case VM_UINT16_ADD:
+        case VM_UINT32_ADD:
+            jit_binop(e, sp, stack, w, 0);
+            return;
+        case VM_UINT8_SUB:
+        case VM_UINT16_SUB:
+        case VM_UINT32_SUB:
+            jit_binop(e, sp, stack, w, 1);
+            return;
+        case VM_UINT8_MUL:
+        case VM_UINT16_MUL:
+        case VM_UINT32_MUL:
+            jit_binop(e, sp, stack, w, 2);
+            return;
+        case VM_FLOAT_LOAD:
+            jit_arg_vm(e);
+            jit_call(e, &rendervm_jit_float_load);
+            jit_emit_bytes(e, test_al, sizeof(test_al));
+            jit_jcc(e, JCC_Z, FIX_BUDGET, idx + 1);
+            return;
+        case VM_UINT32_REG_GET:
+            // Unverified register indexes are left to the interpreter.
+            if (insn->u8 > 9) {
+                break;
+            }
+            // mov edx, [rbx+draw_reg]
+            jit_emit8(e, 0x8b);
+            jit_emit8(e, 0x93);
+            jit_emit32(e, VM_OFF(draw_reg) + (insn->u8 * 4));
+            jit_load_stack(e, sp, stack);
+            jit_move_sp(e, sp, 1);
+            jit_write_top(e, w);
+            return;
+        case VM_UINT32_REG_SET:
+            if (insn->u8 > 9) {
+                break;
+            }
+            jit_pop_edx(e, sp, stack, w);
+            // mov [rbx+draw_reg], edx
+            jit_emit8(e, 0x89);
+            jit_emit8(e, 0x93);
+            jit_emit32(e, VM_OFF(draw_reg) + (insn->u8 * 4));
+            return;
+        default:
+            break;
+    }
+
+    vector_op = rendervm_vector_op(insn->opcode);
+    if (vector_op != NULL) {
+        // Vector and matrix opcodes call their implementation directly:
+        // mov esi, opcode; mov edx, n
+        jit_arg_vm(e);
+        jit_emit8(e, 0xbe);
+        jit_emit32(e, insn->opcode);
+        jit_emit8(e, 0xba);
+        jit_emit32(e, insn->u8);
+        jit_call(e, vector_op);
+        // LOAD and STORE stop the VM on an out of bounds address.
+        // cmp byte [rbx+running], 0
+        jit_emit8(e, 0x80);
+        jit_emit8(e, 0xbb);
+        jit_emit32(e, VM_OFF(running));
+        jit_emit8(e, 0x00);
+        jit_jcc(e, JCC_Z, FIX_BUDGET, idx + 1);
+        return;
+    }
+
+    if (insn->opcode > VM_MAT4_TRANSP) {
+        // Draw opcodes call straight into the callback attached at compile
+        // time.
+        if (vm->callback != NULL) {
+            jit_arg_vm(e);
+            jit_emit8(e, 0xbe);
+            jit_emit32(e, insn->opcode);
+            jit_emit8(e, 0x48);
+            jit_emit8(e, 0xba);
+            jit_emit64(e, (uint64_t)(uintptr_t)vm->user_data);
+            jit_call(e, vm->callback);
+            // The callback may have interrupted the VM.
+            // cmp byte [rbx+running], 0
+            jit_emit8(e, 0x80);
+            jit_emit8(e, 0xbb);
+            jit_emit32(e, VM_OFF(running));
+            jit_emit8(e, 0x00);
+            jit_jcc(e, JCC_Z, FIX_BUDGET, idx + 1);
+        }
+        return;
+    }
+
+    // Everything else goes through the byte interpreter one step at a time.
+    jit_arg_vm(e);
+    jit_emit_bytes(e, mov_rsi_r13, sizeof(mov_rsi_r13));
+    jit_emit8(e, 0xba);
+    jit_emit32(e, insn->pc);
+    jit_call(e, &rendervm_jit_step);
+    jit_emit_bytes(e, test_al, sizeof(test_al));
+    jit_jcc(e, JCC_Z, FIX_EPILOGUE, 0);
+}
+
+rendervm_jit_t* rendervm_jit_create(rendervm_t* vm, rendervm_code_t* code) {
+    static const uint8_t prologue[] = {
+        0x55,                   // push rbp
+        0x53,                   // push rbx
+        0x41, 0x54,             // push r12
+        0x41, 0x55,             // push r13
+        0x41, 0x56,             // push r14
+        0x48, 0x89, 0xfb,       // mov rbx, rdi
+        0x49, 0x89, 0xf6,       // mov r14, rsi
+        0x41, 0x89, 0xd4        // mov r12d, edx
+    };
+    static const uint8_t epilogue[] = {
+        0x44, 0x89, 0xe0,       // mov eax, r12d
+        0x41, 0x5e,             // pop r14
+        0x41, 0x5d,             // pop r13
+        0x41, 0x5c,             // pop r12
+        0x5b,                   // pop rbx
+        0x5d,                   // pop rbp
+        0xc3                    // ret
+    };
+    static const uint8_t test_budget[] = {0x45, 0x85, 0xe4};
+    static const uint8_t mov_rsi_r14[] = {0x4c, 0x89, 0xf6};
+    static const uint8_t jmp_rcx[] = {0xff, 0xe1};
+    rendervm_jit_t* jit;
+    rendervm_jit_emit_t e;
+    rendervm_jit_fixup_t* fixup;
+    uint8_t** budget_stubs;
+    uint8_t* target;
+    int32_t rel;
+    uint32_t i;
+
+    jit = malloc(sizeof(rendervm_jit_t));
+    memset(jit, 0, sizeof(rendervm_jit_t));
+    jit->code = code;
+
+    jit->size = ((code->nr_insns + 1) * (JIT_INSN_MAX + JIT_STUB_MAX)) + 256;
+    jit->mem = mmap(NULL, jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == jit->mem) {
+        free(jit);
+        return NULL;
+    }
+
+    jit->labels = malloc(sizeof(uint8_t*) * (code->nr_insns + 1));
+    budget_stubs = malloc(sizeof(uint8_t*) * (code->nr_insns + 1));
+
+    memset(&e, 0, sizeof(rendervm_jit_emit_t));
+    e.buf = jit->mem;
+    // At most two fixups per instruction and one per budget stub.
+    e.fixups = malloc(sizeof(rendervm_jit_fixup_t) * ((code->nr_insns + 1) * 3));
+
+    jit_emit_bytes(&e, prologue, sizeof(prologue));
+    // mov r13, code
+    jit_emit8(&e, 0x49);
+    jit_emit8(&e, 0xbd);
+    jit_emit64(&e, (uint64_t)(uintptr_t)code);
+    jit_emit_bytes(&e, jmp_rcx, sizeof(jmp_rcx));
+
+    for (i = 0; i < code->nr_insns; i++) {
+        jit->labels[i] = &e.buf[e.pos];
+        rendervm_jit_emit_insn(&e, vm, code, i);
+        // Fall through to the next instruction.
+    }
+
+    // Running off the end of the program.
+    jit->labels[code->nr_insns] = &e.buf[e.pos];
+    jit_emit_bytes(&e, test_budget, sizeof(test_budget));
+    jit_jcc(&e, JCC_Z, FIX_BUDGET, code->nr_insns);
+    jit_arg_vm(&e);
+    jit_emit_bytes(&e, mov_rsi_r14, sizeof(mov_rsi_r14));
+    jit_call(&e, &rendervm_jit_end);
+    jit_jmp(&e, FIX_EPILOGUE, 0);
+
+    // Budget exhausted before instruction i: leave pc pointing at it.
+    for (i = 0; i <= code->nr_insns; i++) {
+        budget_stubs[i] = &e.buf[e.pos];
+        jit_store16_vm(&e, VM_OFF(pc), code->insns[i].pc);
+        jit_jmp(&e, FIX_EPILOGUE, 0);
+    }
+
+    jit->epilogue = &e.buf[e.pos];
+    jit_emit_bytes(&e, epilogue, sizeof(epilogue));
+
+    for (i = 0; i < e.nr_fixups; i++) {
+        fixup = &e.fixups[i];
+        switch (fixup->kind) {
+            case FIX_INSN:
+                target = jit->labels[fixup->idx];
+                break;
+            case FIX_BUDGET:
+                target = budget_stubs[fixup->idx];
+                break;
+            default:
+                target = jit->epilogue;
+                break;
+        }
+        rel = (int32_t)(target - &e.buf[fixup->pos + 4]);
+        memcpy(&e.buf[fixup->pos], &rel, 4);
+    }
+
+    free(e.fixups);
+    free(budget_stubs);
+
+    if (mprotect(jit->mem, jit->size, PROT_READ | PROT_EXEC)) {
+        rendervm_jit_destroy(jit);
+        return NULL;
+    }
+
+    return jit;
+}
+
+void rendervm_jit_destroy(rendervm_jit_t* jit) {
+    munmap(jit->mem, jit->size);
+    free(jit->labels);
+    free(jit);
+}
+
+uint8_t rendervm_run_jit(rendervm_t* vm, rendervm_jit_t* jit, uint32_t budget) {
+    rendervm_code_t* code = jit->code;
+    rendervm_jit_entry_t entry = (rendervm_jit_entry_t)jit->mem;
+    uint8_t* start;
+    uint32_t left;
+
+    if (!vm->running) {
+        return 0;
+    }
+
+    // Compiled code keeps no counts, so profiled runs use threaded code.
+    if (vm->profile) {
+        return rendervm_run_code(vm, code, budget);
+    }
+
+    if (vm->pc >= code->length) {
+        start = jit->labels[code->nr_insns];
+    }
+    else if (0xffff == code->pc_map[vm->pc]) {
+        rendervm_exception(vm, VM_X_OUT_OF_BOUNDS);
+        return 0;
+    }
+    else {
+        start = jit->labels[code->pc_map[vm->pc]];
+    }
+
+    jit->ended = 0;
+    left = entry(vm, jit, budget, start);
+    vm->cycles += budget - left;
+
+    if (jit->ended) {
+        return 0;
+    }
+
+    vm->next_opcode = code->program[vm->pc < code->length ? vm->pc : code->length];
+    return vm->running;
+}
+
+#else
+
+rendervm_jit_t* rendervm_jit_create(rendervm_t* vm, rendervm_code_t* code) {
+    return NULL;
+}
+
+void rendervm_jit_destroy(rendervm_jit_t* jit) {
+}
+
+uint8_t rendervm_run_jit(rendervm_t* vm, rendervm_jit_t* jit, uint32_t budget) {
+    return rendervm_run_code(vm, jit->code, budget);
+}
+
+#endif
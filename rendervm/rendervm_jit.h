@@ -0,0 +1,28 @@
+#ifndef RENDERVM_JIT_H
+#define RENDERVM_JIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "rendervm.h"
+
+typedef struct rendervm_jit {
+    uint8_t* mem;
+    size_t size;
+    rendervm_code_t* code;
+    uint8_t** labels;
+    uint8_t* epilogue;
+    uint8_t ended;
+} rendervm_jit_t;
+
+// Compiles decoded code to native code. Only programs that passed
+// rendervm_verify() should be compiled, as the generated code does no stack
+// checks. The VM callback is called directly, so it must be attached before
+// compiling. Returns NULL on hosts other than x86-64.
+rendervm_jit_t* rendervm_jit_create(rendervm_t* vm, rendervm_code_t* code);
+
+void rendervm_jit_destroy(rendervm_jit_t* jit);
+
+// Same as rendervm_run_code() but runs the compiled program.
+uint8_t rendervm_run_jit(rendervm_t* vm, rendervm_jit_t* jit, uint32_t budget);
+
+#endif
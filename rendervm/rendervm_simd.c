@@ -0,0 +1,172 @@
+#include <stdint.h>
+#include <string.h>
+#include "rendervm_simd.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#define SIMD_LANES          4
+typedef __m128 simd_t;
+#define SIMD_LOAD(p)        _mm_load_ps(p)
+#define SIMD_LOADU(p)       _mm_loadu_ps(p)
+#define SIMD_STORE(p, v)    _mm_store_ps(p, v)
+#define SIMD_STOREU(p, v)   _mm_storeu_ps(p, v)
+#define SIMD_ADD(a, b)      _mm_add_ps(a, b)
+#define SIMD_SUB(a, b)      _mm_sub_ps(a, b)
+#define SIMD_MUL(a, b)      _mm_mul_ps(a, b)
+#define SIMD_SPLAT(f)       _mm_set1_ps(f)
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_LANES          4
+typedef float32x4_t simd_t;
+#define SIMD_LOAD(p)        vld1q_f32(p)
+#define SIMD_LOADU(p)       vld1q_f32(p)
+#define SIMD_STORE(p, v)    vst1q_f32(p, v)
+#define SIMD_STOREU(p, v)   vst1q_f32(p, v)
+#define SIMD_ADD(a, b)      vaddq_f32(a, b)
+#define SIMD_SUB(a, b)      vsubq_f32(a, b)
+#define SIMD_MUL(a, b)      vmulq_f32(a, b)
+#define SIMD_SPLAT(f)       vdupq_n_f32(f)
+#endif
+
+#define SIMD_OP_ADD 0
+#define SIMD_OP_SUB 1
+#define SIMD_OP_MUL 2
+
+static inline void rendervm_simd_lanes(float* out, const float* a, const float* b, uint8_t n, uint8_t op) {
+    uint8_t i = 0;
+
+#if defined(__AVX__)
+    for (; (i + 8) <= n; i += 8) {
+        __m256 va = _mm256_loadu_ps(&a[i]);
+        __m256 vb = _mm256_loadu_ps(&b[i]);
+        __m256 vr = (op == SIMD_OP_ADD) ? _mm256_add_ps(va, vb) : (op == SIMD_OP_SUB) ? _mm256_sub_ps(va, vb) : _mm256_mul_ps(va, vb);
+        _mm256_storeu_ps(&out[i], vr);
+    }
+#endif
+#if defined(SIMD_LANES)
+    for (; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+        simd_t va = SIMD_LOADU(&a[i]);
+        simd_t vb = SIMD_LOADU(&b[i]);
+        simd_t vr = (op == SIMD_OP_ADD) ? SIMD_ADD(va, vb) : (op == SIMD_OP_SUB) ? SIMD_SUB(va, vb) : SIMD_MUL(va, vb);
+        SIMD_STOREU(&out[i], vr);
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (op == SIMD_OP_ADD) ? a[i] + b[i] : (op == SIMD_OP_SUB) ? a[i] - b[i] : a[i] * b[i];
+    }
+}
+
+void rendervm_simd_add(float* out, const float* a, const float* b, uint8_t n) {
+    rendervm_simd_lanes(out, a, b, n, SIMD_OP_ADD);
+}
+
+void rendervm_simd_sub(float* out, const float* a, const float* b, uint8_t n) {
+    rendervm_simd_lanes(out, a, b, n, SIMD_OP_SUB);
+}
+
+void rendervm_simd_mul(float* out, const float* a, const float* b, uint8_t n) {
+    rendervm_simd_lanes(out, a, b, n, SIMD_OP_MUL);
+}
+
+uint8_t rendervm_simd_eq(const float* a, const float* b, uint8_t n) {
+    uint8_t i = 0;
+
+#if defined(__SSE__)
+    for (; (i + 4) <= n; i += 4) {
+        if (_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i]))) != 0x0f) {
+            return 0;
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; (i + 4) <= n; i += 4) {
+        uint32x4_t c = vceqq_f32(vld1q_f32(&a[i]), vld1q_f32(&b[i]));
+        uint32x2_t r = vand_u32(vget_low_u32(c), vget_high_u32(c));
+        if (!(vget_lane_u32(r, 0) & vget_lane_u32(r, 1))) {
+            return 0;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] != b[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void rendervm_simd_mulvec(float* out, const float* m, const float* v, uint8_t cols) {
+    uint8_t i;
+
+#if defined(SIMD_LANES)
+    simd_t acc = SIMD_MUL(SIMD_LOAD(m), SIMD_SPLAT(v[0]));
+    for (i = 1; i < cols; i++) {
+        acc = SIMD_ADD(acc, SIMD_MUL(SIMD_LOAD(&m[i * 4]), SIMD_SPLAT(v[i])));
+    }
+    SIMD_STORE(out, acc);
+#else
+    uint8_t r;
+    for (r = 0; r < 4; r++) {
+        out[r] = m[r] * v[0];
+        for (i = 1; i < cols; i++) {
+            out[r] += m[i * 4 + r] * v[i];
+        }
+    }
+#endif
+}
+
+void rendervm_simd_mulmat(float* out, const float* a, const float* b, uint8_t cols) {
+    float tmp[16] __attribute__((aligned(16)));
+    uint8_t i;
+
+    for (i = 0; i < cols; i++) {
+        rendervm_simd_mulvec(&tmp[i * 4], a, &b[i * 4], cols);
+    }
+    memcpy(out, tmp, sizeof(float) * 4 * cols);
+}
+
+void rendervm_simd_transpose(float* m, uint8_t cols) {
+    float tmp[16] __attribute__((aligned(16)));
+    uint8_t c, r;
+
+    memset(tmp, 0, sizeof(tmp));
+    memcpy(tmp, m, sizeof(float) * 4 * cols);
+
+#if defined(__SSE__)
+    {
+        __m128 c0 = _mm_load_ps(&tmp[0]);
+        __m128 c1 = _mm_load_ps(&tmp[4]);
+        __m128 c2 = _mm_load_ps(&tmp[8]);
+        __m128 c3 = _mm_load_ps(&tmp[12]);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_store_ps(&tmp[0], c0);
+        _mm_store_ps(&tmp[4], c1);
+        _mm_store_ps(&tmp[8], c2);
+        _mm_store_ps(&tmp[12], c3);
+    }
+#elif defined(__ARM_NEON)
+    {
+        float32x4x4_t t = vld4q_f32(tmp);
+        vst1q_f32(&tmp[0], t.val[0]);
+        vst1q_f32(&tmp[4], t.val[1]);
+        vst1q_f32(&tmp[8], t.val[2]);
+        vst1q_f32(&tmp[12], t.val[3]);
+    }
+#else
+    for (c = 0; c < 4; c++) {
+        for (r = c + 1; r < 4; r++) {
+            float f = tmp[c * 4 + r];
+            tmp[c * 4 + r] = tmp[r * 4 + c];
+            tmp[r * 4 + c] = f;
+        }
+    }
+#endif
+
+    for (c = 0; c < cols; c++) {
+        for (r = 0; r < 4; r++) {
+            m[c * 4 + r] = tmp[c * 4 + r];
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef RENDERVM_SIMD_H
+#define RENDERVM_SIMD_H
+
+#include <stdint.h>
+
+// Kernels behind the vector and matrix opcodes. Matrices are stored column
+// major with every column padded to 4 floats and 16 byte aligned, so one
+// column fits one SSE or NEON register. Plain C is used on other hosts.
+
+// Lane wise out = a op b over n floats, n being any count.
+void rendervm_simd_add(float* out, const float* a, const float* b, uint8_t n);
+void rendervm_simd_sub(float* out, const float* a, const float* b, uint8_t n);
+void rendervm_simd_mul(float* out, const float* a, const float* b, uint8_t n);
+
+// Returns 1 if the n floats of a and b are equal.
+uint8_t rendervm_simd_eq(const float* a, const float* b, uint8_t n);
+
+// out = m * v for a matrix with cols padded columns. v holds cols floats
+// and out gets 4. out may not overlap m.
+void rendervm_simd_mulvec(float* out, const float* m, const float* v, uint8_t cols);
+
+// out = a * b for two matrices with cols padded columns. out may overlap
+// either input.
+void rendervm_simd_mulmat(float* out, const float* a, const float* b, uint8_t cols);
+
+// Transposes a matrix with cols padded columns in place.
+void rendervm_simd_transpose(float* m, uint8_t cols);
+
+#endif
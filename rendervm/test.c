@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <math.h>
+#include <string.h>
 #include "rendervm.h"
+#include "rendervm_jit.h"
 #include "test_harness.h"
 
 /*
@@ -12,6 +14,8 @@ float _R4DP(float v) {
 }
 */
 
+uint8_t test_exec(test_harness_t* test, rendervm_t* vm, uint8_t* program, uint16_t length);
+
 void print_ctrl_stack(rendervm_t* vm) {
     uint16_t index = 0;
     if (vm->ctrl_sp == VM_MAX_ADDR) {
@@ -61,14 +65,14 @@ void print_vm(rendervm_t* vm) {
 
 void test_opcode_HALT(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_HALT};
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->running, 0, "OP HALT: stops VM");
     rendervm_reset(vm);
 }
 
 void test_opcode_YIELD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_YIELD};
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->running, 0, "OP YIELD: stops VM");
     is_equal_uint16(test, vm->pc, 1, "OP YIELD: leaves pc");
     rendervm_reset(vm);
@@ -76,7 +80,7 @@ void test_opcode_YIELD(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_RESET(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_RESET};
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->running, 1, "OP RESET: leaves VM running");
     is_equal_uint16(test, vm->pc, 0, "OP RESET: zeros pc");
     rendervm_reset(vm);
@@ -84,7 +88,7 @@ void test_opcode_RESET(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_CALL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_CALL, 0xbb, 0x01};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->running, 1, "OP CALL: leaves VM running");
     is_equal_uint16(test, vm->pc, 443, "OP CALL: pc correct");
     is_equal_uint16(test, vm->ctrl_stack[0], 3, "OP CALL: return address correct");
@@ -93,9 +97,9 @@ void test_opcode_CALL(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_RETURN(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_CALL, 0x04, 0x00, VM_HALT, VM_RETURN};
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_uint16(test, vm->pc, 4, "OP RETURN: pc correct");
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_uint8(test, vm->last_opcode, VM_RETURN, "OP RETURN: last opcode is RETURN");
     is_equal_uint16(test, vm->pc, 3, "OP RETURN: pc correct");
     rendervm_reset(vm);
@@ -103,7 +107,7 @@ void test_opcode_RETURN(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_JUMP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_JUMP, 0xbb, 0x01};
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->pc, 443, "OP JUMP: pc correct");
     rendervm_reset(vm);
 }
@@ -111,7 +115,7 @@ void test_opcode_JUMP(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT8_POP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_POP, 0x01};
     vm->uint8_stack[++vm->uint8_sp] = 0x05;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT8_POP: uint8_sp correct");
     rendervm_reset(vm);
 }
@@ -119,7 +123,7 @@ void test_opcode_UINT8_POP(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT8_DUP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_DUP, 0x01};
     vm->uint8_stack[++vm->uint8_sp] = 0x06;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint8_sp, 0x01, "OP UINT8_DUP: uint8_sp correct");
     is_equal_uint8(test, vm->uint8_stack[0], 0x06, "OP UINT8_DUP: first stack item correct");
     is_equal_uint8(test, vm->uint8_stack[1], 0x06, "OP UINT8_DUP: second stack item correct");
@@ -130,7 +134,7 @@ void test_opcode_UINT8_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_SWAP};
     vm->uint8_stack[++vm->uint8_sp] = 0x07;
     vm->uint8_stack[++vm->uint8_sp] = 0x08;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_sp, 0x01, "OP UINT8_SWAP: uint8_sp correct");
     is_equal_uint8(test, vm->uint8_stack[0], 0x08, "OP UINT8_SWAP: first stack item correct");
     is_equal_uint8(test, vm->uint8_stack[1], 0x07, "OP UINT8_SWAP: second stack item correct");
@@ -139,7 +143,7 @@ void test_opcode_UINT8_SWAP(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT8_JUMPEM(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_JUMPEM, 0x0a, 0x00};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->pc, 10, "OP UINT8_JUMPEM: pc correct");
     rendervm_reset(vm);
 }
@@ -150,7 +154,7 @@ void test_opcode_UINT8_STORE(test_harness_t* test, rendervm_t* vm) {
     vm->uint8_stack[++vm->uint8_sp] = 0x07;
     vm->uint8_memory = &memory[0];
     vm->uint8_memory_size = 1;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, memory[0], 0x07, "OP UINT8_STORE: memory stored");
     rendervm_reset(vm);
 }
@@ -160,7 +164,7 @@ void test_opcode_UINT8_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t memory[] = {0x00, 0x03};
     vm->uint8_memory = &memory[0];
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x03, "OP UINT8_LOAD: memory loaded");
     rendervm_reset(vm);
 }
@@ -169,7 +173,7 @@ void test_opcode_UINT8_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_ADD};
     vm->uint8_stack[++vm->uint8_sp] = 0x03;
     vm->uint8_stack[++vm->uint8_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x07, "OP UINT8_ADD: addition works");
     test_harness_make_note(test, "OP UINT8_ADD: TODO test overflow");
     rendervm_reset(vm);
@@ -179,7 +183,7 @@ void test_opcode_UINT8_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_SUB};
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
     vm->uint8_stack[++vm->uint8_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x06, "OP UINT8_SUB: subtraction works");
     test_harness_make_note(test, "OP UINT8_SUB: TODO test underflow");
     rendervm_reset(vm);
@@ -189,7 +193,7 @@ void test_opcode_UINT8_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_MUL};
     vm->uint8_stack[++vm->uint8_sp] = 0x02;
     vm->uint8_stack[++vm->uint8_sp] = 0x06;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x0c, "OP UINT8_MUL: multiplication works");
     test_harness_make_note(test, "OP UINT8_MUL: TODO test overflow");
     rendervm_reset(vm);
@@ -199,20 +203,20 @@ void test_opcode_UINT8_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_EQ};
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x01, "OP UINT8_EQ: equals works (true)");
     rendervm_reset(vm);
     vm->uint8_stack[++vm->uint8_sp] = 0x01;
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_stack[0], 0x00, "OP UINT8_EQ: equals works (false)");
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
 }
 
 void test_opcode_UINT8_ADDN(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_ADDN, 0x02};
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint8_stack[0], 0x0c, "OP UINT8_ADDN: adds correctly");
     rendervm_reset(vm);
 }
@@ -220,12 +224,12 @@ void test_opcode_UINT8_ADDN(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT8_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_JUMPNZ, 0x06, 0x00};
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT8_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT8_JUMPNZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint8_stack[++vm->uint8_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT8_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT8_JUMPNZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -234,12 +238,12 @@ void test_opcode_UINT8_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT8_JUMPZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_JUMPZ, 0x06, 0x00};
     vm->uint8_stack[++vm->uint8_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT8_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT8_JUMPZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint8_stack[++vm->uint8_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT8_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT8_JUMPZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -247,7 +251,7 @@ void test_opcode_UINT8_JUMPZ(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT8_PUSH(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT8_PUSH, 0x0f};
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint8_stack[0], 0x0f, "OP UINT8_PUSH: pushed value");
     rendervm_reset(vm);
 }
@@ -255,7 +259,7 @@ void test_opcode_UINT8_PUSH(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT16_POP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_POP, 0x01};
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint16_sp, VM_MAX_ADDR, "OP UINT16_POP: stack empty");
     rendervm_reset(vm);
 }
@@ -263,7 +267,7 @@ void test_opcode_UINT16_POP(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT16_DUP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_DUP, 0x01};
     vm->uint16_stack[++vm->uint16_sp] = 0x06;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint16_sp, 0x01, "OP UINT16_DUP: uint16_sp correct");
     is_equal_uint16(test, vm->uint16_stack[0], 0x06, "OP UINT16_DUP: first stack item correct");
     is_equal_uint16(test, vm->uint16_stack[1], 0x06, "OP UINT16_DUP: second stack item correct");
@@ -274,7 +278,7 @@ void test_opcode_UINT16_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_SWAP};
     vm->uint16_stack[++vm->uint16_sp] = 0x07;
     vm->uint16_stack[++vm->uint16_sp] = 0x08;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint16_sp, 0x01, "OP UINT16_SWAP: uint16_sp correct");
     is_equal_uint16(test, vm->uint16_stack[0], 0x08, "OP UINT16_SWAP: first stack item correct");
     is_equal_uint16(test, vm->uint16_stack[1], 0x07, "OP UINT16_SWAP: second stack item correct");
@@ -283,7 +287,7 @@ void test_opcode_UINT16_SWAP(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT16_JUMPEM(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_JUMPEM, 0x0a, 0x00};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->pc, 10, "OP UINT16_JUMPEM: pc correct");
     rendervm_reset(vm);
 }
@@ -294,7 +298,7 @@ void test_opcode_UINT16_STORE(test_harness_t* test, rendervm_t* vm) {
     vm->uint16_stack[++vm->uint16_sp] = 0x07;
     vm->uint16_memory = &memory[0];
     vm->uint16_memory_size = 1;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, memory[0], 0x07, "OP UINT16_STORE: memory stored");
     rendervm_reset(vm);
 }
@@ -304,7 +308,7 @@ void test_opcode_UINT16_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint16_t memory[] = {0x00, 0x03};
     vm->uint16_memory = &memory[0];
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x03, "OP UINT16_LOAD: memory loaded");
     rendervm_reset(vm);
 }
@@ -313,7 +317,7 @@ void test_opcode_UINT16_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_ADD};
     vm->uint16_stack[++vm->uint16_sp] = 0x03;
     vm->uint16_stack[++vm->uint16_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x07, "OP UINT16_ADD: addition works");
     test_harness_make_note(test, "OP UINT16_ADD: TODO test overflow");
     rendervm_reset(vm);
@@ -323,7 +327,7 @@ void test_opcode_UINT16_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_SUB};
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
     vm->uint16_stack[++vm->uint16_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x06, "OP UINT16_SUB: subtraction works");
     test_harness_make_note(test, "OP UINT16_SUB: TODO test underflow");
     rendervm_reset(vm);
@@ -333,7 +337,7 @@ void test_opcode_UINT16_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_MUL};
     vm->uint16_stack[++vm->uint16_sp] = 0x02;
     vm->uint16_stack[++vm->uint16_sp] = 0x06;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x0c, "OP UINT16_MUL: multiplication works");
     test_harness_make_note(test, "OP UINT16_MUL: TODO test overflow");
     rendervm_reset(vm);
@@ -343,20 +347,20 @@ void test_opcode_UINT16_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_EQ};
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x01, "OP UINT16_EQ: equals works (true)");
     rendervm_reset(vm);
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint16(test, vm->uint16_stack[0], 0x00, "OP UINT16_EQ: equals works (false)");
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
 }
 
 void test_opcode_UINT16_ADDN(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_ADDN, 0x02, 0x00};
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->uint16_stack[0], 0x0c, "OP UINT16_ADDN: adds correctly");
     rendervm_reset(vm);
 }
@@ -364,12 +368,12 @@ void test_opcode_UINT16_ADDN(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT16_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_JUMPNZ, 0x06, 0x00};
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint16_sp, VM_MAX_ADDR, "OP UINT16_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT16_JUMPNZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint16_stack[++vm->uint16_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint16_sp, VM_MAX_ADDR, "OP UINT16_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT16_JUMPNZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -378,12 +382,12 @@ void test_opcode_UINT16_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT16_JUMPZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_JUMPZ, 0x06, 0x00};
     vm->uint16_stack[++vm->uint16_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint16_sp, VM_MAX_ADDR, "OP UINT16_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT16_JUMPZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint16_stack[++vm->uint16_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint16_sp, VM_MAX_ADDR, "OP UINT16_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT16_JUMPZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -392,7 +396,7 @@ void test_opcode_UINT16_JUMPZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT16_MOVE_UINT8(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_MOVE_UINT8};
     vm->uint8_stack[++vm->uint8_sp] = 0x45;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT16_MOVE_UINT8: uint8 stack empty");
     is_equal_uint16(test, vm->uint16_stack[0], 0x45, "OP UINT16_MOVE_UINT8: has the value");
     rendervm_reset(vm);
@@ -400,7 +404,7 @@ void test_opcode_UINT16_MOVE_UINT8(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT16_PUSH(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT16_PUSH, 0x0f, 0x00};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->uint16_stack[0], 0x0f, "OP UINT16_PUSH: pushed value");
     rendervm_reset(vm);
 }
@@ -408,7 +412,7 @@ void test_opcode_UINT16_PUSH(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_POP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_POP, 0x01};
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_POP: stack empty");
     rendervm_reset(vm);
 }
@@ -416,7 +420,7 @@ void test_opcode_UINT32_POP(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_DUP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_DUP, 0x01};
     vm->uint32_stack[++vm->uint32_sp] = 0x06;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->uint32_sp, 0x01, "OP UINT32_DUP: uint32_sp correct");
     is_equal_uint32(test, vm->uint32_stack[0], 0x06, "OP UINT32_DUP: first stack item correct");
     is_equal_uint32(test, vm->uint32_stack[1], 0x06, "OP UINT32_DUP: second stack item correct");
@@ -427,7 +431,7 @@ void test_opcode_UINT32_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_SWAP};
     vm->uint32_stack[++vm->uint32_sp] = 0x07;
     vm->uint32_stack[++vm->uint32_sp] = 0x08;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint32_sp, 0x01, "OP UINT32_SWAP: uint32_sp correct");
     is_equal_uint32(test, vm->uint32_stack[0], 0x08, "OP UINT32_SWAP: first stack item correct");
     is_equal_uint32(test, vm->uint32_stack[1], 0x07, "OP UINT32_SWAP: second stack item correct");
@@ -436,7 +440,7 @@ void test_opcode_UINT32_SWAP(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT32_JUMPEM(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_JUMPEM, 0x0a, 0x00};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->pc, 10, "OP UINT32_JUMPEM: pc correct");
     rendervm_reset(vm);
 }
@@ -448,7 +452,7 @@ void test_opcode_UINT32_STORE(test_harness_t* test, rendervm_t* vm) {
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
     vm->uint32_memory = &memory[0];
     vm->uint32_memory_size = 2;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, memory[1], 0x07, "OP UINT32_STORE: memory stored");
     rendervm_reset(vm);
 }
@@ -458,7 +462,7 @@ void test_opcode_UINT32_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint32_t memory[] = {0x00, 0x03};
     vm->uint32_memory = &memory[0];
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x03, "OP UINT32_LOAD: memory loaded");
     rendervm_reset(vm);
 }
@@ -467,7 +471,7 @@ void test_opcode_UINT32_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_ADD};
     vm->uint32_stack[++vm->uint32_sp] = 0x03;
     vm->uint32_stack[++vm->uint32_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x07, "OP UINT32_ADD: addition works");
     test_harness_make_note(test, "OP UINT32_ADD: TODO test overflow");
     rendervm_reset(vm);
@@ -477,7 +481,7 @@ void test_opcode_UINT32_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_SUB};
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
     vm->uint32_stack[++vm->uint32_sp] = 0x04;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x06, "OP UINT32_SUB: subtraction works");
     test_harness_make_note(test, "OP UINT32_SUB: TODO test underflow");
     rendervm_reset(vm);
@@ -487,7 +491,7 @@ void test_opcode_UINT32_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_MUL};
     vm->uint32_stack[++vm->uint32_sp] = 0x02;
     vm->uint32_stack[++vm->uint32_sp] = 0x06;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x0c, "OP UINT32_MUL: multiplication works");
     test_harness_make_note(test, "OP UINT32_MUL: TODO test overflow");
     rendervm_reset(vm);
@@ -497,20 +501,20 @@ void test_opcode_UINT32_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_EQ};
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x01, "OP UINT32_EQ: equals works (true)");
     rendervm_reset(vm);
     vm->uint32_stack[++vm->uint32_sp] = 0x01;
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint32(test, vm->uint32_stack[0], 0x00, "OP UINT32_EQ: equals works (false)");
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
 }
 
 void test_opcode_UINT32_ADDN(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_ADDN, 0x02, 0x00, 0x00, 0x00};
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_uint32(test, vm->uint32_stack[0], 0x0c, "OP UINT32_ADDN: adds correctly");
     rendervm_reset(vm);
 }
@@ -518,12 +522,12 @@ void test_opcode_UINT32_ADDN(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_JUMPNZ, 0x06, 0x00};
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT32_JUMPNZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint32_stack[++vm->uint32_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT32_JUMPNZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -532,12 +536,12 @@ void test_opcode_UINT32_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_JUMPZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_JUMPZ, 0x06, 0x00};
     vm->uint32_stack[++vm->uint32_sp] = 0x00;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP UINT32_JUMPZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->uint32_stack[++vm->uint32_sp] = 0x0a;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP UINT32_JUMPZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -546,7 +550,7 @@ void test_opcode_UINT32_JUMPZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_MOVE_UINT8(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_MOVE_UINT8};
     vm->uint8_stack[++vm->uint8_sp] = 0x46;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "OP UINT32_MOVE_UINT8: uint8 stack empty");
     is_equal_uint32(test, vm->uint32_stack[0], 0x46, "OP UINT32_MOVE_UINT8: has the value");
     rendervm_reset(vm);
@@ -554,7 +558,7 @@ void test_opcode_UINT32_MOVE_UINT8(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_UINT32_PUSH(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_PUSH, 0x19, 0x00, 0x00, 0x00};
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_uint32(test, vm->uint32_stack[0], 25, "OP UINT32_PUSH: value correct");
     rendervm_reset(vm);
 }
@@ -562,25 +566,34 @@ void test_opcode_UINT32_PUSH(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_UINT32_REG_GET(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_REG_GET, 0x03};
     vm->draw_reg[3] = 25;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint32(test, vm->uint32_stack[0], 25, "OP UINT32_REG_GET: value correct");
     vm->draw_reg[3] = 0;
     rendervm_reset(vm);
+    program[1] = 0x0a;
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->uint32_sp, VM_MAX_ADDR, "OP UINT32_REG_GET: index out of range ignored");
+    rendervm_reset(vm);
 }
 
 void test_opcode_UINT32_REG_SET(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_UINT32_REG_SET, 0x03};
     vm->draw_reg[3] = 0;
     vm->uint32_stack[++vm->uint32_sp] = 25;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint32(test, vm->draw_reg[3], 25, "OP UINT32_REG_SET: value correct");
     rendervm_reset(vm);
+    program[1] = 0x0a;
+    vm->uint32_stack[++vm->uint32_sp] = 25;
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->uint32_sp, 0x00, "OP UINT32_REG_SET: index out of range ignored");
+    rendervm_reset(vm);
 }
 
 void test_opcode_FLOAT_POP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_POP, 0x01};
     vm->float_stack[++vm->float_sp] = 3.14f;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP FLOAT_POP: stack empty");
     rendervm_reset(vm);
 }
@@ -588,7 +601,7 @@ void test_opcode_FLOAT_POP(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_FLOAT_DUP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_DUP, 0x01};
     vm->float_stack[++vm->float_sp] = 6.0f;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->float_sp, 0x01, "OP FLOAT_DUP: float_sp correct");
     is_equal_float(test, vm->float_stack[0], 6.0f, "OP FLOAT_DUP: first stack item correct");
     is_equal_float(test, vm->float_stack[1], 6.0f, "OP FLOAT_DUP: second stack item correct");
@@ -599,7 +612,7 @@ void test_opcode_FLOAT_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_SWAP};
     vm->float_stack[++vm->float_sp] = 7.0f;
     vm->float_stack[++vm->float_sp] = 8.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_uint8(test, vm->float_sp, 0x01, "OP FLOAT_SWAP: float_sp correct");
     is_equal_float(test, vm->float_stack[0], 8.0f, "OP FLOAT_SWAP: first stack item correct");
     is_equal_float(test, vm->float_stack[1], 7.0f, "OP FLOAT_SWAP: second stack item correct");
@@ -608,7 +621,7 @@ void test_opcode_FLOAT_SWAP(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_FLOAT_JUMPEM(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_JUMPEM, 0x0a, 0x00};
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint16(test, vm->pc, 10, "OP FLOAT_JUMPEM: pc correct");
     rendervm_reset(vm);
 }
@@ -620,7 +633,7 @@ void test_opcode_FLOAT_STORE(test_harness_t* test, rendervm_t* vm) {
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
     vm->float_memory = &memory[0];
     vm->float_memory_size = 2;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_float(test, memory[1], 7.0f, "OP FLOAT_STORE: memory stored");
     rendervm_reset(vm);
 }
@@ -630,7 +643,7 @@ void test_opcode_FLOAT_LOAD(test_harness_t* test, rendervm_t* vm) {
     float_t memory[] = {0.0f, 3.0f};
     vm->float_memory = &memory[0];
     vm->uint16_stack[++vm->uint16_sp] = 0x01;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 3.0f, "OP FLOAT_LOAD: memory loaded");
     rendervm_reset(vm);
 }
@@ -639,7 +652,7 @@ void test_opcode_FLOAT_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_ADD};
     vm->float_stack[++vm->float_sp] = 3.0f;
     vm->float_stack[++vm->float_sp] = 4.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 7.0f, "OP FLOAT_ADD: addition works");
     rendervm_reset(vm);
 }
@@ -648,7 +661,7 @@ void test_opcode_FLOAT_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_SUB};
     vm->float_stack[++vm->float_sp] = 10.0f;
     vm->float_stack[++vm->float_sp] = 4.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 6.0f, "OP FLOAT_SUB: subtraction works");
     rendervm_reset(vm);
 }
@@ -657,7 +670,7 @@ void test_opcode_FLOAT_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_MUL};
     vm->float_stack[++vm->float_sp] = 2.0f;
     vm->float_stack[++vm->float_sp] = 6.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 12.0f, "OP FLOAT_MUL: multiplication works");
     rendervm_reset(vm);
 }
@@ -666,20 +679,20 @@ void test_opcode_FLOAT_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_EQ};
     vm->float_stack[++vm->float_sp] = 10.0f;
     vm->float_stack[++vm->float_sp] = 10.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 1.0f, "OP FLOAT_EQ: equals works (true)");
     rendervm_reset(vm);
     vm->float_stack[++vm->float_sp] = 1.0f;
     vm->float_stack[++vm->float_sp] = 10.0f;
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     is_equal_float(test, vm->float_stack[0], 0.0f, "OP FLOAT_EQ: equals works (false)");
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
 }
 
 void test_opcode_FLOAT_ADDN(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_ADDN, 0x00, 0x00, 0x00, 0x40};
     vm->float_stack[++vm->float_sp] = 10.0f;
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_float(test, vm->float_stack[0], 12.0f, "OP FLOAT_ADDN: adds correctly");
     rendervm_reset(vm);
 }
@@ -687,12 +700,12 @@ void test_opcode_FLOAT_ADDN(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_FLOAT_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_JUMPNZ, 0x06, 0x00};
     vm->float_stack[++vm->float_sp] = 10.0f;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP FLOAT_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP FLOAT_JUMPNZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->float_stack[++vm->float_sp] = 0.0f;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP FLOAT_JUMPNZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP FLOAT_JUMPNZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -701,12 +714,12 @@ void test_opcode_FLOAT_JUMPNZ(test_harness_t* test, rendervm_t* vm) {
 void test_opcode_FLOAT_JUMPZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_JUMPZ, 0x06, 0x00};
     vm->float_stack[++vm->float_sp] = 0.0f;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP FLOAT_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x06, "OP FLOAT_JUMPZ: program counter correct (jump)");
     rendervm_reset(vm);
     vm->float_stack[++vm->float_sp] = 10.0f;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP FLOAT_JUMPZ: stack empty");
     is_equal_uint16(test, vm->pc, 0x03, "OP FLOAT_JUMPZ: program counter correct (no jump)");
     rendervm_reset(vm);
@@ -714,7 +727,7 @@ void test_opcode_FLOAT_JUMPZ(test_harness_t* test, rendervm_t* vm) {
 
 void test_opcode_FLOAT_PUSH(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_FLOAT_PUSH, 0x00, 0x00, 0x20, 0x40};
-    rendervm_exec(vm, program, 5);
+    test_exec(test, vm, program, 5);
     is_equal_float(test, vm->float_stack[0], 2.5f, "OP FLOAT_PUSH: value correct");
     rendervm_reset(vm);
 }
@@ -723,7 +736,7 @@ void test_opcode_VEC2_POP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_POP, 0x01};
     vm->vec2_stack[++vm->vec2_sp] = 1.0f;
     vm->vec2_stack[++vm->vec2_sp] = 2.0f;
-    rendervm_exec(vm, program, 3);
+    test_exec(test, vm, program, 3);
     is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP VEC2_POP: stack empty");
     rendervm_reset(vm);
 }
@@ -732,7 +745,7 @@ void test_opcode_VEC2_DUP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_DUP, 0x01};
     vm->vec2_stack[++vm->vec2_sp] = 6.0f;
     vm->vec2_stack[++vm->vec2_sp] = 2.0f;
-    rendervm_exec(vm, program, 2);
+    test_exec(test, vm, program, 2);
     is_equal_uint8(test, vm->vec2_sp, 0x03, "OP VEC2_DUP: vec2_sp correct");
     is_equal_float(test, vm->vec2_stack[0], 6.0f, "OP VEC2_DUP: first stack item correct");
     is_equal_float(test, vm->vec2_stack[1], 2.0f, "OP VEC2_DUP: second stack item correct");
@@ -741,555 +754,1188 @@ void test_opcode_VEC2_DUP(test_harness_t* test, rendervm_t* vm) {
     rendervm_reset(vm);
 }
 
+void test_vector_push(float* stack, uint8_t* sp, const float* v, uint8_t n) {
+    uint8_t i;
+    for (i = 0; i < n; i++) {
+        stack[++(*sp)] = v[i];
+    }
+}
+
+uint8_t test_floats_equal(const float* provided, const float* desired, uint8_t n) {
+    uint8_t i;
+    for (i = 0; i < n; i++) {
+        if (fabsf(provided[i] - desired[i]) > 0.0001f) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 void test_opcode_VEC2_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f};
+    float b[] = {3.0f, 4.0f};
+    float desired[] = {3.0f, 4.0f, 1.0f, 2.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, b, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, 0x03, "OP VEC2_SWAP: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 4), 1, "OP VEC2_SWAP: stack items swapped");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC2_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC2_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP VEC2_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP VEC2_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float a[] = {5.0f, 6.0f};
+    vm->vec2_memory = &memory[0];
+    vm->vec2_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_float(test, memory[2], 5.0f, "OP VEC2_STORE: first component stored");
+    is_equal_float(test, memory[3], 6.0f, "OP VEC2_STORE: second component stored");
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP VEC2_STORE: stack empty");
+    rendervm_reset(vm);
+    vm->uint16_stack[++vm->uint16_sp] = 0x02;
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->exception, VM_X_OUT_OF_BOUNDS, "OP VEC2_STORE: address out of bounds");
+    vm->vec2_memory = NULL;
+    vm->vec2_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    vm->vec2_memory = &memory[0];
+    vm->vec2_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_LOAD: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, &memory[2], 2), 1, "OP VEC2_LOAD: memory loaded");
+    vm->vec2_memory = NULL;
+    vm->vec2_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f};
+    float b[] = {3.0f, 4.0f};
+    float desired[] = {4.0f, 6.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, b, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_ADD: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {5.0f, 7.0f};
+    float b[] = {1.0f, 2.0f};
+    float desired[] = {4.0f, 5.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, b, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_SUB: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {2.0f, 3.0f};
+    float b[] = {4.0f, 5.0f};
+    float desired[] = {8.0f, 15.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, b, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_MUL: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {2.0f, 3.0f};
+    float b[] = {2.0f, 4.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP VEC2_EQ: stack empty");
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP VEC2_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, b, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP VEC2_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f};
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, a, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP VEC2_EXPLODE: stack empty");
+    is_equal_uint8(test, vm->float_sp, 0x01, "OP VEC2_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, a, 2), 1, "OP VEC2_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f};
+    test_vector_push(vm->float_stack, &vm->float_sp, a, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP VEC2_IMPLODE: float stack empty");
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_IMPLODE: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, a, 2), 1, "OP VEC2_IMPLODE: components popped");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_MULMAT2(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_MULMAT2};
-    rendervm_exec(vm, program, 1);
+    float m[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float v[] = {1.0f, 1.0f};
+    float desired[] = {4.0f, 6.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, m, 8);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, VM_MAX_ADDR, "OP VEC2_MULMAT2: mat2 stack empty");
+    is_equal_uint8(test, vm->vec2_sp, 0x01, "OP VEC2_MULMAT2: vec2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_MULMAT2: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_MULMAT3(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_MULMAT3};
-    rendervm_exec(vm, program, 1);
+    float m[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 10.0f, 20.0f, 1.0f, 0.0f};
+    float v[] = {1.0f, 2.0f};
+    float desired[] = {11.0f, 22.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, m, 12);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, VM_MAX_ADDR, "OP VEC2_MULMAT3: mat3 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_MULMAT3: point translated");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC2_MULMAT4(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC2_MULMAT4};
-    rendervm_exec(vm, program, 1);
+    float m[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 10.0f, 20.0f, 30.0f, 1.0f};
+    float v[] = {1.0f, 2.0f};
+    float desired[] = {11.0f, 22.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, m, 16);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, VM_MAX_ADDR, "OP VEC2_MULMAT4: mat4 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec2_stack, desired, 2), 1, "OP VEC2_MULMAT4: point translated");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_POP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC3_POP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC3_POP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->vec3_sp, 0x03, "OP VEC3_POP: vec3_sp correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_DUP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC3_DUP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC3_DUP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->vec3_sp, 0x07, "OP VEC3_DUP: vec3_sp correct");
+    is_equal_uint8(test, test_floats_equal(&vm->vec3_stack[4], a, 4), 1, "OP VEC3_DUP: top item duplicated");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    float b[] = {4.0f, 5.0f, 6.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&vm->vec3_stack[0], b, 4), 1, "OP VEC3_SWAP: first stack item correct");
+    is_equal_uint8(test, test_floats_equal(&vm->vec3_stack[4], a, 4), 1, "OP VEC3_SWAP: second stack item correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC3_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC3_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP VEC3_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP VEC3_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 9.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    float desired[] = {1.0f, 2.0f, 3.0f, 9.0f};
+    vm->vec3_memory = &memory[0];
+    vm->vec3_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&memory[3], desired, 4), 1, "OP VEC3_STORE: memory stored");
+    is_equal_uint8(test, vm->vec3_sp, VM_MAX_ADDR, "OP VEC3_STORE: stack empty");
+    vm->vec3_memory = NULL;
+    vm->vec3_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f};
+    float desired[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    vm->vec3_memory = &memory[0];
+    vm->vec3_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec3_sp, 0x03, "OP VEC3_LOAD: vec3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_LOAD: memory loaded");
+    rendervm_reset(vm);
+    vm->uint16_stack[++vm->uint16_sp] = 0x02;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->exception, VM_X_OUT_OF_BOUNDS, "OP VEC3_LOAD: address out of bounds");
+    vm->vec3_memory = NULL;
+    vm->vec3_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    float b[] = {4.0f, 5.0f, 6.0f, 0.0f};
+    float desired[] = {5.0f, 7.0f, 9.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec3_sp, 0x03, "OP VEC3_ADD: vec3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {4.0f, 5.0f, 6.0f, 0.0f};
+    float b[] = {1.0f, 2.0f, 4.0f, 0.0f};
+    float desired[] = {3.0f, 3.0f, 2.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    float b[] = {4.0f, 5.0f, 6.0f, 0.0f};
+    float desired[] = {4.0f, 10.0f, 18.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    float b[] = {1.0f, 2.0f, 4.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP VEC3_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP VEC3_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec3_sp, VM_MAX_ADDR, "OP VEC3_EXPLODE: stack empty");
+    is_equal_uint8(test, vm->float_sp, 0x02, "OP VEC3_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, a, 3), 1, "OP VEC3_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f};
+    vm->vec3_stack[3] = 7.0f;
+    test_vector_push(vm->float_stack, &vm->float_sp, a, 3);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP VEC3_IMPLODE: float stack empty");
+    is_equal_uint8(test, vm->vec3_sp, 0x03, "OP VEC3_IMPLODE: vec3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, a, 4), 1, "OP VEC3_IMPLODE: components popped and padded");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_MULMAT3(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_MULMAT3};
-    rendervm_exec(vm, program, 1);
+    float m[] = {2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f, 4.0f, 0.0f};
+    float v[] = {1.0f, 1.0f, 1.0f, 0.0f};
+    float desired[] = {2.0f, 3.0f, 4.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, m, 12);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, v, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, VM_MAX_ADDR, "OP VEC3_MULMAT3: mat3 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_MULMAT3: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC3_MULMAT4(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC3_MULMAT4};
-    rendervm_exec(vm, program, 1);
+    float m[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 2.0f, 3.0f, 1.0f};
+    float v[] = {1.0f, 1.0f, 1.0f, 0.0f};
+    float desired[] = {2.0f, 3.0f, 4.0f, 0.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, m, 16);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, v, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, VM_MAX_ADDR, "OP VEC3_MULMAT4: mat4 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec3_stack, desired, 4), 1, "OP VEC3_MULMAT4: point translated");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_POP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC4_POP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC4_POP, 0x02};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->vec4_sp, VM_MAX_ADDR, "OP VEC4_POP: stack empty");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_DUP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC4_DUP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC4_DUP, 0x02};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 8);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->vec4_sp, 0x0f, "OP VEC4_DUP: vec4_sp correct");
+    is_equal_uint8(test, test_floats_equal(&vm->vec4_stack[8], a, 8), 1, "OP VEC4_DUP: top items duplicated");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float b[] = {5.0f, 6.0f, 7.0f, 8.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&vm->vec4_stack[0], b, 4), 1, "OP VEC4_SWAP: first stack item correct");
+    is_equal_uint8(test, test_floats_equal(&vm->vec4_stack[4], a, 4), 1, "OP VEC4_SWAP: second stack item correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_VEC4_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_VEC4_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP VEC4_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP VEC4_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[8];
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    memset(memory, 0, sizeof(memory));
+    vm->vec4_memory = &memory[0];
+    vm->vec4_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&memory[4], a, 4), 1, "OP VEC4_STORE: memory stored");
+    vm->vec4_memory = NULL;
+    vm->vec4_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    vm->vec4_memory = &memory[0];
+    vm->vec4_memory_size = 1;
+    vm->uint16_stack[++vm->uint16_sp] = 0x00;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec4_sp, 0x03, "OP VEC4_LOAD: vec4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, memory, 4), 1, "OP VEC4_LOAD: memory loaded");
+    vm->vec4_memory = NULL;
+    vm->vec4_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float b[] = {5.0f, 6.0f, 7.0f, 8.0f};
+    float desired[] = {6.0f, 8.0f, 10.0f, 12.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec4_sp, 0x03, "OP VEC4_ADD: vec4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, desired, 4), 1, "OP VEC4_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {5.0f, 6.0f, 7.0f, 8.0f};
+    float b[] = {1.0f, 2.0f, 3.0f, 5.0f};
+    float desired[] = {4.0f, 4.0f, 4.0f, 3.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, desired, 4), 1, "OP VEC4_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float b[] = {5.0f, 6.0f, 7.0f, 8.0f};
+    float desired[] = {5.0f, 12.0f, 21.0f, 32.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, desired, 4), 1, "OP VEC4_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float b[] = {1.0f, 2.0f, 3.0f, 5.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP VEC4_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, b, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP VEC4_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, 0x03, "OP VEC4_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, a, 4), 1, "OP VEC4_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    test_vector_push(vm->float_stack, &vm->float_sp, a, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP VEC4_IMPLODE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, a, 4), 1, "OP VEC4_IMPLODE: components popped");
     rendervm_reset(vm);
 }
 
 void test_opcode_VEC4_MULMAT4(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_VEC4_MULMAT4};
-    rendervm_exec(vm, program, 1);
+    float m[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float v[] = {1.0f, 0.0f, 2.0f, 1.0f};
+    float desired[] = {32.0f, 36.0f, 40.0f, 44.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, m, 16);
+    test_vector_push(vm->vec4_stack, &vm->vec4_sp, v, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, VM_MAX_ADDR, "OP VEC4_MULMAT4: mat4 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->vec4_stack, desired, 4), 1, "OP VEC4_MULMAT4: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_POP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT2_POP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT2_POP, 0x01};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_POP: mat2_sp correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_DUP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT2_DUP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT2_DUP, 0x01};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat2_sp, 0x0f, "OP MAT2_DUP: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat2_stack[8], a, 8), 1, "OP MAT2_DUP: top item duplicated");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 0.0f, 0.0f, 7.0f, 9.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, b, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&vm->mat2_stack[0], b, 8), 1, "OP MAT2_SWAP: first stack item correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat2_stack[8], a, 8), 1, "OP MAT2_SWAP: second stack item correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT2_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT2_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP MAT2_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP MAT2_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[8];
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    memset(memory, 0, sizeof(memory));
+    vm->mat2_memory = &memory[0];
+    vm->mat2_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&memory[4], desired, 4), 1, "OP MAT2_STORE: memory stored packed");
+    is_equal_uint8(test, vm->mat2_sp, VM_MAX_ADDR, "OP MAT2_STORE: stack empty");
+    vm->mat2_memory = NULL;
+    vm->mat2_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f, 4.0f};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    vm->mat2_memory = &memory[0];
+    vm->mat2_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_LOAD: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, a, 8), 1, "OP MAT2_LOAD: memory loaded padded");
+    vm->mat2_memory = NULL;
+    vm->mat2_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 0.0f, 0.0f, 7.0f, 9.0f, 0.0f, 0.0f};
+    float desired[] = {4.0f, 7.0f, 0.0f, 0.0f, 10.0f, 13.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, b, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_ADD: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 0.0f, 0.0f, 7.0f, 9.0f, 0.0f, 0.0f};
+    float desired[] = {-2.0f, -3.0f, 0.0f, 0.0f, -4.0f, -5.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, b, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_SUB: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 0.0f, 0.0f, 7.0f, 9.0f, 0.0f, 0.0f};
+    float desired[] = {18.0f, 26.0f, 0.0f, 0.0f, 34.0f, 50.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, b, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_MUL: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 0.0f, 0.0f, 7.0f, 9.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP MAT2_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, b, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP MAT2_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, VM_MAX_ADDR, "OP MAT2_EXPLODE: stack empty");
+    is_equal_uint8(test, vm->float_sp, 0x03, "OP MAT2_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, desired, 4), 1, "OP MAT2_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_IDENT(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_IDENT};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat2_sp, 0x07, "OP MAT2_IDENT: mat2_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_IDENT: identity pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float components[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    test_vector_push(vm->float_stack, &vm->float_sp, components, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT2_IMPLODE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, a, 8), 1, "OP MAT2_IMPLODE: components popped");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_ROTATE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_ROTATE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float desired[] = {2.315859f, 3.672867f, 0.0f, 0.0f, 2.153322f, 2.551479f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    vm->float_stack[++vm->float_sp] = 0.5f;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT2_ROTATE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_ROTATE: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_SCALE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_SCALE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float v[] = {2.0f, 3.0f};
+    float desired[] = {2.0f, 4.0f, 0.0f, 0.0f, 9.0f, 12.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP MAT2_SCALE: vec2 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_SCALE: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT2_TRANSP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT2_TRANSP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 0.0f, 0.0f, 3.0f, 4.0f, 0.0f, 0.0f};
+    float desired[] = {1.0f, 3.0f, 0.0f, 0.0f, 2.0f, 4.0f, 0.0f, 0.0f};
+    test_vector_push(vm->mat2_stack, &vm->mat2_sp, a, 8);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->mat2_stack, desired, 8), 1, "OP MAT2_TRANSP: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_POP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT3_POP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT3_POP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_POP: mat3_sp correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_DUP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT3_DUP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT3_DUP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat3_sp, 0x17, "OP MAT3_DUP: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat3_stack[12], a, 12), 1, "OP MAT3_DUP: top item duplicated");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 0.0f, 9.0f, 11.0f, 13.0f, 0.0f, 15.0f, 17.0f, 19.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, b, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&vm->mat3_stack[0], b, 12), 1, "OP MAT3_SWAP: first stack item correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat3_stack[12], a, 12), 1, "OP MAT3_SWAP: second stack item correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT3_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT3_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP MAT3_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP MAT3_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[18];
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    memset(memory, 0, sizeof(memory));
+    vm->mat3_memory = &memory[0];
+    vm->mat3_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&memory[9], desired, 9), 1, "OP MAT3_STORE: memory stored packed");
+    is_equal_uint8(test, vm->mat3_sp, VM_MAX_ADDR, "OP MAT3_STORE: stack empty");
+    vm->mat3_memory = NULL;
+    vm->mat3_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    vm->mat3_memory = &memory[0];
+    vm->mat3_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_LOAD: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, a, 12), 1, "OP MAT3_LOAD: memory loaded padded");
+    vm->mat3_memory = NULL;
+    vm->mat3_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 0.0f, 9.0f, 11.0f, 13.0f, 0.0f, 15.0f, 17.0f, 19.0f, 0.0f};
+    float desired[] = {4.0f, 7.0f, 10.0f, 0.0f, 13.0f, 16.0f, 19.0f, 0.0f, 22.0f, 25.0f, 28.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, b, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_ADD: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 0.0f, 9.0f, 11.0f, 13.0f, 0.0f, 15.0f, 17.0f, 19.0f, 0.0f};
+    float desired[] = {-2.0f, -3.0f, -4.0f, 0.0f, -5.0f, -6.0f, -7.0f, 0.0f, -8.0f, -9.0f, -10.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, b, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_SUB: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 0.0f, 9.0f, 11.0f, 13.0f, 0.0f, 15.0f, 17.0f, 19.0f, 0.0f};
+    float desired[] = {72.0f, 87.0f, 102.0f, 0.0f, 144.0f, 177.0f, 210.0f, 0.0f, 216.0f, 267.0f, 318.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, b, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_MUL: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 0.0f, 9.0f, 11.0f, 13.0f, 0.0f, 15.0f, 17.0f, 19.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP MAT3_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, b, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP MAT3_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, VM_MAX_ADDR, "OP MAT3_EXPLODE: stack empty");
+    is_equal_uint8(test, vm->float_sp, 0x08, "OP MAT3_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, desired, 9), 1, "OP MAT3_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_IDENT(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_IDENT};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat3_sp, 0x0b, "OP MAT3_IDENT: mat3_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_IDENT: identity pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float components[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->float_stack, &vm->float_sp, components, 9);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT3_IMPLODE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, a, 12), 1, "OP MAT3_IMPLODE: components popped");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_ROTATE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_ROTATE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float desired[] = {2.795285f, 4.152293f, 5.509301f, 0.0f, 3.030905f, 3.429062f, 3.827219f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    vm->float_stack[++vm->float_sp] = 0.5f;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT3_ROTATE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_ROTATE: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_SCALE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_SCALE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float v[] = {2.0f, 3.0f};
+    float desired[] = {2.0f, 4.0f, 6.0f, 0.0f, 12.0f, 15.0f, 18.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP MAT3_SCALE: vec2 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_SCALE: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_TRANSL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_TRANSL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float v[] = {5.0f, 6.0f};
+    float desired[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 36.0f, 48.0f, 60.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_vector_push(vm->vec2_stack, &vm->vec2_sp, v, 2);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR, "OP MAT3_TRANSL: vec2 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_TRANSL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT3_TRANSP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT3_TRANSP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 0.0f, 4.0f, 5.0f, 6.0f, 0.0f, 7.0f, 8.0f, 9.0f, 0.0f};
+    float desired[] = {1.0f, 4.0f, 7.0f, 0.0f, 2.0f, 5.0f, 8.0f, 0.0f, 3.0f, 6.0f, 9.0f, 0.0f};
+    test_vector_push(vm->mat3_stack, &vm->mat3_sp, a, 12);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->mat3_stack, desired, 12), 1, "OP MAT3_TRANSP: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_POP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT4_POP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT4_POP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_POP: mat4_sp correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_DUP(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT4_DUP};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT4_DUP, 0x01};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 2);
+    is_equal_uint8(test, vm->mat4_sp, 0x1f, "OP MAT4_DUP: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat4_stack[16], a, 16), 1, "OP MAT4_DUP: top item duplicated");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_SWAP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_SWAP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 9.0f, 11.0f, 13.0f, 15.0f, 17.0f, 19.0f, 21.0f, 23.0f, 25.0f, 27.0f, 29.0f, 31.0f, 33.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, b, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&vm->mat4_stack[0], b, 16), 1, "OP MAT4_SWAP: first stack item correct");
+    is_equal_uint8(test, test_floats_equal(&vm->mat4_stack[16], a, 16), 1, "OP MAT4_SWAP: second stack item correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_JUMPEM(test_harness_t* test, rendervm_t* vm) {
-    uint8_t program[] = {VM_MAT4_JUMPEM};
-    rendervm_exec(vm, program, 1);
+    uint8_t program[] = {VM_MAT4_JUMPEM, 0x06, 0x00};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x06, "OP MAT4_JUMPEM: program counter correct (jump)");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 3);
+    is_equal_uint16(test, vm->pc, 0x03, "OP MAT4_JUMPEM: program counter correct (no jump)");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_STORE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_STORE};
-    rendervm_exec(vm, program, 1);
+    float memory[32];
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    memset(memory, 0, sizeof(memory));
+    vm->mat4_memory = &memory[0];
+    vm->mat4_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(&memory[16], desired, 16), 1, "OP MAT4_STORE: memory stored packed");
+    is_equal_uint8(test, vm->mat4_sp, VM_MAX_ADDR, "OP MAT4_STORE: stack empty");
+    vm->mat4_memory = NULL;
+    vm->mat4_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_LOAD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_LOAD};
-    rendervm_exec(vm, program, 1);
+    float memory[] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    vm->mat4_memory = &memory[0];
+    vm->mat4_memory_size = 2;
+    vm->uint16_stack[++vm->uint16_sp] = 0x01;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_LOAD: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, a, 16), 1, "OP MAT4_LOAD: memory loaded padded");
+    vm->mat4_memory = NULL;
+    vm->mat4_memory_size = 0;
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_ADD(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_ADD};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 9.0f, 11.0f, 13.0f, 15.0f, 17.0f, 19.0f, 21.0f, 23.0f, 25.0f, 27.0f, 29.0f, 31.0f, 33.0f};
+    float desired[] = {4.0f, 7.0f, 10.0f, 13.0f, 16.0f, 19.0f, 22.0f, 25.0f, 28.0f, 31.0f, 34.0f, 37.0f, 40.0f, 43.0f, 46.0f, 49.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, b, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_ADD: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_ADD: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_SUB(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_SUB};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 9.0f, 11.0f, 13.0f, 15.0f, 17.0f, 19.0f, 21.0f, 23.0f, 25.0f, 27.0f, 29.0f, 31.0f, 33.0f};
+    float desired[] = {-2.0f, -3.0f, -4.0f, -5.0f, -6.0f, -7.0f, -8.0f, -9.0f, -10.0f, -11.0f, -12.0f, -13.0f, -14.0f, -15.0f, -16.0f, -17.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, b, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_SUB: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_SUB: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_MUL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_MUL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 9.0f, 11.0f, 13.0f, 15.0f, 17.0f, 19.0f, 21.0f, 23.0f, 25.0f, 27.0f, 29.0f, 31.0f, 33.0f};
+    float desired[] = {208.0f, 232.0f, 256.0f, 280.0f, 432.0f, 488.0f, 544.0f, 600.0f, 656.0f, 744.0f, 832.0f, 920.0f, 880.0f, 1000.0f, 1120.0f, 1240.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, b, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_MUL: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_MUL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_EQ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_EQ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float b[] = {3.0f, 5.0f, 7.0f, 9.0f, 11.0f, 13.0f, 15.0f, 17.0f, 19.0f, 21.0f, 23.0f, 25.0f, 27.0f, 29.0f, 31.0f, 33.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 1, "OP MAT4_EQ: equal");
+    rendervm_reset(vm);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, b, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->uint8_stack[vm->uint8_sp], 0, "OP MAT4_EQ: not equal");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_EXPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_EXPLODE};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, VM_MAX_ADDR, "OP MAT4_EXPLODE: stack empty");
+    is_equal_uint8(test, vm->float_sp, 0x0f, "OP MAT4_EXPLODE: float_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->float_stack, desired, 16), 1, "OP MAT4_EXPLODE: components pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_IDENT(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_IDENT};
-    rendervm_exec(vm, program, 1);
+    float desired[] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->mat4_sp, 0x0f, "OP MAT4_IDENT: mat4_sp correct");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_IDENT: identity pushed");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_IMPLODE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_IMPLODE};
-    rendervm_exec(vm, program, 1);
+    float components[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->float_stack, &vm->float_sp, components, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT4_IMPLODE: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, a, 16), 1, "OP MAT4_IMPLODE: components popped");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_ROTATEX(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_ROTATEX};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 8.702743f, 10.05975f, 11.41676f, 12.77377f, 5.501115f, 5.899272f, 6.297429f, 6.695586f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    vm->float_stack[++vm->float_sp] = 0.5f;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT4_ROTATEX: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_ROTATEX: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_ROTATEY(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_ROTATEY};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float desired[] = {-3.437247f, -3.03909f, -2.640933f, -2.242776f, 5.0f, 6.0f, 7.0f, 8.0f, 8.377669f, 9.734677f, 11.09168f, 12.44869f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    vm->float_stack[++vm->float_sp] = 0.5f;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT4_ROTATEY: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_ROTATEY: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_ROTATEZ(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_ROTATEZ};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float desired[] = {3.27471f, 4.631718f, 5.988726f, 7.345735f, 3.908487f, 4.306644f, 4.704801f, 5.102958f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    vm->float_stack[++vm->float_sp] = 0.5f;
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->float_sp, VM_MAX_ADDR, "OP MAT4_ROTATEZ: float stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_ROTATEZ: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_SCALE(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_SCALE};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float v[] = {2.0f, 3.0f, 4.0f, 0.0f};
+    float desired[] = {2.0f, 4.0f, 6.0f, 8.0f, 15.0f, 18.0f, 21.0f, 24.0f, 36.0f, 40.0f, 44.0f, 48.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, v, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec3_sp, VM_MAX_ADDR, "OP MAT4_SCALE: vec3 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_SCALE: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_TRANSL(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_TRANSL};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float v[] = {5.0f, 6.0f, 7.0f, 0.0f};
+    float desired[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 111.0f, 130.0f, 149.0f, 168.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_vector_push(vm->vec3_stack, &vm->vec3_sp, v, 4);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, vm->vec3_sp, VM_MAX_ADDR, "OP MAT4_TRANSL: vec3 stack empty");
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_TRANSL: result correct");
     rendervm_reset(vm);
 }
 
 void test_opcode_MAT4_TRANSP(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {VM_MAT4_TRANSP};
-    rendervm_exec(vm, program, 1);
+    float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f};
+    float desired[] = {1.0f, 5.0f, 9.0f, 13.0f, 2.0f, 6.0f, 10.0f, 14.0f, 3.0f, 7.0f, 11.0f, 15.0f, 4.0f, 8.0f, 12.0f, 16.0f};
+    test_vector_push(vm->mat4_stack, &vm->mat4_sp, a, 16);
+    test_exec(test, vm, program, 1);
+    is_equal_uint8(test, test_floats_equal(vm->mat4_stack, desired, 16), 1, "OP MAT4_TRANSP: result correct");
     rendervm_reset(vm);
 }
 
@@ -1302,7 +1948,7 @@ void test_opcode_CUSTOM_callback(rendervm_t* vm, rendervm_opcode_t opcode, void*
 void test_opcode_CUSTOM(test_harness_t* test, rendervm_t* vm) {
     uint8_t program[] = {0xc8};
     rendervm_attach_callback(vm, test_opcode_CUSTOM_callback, (void*)test);
-    rendervm_exec(vm, program, 1);
+    test_exec(test, vm, program, 1);
     rendervm_reset(vm);
 }
 
@@ -1375,101 +2021,763 @@ void test_all_opcodes(test_harness_t* test, rendervm_t* vm) {
     test_opcode_FLOAT_PUSH(test, vm);
     test_opcode_VEC2_POP(test, vm);
     test_opcode_VEC2_DUP(test, vm);
-    //test_opcode_VEC2_SWAP(test, vm);
-    //test_opcode_VEC2_JUMPEM(test, vm);
-    //test_opcode_VEC2_STORE(test, vm);
-    //test_opcode_VEC2_LOAD(test, vm);
-    //test_opcode_VEC2_ADD(test, vm);
-    //test_opcode_VEC2_SUB(test, vm);
-    //test_opcode_VEC2_MUL(test, vm);
-    //test_opcode_VEC2_EQ(test, vm);
-    //test_opcode_VEC2_EXPLODE(test, vm);
-    //test_opcode_VEC2_IMPLODE(test, vm);
-    //test_opcode_VEC2_MULMAT2(test, vm);
-    //test_opcode_VEC2_MULMAT3(test, vm);
-    //test_opcode_VEC2_MULMAT4(test, vm);
-    //test_opcode_VEC3_POP(test, vm);
-    //test_opcode_VEC3_DUP(test, vm);
-    //test_opcode_VEC3_SWAP(test, vm);
-    //test_opcode_VEC3_JUMPEM(test, vm);
-    //test_opcode_VEC3_STORE(test, vm);
-    //test_opcode_VEC3_LOAD(test, vm);
-    //test_opcode_VEC3_ADD(test, vm);
-    //test_opcode_VEC3_SUB(test, vm);
-    //test_opcode_VEC3_MUL(test, vm);
-    //test_opcode_VEC3_EQ(test, vm);
-    //test_opcode_VEC3_EXPLODE(test, vm);
-    //test_opcode_VEC3_IMPLODE(test, vm);
-    //test_opcode_VEC3_MULMAT3(test, vm);
-    //test_opcode_VEC3_MULMAT4(test, vm);
-    //test_opcode_VEC4_POP(test, vm);
-    //test_opcode_VEC4_DUP(test, vm);
-    //test_opcode_VEC4_SWAP(test, vm);
-    //test_opcode_VEC4_JUMPEM(test, vm);
-    //test_opcode_VEC4_STORE(test, vm);
-    //test_opcode_VEC4_LOAD(test, vm);
-    //test_opcode_VEC4_ADD(test, vm);
-    //test_opcode_VEC4_SUB(test, vm);
-    //test_opcode_VEC4_MUL(test, vm);
-    //test_opcode_VEC4_EQ(test, vm);
-    //test_opcode_VEC4_EXPLODE(test, vm);
-    //test_opcode_VEC4_IMPLODE(test, vm);
-    //test_opcode_VEC4_MULMAT4(test, vm);
-    //test_opcode_MAT2_POP(test, vm);
-    //test_opcode_MAT2_DUP(test, vm);
-    //test_opcode_MAT2_SWAP(test, vm);
-    //test_opcode_MAT2_JUMPEM(test, vm);
-    //test_opcode_MAT2_STORE(test, vm);
-    //test_opcode_MAT2_LOAD(test, vm);
-    //test_opcode_MAT2_ADD(test, vm);
-    //test_opcode_MAT2_SUB(test, vm);
-    //test_opcode_MAT2_MUL(test, vm);
-    //test_opcode_MAT2_EQ(test, vm);
-    //test_opcode_MAT2_EXPLODE(test, vm);
-    //test_opcode_MAT2_IDENT(test, vm);
-    //test_opcode_MAT2_IMPLODE(test, vm);
-    //test_opcode_MAT2_ROTATE(test, vm);
-    //test_opcode_MAT2_SCALE(test, vm);
-    //test_opcode_MAT2_TRANSP(test, vm);
-    //test_opcode_MAT3_POP(test, vm);
-    //test_opcode_MAT3_DUP(test, vm);
-    //test_opcode_MAT3_SWAP(test, vm);
-    //test_opcode_MAT3_JUMPEM(test, vm);
-    //test_opcode_MAT3_STORE(test, vm);
-    //test_opcode_MAT3_LOAD(test, vm);
-    //test_opcode_MAT3_ADD(test, vm);
-    //test_opcode_MAT3_SUB(test, vm);
-    //test_opcode_MAT3_MUL(test, vm);
-    //test_opcode_MAT3_EQ(test, vm);
-    //test_opcode_MAT3_EXPLODE(test, vm);
-    //test_opcode_MAT3_IDENT(test, vm);
-    //test_opcode_MAT3_IMPLODE(test, vm);
-    //test_opcode_MAT3_ROTATE(test, vm);
-    //test_opcode_MAT3_SCALE(test, vm);
-    //test_opcode_MAT3_TRANSL(test, vm);
-    //test_opcode_MAT3_TRANSP(test, vm);
-    //test_opcode_MAT4_POP(test, vm);
-    //test_opcode_MAT4_DUP(test, vm);
-    //test_opcode_MAT4_SWAP(test, vm);
-    //test_opcode_MAT4_JUMPEM(test, vm);
-    //test_opcode_MAT4_STORE(test, vm);
-    //test_opcode_MAT4_LOAD(test, vm);
-    //test_opcode_MAT4_ADD(test, vm);
-    //test_opcode_MAT4_SUB(test, vm);
-    //test_opcode_MAT4_MUL(test, vm);
-    //test_opcode_MAT4_EQ(test, vm);
-    //test_opcode_MAT4_EXPLODE(test, vm);
-    //test_opcode_MAT4_IDENT(test, vm);
-    //test_opcode_MAT4_IMPLODE(test, vm);
-    //test_opcode_MAT4_ROTATEX(test, vm);
-    //test_opcode_MAT4_ROTATEY(test, vm);
-    //test_opcode_MAT4_ROTATEZ(test, vm);
-    //test_opcode_MAT4_SCALE(test, vm);
-    //test_opcode_MAT4_TRANSL(test, vm);
-    //test_opcode_MAT4_TRANSP(test, vm);
+    test_opcode_VEC2_SWAP(test, vm);
+    test_opcode_VEC2_JUMPEM(test, vm);
+    test_opcode_VEC2_STORE(test, vm);
+    test_opcode_VEC2_LOAD(test, vm);
+    test_opcode_VEC2_ADD(test, vm);
+    test_opcode_VEC2_SUB(test, vm);
+    test_opcode_VEC2_MUL(test, vm);
+    test_opcode_VEC2_EQ(test, vm);
+    test_opcode_VEC2_EXPLODE(test, vm);
+    test_opcode_VEC2_IMPLODE(test, vm);
+    test_opcode_VEC2_MULMAT2(test, vm);
+    test_opcode_VEC2_MULMAT3(test, vm);
+    test_opcode_VEC2_MULMAT4(test, vm);
+    test_opcode_VEC3_POP(test, vm);
+    test_opcode_VEC3_DUP(test, vm);
+    test_opcode_VEC3_SWAP(test, vm);
+    test_opcode_VEC3_JUMPEM(test, vm);
+    test_opcode_VEC3_STORE(test, vm);
+    test_opcode_VEC3_LOAD(test, vm);
+    test_opcode_VEC3_ADD(test, vm);
+    test_opcode_VEC3_SUB(test, vm);
+    test_opcode_VEC3_MUL(test, vm);
+    test_opcode_VEC3_EQ(test, vm);
+    test_opcode_VEC3_EXPLODE(test, vm);
+    test_opcode_VEC3_IMPLODE(test, vm);
+    test_opcode_VEC3_MULMAT3(test, vm);
+    test_opcode_VEC3_MULMAT4(test, vm);
+    test_opcode_VEC4_POP(test, vm);
+    test_opcode_VEC4_DUP(test, vm);
+    test_opcode_VEC4_SWAP(test, vm);
+    test_opcode_VEC4_JUMPEM(test, vm);
+    test_opcode_VEC4_STORE(test, vm);
+    test_opcode_VEC4_LOAD(test, vm);
+    test_opcode_VEC4_ADD(test, vm);
+    test_opcode_VEC4_SUB(test, vm);
+    test_opcode_VEC4_MUL(test, vm);
+    test_opcode_VEC4_EQ(test, vm);
+    test_opcode_VEC4_EXPLODE(test, vm);
+    test_opcode_VEC4_IMPLODE(test, vm);
+    test_opcode_VEC4_MULMAT4(test, vm);
+    test_opcode_MAT2_POP(test, vm);
+    test_opcode_MAT2_DUP(test, vm);
+    test_opcode_MAT2_SWAP(test, vm);
+    test_opcode_MAT2_JUMPEM(test, vm);
+    test_opcode_MAT2_STORE(test, vm);
+    test_opcode_MAT2_LOAD(test, vm);
+    test_opcode_MAT2_ADD(test, vm);
+    test_opcode_MAT2_SUB(test, vm);
+    test_opcode_MAT2_MUL(test, vm);
+    test_opcode_MAT2_EQ(test, vm);
+    test_opcode_MAT2_EXPLODE(test, vm);
+    test_opcode_MAT2_IDENT(test, vm);
+    test_opcode_MAT2_IMPLODE(test, vm);
+    test_opcode_MAT2_ROTATE(test, vm);
+    test_opcode_MAT2_SCALE(test, vm);
+    test_opcode_MAT2_TRANSP(test, vm);
+    test_opcode_MAT3_POP(test, vm);
+    test_opcode_MAT3_DUP(test, vm);
+    test_opcode_MAT3_SWAP(test, vm);
+    test_opcode_MAT3_JUMPEM(test, vm);
+    test_opcode_MAT3_STORE(test, vm);
+    test_opcode_MAT3_LOAD(test, vm);
+    test_opcode_MAT3_ADD(test, vm);
+    test_opcode_MAT3_SUB(test, vm);
+    test_opcode_MAT3_MUL(test, vm);
+    test_opcode_MAT3_EQ(test, vm);
+    test_opcode_MAT3_EXPLODE(test, vm);
+    test_opcode_MAT3_IDENT(test, vm);
+    test_opcode_MAT3_IMPLODE(test, vm);
+    test_opcode_MAT3_ROTATE(test, vm);
+    test_opcode_MAT3_SCALE(test, vm);
+    test_opcode_MAT3_TRANSL(test, vm);
+    test_opcode_MAT3_TRANSP(test, vm);
+    test_opcode_MAT4_POP(test, vm);
+    test_opcode_MAT4_DUP(test, vm);
+    test_opcode_MAT4_SWAP(test, vm);
+    test_opcode_MAT4_JUMPEM(test, vm);
+    test_opcode_MAT4_STORE(test, vm);
+    test_opcode_MAT4_LOAD(test, vm);
+    test_opcode_MAT4_ADD(test, vm);
+    test_opcode_MAT4_SUB(test, vm);
+    test_opcode_MAT4_MUL(test, vm);
+    test_opcode_MAT4_EQ(test, vm);
+    test_opcode_MAT4_EXPLODE(test, vm);
+    test_opcode_MAT4_IDENT(test, vm);
+    test_opcode_MAT4_IMPLODE(test, vm);
+    test_opcode_MAT4_ROTATEX(test, vm);
+    test_opcode_MAT4_ROTATEY(test, vm);
+    test_opcode_MAT4_ROTATEZ(test, vm);
+    test_opcode_MAT4_SCALE(test, vm);
+    test_opcode_MAT4_TRANSL(test, vm);
+    test_opcode_MAT4_TRANSP(test, vm);
     test_opcode_CUSTOM(test, vm);
 }
 
+void test_run_until_yield(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_PUSH, 0x02, VM_UINT8_ADD, VM_YIELD, VM_UINT8_PUSH, 0x04};
+    uint8_t ret;
+    vm->cycles = 0;
+    ret = rendervm_run(vm, program, 8, 100);
+    is_equal_uint8(test, ret, 0, "RUN: stops at YIELD");
+    is_equal_uint32(test, vm->cycles, 4, "RUN: executed instructions up to YIELD");
+    is_equal_uint16(test, vm->pc, 6, "RUN: pc after YIELD");
+    is_equal_uint8(test, vm->uint8_stack[0], 0x03, "RUN: stack correct at YIELD");
+    rendervm_resume(vm);
+    ret = rendervm_run(vm, program, 8, 100);
+    is_equal_uint8(test, ret, 0, "RUN: stops at end of program");
+    is_equal_uint32(test, vm->cycles, 5, "RUN: resumed after YIELD");
+    is_equal_uint16(test, vm->pc, 0, "RUN: end of program resets pc");
+    rendervm_reset(vm);
+}
+
+void test_run_budget(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_JUMP, 0x00, 0x00};
+    uint8_t ret;
+    vm->cycles = 0;
+    ret = rendervm_run(vm, program, 3, 10);
+    is_equal_uint8(test, ret, 1, "RUN: budget exhausted leaves VM running");
+    is_equal_uint32(test, vm->cycles, 10, "RUN: executed exactly the budget");
+    rendervm_reset(vm);
+}
+
+void test_run_halt(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x01, VM_HALT, VM_UINT8_PUSH, 0x02};
+    uint8_t ret;
+    ret = rendervm_run(vm, program, 5, 100);
+    is_equal_uint8(test, ret, 0, "RUN: stops at HALT");
+    is_equal_uint8(test, vm->uint8_sp, 0x00, "RUN: nothing executed after HALT");
+    rendervm_reset(vm);
+}
+
+void test_run(test_harness_t* test, rendervm_t* vm) {
+    test_run_until_yield(test, vm);
+    test_run_budget(test, vm);
+    test_run_halt(test, vm);
+}
+
+void test_code_loop(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x05, VM_UINT16_PUSH, 0x01, 0x00, VM_UINT8_PUSH, 0x01, VM_UINT8_SUB, VM_UINT8_DUP, 0x01, VM_UINT8_JUMPNZ, 0x02, 0x00, VM_YIELD, VM_UINT8_PUSH, 0x09};
+    rendervm_code_t* code;
+    uint8_t ret;
+    code = rendervm_code_create(program, 16);
+    is_equal_uint8(test, (code != NULL), 1, "CODE: program decoded");
+    is_equal_uint16(test, code->nr_insns, 8, "CODE: instruction count");
+    vm->cycles = 0;
+    ret = rendervm_run_code(vm, code, 100);
+    is_equal_uint8(test, ret, 0, "CODE: stops at YIELD");
+    is_equal_uint32(test, vm->cycles, 27, "CODE: executed loop instructions");
+    is_equal_uint16(test, vm->pc, 14, "CODE: pc after YIELD");
+    is_equal_uint8(test, vm->uint8_sp, 0x00, "CODE: counter left on stack");
+    is_equal_uint8(test, vm->uint8_stack[0], 0x00, "CODE: counter reached zero");
+    is_equal_uint8(test, vm->uint16_sp, 0x04, "CODE: loop body ran five times");
+    rendervm_resume(vm);
+    ret = rendervm_run_code(vm, code, 100);
+    is_equal_uint8(test, ret, 0, "CODE: stops at end of program");
+    is_equal_uint32(test, vm->cycles, 28, "CODE: resumed after YIELD");
+    is_equal_uint16(test, vm->pc, 0, "CODE: end of program resets pc");
+    rendervm_reset(vm);
+    vm->cycles = 0;
+    ret = rendervm_run(vm, program, 16, 100);
+    is_equal_uint32(test, vm->cycles, 27, "CODE: byte interpreter agrees on cycles");
+    is_equal_uint8(test, vm->uint16_sp, 0x04, "CODE: byte interpreter agrees on stack");
+    rendervm_code_destroy(code);
+    rendervm_reset(vm);
+}
+
+void test_code_budget(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_ADDN, 0x01, VM_JUMP, 0x02, 0x00};
+    rendervm_code_t* code;
+    uint8_t ret;
+    code = rendervm_code_create(program, 7);
+    vm->cycles = 0;
+    ret = rendervm_run_code(vm, code, 11);
+    is_equal_uint8(test, ret, 1, "CODE: budget exhausted leaves VM running");
+    is_equal_uint32(test, vm->cycles, 11, "CODE: executed exactly the budget");
+    is_equal_uint16(test, vm->pc, 2, "CODE: pc points at next instruction");
+    is_equal_uint8(test, vm->next_opcode, VM_UINT8_ADDN, "CODE: next opcode after budget");
+    ret = rendervm_run_code(vm, code, 1);
+    is_equal_uint8(test, vm->uint8_stack[0], 0x07, "CODE: continues where budget ran out");
+    rendervm_code_destroy(code);
+    rendervm_reset(vm);
+}
+
+void test_code_fallback_callback(rendervm_t* vm, rendervm_opcode_t opcode, void* user_data) {
+    uint8_t* seen = (uint8_t*)user_data;
+    *seen = opcode;
+}
+
+void test_code_fallback(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_VEC2_POP, 0x01, 0xc8, VM_UINT8_PUSH, 0x07, VM_YIELD};
+    rendervm_code_t* code;
+    uint8_t seen = 0;
+    uint8_t ret;
+    rendervm_attach_callback(vm, test_code_fallback_callback, &seen);
+    vm->vec2_sp = VM_MAX_ADDR;
+    vm->cycles = 0;
+    code = rendervm_code_create(program, 6);
+    ret = rendervm_run_code(vm, code, 100);
+    is_equal_uint8(test, ret, 0, "CODE: ran to end of program");
+    is_equal_uint32(test, vm->cycles, 4, "CODE: fallback opcode counted once");
+    is_equal_uint8(test, vm->vec2_sp, VM_MAX_ADDR - 2, "CODE: fallback opcode executed");
+    is_equal_uint8(test, vm->uint8_stack[0], 0x07, "CODE: continued after fallback opcode");
+    is_equal_uint8(test, seen, 0xc8, "CODE: callback opcode dispatched");
+    rendervm_attach_callback(vm, NULL, NULL);
+    vm->vec2_sp = VM_MAX_ADDR;
+    rendervm_code_destroy(code);
+    rendervm_reset(vm);
+}
+
+void test_code_invalid(test_harness_t* test, rendervm_t* vm) {
+    uint8_t truncated[] = {VM_UINT8_PUSH, 0x01, VM_UINT16_PUSH, 0x01};
+    uint8_t misaligned[] = {VM_UINT16_PUSH, 0x01, 0x00, VM_JUMP, 0x01, 0x00};
+    uint8_t past_end[] = {VM_JUMP, 0x40, 0x00, VM_UINT8_PUSH, 0x01};
+    rendervm_code_t* code;
+    code = rendervm_code_create(truncated, 4);
+    is_equal_uint8(test, (code == NULL), 1, "CODE: truncated operand rejected");
+    code = rendervm_code_create(misaligned, 6);
+    is_equal_uint8(test, (code == NULL), 1, "CODE: jump into instruction rejected");
+    code = rendervm_code_create(past_end, 5);
+    is_equal_uint8(test, (code != NULL), 1, "CODE: jump past end accepted");
+    rendervm_run_code(vm, code, 100);
+    is_equal_uint8(test, vm->uint8_sp, VM_MAX_ADDR, "CODE: jump past end ends program");
+    is_equal_uint16(test, vm->pc, 0, "CODE: jump past end resets pc");
+    rendervm_code_destroy(code);
+    rendervm_reset(vm);
+}
+
+void test_code(test_harness_t* test, rendervm_t* vm) {
+    test_code_loop(test, vm);
+    test_code_budget(test, vm);
+    test_code_fallback(test, vm);
+    test_code_invalid(test, vm);
+}
+
+void test_verify_ok(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x05, VM_UINT16_PUSH, 0x01, 0x00, VM_UINT16_POP, 0x01, VM_UINT8_PUSH, 0x01, VM_UINT8_SUB, VM_UINT8_DUP, 0x01, VM_UINT8_JUMPNZ, 0x02, 0x00, VM_UINT8_POP, 0x01, VM_CALL, 0x16, 0x00, VM_HALT, VM_YIELD, VM_UINT32_REG_GET, 0x02, VM_UINT32_REG_SET, 0x03, VM_RETURN};
+    rendervm_verify_t result;
+    is_equal_uint8(test, rendervm_verify(program, 27, &result), 1, "VERIFY: balanced program verified");
+    is_equal_uint8(test, result.error, VM_V_OK, "VERIFY: no error reported");
+}
+
+void test_verify_errors(test_harness_t* test, rendervm_t* vm) {
+    uint8_t underflow[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_ADD};
+    uint8_t overflow[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_DUP, 0x01, VM_UINT8_DUP, 0x02, VM_UINT8_DUP, 0x04, VM_UINT8_DUP, 0x08, VM_UINT8_DUP, 0x10, VM_UINT8_DUP, 0x20, VM_UINT8_DUP, 0x40, VM_UINT8_DUP, 0x80};
+    uint8_t mismatch[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_PUSH, 0x01, VM_UINT8_PUSH, 0x01, VM_UINT8_JUMPNZ, 0x02, 0x00};
+    uint8_t halt[] = {VM_UINT8_PUSH, 0x01, VM_HALT};
+    uint8_t reg[] = {VM_UINT32_REG_GET, 0x0a};
+    uint8_t target[] = {VM_JUMP, 0x01, 0x00};
+    uint8_t truncated[] = {VM_UINT16_PUSH, 0x01};
+    uint8_t vec2[] = {VM_VEC2_POP, 0x01};
+    uint8_t undefined[] = {0xa0};
+    rendervm_verify_t result;
+    is_equal_uint8(test, rendervm_verify(underflow, 3, &result), 0, "VERIFY: underflow rejected");
+    is_equal_uint8(test, result.error, VM_V_STACK_UNDERFLOW, "VERIFY: underflow reported");
+    is_equal_uint16(test, result.pc, 2, "VERIFY: underflow pc reported");
+    rendervm_verify(overflow, 18, &result);
+    is_equal_uint8(test, result.error, VM_V_STACK_OVERFLOW, "VERIFY: overflow reported");
+    rendervm_verify(mismatch, 9, &result);
+    is_equal_uint8(test, result.error, VM_V_STACK_MISMATCH, "VERIFY: growing loop reported");
+    is_equal_uint16(test, result.pc, 6, "VERIFY: growing loop pc reported");
+    rendervm_verify(halt, 3, &result);
+    is_equal_uint8(test, result.error, VM_V_STACK_MISMATCH, "VERIFY: stack left at HALT reported");
+    rendervm_verify(reg, 2, &result);
+    is_equal_uint8(test, result.error, VM_V_BAD_REGISTER, "VERIFY: bad register reported");
+    rendervm_verify(target, 3, &result);
+    is_equal_uint8(test, result.error, VM_V_BAD_TARGET, "VERIFY: bad jump target reported");
+    rendervm_verify(truncated, 2, &result);
+    is_equal_uint8(test, result.error, VM_V_TRUNCATED, "VERIFY: truncated operand reported");
+    rendervm_verify(vec2, 2, &result);
+    is_equal_uint8(test, result.error, VM_V_STACK_UNDERFLOW, "VERIFY: vector stack underflow reported");
+    is_equal_uint8(test, rendervm_verify(undefined, 1, &result), 0, "VERIFY: undefined opcode rejected");
+    is_equal_uint8(test, result.error, VM_V_UNVERIFIABLE, "VERIFY: undefined opcode reported");
+}
+
+void test_verify_checked(test_harness_t* test, rendervm_t* vm) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_ADD, VM_UINT8_PUSH, 0x02};
+    uint8_t ret;
+    rendervm_reset(vm);
+    vm->checked = 1;
+    ret = rendervm_run(vm, program, 5, 100);
+    is_equal_uint8(test, ret, 0, "CHECKED: stops on underflow");
+    is_equal_uint8(test, vm->exception, VM_X_STACK_UNDERFLOW, "CHECKED: underflow exception raised");
+    is_equal_uint16(test, vm->pc, 3, "CHECKED: pc after failing opcode");
+    is_equal_uint8(test, vm->uint8_sp, 0x00, "CHECKED: stack left untouched");
+    vm->checked = 0;
+    rendervm_reset(vm);
+}
+
+void test_verify(test_harness_t* test, rendervm_t* vm) {
+    test_verify_ok(test, vm);
+    test_verify_errors(test, vm);
+    test_verify_checked(test, vm);
+}
+
+#define TEST_TRACE_MAX 32
+
+#define ENGINE_INTERP   0
+#define ENGINE_THREADED 1
+#define ENGINE_JIT      2
+
+typedef struct test_trace {
+    uint32_t count;
+    uint8_t opcode[TEST_TRACE_MAX];
+    uint32_t draw_reg[TEST_TRACE_MAX][10];
+} test_trace_t;
+
+void test_trace_callback(rendervm_t* vm, rendervm_opcode_t opcode, void* user_data) {
+    test_trace_t* trace = (test_trace_t*)user_data;
+    if (trace->count >= TEST_TRACE_MAX) {
+        return;
+    }
+    trace->opcode[trace->count] = opcode;
+    memcpy(trace->draw_reg[trace->count], vm->draw_reg, sizeof(vm->draw_reg));
+    trace->count++;
+}
+
+// Runs a program for a few frames on one engine with a small budget so the
+// budget boundaries land on many different instructions. Frames are capped
+// at a fixed number of slices like the scene caps them by time. Returns NULL if
+// the engine is not available on this host.
+rendervm_t* test_diff_engine(uint8_t engine, uint8_t* program, uint16_t length, test_trace_t* trace) {
+    rendervm_t* vm = rendervm_create();
+    rendervm_code_t* code = rendervm_code_create(program, length);
+    rendervm_jit_t* jit = NULL;
+    uint8_t running;
+    uint8_t frame;
+    uint8_t slice;
+
+    memset(trace, 0, sizeof(test_trace_t));
+    rendervm_attach_callback(vm, test_trace_callback, trace);
+
+    if (engine == ENGINE_JIT) {
+        jit = rendervm_jit_create(vm, code);
+        if (!jit) {
+            rendervm_code_destroy(code);
+            rendervm_destroy(vm);
+            return NULL;
+        }
+    }
+
+    for (frame = 0; frame < 8; frame++) {
+        rendervm_resume(vm);
+        slice = 0;
+        do {
+            if (engine == ENGINE_JIT) {
+                running = rendervm_run_jit(vm, jit, 3);
+            }
+            else if (engine == ENGINE_THREADED) {
+                running = rendervm_run_code(vm, code, 3);
+            }
+            else {
+                running = rendervm_run(vm, program, length, 3);
+            }
+            slice++;
+        } while (running && (slice < 16));
+    }
+
+    if (jit) {
+        rendervm_jit_destroy(jit);
+    }
+    rendervm_code_destroy(code);
+
+    return vm;
+}
+
+uint8_t test_diff_equal(rendervm_t* a, rendervm_t* b, test_trace_t* ta, test_trace_t* tb) {
+    if (a->pc != b->pc || a->running != b->running || a->exception != b->exception) return 0;
+    if (a->cycles != b->cycles || a->last_opcode != b->last_opcode || a->next_opcode != b->next_opcode) return 0;
+    if (a->ctrl_sp != b->ctrl_sp || a->uint8_sp != b->uint8_sp || a->uint16_sp != b->uint16_sp) return 0;
+    if (a->uint32_sp != b->uint32_sp || a->float_sp != b->float_sp) return 0;
+    if (memcmp(a->ctrl_stack, b->ctrl_stack, VM_STACK_SIZE * sizeof(uint16_t))) return 0;
+    if (memcmp(a->uint8_stack, b->uint8_stack, VM_STACK_SIZE)) return 0;
+    if (memcmp(a->uint16_stack, b->uint16_stack, VM_STACK_SIZE * sizeof(uint16_t))) return 0;
+    if (memcmp(a->uint32_stack, b->uint32_stack, VM_STACK_SIZE * sizeof(uint32_t))) return 0;
+    if (memcmp(a->float_stack, b->float_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (a->vec2_sp != b->vec2_sp || a->vec3_sp != b->vec3_sp || a->vec4_sp != b->vec4_sp) return 0;
+    if (a->mat2_sp != b->mat2_sp || a->mat3_sp != b->mat3_sp || a->mat4_sp != b->mat4_sp) return 0;
+    if (memcmp(a->vec2_stack, b->vec2_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->vec3_stack, b->vec3_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->vec4_stack, b->vec4_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->mat2_stack, b->mat2_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->mat3_stack, b->mat3_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->mat4_stack, b->mat4_stack, VM_STACK_SIZE * sizeof(float))) return 0;
+    if (memcmp(a->draw_reg, b->draw_reg, sizeof(a->draw_reg))) return 0;
+    if (ta->count != tb->count || memcmp(ta, tb, sizeof(test_trace_t))) return 0;
+    return 1;
+}
+
+// Runs a program on the byte interpreter, the threaded code and the JIT and
+// checks they end up with the same stacks, registers and draw trace.
+void test_diff(test_harness_t* test, const char* name, uint8_t* program, uint16_t length) {
+    test_trace_t trace[3];
+    rendervm_t* vm[3];
+    char test_name[128];
+    uint8_t engine;
+
+    for (engine = ENGINE_INTERP; engine <= ENGINE_JIT; engine++) {
+        vm[engine] = test_diff_engine(engine, program, length, &trace[engine]);
+    }
+
+    snprintf(test_name, sizeof(test_name), "DIFF %s: threaded matches interpreter", name);
+    is_equal_uint8(test, test_diff_equal(vm[ENGINE_INTERP], vm[ENGINE_THREADED], &trace[ENGINE_INTERP], &trace[ENGINE_THREADED]), 1, test_name);
+
+    if (vm[ENGINE_JIT]) {
+        snprintf(test_name, sizeof(test_name), "DIFF %s: jit matches interpreter", name);
+        is_equal_uint8(test, test_diff_equal(vm[ENGINE_INTERP], vm[ENGINE_JIT], &trace[ENGINE_INTERP], &trace[ENGINE_JIT]), 1, test_name);
+        rendervm_destroy(vm[ENGINE_JIT]);
+    }
+    else {
+        test_harness_make_note(test, "DIFF: jit not available on this host");
+    }
+
+    rendervm_destroy(vm[ENGINE_THREADED]);
+    rendervm_destroy(vm[ENGINE_INTERP]);
+}
+
+// A copy of the VM with stacks of its own. Memory and the callback are
+// shared with the original.
+rendervm_t* test_exec_clone(rendervm_t* vm) {
+    rendervm_t* clone = rendervm_create();
+    rendervm_t own = *clone;
+
+    *clone = *vm;
+    clone->profile = NULL;
+    clone->ctrl_stack = own.ctrl_stack;
+    clone->uint8_stack = own.uint8_stack;
+    clone->uint16_stack = own.uint16_stack;
+    clone->uint32_stack = own.uint32_stack;
+    clone->float_stack = own.float_stack;
+    clone->vec2_stack = own.vec2_stack;
+    clone->vec3_stack = own.vec3_stack;
+    clone->vec4_stack = own.vec4_stack;
+    clone->mat2_stack = own.mat2_stack;
+    clone->mat3_stack = own.mat3_stack;
+    clone->mat4_stack = own.mat4_stack;
+    memcpy(clone->ctrl_stack, vm->ctrl_stack, VM_STACK_SIZE * sizeof(uint16_t));
+    memcpy(clone->uint8_stack, vm->uint8_stack, VM_STACK_SIZE);
+    memcpy(clone->uint16_stack, vm->uint16_stack, VM_STACK_SIZE * sizeof(uint16_t));
+    memcpy(clone->uint32_stack, vm->uint32_stack, VM_STACK_SIZE * sizeof(uint32_t));
+    memcpy(clone->float_stack, vm->float_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->vec2_stack, vm->vec2_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->vec3_stack, vm->vec3_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->vec4_stack, vm->vec4_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->mat2_stack, vm->mat2_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->mat3_stack, vm->mat3_stack, VM_STACK_SIZE * sizeof(float));
+    memcpy(clone->mat4_stack, vm->mat4_stack, VM_STACK_SIZE * sizeof(float));
+
+    return clone;
+}
+
+// Steps one instruction like rendervm_exec() does for the per-opcode tests,
+// first running the same instruction from the same state on threaded code
+// and the JIT and checking they end up where the interpreter does. The
+// interpreter's result is left in vm for the test to check.
+uint8_t test_exec(test_harness_t* test, rendervm_t* vm, uint8_t* program, uint16_t length) {
+    test_trace_t none;
+    rendervm_t* clone[3] = {NULL, NULL, NULL};
+    rendervm_code_t* code = rendervm_code_create(program, length);
+    rendervm_jit_t* jit;
+    char test_name[128];
+    uint8_t opcode = (vm->pc < length) ? program[vm->pc] : VM_HALT;
+    uint8_t running;
+    uint8_t engine;
+
+    memset(&none, 0, sizeof(test_trace_t));
+
+    if (code) {
+        clone[ENGINE_THREADED] = test_exec_clone(vm);
+        rendervm_run_code(clone[ENGINE_THREADED], code, 1);
+
+        clone[ENGINE_JIT] = test_exec_clone(vm);
+        jit = rendervm_jit_create(clone[ENGINE_JIT], code);
+        if (jit) {
+            rendervm_run_jit(clone[ENGINE_JIT], jit, 1);
+            rendervm_jit_destroy(jit);
+        }
+        else {
+            rendervm_destroy(clone[ENGINE_JIT]);
+            clone[ENGINE_JIT] = NULL;
+        }
+        rendervm_code_destroy(code);
+    }
+
+    running = rendervm_exec(vm, program, length);
+
+    for (engine = ENGINE_THREADED; engine <= ENGINE_JIT; engine++) {
+        if (!clone[engine]) {
+            continue;
+        }
+        // Every target past the end of the program ends it, but only the
+        // byte interpreter reports the target itself as pc.
+        if (vm->pc >= length && clone[engine]->pc >= length) {
+            clone[engine]->pc = vm->pc;
+            clone[engine]->next_opcode = vm->next_opcode;
+        }
+        snprintf(test_name, sizeof(test_name), "DIFF OP %s: %s matches interpreter", (opcode > VM_MAT4_TRANSP) ? "CUSTOM" : rendervm_opcode2str(opcode), (engine == ENGINE_JIT) ? "jit" : "threaded");
+        is_equal_uint8(test, test_diff_equal(vm, clone[engine], &none, &none), 1, test_name);
+        rendervm_destroy(clone[engine]);
+    }
+
+    return running;
+}
+
+void test_differential(test_harness_t* test, rendervm_t* vm) {
+    uint8_t loop[] = {VM_UINT8_PUSH, 0x05, VM_UINT16_PUSH, 0x01, 0x00, VM_UINT8_PUSH, 0x01, VM_UINT8_SUB, VM_UINT8_DUP, 0x01, VM_UINT8_JUMPNZ, 0x02, 0x00, VM_YIELD, VM_UINT8_PUSH, 0x09};
+    uint8_t spin[] = {VM_UINT8_PUSH, 0x01, VM_UINT8_ADDN, 0x01, VM_JUMP, 0x02, 0x00};
+    uint8_t subroutine[] = {
+        VM_UINT8_PUSH, 0x03,
+        VM_CALL, 0x10, 0x00,
+        VM_UINT8_PUSH, 0x01,
+        VM_UINT8_SUB,
+        VM_UINT8_DUP, 0x01,
+        VM_UINT8_JUMPNZ, 0x02, 0x00,
+        VM_UINT8_POP, 0x01,
+        VM_HALT,
+        VM_UINT32_REG_GET, 0x00,
+        VM_UINT32_ADDN, 0x01, 0x00, 0x00, 0x00,
+        VM_UINT32_REG_SET, 0x00,
+        0xc8,
+        VM_YIELD,
+        VM_RETURN
+    };
+    uint8_t arith[] = {
+        VM_UINT8_PUSH, 0x07,
+        VM_UINT8_PUSH, 0x03,
+        VM_UINT8_SUB,
+        VM_UINT8_PUSH, 0x05,
+        VM_UINT8_MUL,
+        VM_UINT8_ADDN, 0x01,
+        VM_UINT8_PUSH, 0xc8,
+        VM_UINT8_ADD,
+        VM_UINT8_JUMPEM, 0x00, 0x00,
+        VM_UINT16_PUSH, 0x34, 0x12,
+        VM_UINT16_PUSH, 0x00, 0x01,
+        VM_UINT16_MUL,
+        VM_UINT16_ADDN, 0x01, 0x00,
+        VM_UINT16_PUSH, 0x02, 0x00,
+        VM_UINT16_SUB,
+        VM_UINT16_MOVE_UINT8,
+        VM_UINT16_JUMPZ, 0x00, 0x00,
+        VM_UINT32_PUSH, 0x00, 0x00, 0x01, 0x00,
+        VM_UINT32_PUSH, 0x03, 0x00, 0x00, 0x00,
+        VM_UINT32_MUL,
+        VM_UINT32_ADDN, 0x05, 0x00, 0x00, 0x00,
+        VM_UINT32_PUSH, 0x01, 0x00, 0x00, 0x00,
+        VM_UINT32_ADD,
+        VM_UINT32_REG_SET, 0x04,
+        VM_UINT32_REG_GET, 0x04,
+        VM_UINT32_DUP, 0x01,
+        VM_UINT32_EQ,
+        VM_UINT32_JUMPZ, 0x00, 0x00,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0xc0, 0x3f,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x00, 0x40,
+        VM_FLOAT_MUL,
+        VM_FLOAT_ADDN, 0x00, 0x00, 0x80, 0x3f,
+        VM_FLOAT_DUP, 0x01,
+        VM_FLOAT_JUMPZ, 0x00, 0x00,
+        0xc8,
+        VM_UINT32_POP, 0x01,
+        VM_YIELD,
+        0xc9
+    };
+
+    uint8_t vector[] = {
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x80, 0x3f,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x00, 0x40,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x40, 0x40,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x80, 0x40,
+        VM_VEC4_IMPLODE,
+        VM_MAT4_IDENT,
+        VM_FLOAT_PUSH, 0x00, 0x00, 0x00, 0x3f,
+        VM_MAT4_ROTATEZ,
+        VM_VEC4_DUP, 0x01,
+        VM_VEC4_ADD,
+        VM_MAT4_DUP, 0x01,
+        VM_VEC4_MULMAT4,
+        VM_VEC4_EXPLODE,
+        VM_FLOAT_POP, 0x04,
+        VM_MAT4_POP, 0x01,
+        VM_MAT4_JUMPEM, 0x2b, 0x00,
+        VM_YIELD,
+        0xc8,
+        VM_YIELD
+    };
+
+    test_diff(test, "loop", loop, sizeof(loop));
+    test_diff(test, "spin", spin, sizeof(spin));
+    test_diff(test, "subroutine", subroutine, sizeof(subroutine));
+    test_diff(test, "arith", arith, sizeof(arith));
+    test_diff(test, "vector", vector, sizeof(vector));
+}
+
+void test_interrupt_callback(rendervm_t* vm, rendervm_opcode_t opcode, void* user_data) {
+    rendervm_interrupt(vm);
+}
+
+uint8_t test_interrupt_run(uint8_t engine, rendervm_t* vm, uint8_t* program, uint16_t length, rendervm_code_t* code, rendervm_jit_t* jit) {
+    rendervm_resume(vm);
+    if (engine == ENGINE_JIT) {
+        return rendervm_run_jit(vm, jit, 100);
+    }
+    if (engine == ENGINE_THREADED) {
+        return rendervm_run_code(vm, code, 100);
+    }
+    return rendervm_run(vm, program, length, 100);
+}
+
+// A callback that interrupts the VM stops the run right after its opcode,
+// and resuming carries on from the next one.
+void test_interrupt_engine(test_harness_t* test, uint8_t engine, const char* name) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x01, 0xc8, VM_UINT8_PUSH, 0x02, 0xc8, VM_UINT8_PUSH, 0x03, VM_YIELD};
+    rendervm_t* vm = rendervm_create();
+    rendervm_code_t* code = rendervm_code_create(program, sizeof(program));
+    rendervm_jit_t* jit = NULL;
+    char test_name[128];
+    uint8_t ret;
+
+    rendervm_attach_callback(vm, test_interrupt_callback, NULL);
+    if (engine == ENGINE_JIT) {
+        jit = rendervm_jit_create(vm, code);
+        if (!jit) {
+            test_harness_make_note(test, "INTERRUPT: jit not available on this host");
+            rendervm_code_destroy(code);
+            rendervm_destroy(vm);
+            return;
+        }
+    }
+
+    ret = test_interrupt_run(engine, vm, program, sizeof(program), code, jit);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: run stops after callback", name);
+    is_equal_uint8(test, ret, 0, test_name);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: pc after callback opcode", name);
+    is_equal_uint16(test, vm->pc, 3, test_name);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: nothing run past callback", name);
+    is_equal_uint8(test, vm->uint8_sp, 0, test_name);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: interrupted opcode counted", name);
+    is_equal_uint32(test, vm->cycles, 2, test_name);
+
+    test_interrupt_run(engine, vm, program, sizeof(program), code, jit);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: resumed to second callback", name);
+    is_equal_uint16(test, vm->pc, 6, test_name);
+
+    test_interrupt_run(engine, vm, program, sizeof(program), code, jit);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: resumed to yield", name);
+    is_equal_uint8(test, vm->uint8_stack[2], 0x03, test_name);
+    snprintf(test_name, sizeof(test_name), "INTERRUPT %s: no exception", name);
+    is_equal_uint8(test, rendervm_has_exception(vm), 0, test_name);
+
+    if (jit) {
+        rendervm_jit_destroy(jit);
+    }
+    rendervm_code_destroy(code);
+    rendervm_destroy(vm);
+}
+
+void test_interrupt(test_harness_t* test, rendervm_t* vm) {
+    test_interrupt_engine(test, ENGINE_INTERP, "interpreter");
+    test_interrupt_engine(test, ENGINE_THREADED, "threaded");
+    test_interrupt_engine(test, ENGINE_JIT, "jit");
+}
+
+// Profiles the same programs on every engine, running in small slices so
+// the budget boundaries fall inside the loop.
+void test_profile_engine(test_harness_t* test, uint8_t engine, const char* name) {
+    uint8_t loop[] = {VM_UINT8_PUSH, 0x05, VM_UINT16_PUSH, 0x01, 0x00, VM_UINT8_PUSH, 0x01, VM_UINT8_SUB, VM_UINT8_DUP, 0x01, VM_UINT8_JUMPNZ, 0x02, 0x00, VM_YIELD};
+    uint8_t fallback[] = {VM_VEC2_POP, 0x01, VM_UINT8_PUSH, 0x07, VM_YIELD};
+    rendervm_t* vm = rendervm_create();
+    rendervm_code_t* code = rendervm_code_create(loop, sizeof(loop));
+    rendervm_jit_t* jit = NULL;
+    char test_name[128];
+    uint8_t running;
+
+    if (engine == ENGINE_JIT) {
+        jit = rendervm_jit_create(vm, code);
+        if (!jit) {
+            test_harness_make_note(test, "PROFILE: jit not available on this host");
+            rendervm_code_destroy(code);
+            rendervm_destroy(vm);
+            return;
+        }
+    }
+
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: enabled", name);
+    is_equal_uint8(test, rendervm_profile_enable(vm, sizeof(loop)), 1, test_name);
+    do {
+        if (engine == ENGINE_JIT) {
+            running = rendervm_run_jit(vm, jit, 4);
+        }
+        else if (engine == ENGINE_THREADED) {
+            running = rendervm_run_code(vm, code, 4);
+        }
+        else {
+            running = rendervm_run(vm, loop, sizeof(loop), 4);
+        }
+    } while (running);
+
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: cycles counted", name);
+    is_equal_uint32(test, (uint32_t)vm->profile->cycles, 27, test_name);
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: loop start hits", name);
+    is_equal_uint32(test, (uint32_t)vm->profile->pc_hits[2], 5, test_name);
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: single instruction hits", name);
+    is_equal_uint32(test, (uint32_t)vm->profile->pc_hits[0], 1, test_name);
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: operand bytes not hit", name);
+    is_equal_uint32(test, (uint32_t)vm->profile->pc_hits[3], 0, test_name);
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: opcode count", name);
+    is_equal_uint32(test, (uint32_t)vm->profile->opcode_count[VM_UINT8_PUSH], 6, test_name);
+
+    rendervm_profile_disable(vm);
+    snprintf(test_name, sizeof(test_name), "PROFILE %s: disabled", name);
+    is_equal_uint8(test, (vm->profile == NULL), 1, test_name);
+
+    if (jit) {
+        rendervm_jit_destroy(jit);
+    }
+    rendervm_code_destroy(code);
+
+    if (engine == ENGINE_THREADED) {
+        rendervm_reset(vm);
+        code = rendervm_code_create(fallback, sizeof(fallback));
+        rendervm_profile_enable(vm, sizeof(fallback));
+        rendervm_run_code(vm, code, 100);
+        is_equal_uint32(test, (uint32_t)vm->profile->pc_hits[0], 1, "PROFILE threaded: fallback opcode counted once");
+        is_equal_uint32(test, (uint32_t)vm->profile->cycles, 3, "PROFILE threaded: fallback cycles");
+        rendervm_code_destroy(code);
+    }
+
+    rendervm_destroy(vm);
+}
+
+void test_profile_write(test_harness_t* test) {
+    uint8_t program[] = {VM_UINT8_PUSH, 0x05, VM_YIELD};
+    rendervm_t* vm = rendervm_create();
+    char buffer[256];
+    FILE* out;
+    size_t length;
+
+    rendervm_profile_enable(vm, sizeof(program));
+    rendervm_run(vm, program, sizeof(program), 100);
+
+    out = tmpfile();
+    rendervm_profile_write(vm, program, sizeof(program), out);
+    rewind(out);
+    length = fread(buffer, 1, sizeof(buffer) - 1, out);
+    buffer[length] = 0;
+    fclose(out);
+
+    is_equal_string(test, buffer, "cycles 2\nprogram 13 05 01\nopcode 0x01 1\nopcode 0x13 1\npc 0 1\npc 2 1\n", "PROFILE: written for rendervmasm");
+    rendervm_destroy(vm);
+}
+
+void test_profile(test_harness_t* test, rendervm_t* vm) {
+    test_profile_engine(test, ENGINE_INTERP, "interpreter");
+    test_profile_engine(test, ENGINE_THREADED, "threaded");
+    test_profile_engine(test, ENGINE_JIT, "jit");
+    test_profile_write(test);
+}
+
 int main(void) {
     test_harness_t* test;
     rendervm_t* vm;
@@ -1479,6 +2787,12 @@ int main(void) {
 
     vm = rendervm_create();
     test_all_opcodes(test, vm);
+    test_run(test, vm);
+    test_code(test, vm);
+    test_verify(test, vm);
+    test_differential(test, vm);
+    test_interrupt(test, vm);
+    test_profile(test, vm);
 
     test_harness_exit_with_status(test);
 }
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "safemalloc.h"
+#include "ring.h"
+
+#define DEBUG 0
+#define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+
+vrms_ring_t* vrms_ring_create(uint32_t nr_items, uint32_t item_size) {
+    vrms_ring_t* ring;
+    uint32_t size = 1;
+    uint32_t i;
+
+    while (size < nr_items) {
+        size <<= 1;
+    }
+
+    ring = SAFEMALLOC(sizeof(vrms_ring_t));
+    memset(ring, 0, sizeof(vrms_ring_t));
+    ring->size = size;
+    ring->mask = size - 1;
+    ring->item_size = item_size;
+    ring->sequence = SAFEMALLOC(sizeof(uint32_t) * size);
+    ring->items = SAFEMALLOC(item_size * size);
+    memset(ring->items, 0, item_size * size);
+
+    // Slot i is free for the producer whose position is i.
+    for (i = 0; i < size; i++) {
+        ring->sequence[i] = i;
+    }
+
+    return ring;
+}
+
+void vrms_ring_destroy(vrms_ring_t* ring) {
+    free(ring->sequence);
+    free(ring->items);
+    free(ring);
+}
+
+uint8_t vrms_ring_push(vrms_ring_t* ring, const void* item) {
+    uint32_t pos;
+    uint32_t seq;
+    int32_t diff;
+
+    pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    while (1) {
+        seq = __atomic_load_n(&ring->sequence[pos & ring->mask], __ATOMIC_ACQUIRE);
+        diff = (int32_t)(seq - pos);
+        if (0 == diff) {
+            // The slot is free for this lap, claim it by moving the tail on.
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The consumer has not taken the item from the last lap yet.
+            debug_print("vrms_ring_push(): ring full\n");
+            return 0;
+        }
+        else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(&ring->items[(pos & ring->mask) * ring->item_size], item, ring->item_size);
+    __atomic_store_n(&ring->sequence[pos & ring->mask], pos + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+void* vrms_ring_peek(vrms_ring_t* ring) {
+    uint32_t pos = ring->head;
+    uint32_t seq;
+
+    // A slot claimed by a producer that is still copying reads as empty.
+    seq = __atomic_load_n(&ring->sequence[pos & ring->mask], __ATOMIC_ACQUIRE);
+    if (seq != (pos + 1)) {
+        return NULL;
+    }
+    return &ring->items[(pos & ring->mask) * ring->item_size];
+}
+
+void vrms_ring_pop(vrms_ring_t* ring) {
+    uint32_t pos = ring->head;
+
+    // Hand the slot to the producer of the next lap.
+    __atomic_store_n(&ring->sequence[pos & ring->mask], pos + ring->size, __ATOMIC_RELEASE);
+    ring->head = pos + 1;
+}
+
+uint8_t vrms_ring_full(vrms_ring_t* ring) {
+    uint32_t pos;
+    uint32_t seq;
+
+    pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    seq = __atomic_load_n(&ring->sequence[pos & ring->mask], __ATOMIC_ACQUIRE);
+    return ((int32_t)(seq - pos) < 0) ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+#ifndef VRMS_RING_H
+#define VRMS_RING_H
+
+#include <stdint.h>
+
+// A bounded queue for many producer threads and one consumer thread. Items
+// are copied into the ring, so pushing needs no allocation, and neither side
+// takes a lock. Every slot carries a sequence number that says whether it is
+// free for the producer of a given lap or holds an item for the consumer.
+typedef struct vrms_ring {
+    uint32_t size;
+    uint32_t mask;
+    uint32_t item_size;
+    uint32_t* sequence;
+    uint8_t* items;
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t tail __attribute__((aligned(64)));
+} vrms_ring_t;
+
+// Creates a ring of nr_items items of item_size bytes, nr_items being
+// rounded up to a power of two.
+vrms_ring_t* vrms_ring_create(uint32_t nr_items, uint32_t item_size);
+
+void vrms_ring_destroy(vrms_ring_t* ring);
+
+// Copies an item in. Returns 0 without waiting if the ring is full, leaving
+// the producer to decide whether to retry, drop or report it.
+uint8_t vrms_ring_push(vrms_ring_t* ring, const void* item);
+
+// Returns the oldest item, or NULL if there is none. The item stays in the
+// ring until vrms_ring_pop() so the consumer can leave it for later. Only
+// the consumer thread may call this or vrms_ring_pop().
+void* vrms_ring_peek(vrms_ring_t* ring);
+void vrms_ring_pop(vrms_ring_t* ring);
+
+// Returns 1 if a push would fail right now. Only certain when the caller is
+// the one producer, as other producers may take or free slots meanwhile.
+uint8_t vrms_ring_full(vrms_ring_t* ring);
+
+#endif
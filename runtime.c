@@ -5,6 +5,8 @@
 #include <string.h>
 #include <dirent.h>
 #include <stdarg.h>
+#include <time.h>
+#include <errno.h>
 #include "gl.h"
 #include "safemalloc.h"
 #include "object.h"
@@ -17,6 +19,18 @@
 #define DEBUG 1
 #define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
 
+#ifdef VRMS_SIDE_BY_SIDE
+#define STEREO_MODE OSTEREO_MODE_SIDE_BY_SIDE
+#else
+#define STEREO_MODE OSTEREO_MODE_STEREO
+#endif
+
+// Frames start rendering this long before the predicted time they need,
+// and the last part of the wait spins rather than trusting the sleep.
+#define FRAME_MARGIN_USEC 1000
+#define FRAME_SPIN_USEC 200
+#define FRAME_REFRESH_DEFAULT 60.0
+
 opengl_stereo ostereo;
 
 uint8_t assert_vrms_server(vrms_runtime_t* vrms_runtime) {
@@ -145,6 +159,30 @@ uint32_t vrms_module_set_skybox(vrms_module_t* module, uint32_t scene_id, uint32
     return vrms_scene_set_skybox(vrms_scene, texture_id);
 }
 
+uint32_t vrms_module_update_data(vrms_module_t* module, uint32_t scene_id, uint32_t data_id, uint32_t offset, uint32_t length) {
+    if (!assert_vrms_server(module->runtime)) {
+        return 0;
+    }
+
+    vrms_scene_t* vrms_scene = vrms_server_get_scene(module->runtime->vrms_server, scene_id);
+    if (!vrms_scene) {
+        return 0;
+    }
+    return vrms_scene_update_data(vrms_scene, data_id, offset, length);
+}
+
+uint32_t vrms_module_update_texture(vrms_module_t* module, uint32_t scene_id, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if (!assert_vrms_server(module->runtime)) {
+        return 0;
+    }
+
+    vrms_scene_t* vrms_scene = vrms_server_get_scene(module->runtime->vrms_server, scene_id);
+    if (!vrms_scene) {
+        return 0;
+    }
+    return vrms_scene_update_texture(vrms_scene, texture_id, x, y, width, height);
+}
+
 uint32_t vrms_module_destroy_scene(vrms_module_t* module, uint32_t scene_id) {
     if (!assert_vrms_server(module->runtime)) {
         return 0;
@@ -233,6 +271,8 @@ vrms_module_t* vrms_runtime_module_create(char* module_name) {
     module->interface.attach_memory = vrms_module_attach_memory;
     module->interface.run_program = vrms_module_run_program;
     module->interface.set_skybox = vrms_module_set_skybox;
+    module->interface.update_data = vrms_module_update_data;
+    module->interface.update_texture = vrms_module_update_texture;
     module->interface.destroy_scene = vrms_module_destroy_scene;
     module->interface.destroy_object = vrms_module_destroy_object;
     module->interface.update_system_matrix = vrms_module_update_system_matrix;
@@ -289,6 +329,12 @@ void vrms_runtime_load_modules(vrms_runtime_t* vrms_runtime) {
     closedir(dir);
 }
 
+void record_scene(opengl_stereo* ostereo, void* data) {
+    if (NULL != data) {
+        vrms_server_record_scenes((vrms_server_t*)data);
+    }
+}
+
 void draw_scene(opengl_stereo* ostereo, void* data) {
     if (NULL != data) {
         vrms_server_draw_scenes((vrms_server_t*)data, ostereo->projection_matrix, ostereo->view_matrix, ostereo->model_matrix, ostereo->skybox_camera.projection_matrix);
@@ -315,12 +361,21 @@ vrms_runtime_t* vrms_runtime_init(int width, int height, double physical_width)
     vrms_server_t* vrms_server = vrms_server_create();
     vrms_runtime->vrms_server = vrms_server;
 
-    opengl_stereo_init(&ostereo, width, height, physical_width, OSTEREO_MODE_STEREO);
+    opengl_stereo_init(&ostereo, width, height, physical_width, STEREO_MODE);
     opengl_stereo_draw_scene_callback(&ostereo, draw_scene, vrms_server);
+    opengl_stereo_record_scene_callback(&ostereo, record_scene);
+    vrms_runtime_set_refresh_rate(vrms_runtime, FRAME_REFRESH_DEFAULT);
 
     vrms_server->color_shader_id = ostereo.color_shader_id;
     vrms_server->texture_shader_id = ostereo.texture_shader_id;
     vrms_server->cubemap_shader_id = ostereo.cubemap_shader_id;
+    vrms_server->color_instanced_shader_id = ostereo.color_instanced_shader_id;
+    vrms_server->texture_instanced_shader_id = ostereo.texture_instanced_shader_id;
+    vrms_gl_add_shader(ostereo.color_shader_id);
+    vrms_gl_add_shader(ostereo.texture_shader_id);
+    vrms_gl_add_shader(ostereo.cubemap_shader_id);
+    vrms_gl_add_shader(ostereo.color_instanced_shader_id);
+    vrms_gl_add_shader(ostereo.texture_instanced_shader_id);
     vrms_server->system_matrix_update = vrms_runtime_system_matrix_update;
 
     vrms_runtime_load_modules(vrms_runtime);
@@ -342,6 +397,81 @@ void vrms_runtime_process(vrms_runtime_t* vrms_runtime) {
     vrms_server_process_queue(vrms_runtime->vrms_server);
 }
 
+static uint64_t vrms_runtime_usec_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void vrms_runtime_sleep_until(uint64_t deadline) {
+    struct timespec ts;
+    uint64_t wake;
+
+    if (deadline > FRAME_SPIN_USEC) {
+        wake = deadline - FRAME_SPIN_USEC;
+        ts.tv_sec = wake / 1000000;
+        ts.tv_nsec = (wake % 1000000) * 1000;
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL));
+    }
+    while (vrms_runtime_usec_now() < deadline);
+}
+
+void vrms_runtime_set_refresh_rate(vrms_runtime_t* vrms_runtime, double hz) {
+    vrms_runtime->frame_period_usec = (hz > 0.0) ? (uint64_t)(1000000.0 / hz) : 0;
+    vrms_runtime->frame_vsync_usec = 0;
+    if (vrms_runtime->frame_period_usec) {
+        ostereo.target_usec = vrms_runtime->frame_period_usec;
+    }
+}
+
+void vrms_runtime_frame(vrms_runtime_t* vrms_runtime) {
+    uint64_t now = vrms_runtime_usec_now();
+    uint64_t next_vsync, deadline, render_usec;
+
+    if (vrms_runtime->frame_period_usec && vrms_runtime->frame_vsync_usec) {
+        next_vsync = vrms_runtime->frame_vsync_usec + vrms_runtime->frame_period_usec;
+        deadline = next_vsync - vrms_runtime->frame_render_usec - FRAME_MARGIN_USEC;
+        // Never plan to start before the frame being shown began.
+        if (deadline < vrms_runtime->frame_vsync_usec) {
+            deadline = vrms_runtime->frame_vsync_usec;
+        }
+        if (deadline > now) {
+            vrms_runtime_sleep_until(deadline);
+            now = vrms_runtime_usec_now();
+        }
+    }
+    vrms_runtime_process(vrms_runtime);
+    vrms_runtime_display(vrms_runtime);
+
+    // The swap may block, so the render time is taken here. GPU time is
+    // used instead where it is known and longer.
+    render_usec = vrms_runtime_usec_now() - now;
+    opengl_stereo_frame_time(&ostereo, render_usec);
+    if (ostereo.gpu_usec > render_usec) {
+        render_usec = ostereo.gpu_usec;
+    }
+    vrms_runtime->frame_render_usec += ((int64_t)render_usec - (int64_t)vrms_runtime->frame_render_usec) / 8;
+}
+
+void vrms_runtime_frame_presented(vrms_runtime_t* vrms_runtime) {
+    uint64_t now = vrms_runtime_usec_now();
+    uint64_t next_vsync = vrms_runtime->frame_vsync_usec + vrms_runtime->frame_period_usec;
+
+    // A swap that blocked returns at vsync, so lock onto it. One that came
+    // back before the predicted vsync is not synced, keep counting periods.
+    // A missed frame lands past the prediction and resyncs.
+    if (!vrms_runtime->frame_vsync_usec || ((now + (FRAME_MARGIN_USEC / 2)) >= next_vsync)) {
+        vrms_runtime->frame_vsync_usec = now;
+    }
+    else {
+        vrms_runtime->frame_vsync_usec = next_vsync;
+    }
+}
+
+void vrms_runtime_start_upload_thread(vrms_runtime_t* vrms_runtime, vrms_upload_context_t make_current, void* data) {
+    vrms_server_start_upload_thread(vrms_runtime->vrms_server, make_current, data);
+}
+
 void vrms_runtime_end(vrms_runtime_t* vrms_runtime) {
     uint8_t index;
     vrms_module_t* module;
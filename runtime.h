@@ -3,6 +3,7 @@
 
 #include "vroom.h"
 #include <pthread.h>
+#include "upload.h"
 
 typedef struct vrms_server vrms_server_t;
 typedef struct vrms_module vrms_module_t;
@@ -15,6 +16,9 @@ typedef struct vrms_runtime {
     char* module_load_path;
     uint32_t w;
     uint32_t h;
+    uint64_t frame_period_usec;
+    uint64_t frame_vsync_usec;
+    uint64_t frame_render_usec;
 } vrms_runtime_t;
 
 typedef struct vrms_module_interface {
@@ -27,6 +31,8 @@ typedef struct vrms_module_interface {
     uint32_t (*attach_memory)(vrms_module_t* module, uint32_t scene_id, uint32_t data_id);
     uint32_t (*run_program)(vrms_module_t* module, uint32_t scene_id, uint32_t program_id, uint32_t register_id);
     uint32_t (*set_skybox)(vrms_module_t* module, uint32_t scene_id, uint32_t texture_id);
+    uint32_t (*update_data)(vrms_module_t* module, uint32_t scene_id, uint32_t data_id, uint32_t offset, uint32_t length);
+    uint32_t (*update_texture)(vrms_module_t* module, uint32_t scene_id, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
     uint32_t (*destroy_scene)(vrms_module_t* module, uint32_t scene_id);
     uint32_t (*destroy_object)(vrms_module_t* module, uint32_t scene_id, uint32_t object_id);
     uint32_t (*update_system_matrix)(vrms_module_t* module, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, float* matrix);
@@ -47,6 +53,21 @@ void vrms_runtime_reshape(vrms_runtime_t* vrms_runtime, int w, int h);
 
 void vrms_runtime_process(vrms_runtime_t* vrms_runtime);
 
+// Paces frames to the display. vrms_runtime_frame() sleeps until just
+// before the next frame has to start rendering, processes the queue there
+// so the head pose is as fresh as possible, then draws. The backend swaps
+// and calls vrms_runtime_frame_presented(), which keeps the schedule
+// locked to vsync when the swap blocks. A refresh rate of 0 draws frames
+// back to back without sleeping.
+void vrms_runtime_set_refresh_rate(vrms_runtime_t* vrms_runtime, double hz);
+void vrms_runtime_frame(vrms_runtime_t* vrms_runtime);
+void vrms_runtime_frame_presented(vrms_runtime_t* vrms_runtime);
+
+// Called by the backend once the render context is current, with a
+// function that makes a context sharing its objects current on another
+// thread.
+void vrms_runtime_start_upload_thread(vrms_runtime_t* vrms_runtime, vrms_upload_context_t make_current, void* data);
+
 void vrms_runtime_end(vrms_runtime_t* vrms_runtime);
 
 int vrms_module_debug(vrms_module_t* module, const char *format, ...);
@@ -71,6 +92,10 @@ uint32_t vrms_module_update_system_matrix(vrms_module_t* module, vrms_matrix_typ
 
 uint32_t vrms_module_set_skybox(vrms_module_t* module, uint32_t scene_id, uint32_t texture_id);
 
+uint32_t vrms_module_update_data(vrms_module_t* module, uint32_t scene_id, uint32_t data_id, uint32_t offset, uint32_t length);
+
+uint32_t vrms_module_update_texture(vrms_module_t* module, uint32_t scene_id, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
 uint32_t vrms_module_destroy_scene(vrms_module_t* module, uint32_t scene_id);
 
 uint32_t vrms_module_destroy_object(vrms_module_t* module, uint32_t scene_id, uint32_t object_id);
@@ -17,6 +17,7 @@
 #include "object.h"
 #include "scene.h"
 #include "server.h"
+#include "ring.h"
 #include "gl-matrix.h"
 #include "gl.h"
 
@@ -29,6 +30,19 @@
 #define ALLOCATION_US_30FPS 33000
 #define ALLOCATION_US_60FPS 16666
 
+// Number of VM instructions executed between checks of the render allocation.
+#define VM_SLICE_INSTRUCTIONS 256
+
+// Default render allocation of a scene each frame.
+#define ALLOCATION_US_DEFAULT 4000
+#define ALLOCATION_INSTRUCTIONS_DEFAULT (1 << 20)
+
+// A scene that overruns its allocation this many frames in a row is demoted:
+// it is recorded after the other scenes and with a quarter of its allocation
+// until it manages to finish a frame in time.
+#define ALLOCATION_DEMOTE_OVERRUNS 3
+#define ALLOCATION_DEMOTE_SHIFT 2
+
 typedef struct vrms_data_type_def {
     const char* name;
     uint8_t item_length;
@@ -49,36 +63,37 @@ const vrms_data_type_def_t data_type_info[] = {
 };
 
 vrms_object_t* vrms_scene_get_object_by_id(vrms_scene_t* scene, uint32_t id) {
-    vrms_object_t* vrms_object;
-    if (scene->next_object_id <= id) {
-        debug_print("C|DEBUG|scene.c|id: %d out of range\n", id);
-        return NULL;
-    }
-    vrms_object = scene->objects[id];
+    vrms_object_t* vrms_object = vrms_object_table_get(scene->objects, id);
     if (!vrms_object) {
+        debug_print("C|DEBUG|scene.c|id: %d not found\n", id);
         return NULL;
     }
     return vrms_object;
 }
 
-uint32_t vrms_scene_queue_add_gl_loaded(vrms_scene_t* scene, vrms_object_type_t type, uint32_t object_id, uint32_t gl_id) {
-    vrms_scene_queue_item_gl_load_t* gl_load = SAFEMALLOC(sizeof(vrms_scene_queue_item_gl_load_t));
-    memset(gl_load, 0, sizeof(vrms_scene_queue_item_gl_load_t));
+// Drops every resolved draw. Called from the module threads as well as the
+// render thread, so the count is bumped atomically.
+void vrms_scene_invalidate_draws(vrms_scene_t* scene) {
+    __atomic_add_fetch(&scene->draw_generation, 1, __ATOMIC_RELEASE);
+}
 
-    gl_load->type = type;
-    gl_load->object_id = object_id;
-    gl_load->gl_id = gl_id;
+uint32_t vrms_scene_queue_add_gl_loaded(vrms_scene_t* scene, vrms_object_type_t type, uint32_t object_id, uint32_t gl_id, uint32_t loaded, uint32_t size) {
+    vrms_scene_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_scene_queue_item_t));
 
-    pthread_mutex_lock(&scene->outbound_queue_lock);
-    uint32_t idx = scene->outbound_queue_index;
-    vrms_scene_queue_item_t* queue_item = &scene->outbound_queue[idx];
-    scene->outbound_queue_index++;
-    pthread_mutex_unlock(&scene->outbound_queue_lock);
+    queue_item.type = VRMS_SCENE_QUEUE_GL_LOAD;
+    queue_item.item.gl_load.type = type;
+    queue_item.item.gl_load.object_id = object_id;
+    queue_item.item.gl_load.gl_id = gl_id;
+    queue_item.item.gl_load.loaded = loaded;
+    queue_item.item.gl_load.size = size;
 
-    queue_item->type = VRMS_SCENE_QUEUE_GL_LOAD;
-    queue_item->item.gl_load = gl_load;
+    if (!vrms_ring_push(scene->outbound_queue, &queue_item)) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_queue_add_gl_loaded(): outbound queue full\n");
+        return 0;
+    }
 
-    return idx;
+    return 1;
 }
 
 vrms_object_memory_t* vrms_scene_get_memory_object_by_id(vrms_scene_t* scene, uint32_t memory_id) {
@@ -144,13 +159,79 @@ vrms_object_texture_t* vrms_scene_get_texture_object_by_id(vrms_scene_t* scene,
     return object->object.object_texture;
 }
 
-void vrms_scene_destroy_object_memory(vrms_object_memory_t* memory) {
+void vrms_scene_pin_memory(vrms_object_memory_t* memory) {
+    __atomic_add_fetch(&memory->refs, 1, __ATOMIC_ACQ_REL);
+}
+
+void vrms_scene_unpin_memory(vrms_object_memory_t* memory) {
+    if (__atomic_sub_fetch(&memory->refs, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
     if (NULL != memory->address) {
         munmap(memory->address, memory->size);
     }
     vrms_object_memory_destroy(memory);
 }
 
+// Where an object's bytes are in client memory: a data object's own, or for
+// a texture those of the data it was created from. Returns NULL once the
+// object or its memory is destroyed. Objects are only freed with scene_lock
+// held, so hold it for as long as the pointer is used.
+uint8_t* vrms_scene_find_object_buffer(vrms_scene_t* scene, uint32_t object_id, vrms_object_memory_t** memory_out) {
+    vrms_object_t* object;
+    vrms_object_data_t* data;
+    vrms_object_memory_t* memory;
+
+    object = vrms_object_table_get(scene->objects, object_id);
+    if (!object) {
+        return NULL;
+    }
+    if (VRMS_OBJECT_TEXTURE == object->type) {
+        object = vrms_object_table_get(scene->objects, object->object.object_texture->data_id);
+        if (!object) {
+            return NULL;
+        }
+    }
+    if (VRMS_OBJECT_DATA != object->type) {
+        return NULL;
+    }
+    data = object->object.object_data;
+
+    object = vrms_object_table_get(scene->objects, data->memory_id);
+    if (!object || (VRMS_OBJECT_MEMORY != object->type)) {
+        return NULL;
+    }
+    memory = object->object.object_memory;
+    if (memory_out) {
+        *memory_out = memory;
+    }
+
+    return &((uint8_t*)memory->address)[data->memory_offset];
+}
+
+uint8_t* vrms_scene_get_object_buffer(vrms_scene_t* scene, uint32_t object_id) {
+    return vrms_scene_find_object_buffer(scene, object_id, NULL);
+}
+
+uint8_t* vrms_scene_pin_object_buffer(vrms_scene_t* scene, uint32_t object_id, vrms_object_memory_t** memory) {
+    uint8_t* buffer;
+
+    pthread_mutex_lock(&scene->scene_lock);
+    buffer = vrms_scene_find_object_buffer(scene, object_id, memory);
+    if (buffer) {
+        vrms_scene_pin_memory(*memory);
+    }
+    pthread_mutex_unlock(&scene->scene_lock);
+
+    return buffer;
+}
+
+// Drops the scene's reference. Memory still pinned by an upload stays
+// mapped until that lets go of it.
+void vrms_scene_destroy_object_memory(vrms_object_memory_t* memory) {
+    vrms_scene_unpin_memory(memory);
+}
+
 void vrms_scene_destroy_object_data(vrms_object_data_t* data) {
     if (NULL != data->local_storage) {
         free(data->local_storage);
@@ -158,12 +239,7 @@ void vrms_scene_destroy_object_data(vrms_object_data_t* data) {
     vrms_object_data_destroy(data);
 }
 
-void vrms_scene_destroy_object(vrms_scene_t* scene, uint32_t object_id) {
-    vrms_object_t* object = vrms_scene_get_object_by_id(scene, object_id);
-    if (!object) {
-        return;
-    }
-
+void vrms_scene_free_object(vrms_object_t* object) {
     // At some point the gl_id *value* is copied into the object, loosing the
     // meaning of the address. TODO: store the address of the gl_id in the
     // object so it can be properly destroyed here, or handle destruction
@@ -189,27 +265,53 @@ void vrms_scene_destroy_object(vrms_scene_t* scene, uint32_t object_id) {
             // N/A
             break;
     }
+    free(object);
+}
+
+void vrms_scene_destroy_object(vrms_scene_t* scene, uint32_t object_id) {
+    vrms_object_t* object = vrms_object_table_remove(scene->objects, object_id);
+    if (!object) {
+        return;
+    }
+    vrms_scene_invalidate_draws(scene);
+
+    // Lookups take no lock, so the render program may still hold the object
+    // it looked up. It only runs with the scene locked, so wait for that.
+    pthread_mutex_lock(&scene->scene_lock);
+    vrms_scene_free_object(object);
+    pthread_mutex_unlock(&scene->scene_lock);
 }
 
 void vrms_scene_destroy_objects(vrms_scene_t* scene) {
-    uint32_t id;
-    for (id = 1; id < scene->next_object_id; id++) {
-        vrms_scene_destroy_object(scene, id);
+    vrms_object_t* object;
+    uint32_t index;
+    for (index = 1; index < scene->objects->nr_slots; index++) {
+        object = vrms_object_table_at(scene->objects, index);
+        if (object) {
+            vrms_scene_free_object(object);
+        }
     }
 
-    free(scene->objects);
+    vrms_object_table_destroy(scene->objects);
 }
 
 void vrms_scene_queue_item_gl_load_process(vrms_scene_t* scene, vrms_scene_queue_item_gl_load_t* gl_load) {
-    vrms_object_t* object;
+    vrms_object_t* object = vrms_scene_get_object_by_id(scene, gl_load->object_id);
+    if (!object) {
+        // Destroyed while its buffer was being loaded.
+        return;
+    }
+    object->gl_loaded = gl_load->loaded;
+    if (gl_load->loaded < gl_load->size) {
+        return;
+    }
+    vrms_scene_invalidate_draws(scene);
     switch (gl_load->type) {
         case VRMS_OBJECT_DATA:
-            object = vrms_scene_get_object_by_id(scene, gl_load->object_id);
             debug_print("C|DEBUG|scene.c|vrms_scene_queue_item_gl_load_process(): setting gl_id on object_id: %d\n", object->id);
             object->gl_id = gl_load->gl_id;
             break;
         case VRMS_OBJECT_TEXTURE:
-            object = vrms_scene_get_object_by_id(scene, gl_load->object_id);
             object->gl_id = gl_load->gl_id;
             if (scene->skybox_texture_id) {
                 debug_print("C|DEBUG|scene.c|vrms_scene_queue_item_gl_load_process(): setting skybox.texture_gl_id\n");
@@ -225,7 +327,7 @@ void vrms_scene_queue_item_gl_load_process(vrms_scene_t* scene, vrms_scene_queue
 void vrms_scene_queue_item_process(vrms_scene_t* scene, vrms_scene_queue_item_t* queue_item) {
     switch (queue_item->type) {
         case VRMS_SCENE_QUEUE_GL_LOAD:
-            vrms_scene_queue_item_gl_load_process(scene, queue_item->item.gl_load);
+            vrms_scene_queue_item_gl_load_process(scene, &queue_item->item.gl_load);
             break;
         default:
             debug_print("C|DEBUG|scene.c|vrms_scene_queue_item_process(): unknown type!!\n");
@@ -234,37 +336,41 @@ void vrms_scene_queue_item_process(vrms_scene_t* scene, vrms_scene_queue_item_t*
 }
 
 void vrms_scene_process_queue(vrms_scene_t* scene) {
-    if (!pthread_mutex_trylock(&scene->outbound_queue_lock)) {
-        uint8_t idx;
-        for (idx = 0; idx < scene->outbound_queue_index; idx++) {
-            vrms_scene_queue_item_process(scene, &scene->outbound_queue[idx]);
-        }
-        scene->outbound_queue_index = 0;
-        pthread_mutex_unlock(&scene->outbound_queue_lock);
-    }
-    else {
-        debug_print("C|DEBUG|scene.c|vrms_scene_process_queue(): lock on queue\n");
+    vrms_scene_queue_item_t* queue_item;
+
+    while (NULL != (queue_item = vrms_ring_peek(scene->outbound_queue))) {
+        vrms_scene_queue_item_process(scene, queue_item);
+        vrms_ring_pop(scene->outbound_queue);
     }
 }
 
-void vrms_scene_add_object(vrms_scene_t* scene, vrms_object_t* object) {
-    // TODO: Need locking here. The server might choose to destroy a scene
-    // while an object is being added.
-    scene->objects[scene->next_object_id] = object;
-    object->id = scene->next_object_id;
-    scene->next_object_id++;
+uint32_t vrms_scene_add_object(vrms_scene_t* scene, vrms_object_t* object) {
+    if (!vrms_object_table_add(scene->objects, object)) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_add_object(): object table full\n");
+        vrms_scene_free_object(object);
+        return 0;
+    }
+    vrms_scene_invalidate_draws(scene);
+    return object->id;
 }
 
 void vrms_scene_destroy(vrms_scene_t* scene) {
     if (!pthread_mutex_lock(&scene->scene_lock)) {
         debug_print("C|DEBUG|scene.c|vrms_scene_destroy(): locked scene\n");
         vrms_scene_destroy_objects(scene);
-        /*
-        vrms_scene_empty_outbound_queue(scene);
-        free(scene->outbound_queue);
-        free(scene->outbound_queue_lock);
-        */
+        vrms_ring_destroy(scene->outbound_queue);
+        if (scene->render_jit) {
+            rendervm_jit_destroy(scene->render_jit);
+        }
+        if (scene->render_code) {
+            rendervm_code_destroy(scene->render_code);
+        }
         rendervm_destroy(scene->vm);
+        free(scene->draw_cache);
+        free(scene->recording.draws);
+        free(scene->recording.models);
+        free(scene->drawing.draws);
+        free(scene->drawing.models);
         pthread_mutex_unlock(&scene->scene_lock);
         debug_print("C|DEBUG|scene.c|vrms_scene_destroy(): unlocked scene\n");
 
@@ -289,9 +395,7 @@ uint32_t vrms_scene_create_memory(vrms_scene_t* scene, uint32_t fd, uint32_t siz
     }
 
     vrms_object_t* object = vrms_object_memory_create(fd, address, size);
-    vrms_scene_add_object(scene, object);
-
-    return object->id;
+    return vrms_scene_add_object(scene, object);
 }
 
 uint32_t vrms_scene_create_object_data(vrms_scene_t* scene, uint32_t memory_id, uint32_t memory_offset, uint32_t memory_length, vrms_data_type_t type) {
@@ -307,7 +411,9 @@ uint32_t vrms_scene_create_object_data(vrms_scene_t* scene, uint32_t memory_id,
     }
 
     vrms_object_t* object = vrms_object_data_create(memory_id, memory_offset, memory_length, type);
-    vrms_scene_add_object(scene, object);
+    if (!vrms_scene_add_object(scene, object)) {
+        return 0;
+    }
 
     debug_print("C|DEBUG|scene.c|created data object[%d]:\n", object->id);
     debug_print("C|DEBUG|scene.c|    memory_id[%d]\n", memory_id);
@@ -319,8 +425,11 @@ uint32_t vrms_scene_create_object_data(vrms_scene_t* scene, uint32_t memory_id,
     if (!object->realized) {
         uint8_t* buffer_ref = (uint8_t*)memory->address;
         void* buffer = &buffer_ref[memory_offset];
-        uint32_t idx = vrms_server_queue_add_data_load(scene->server, memory_length, scene->id, object->id, type, buffer);
-        debug_print("C|DEBUG|scene.c|    queue_idx[%d]\n", idx);
+        if (!vrms_server_queue_add_data_load(scene->server, memory_length, scene->id, object->id, type, buffer)) {
+            debug_print("C|DEBUG|scene.c|    server busy, dropping object\n");
+            vrms_scene_destroy_object(scene, object->id);
+            return 0;
+        }
     }
 
     debug_print("C|DEBUG|scene.c|\n");
@@ -342,8 +451,10 @@ uint32_t vrms_scene_create_object_texture(vrms_scene_t* scene, uint32_t data_id,
         return 0;
     }
 
-    vrms_object_t* object = vrms_object_texture_create(data_id, width, height, format, type);
-    vrms_scene_add_object(scene, object);
+    vrms_object_t* object = vrms_object_texture_create(data_id, data->memory_length, width, height, format, type);
+    if (!vrms_scene_add_object(scene, object)) {
+        return 0;
+    }
 
     debug_print("C|DEBUG|scene.c|created texture object[%d]:\n", object->id);
     debug_print("C|DEBUG|scene.c|    data_id[%d]\n", data_id);
@@ -356,8 +467,11 @@ uint32_t vrms_scene_create_object_texture(vrms_scene_t* scene, uint32_t data_id,
     if (!object->realized) {
         uint8_t* buffer_ref = (uint8_t*)memory->address;
         void* buffer = &buffer_ref[data->memory_offset];
-        uint32_t idx = vrms_server_queue_add_texture_load(scene->server, data->memory_length, scene->id, object->id, width, height, format, type, buffer);
-        debug_print("C|DEBUG|scene.c|    queue_idx[%d]\n", idx);
+        if (!vrms_server_queue_add_texture_load(scene->server, data->memory_length, scene->id, object->id, width, height, format, type, buffer)) {
+            debug_print("C|DEBUG|scene.c|    server busy, dropping object\n");
+            vrms_scene_destroy_object(scene, object->id);
+            return 0;
+        }
     }
     debug_print("C|DEBUG|scene.c|\n");
 
@@ -384,9 +498,44 @@ uint32_t vrms_scene_update_system_matrix(vrms_scene_t* scene, uint32_t data_id,
     float* matrix_array = (float*)&buffer_ref[data->memory_offset];
     float* matrix = &matrix_array[data_index * 16];
 
-    vrms_server_queue_update_system_matrix(scene->server, matrix_type, update_type, (uint8_t*)matrix);
+    return vrms_server_queue_update_system_matrix(scene->server, matrix_type, update_type, (uint8_t*)matrix);
+}
 
-    return 1;
+uint32_t vrms_scene_update_data(vrms_scene_t* scene, uint32_t data_id, uint32_t offset, uint32_t length) {
+    vrms_object_data_t* data = vrms_scene_get_data_object_by_id(scene, data_id);
+    if (!data) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_data(): unable to find data object\n");
+        return 0;
+    }
+    if ((0 == length) || (offset > data->memory_length) || (length > (data->memory_length - offset))) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_data(): range outside data object\n");
+        return 0;
+    }
+
+    return vrms_server_queue_add_data_update(scene->server, scene->id, data_id, offset, length, data->type);
+}
+
+uint32_t vrms_scene_update_texture(vrms_scene_t* scene, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    vrms_object_texture_t* texture = vrms_scene_get_texture_object_by_id(scene, texture_id);
+    if (!texture) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_texture(): unable to find texture object\n");
+        return 0;
+    }
+    if (texture->type != VRMS_TEXTURE_2D) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_texture(): only 2D textures can be updated\n");
+        return 0;
+    }
+    if ((0 == width) || (0 == height) || (x > texture->width) || (width > (texture->width - x)) || (y > texture->height) || (height > (texture->height - y))) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_texture(): rectangle outside texture\n");
+        return 0;
+    }
+
+    if (!vrms_scene_get_object_buffer(scene, texture_id)) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_update_texture(): unable to find texture data\n");
+        return 0;
+    }
+
+    return vrms_server_queue_add_texture_update(scene->server, scene->id, texture_id, texture->width, x, y, width, height, texture->format);
 }
 
 uint32_t vrms_scene_attach_memory(vrms_scene_t* scene, uint32_t data_id) {
@@ -442,11 +591,15 @@ uint32_t vrms_scene_attach_memory(vrms_scene_t* scene, uint32_t data_id) {
     return 1;
 }
 
+// Empties a draw list, keeping its arrays for the next recording.
+void vrms_scene_clear_draw_list(vrms_scene_draw_list_t* list) {
+    list->nr_draws = 0;
+    list->nr_models = 0;
+}
+
 uint32_t vrms_scene_run_program(vrms_scene_t* scene, uint32_t program_id, uint32_t register_id) {
     uint8_t i = 0;
 
-    rendervm_reset(scene->vm);
-
     vrms_object_data_t* reg_data = vrms_scene_get_data_object_by_id(scene, register_id);
     if (!reg_data) {
         debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): unable to find register data object\n");
@@ -466,10 +619,8 @@ uint32_t vrms_scene_run_program(vrms_scene_t* scene, uint32_t program_id, uint32
     uint32_t reg_count = reg_data->memory_length / 4;
     uint8_t* reg_buffer = (uint8_t*)reg_memory->address;
     uint32_t* registers = (uint32_t*)&reg_buffer[reg_data->memory_offset];
-
-    for (i = 0; i < reg_count; i++) {
-        debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): setting register %d to %d\n", i, registers[i]);
-        scene->vm->draw_reg[i] = registers[i];
+    if (reg_count > (sizeof(scene->vm->draw_reg) / sizeof(uint32_t))) {
+        reg_count = sizeof(scene->vm->draw_reg) / sizeof(uint32_t);
     }
 
     vrms_object_data_t* prg_data = vrms_scene_get_data_object_by_id(scene, program_id);
@@ -494,9 +645,58 @@ uint32_t vrms_scene_run_program(vrms_scene_t* scene, uint32_t program_id, uint32
 
     debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): attaching program of length[%d] to render buffer\n", prg_count);
 
+    // Decode and verify once here rather than every frame. The client can
+    // still write to its memory, so it is the decoded copy that is verified.
+    // Programs that fail verification run in the checked byte interpreter.
+    rendervm_code_t* code = NULL;
+    rendervm_verify_t verify;
+    if (prg_count > 0xffff) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): program too long to verify\n");
+    }
+    else {
+        code = rendervm_code_create(program, prg_count);
+        if (code && !rendervm_verify(code->program, code->length, &verify)) {
+            debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): program failed verification at pc[%d] opcode[0x%02x]: %s\n", verify.pc, verify.opcode, rendervm_verify_error2str(verify.error));
+            rendervm_code_destroy(code);
+            code = NULL;
+        }
+    }
+    if (!code) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): running program in checked interpreter\n");
+    }
+
+    rendervm_jit_t* jit = NULL;
+    if (code && scene->jit_enabled) {
+        jit = rendervm_jit_create(scene->vm, code);
+        if (!jit) {
+            debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): unable to compile program, using threaded code\n");
+        }
+    }
+
+    // A worker may be recording the scene, so the VM is only touched with
+    // the scene locked.
     pthread_mutex_lock(&scene->scene_lock);
+    rendervm_reset(scene->vm);
+    for (i = 0; i < reg_count; i++) {
+        debug_print("C|DEBUG|scene.c|vrms_scene_run_program(): setting register %d to %d\n", i, registers[i]);
+        scene->vm->draw_reg[i] = registers[i];
+    }
+    if (scene->render_jit) {
+        rendervm_jit_destroy(scene->render_jit);
+    }
+    if (scene->render_code) {
+        rendervm_code_destroy(scene->render_code);
+    }
+    scene->render_code = code;
+    scene->render_jit = jit;
+    scene->vm->checked = code ? 0 : 1;
     scene->render_buffer = program;
     scene->render_buffer_size = prg_count;
+    vrms_scene_clear_draw_list(&scene->recording);
+    scene->preempted = 0;
+    if (scene->profile_enabled) {
+        rendervm_profile_enable(scene->vm, prg_count);
+    }
     pthread_mutex_unlock(&scene->scene_lock);
 
     debug_print("C|DEBUG|scene.c|program: ");
@@ -508,26 +708,107 @@ uint32_t vrms_scene_run_program(vrms_scene_t* scene, uint32_t program_id, uint32
     return 1;
 }
 
-uint32_t vrms_scene_draw(vrms_scene_t* scene, float* projection_matrix, float* view_matrix, float* model_matrix, float* skybox_projection_matrix) {
-    uint32_t usec_elapsed;
+void vrms_scene_enable_jit(vrms_scene_t* scene, uint8_t enable) {
+    pthread_mutex_lock(&scene->scene_lock);
+    scene->jit_enabled = enable;
+    if (enable && scene->render_code && !scene->render_jit) {
+        scene->render_jit = rendervm_jit_create(scene->vm, scene->render_code);
+    }
+    if (!enable && scene->render_jit) {
+        rendervm_jit_destroy(scene->render_jit);
+        scene->render_jit = NULL;
+    }
+    pthread_mutex_unlock(&scene->scene_lock);
+}
 
-    scene->matrix.p = projection_matrix;
-    scene->matrix.v = view_matrix;
+void vrms_scene_enable_profile(vrms_scene_t* scene, uint8_t enable) {
+    pthread_mutex_lock(&scene->scene_lock);
+    scene->profile_enabled = enable;
+    if (enable && !scene->vm->profile) {
+        rendervm_profile_enable(scene->vm, scene->render_buffer_size);
+    }
+    if (!enable) {
+        rendervm_profile_disable(scene->vm);
+    }
+    pthread_mutex_unlock(&scene->scene_lock);
+}
+
+void vrms_scene_write_profile(vrms_scene_t* scene, FILE* out) {
+    pthread_mutex_lock(&scene->scene_lock);
+    rendervm_profile_write(scene->vm, scene->render_buffer, scene->render_buffer_size, out);
+    pthread_mutex_unlock(&scene->scene_lock);
+}
+
+uint8_t vrms_scene_run_slice(vrms_scene_t* scene, uint32_t budget) {
+    if (scene->render_jit) {
+        return rendervm_run_jit(scene->vm, scene->render_jit, budget);
+    }
+    if (scene->render_code) {
+        return rendervm_run_code(scene->vm, scene->render_code, budget);
+    }
+    return rendervm_run(scene->vm, scene->render_buffer, scene->render_buffer_size, budget);
+}
 
-    vrms_scene_process_queue(scene);
+static uint32_t vrms_scene_usec_between(struct timespec* start, struct timespec* end) {
+    uint64_t nsec_elapsed = ((1.0e+9 * end->tv_sec) + end->tv_nsec) - ((1.0e+9 * start->tv_sec) + start->tv_nsec);
+    return nsec_elapsed / 1000;
+}
+
+void vrms_scene_set_allocation(vrms_scene_t* scene, uint32_t usec, uint32_t instructions) {
+    pthread_mutex_lock(&scene->scene_lock);
+    scene->render_allocation_usec = usec;
+    scene->render_allocation_instructions = instructions;
+    pthread_mutex_unlock(&scene->scene_lock);
+}
+
+// The program finished a frame, so what it recorded becomes what is drawn.
+// The models array has stopped growing, so instanced draws can now point
+// into it.
+void vrms_scene_swap_draw_lists(vrms_scene_t* scene) {
+    vrms_scene_draw_list_t drawing = scene->drawing;
+    vrms_scene_draw_t* draw;
+    uint32_t i;
+
+    scene->drawing = scene->recording;
+    scene->recording = drawing;
+    vrms_scene_clear_draw_list(&scene->recording);
+
+    for (i = 0; i < scene->drawing.nr_draws; i++) {
+        draw = &scene->drawing.draws[i];
+        if (draw->nr_models) {
+            draw->models = &scene->drawing.models[draw->models_index];
+        }
+    }
+}
+
+uint32_t vrms_scene_record(vrms_scene_t* scene) {
+    uint32_t usec_elapsed = 0;
 
     if (!pthread_mutex_trylock(&scene->scene_lock)) {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): locked scene\n");
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): locked scene\n");
+        vrms_scene_process_queue(scene);
         if ((!scene->render_buffer) || (0 == scene->render_buffer_size)) {
             pthread_mutex_unlock(&scene->scene_lock);
             return 0;
         }
 
         uint32_t render_allocation_usec = scene->render_allocation_usec;
-        render_allocation_usec = ALLOCATION_US_60FPS;
+        uint32_t render_allocation_instructions = scene->render_allocation_instructions;
+        if (scene->demoted) {
+            render_allocation_usec >>= ALLOCATION_DEMOTE_SHIFT;
+            render_allocation_instructions >>= ALLOCATION_DEMOTE_SHIFT;
+        }
         rendervm_t* vm = scene->vm;
+        uint32_t cycles = vm->cycles;
 
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): allocation for render is %d usec\n", render_allocation_usec);
+        // A program preempted last frame carries on adding to the same
+        // recording, otherwise this is the start of a new one.
+        if (!scene->preempted) {
+            vrms_scene_clear_draw_list(&scene->recording);
+        }
+        scene->preempted = 0;
+
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): allocation for render is %d usec\n", render_allocation_usec);
 
         struct timespec start;
         struct timespec end;
@@ -537,80 +818,187 @@ uint32_t vrms_scene_draw(vrms_scene_t* scene, float* projection_matrix, float* v
         end.tv_nsec = 0;
         usec_elapsed = 0;
 
+        // A program that yielded or was interrupted last frame carries on
+        // from where it left off.
+        rendervm_resume(vm);
+
+        // Every scene gets at least one slice, however far over its
+        // allocation it is.
         clock_gettime(CLOCK_MONOTONIC, &start);
-        while (rendervm_exec(vm, scene->render_buffer, scene->render_buffer_size)) {
+        while (vrms_scene_run_slice(scene, VM_SLICE_INSTRUCTIONS)) {
 
             clock_gettime(CLOCK_MONOTONIC, &end);
-            uint64_t nsec_elapsed = ((1.0e+9 * end.tv_sec) + end.tv_nsec) - ((1.0e+9 * start.tv_sec) + start.tv_nsec);
-            usec_elapsed += nsec_elapsed / 1000;
+            usec_elapsed = vrms_scene_usec_between(&start, &end);
 
-            debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): executed 1 VM cycle in %d usec\n", usec_elapsed);
+            debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): executed %d VM instructions in %d usec\n", VM_SLICE_INSTRUCTIONS, usec_elapsed);
 
-            if (usec_elapsed > render_allocation_usec) {
-                //rendervm_interrupt(vm);
-                debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): allocation exceeded after %d usec\n", usec_elapsed);
+            if ((render_allocation_usec && (usec_elapsed > render_allocation_usec)) ||
+                (render_allocation_instructions && ((vm->cycles - cycles) >= render_allocation_instructions))) {
+                rendervm_interrupt(vm);
+                scene->preempted = 1;
+                debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): allocation exceeded after %d usec\n", usec_elapsed);
+                break;
             }
         }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        usec_elapsed = vrms_scene_usec_between(&start, &end);
+
         if (rendervm_has_exception(vm)) {
             // TODO: queue message to client that exception occurred
-            debug_print("C|DEBUG|scene.c|vrms_scene_draw(): VM has exception: 0x%02x\n", vm->exception);
+            debug_print("C|DEBUG|scene.c|vrms_scene_record(): VM has exception: 0x%02x\n", vm->exception);
+            vrms_scene_clear_draw_list(&scene->recording);
+        }
+        else if (scene->preempted) {
+            if (scene->overruns < ALLOCATION_DEMOTE_OVERRUNS) {
+                scene->overruns++;
+            }
+            else if (!scene->demoted) {
+                debug_print("C|DEBUG|scene.c|vrms_scene_record(): scene %d demoted\n", scene->id);
+                scene->demoted = 1;
+            }
+        }
+        else {
+            vrms_scene_swap_draw_lists(scene);
+            scene->overruns = 0;
+            scene->demoted = 0;
         }
 
         pthread_mutex_unlock(&scene->scene_lock);
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): unlocked scene\n");
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): unlocked scene\n");
     }
     else {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_draw(): lock on render buffer\n");
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_record(): lock on render buffer\n");
     }
 
     return usec_elapsed;
 }
 
-// TODO this is called for every render call. It is likely that the matrix will
-// be different each time, but unlikely that the matrix will come from a
-// different memory object (ie: just an increment of the matrix_idx). This code
-// should detect that and not do all this work every time.
-void vrms_scene_attach_matrix(vrms_scene_t* scene) {
-    rendervm_t* vm = scene->vm;
-    uint32_t matrix_id = vm->draw_reg[4];
-    uint32_t matrix_idx = vm->draw_reg[5];
+uint8_t vrms_scene_begin_submit(vrms_scene_t* scene) {
+    if (pthread_mutex_trylock(&scene->scene_lock)) {
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_begin_submit(): lock on scene\n");
+        return 0;
+    }
+    return 1;
+}
+
+void vrms_scene_submit_draw(vrms_scene_t* scene, vrms_scene_draw_t* draw) {
+    scene->matrix.m = draw->model;
+    switch (draw->opcode) {
+        case VRMS_SCENE_DRAW_COLOR:
+        case VRMS_SCENE_DRAW_TEXTURE:
+            if (VRMS_SCENE_DRAW_COLOR == draw->opcode) {
+                vrms_gl_draw_mesh_color(draw->render, scene->matrix);
+            }
+            else {
+                vrms_gl_draw_mesh_texture(draw->render, scene->matrix);
+            }
+            break;
+        case VRMS_SCENE_DRAW_COLOR_INSTANCED:
+            vrms_gl_draw_mesh_color_instanced(draw->render, scene->matrix, draw->instanced_shader_id, draw->models, draw->nr_models);
+            break;
+        case VRMS_SCENE_DRAW_TEXTURE_INSTANCED:
+            vrms_gl_draw_mesh_texture_instanced(draw->render, scene->matrix, draw->instanced_shader_id, draw->models, draw->nr_models);
+            break;
+        default:
+            break;
+    }
+}
+
+void vrms_scene_end_submit(vrms_scene_t* scene) {
+    pthread_mutex_unlock(&scene->scene_lock);
+}
+
+// From the top: 8 bits of layer, then for opaque draws 8 bits of shader,
+// 12 of texture, 12 of vertex buffer and 24 of depth. Ids are cut down to
+// fit, which at worst splits a group. Depth is the float bits of the view
+// distance to the model origin, as positive floats order like their bits.
+uint64_t vrms_scene_draw_sort_key(vrms_scene_draw_t* draw, float* view_matrix, uint32_t sequence) {
+    uint64_t key = (uint64_t)draw->layer << 56;
+    uint32_t depth_bits;
+    float* model;
+    float depth;
+
+    if (draw->layer) {
+        return key | sequence;
+    }
+
+    model = draw->models ? draw->models : draw->model;
+    depth = -((view_matrix[2] * model[12]) + (view_matrix[6] * model[13]) + (view_matrix[10] * model[14]) + view_matrix[14]);
+    if (!(depth > 0.0f)) {
+        depth = 0.0f;
+    }
+    memcpy(&depth_bits, &depth, sizeof(uint32_t));
+
+    key |= (uint64_t)(draw->render.shader_id & 0xff) << 48;
+    key |= (uint64_t)(draw->render.texture_id & 0xfff) << 36;
+    key |= (uint64_t)(draw->render.vertex_id & 0xfff) << 24;
+    key |= depth_bits >> 8;
 
+    return key;
+}
+
+// Returns the MAT4 array behind a data object, with nr_matrices set to the
+// number of matrices it holds, or NULL if there is none.
+float* vrms_scene_get_matrix_array(vrms_scene_t* scene, uint32_t matrix_id, uint32_t* nr_matrices) {
     vrms_object_t* mat_object = vrms_scene_get_object_by_id(scene, matrix_id);
     if (!mat_object) {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_matrix(): no matrix object for id: %d\n", matrix_id);
-        return;
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_get_matrix_array(): no matrix object for id: %d\n", matrix_id);
+        return NULL;
     }
 
     vrms_object_data_t* mat_data = mat_object->object.object_data;
     if (mat_data->type != VRMS_MAT4) {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_matrix(): mat_data object is not a VRMS_MAT4\n");
-        return;
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_get_matrix_array(): mat_data object is not a VRMS_MAT4\n");
+        return NULL;
     }
 
     vrms_object_t* mem_object = vrms_scene_get_object_by_id(scene, mat_data->memory_id);
     if (!mem_object) {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_matrix(): no memory object for id: %d\n", mat_data->memory_id);
-        return;
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_get_matrix_array(): no memory object for id: %d\n", mat_data->memory_id);
+        return NULL;
     }
 
     vrms_object_memory_t* memory = mem_object->object.object_memory;
     if (!memory->address) {
-        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_matrix(): memory->address NULL\n");
-        return;
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_get_matrix_array(): memory->address NULL\n");
+        return NULL;
     }
     uint8_t* buffer_ref = (uint8_t*)memory->address;
-    float* matrix_array = (float*)&buffer_ref[mat_data->memory_offset];
+
+    *nr_matrices = mat_data->memory_length / (16 * sizeof(float));
+    return (float*)&buffer_ref[mat_data->memory_offset];
+}
+
+void vrms_scene_attach_matrix(vrms_scene_t* scene, float* matrix_array, uint32_t nr_matrices) {
+    rendervm_t* vm = scene->vm;
+    uint32_t matrix_idx = vm->draw_reg[5];
+
+    if (matrix_idx >= nr_matrices) {
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_matrix(): index %d outside %d matrices\n", matrix_idx, nr_matrices);
+        return;
+    }
     float* model_matrix = &matrix_array[matrix_idx * 16];
 
     scene->matrix.realized = 1;
     scene->matrix.m = model_matrix;
+}
 
-    mat4_copy(scene->matrix.mv, scene->matrix.v);
-    mat4_multiply(scene->matrix.mv, scene->matrix.m);
+// Returns the model matrices for an instanced draw, draw_reg[5] being the
+// first and draw_reg[8] the count, or NULL if the range is out of bounds.
+float* vrms_scene_attach_instances(vrms_scene_t* scene, float* matrix_array, uint32_t nr_matrices, uint32_t* count) {
+    rendervm_t* vm = scene->vm;
+    uint32_t first = vm->draw_reg[5];
 
-    mat4_copy(scene->matrix.mvp, scene->matrix.p);
-    mat4_multiply(scene->matrix.mvp, scene->matrix.v);
-    mat4_multiply(scene->matrix.mvp, scene->matrix.m);
+    *count = vm->draw_reg[8];
+    if ((0 == *count) || (first >= nr_matrices) || (*count > (nr_matrices - first))) {
+        debug_render_print("C|DEBUG|scene.c|vrms_scene_attach_instances(): range %d+%d outside %d matrices\n", first, *count, nr_matrices);
+        return NULL;
+    }
+
+    scene->matrix.realized = 1;
+    scene->matrix.m = &matrix_array[first * 16];
+
+    return scene->matrix.m;
 }
 
 // TODO: add gpu_attempted flag to data object, pass vertex_id as reference and
@@ -693,22 +1081,201 @@ void vrms_scene_dump_render(vrms_scene_t* scene) {
     debug_render_print("C|DEBUG|scene.c|    realized: %d\n", scene->render.realized);
 }
 
+// Registers a draw resolves through: all but the matrix index, which
+// changes from draw to draw, and the instance count.
+void vrms_scene_draw_key(rendervm_t* vm, uint32_t regs[8]) {
+    memcpy(regs, vm->draw_reg, sizeof(uint32_t) * 8);
+    regs[5] = 0;
+}
+
+uint32_t vrms_scene_draw_hash(uint32_t regs[8], uint8_t texture) {
+    uint32_t hash = 2166136261u ^ texture;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++) {
+        hash = (hash ^ regs[i]) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+// Sets scene->render for the draw in the VM registers and returns the MAT4
+// array behind draw_reg[4], or NULL if there is none. Draws resolved before
+// come from the cache without touching the object table.
+float* vrms_scene_resolve_draw(vrms_scene_t* scene, uint8_t texture, uint32_t* nr_matrices) {
+    vrms_scene_draw_cache_t* entry;
+    uint32_t generation;
+    uint32_t regs[8];
+    float* matrices;
+
+    generation = __atomic_load_n(&scene->draw_generation, __ATOMIC_ACQUIRE);
+    vrms_scene_draw_key(scene->vm, regs);
+    entry = &scene->draw_cache[vrms_scene_draw_hash(regs, texture) % VRMS_SCENE_DRAW_CACHE_SIZE];
+
+    if ((entry->generation == generation) && (entry->texture == texture) && (0 == memcmp(entry->regs, regs, sizeof(regs)))) {
+        scene->render = entry->render;
+        *nr_matrices = entry->nr_matrices;
+        return entry->matrices;
+    }
+
+    memset(&scene->render, 0, sizeof(vrms_gl_render_t));
+    if (texture) {
+        vrms_scene_render_realize_texture(scene);
+    }
+    else {
+        vrms_scene_render_realize_color(scene);
+    }
+    matrices = vrms_scene_get_matrix_array(scene, regs[4], nr_matrices);
+
+    // Draws still waiting on an upload are resolved again next time.
+    if (matrices && scene->render.realized) {
+        entry->generation = generation;
+        entry->texture = texture;
+        memcpy(entry->regs, regs, sizeof(regs));
+        entry->render = scene->render;
+        entry->matrices = matrices;
+        entry->nr_matrices = *nr_matrices;
+    }
+
+    return matrices;
+}
+
+// Appends a draw to the list the scene submits for each eye, or returns NULL
+// if the list could not grow.
+vrms_scene_draw_t* vrms_scene_add_draw(vrms_scene_t* scene, uint8_t opcode) {
+    vrms_scene_draw_list_t* list = &scene->recording;
+    vrms_scene_draw_t* draws;
+    uint32_t size;
+
+    if (list->nr_draws == list->size) {
+        size = list->size ? list->size * 2 : 64;
+        draws = realloc(list->draws, size * sizeof(vrms_scene_draw_t));
+        if (!draws) {
+            debug_print("C|DEBUG|scene.c|vrms_scene_add_draw(): unable to grow draw list to %d\n", size);
+            return NULL;
+        }
+        list->draws = draws;
+        list->size = size;
+    }
+
+    vrms_scene_draw_t* draw = &list->draws[list->nr_draws++];
+    memset(draw, 0, sizeof(vrms_scene_draw_t));
+    draw->opcode = opcode;
+    draw->layer = (scene->vm->draw_reg[9] > 0xff) ? 0xff : scene->vm->draw_reg[9];
+    draw->render = scene->render;
+
+    return draw;
+}
+
+// The draw opcodes only record what to draw. The model matrix is copied as
+// the client may rewrite its memory before the second eye is drawn.
+void vrms_scene_record_draw(vrms_scene_t* scene, uint8_t opcode, float* matrix_array, uint32_t nr_matrices) {
+    vrms_scene_draw_t* draw;
+
+    if (!matrix_array) {
+        return;
+    }
+
+    scene->matrix.m = NULL;
+    vrms_scene_attach_matrix(scene, matrix_array, nr_matrices);
+    if (!scene->matrix.m) {
+        return;
+    }
+
+    draw = vrms_scene_add_draw(scene, opcode);
+    if (draw) {
+        mat4_copy(draw->model, scene->matrix.m);
+    }
+}
+
+// Copies count model matrices onto the end of the recording's models array
+// and returns where they start, or -1 if the array could not grow.
+int64_t vrms_scene_add_models(vrms_scene_t* scene, float* models, uint32_t count) {
+    vrms_scene_draw_list_t* list = &scene->recording;
+    uint32_t nr_floats = count * 16;
+    uint32_t index = list->nr_models;
+    float* array;
+    uint32_t size;
+
+    if ((list->nr_models + nr_floats) > list->models_size) {
+        size = list->models_size ? list->models_size * 2 : 1024;
+        while (size < (list->nr_models + nr_floats)) {
+            size *= 2;
+        }
+        array = realloc(list->models, size * sizeof(float));
+        if (!array) {
+            debug_print("C|DEBUG|scene.c|vrms_scene_add_models(): unable to grow models to %d\n", size);
+            return -1;
+        }
+        list->models = array;
+        list->models_size = size;
+    }
+
+    memcpy(&list->models[index], models, nr_floats * sizeof(float));
+    list->nr_models += nr_floats;
+
+    return index;
+}
+
+void vrms_scene_record_draw_instanced(vrms_scene_t* scene, uint8_t opcode, uint32_t instanced_shader_id, float* matrix_array, uint32_t nr_matrices) {
+    vrms_scene_draw_t* draw;
+    float* models;
+    uint32_t count;
+    int64_t index;
+
+    if (!matrix_array) {
+        return;
+    }
+
+    models = vrms_scene_attach_instances(scene, matrix_array, nr_matrices, &count);
+    if (!models) {
+        return;
+    }
+
+    // Copied like the single draw's matrix, the pointer into the models
+    // array is set once recording is done.
+    index = vrms_scene_add_models(scene, models, count);
+    if (index < 0) {
+        return;
+    }
+
+    draw = vrms_scene_add_draw(scene, opcode);
+    if (draw) {
+        draw->instanced_shader_id = instanced_shader_id;
+        draw->models_index = (uint32_t)index;
+        draw->nr_models = count;
+    }
+    else {
+        scene->recording.nr_models = (uint32_t)index;
+    }
+}
+
 void vrms_scene_vm_callback(rendervm_t* vm, rendervm_opcode_t opcode, void* user_data) {
     vrms_scene_t* scene = (vrms_scene_t*)user_data;
+    uint32_t nr_matrices = 0;
+    float* matrices;
+
     switch ((uint8_t)opcode) {
-        case 0xc8:
-            vrms_scene_render_realize_color(scene);
-            vrms_scene_attach_matrix(scene);
+        case VRMS_SCENE_DRAW_COLOR:
+            matrices = vrms_scene_resolve_draw(scene, 0, &nr_matrices);
             scene->render.shader_id = scene->server->color_shader_id;
-            vrms_gl_draw_mesh_color(scene->render, scene->matrix);
+            vrms_scene_record_draw(scene, VRMS_SCENE_DRAW_COLOR, matrices, nr_matrices);
             break;
-        case 0xc9:
+        case VRMS_SCENE_DRAW_TEXTURE:
             debug_render_print("C|DEBUG|scene.c|vrms_scene_vm_callback(): vrms_gl_draw_mesh_texture\n");
-            vrms_scene_render_realize_texture(scene);
+            matrices = vrms_scene_resolve_draw(scene, 1, &nr_matrices);
             vrms_scene_dump_render(scene);
-            vrms_scene_attach_matrix(scene);
             scene->render.shader_id = scene->server->texture_shader_id;
-            vrms_gl_draw_mesh_texture(scene->render, scene->matrix);
+            vrms_scene_record_draw(scene, VRMS_SCENE_DRAW_TEXTURE, matrices, nr_matrices);
+            break;
+        case VRMS_SCENE_DRAW_COLOR_INSTANCED:
+            matrices = vrms_scene_resolve_draw(scene, 0, &nr_matrices);
+            scene->render.shader_id = scene->server->color_shader_id;
+            vrms_scene_record_draw_instanced(scene, VRMS_SCENE_DRAW_COLOR_INSTANCED, scene->server->color_instanced_shader_id, matrices, nr_matrices);
+            break;
+        case VRMS_SCENE_DRAW_TEXTURE_INSTANCED:
+            matrices = vrms_scene_resolve_draw(scene, 1, &nr_matrices);
+            scene->render.shader_id = scene->server->texture_shader_id;
+            vrms_scene_record_draw_instanced(scene, VRMS_SCENE_DRAW_TEXTURE_INSTANCED, scene->server->texture_instanced_shader_id, matrices, nr_matrices);
             break;
         default:
             break;
@@ -724,11 +1291,16 @@ vrms_scene_t* vrms_scene_create(char* name) {
     vrms_scene_t* scene = SAFEMALLOC(sizeof(vrms_scene_t));
     memset(scene, 0, sizeof(vrms_scene_t));
 
-    scene->objects = SAFEMALLOC(sizeof(vrms_object_t) * 10);
-    memset(scene->objects, 0, sizeof(vrms_object_t) * 10);
-    scene->next_object_id = 1;
+    scene->objects = vrms_object_table_create();
+    scene->outbound_queue = vrms_ring_create(VRMS_SCENE_OUTBOUND_QUEUE_SIZE, sizeof(vrms_scene_queue_item_t));
 
     scene->render_buffer_size = 0;
+    scene->render_allocation_usec = ALLOCATION_US_DEFAULT;
+    scene->render_allocation_instructions = ALLOCATION_INSTRUCTIONS_DEFAULT;
+
+    scene->draw_cache = SAFEMALLOC(sizeof(vrms_scene_draw_cache_t) * VRMS_SCENE_DRAW_CACHE_SIZE);
+    memset(scene->draw_cache, 0, sizeof(vrms_scene_draw_cache_t) * VRMS_SCENE_DRAW_CACHE_SIZE);
+    scene->draw_generation = 1;
 
     scene->vm = rendervm_create();
     rendervm_attach_callback(scene->vm, &vrms_scene_vm_callback, (void*)scene);
@@ -4,44 +4,113 @@
 #include "vroom.h"
 #include "gl.h"
 #include "rendervm.h"
+#include "rendervm_jit.h"
+
+// Render VM callback opcodes. Meshes are taken from draw_reg[0] vertex,
+// [1] normal and [2] index, plus [3] color for color draws or [6] uv and [7]
+// texture for texture draws. draw_reg[4] holds the MAT4 data object and [5]
+// the index of the model matrix. The instanced draws render draw_reg[8]
+// copies of the mesh, one for each matrix starting at draw_reg[5].
+// draw_reg[9] is the layer. Draws in layer 0 are opaque and may be drawn in
+// any order. Other layers are drawn after it, lowest first, each keeping
+// the order its draws were made in.
+#define VRMS_SCENE_DRAW_COLOR               0xc8
+#define VRMS_SCENE_DRAW_TEXTURE             0xc9
+#define VRMS_SCENE_DRAW_COLOR_INSTANCED     0xca
+#define VRMS_SCENE_DRAW_TEXTURE_INSTANCED   0xcb
+
+#define VRMS_SCENE_OUTBOUND_QUEUE_SIZE      1024
+#define VRMS_SCENE_DRAW_CACHE_SIZE          256
 
 typedef struct vrms_server vrms_server_t;
 typedef struct vrms_object vrms_object_t;
+typedef struct vrms_object_table vrms_object_table_t;
+typedef struct vrms_ring vrms_ring_t;
 
 typedef enum vrms_scene_queue_item_type {
     VRMS_SCENE_QUEUE_GL_LOAD
 } vrms_scene_queue_item_type_t;
 
+// Large uploads report progress as they go. The object is only given its
+// gl_id once loaded reaches size.
 typedef struct vrms_scene_queue_item_gl_load {
     vrms_object_type_t type;
     uint32_t object_id;
     uint32_t gl_id;
+    uint32_t loaded;
+    uint32_t size;
 } vrms_scene_queue_item_gl_load_t;
 
 typedef struct vrms_scene_queue_item {
     vrms_scene_queue_item_type_t type;
     union {
-        vrms_scene_queue_item_gl_load_t* gl_load;
+        vrms_scene_queue_item_gl_load_t gl_load;
     } item;
 } vrms_scene_queue_item_t;
 
+// One draw recorded by the render VM. Recording happens once a frame and
+// the list is then submitted once for each eye.
+typedef struct vrms_scene_draw {
+    uint8_t opcode;
+    uint8_t layer;
+    vrms_gl_render_t render;
+    float model[16];
+    uint32_t instanced_shader_id;
+    float* models;
+    uint32_t models_index;
+    uint32_t nr_models;
+} vrms_scene_draw_t;
+
+// A draw with its registers resolved to GL ids and the MAT4 array behind
+// draw_reg[4]. Entries are only good while generation matches the scene's
+// draw_generation, which moves whenever an object is created, destroyed or
+// finishes loading.
+typedef struct vrms_scene_draw_cache {
+    uint32_t generation;
+    uint8_t texture;
+    uint32_t regs[8];
+    vrms_gl_render_t render;
+    float* matrices;
+    uint32_t nr_matrices;
+} vrms_scene_draw_cache_t;
+
+// Instanced draws keep their model matrices in the list's own models array,
+// as the client may rewrite its memory while the list is still drawn.
+typedef struct vrms_scene_draw_list {
+    vrms_scene_draw_t* draws;
+    uint32_t size;
+    uint32_t nr_draws;
+    float* models;
+    uint32_t models_size;
+    uint32_t nr_models;
+} vrms_scene_draw_list_t;
+
 typedef struct vrms_scene {
     char* name;
     uint32_t id;
     vrms_server_t* server;
-    uint32_t next_object_id;
-    vrms_object_t** objects;
-    vrms_scene_queue_item_t outbound_queue[256];
-    uint8_t outbound_queue_index;
-    pthread_mutex_t outbound_queue_lock;
+    vrms_object_table_t* objects;
+    vrms_ring_t* outbound_queue;
     uint32_t render_buffer_size;
     uint8_t* render_buffer;
+    rendervm_code_t* render_code;
+    rendervm_jit_t* render_jit;
+    uint8_t jit_enabled;
+    uint8_t profile_enabled;
     rendervm_t* vm;
     pthread_mutex_t scene_lock;
     uint32_t render_allocation_usec;
+    uint32_t render_allocation_instructions;
+    uint8_t preempted;
+    uint8_t overruns;
+    uint8_t demoted;
     uint32_t skybox_texture_id;
     vrms_gl_render_t render;
     vrms_gl_matrix_t matrix;
+    vrms_scene_draw_cache_t* draw_cache;
+    uint32_t draw_generation;
+    vrms_scene_draw_list_t recording;
+    vrms_scene_draw_list_t drawing;
 } vrms_scene_t;
 
 vrms_scene_t* vrms_scene_create(char* name);
@@ -62,15 +131,62 @@ uint32_t vrms_scene_attach_memory(vrms_scene_t* scene, uint32_t data_id);
 
 uint32_t vrms_scene_run_program(vrms_scene_t* scene, uint32_t program_id, uint32_t register_id);
 
+void vrms_scene_enable_jit(vrms_scene_t* scene, uint8_t enable);
+
+// Profiles the scene's render program, starting again whenever a new program
+// is attached. vrms_scene_write_profile() writes the counts in the format
+// read by rendervmasm --profile.
+void vrms_scene_enable_profile(vrms_scene_t* scene, uint8_t enable);
+
+void vrms_scene_write_profile(vrms_scene_t* scene, FILE* out);
+
 vrms_object_t* vrms_scene_get_object_by_id(vrms_scene_t* scene, uint32_t id);
 
+// The client memory holding a data object's bytes, or a texture's. Only
+// valid while scene_lock is held; NULL once the object or memory is gone.
+uint8_t* vrms_scene_get_object_buffer(vrms_scene_t* scene, uint32_t object_id);
+
+// The same for threads that read the bytes without the scene lock. The
+// memory stays mapped, even if the client destroys it, until released
+// with vrms_scene_unpin_memory().
+uint8_t* vrms_scene_pin_object_buffer(vrms_scene_t* scene, uint32_t object_id, vrms_object_memory_t** memory);
+void vrms_scene_unpin_memory(vrms_object_memory_t* memory);
+
 uint32_t vrms_scene_update_system_matrix(vrms_scene_t* scene, uint32_t data_id, uint32_t data_index, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type);
 
+// Mark a byte range of a data object, or a rectangle of a 2D texture, as
+// changed in client memory. Ranges touched more than once in a frame are
+// uploaded once.
+uint32_t vrms_scene_update_data(vrms_scene_t* scene, uint32_t data_id, uint32_t offset, uint32_t length);
+
+uint32_t vrms_scene_update_texture(vrms_scene_t* scene, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
 uint32_t vrms_scene_set_skybox(vrms_scene_t* scene, uint32_t texture_id);
 vrms_object_t* vrms_scene_get_mesh_by_id(vrms_scene_t* scene, uint32_t mesh_id);
 
-uint32_t vrms_scene_draw(vrms_scene_t* scene, float* projection_matrix, float* view_matrix, float* model_matrix, float* skybox_projection_matrix);
-
-uint32_t vrms_scene_queue_add_gl_loaded(vrms_scene_t* scene, vrms_object_type_t type, uint32_t object_id, uint32_t gl_id);
+// Sets how long the render program may run each frame, in usec and in VM
+// instructions. 0 leaves that limit off. A program still running when either
+// runs out is interrupted and resumed next frame.
+void vrms_scene_set_allocation(vrms_scene_t* scene, uint32_t usec, uint32_t instructions);
+
+// Runs the scene's render program for this frame, recording its draws.
+// Returns the time taken in usec.
+uint32_t vrms_scene_record(vrms_scene_t* scene);
+
+// Draws the last frame the program finished recording, with the given view
+// and projection.
+// Submitting draws for an eye starts by locking the scene, which returns 0
+// if the scene is busy and must be skipped. The draws in scene->drawing may
+// then be submitted in any order until the scene is unlocked. The eye's view
+// and projection are set with vrms_gl_set_eye().
+uint8_t vrms_scene_begin_submit(vrms_scene_t* scene);
+void vrms_scene_submit_draw(vrms_scene_t* scene, vrms_scene_draw_t* draw);
+void vrms_scene_end_submit(vrms_scene_t* scene);
+
+// Sort key that groups draws by layer, shader, texture and vertex buffer,
+// opaque ones front to back. sequence orders draws in the other layers.
+uint64_t vrms_scene_draw_sort_key(vrms_scene_draw_t* draw, float* view_matrix, uint32_t sequence);
+
+uint32_t vrms_scene_queue_add_gl_loaded(vrms_scene_t* scene, vrms_object_type_t type, uint32_t object_id, uint32_t gl_id, uint32_t loaded, uint32_t size);
 
 #endif
@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <limits.h>
 #include <pthread.h>
+#include <time.h>
 
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -18,117 +20,268 @@
 #include "object.h"
 #include "scene.h"
 #include "server.h"
+#include "ring.h"
+#include "sort.h"
+#include "upload.h"
+#include "workers.h"
 #include "gl-matrix.h"
 
 #define DEBUG 1
 #define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
 
+#define UPLOAD_BYTES_DEFAULT (4 * 1024 * 1024)
+#define UPLOAD_USEC_DEFAULT 2000
+#define UPLOAD_CHUNK_BYTES (512 * 1024)
+
 vrms_scene_t* vrms_server_get_scene(vrms_server_t* vrms_server, uint32_t scene_id) {
-    vrms_scene_t* scene;
-    if (scene_id >= vrms_server->next_scene_id) {
-        debug_print("invalid scene_id [%d] requested: id out of range\n", scene_id);
-        return NULL;
-    }
-    scene = vrms_server->scenes[scene_id];
-    if (!scene) {
+    vrms_object_t* object;
+    object = vrms_object_table_get(vrms_server->scenes, scene_id);
+    if (!object) {
         debug_print("invalid scene_id [%d] requested: scene does not exist\n", scene_id);
         return NULL;
     }
-    return scene;
+    return object->object.object_scene;
+}
+
+vrms_server_active_t* vrms_server_active_create(uint32_t nr_scenes) {
+    vrms_server_active_t* active;
+
+    active = SAFEMALLOC(sizeof(vrms_server_active_t) + (sizeof(vrms_scene_t*) * nr_scenes * 2));
+    active->nr_scenes = nr_scenes;
+    active->scenes = (vrms_scene_t**)(active + 1);
+    active->order = active->scenes + nr_scenes;
+
+    return active;
+}
+
+// Frees whatever the render thread can no longer be using. Called with the
+// registry lock held.
+void vrms_server_reclaim(vrms_server_t* server) {
+    vrms_server_retired_t** link;
+    vrms_server_retired_t* retired;
+    uint64_t epoch;
+
+    epoch = __atomic_load_n(&server->render_epoch, __ATOMIC_SEQ_CST);
+    link = &server->retired;
+    while (NULL != *link) {
+        retired = *link;
+        if (retired->epoch >= epoch) {
+            link = &retired->next;
+            continue;
+        }
+        *link = retired->next;
+        if (retired->active) {
+            free(retired->active);
+        }
+        if (retired->scene) {
+            vrms_scene_destroy(retired->scene->object.object_scene);
+            free(retired->scene);
+        }
+        free(retired);
+    }
+}
+
+// Swaps in a new active list and retires the old one, along with the scene
+// just destroyed if there is one. Called with the registry lock held.
+void vrms_server_publish(vrms_server_t* server, vrms_server_active_t* active, vrms_object_t* scene) {
+    vrms_server_retired_t* retired = SAFEMALLOC(sizeof(vrms_server_retired_t));
+
+    retired->active = server->active;
+    retired->scene = scene;
+    __atomic_store_n(&server->active, active, __ATOMIC_SEQ_CST);
+    // The render thread bumps the epoch before it loads the list, so any
+    // frame that could have loaded the old one has an epoch no later than
+    // this.
+    retired->epoch = __atomic_load_n(&server->render_epoch, __ATOMIC_SEQ_CST);
+    retired->next = server->retired;
+    server->retired = retired;
+
+    vrms_server_reclaim(server);
 }
 
 uint32_t vrms_server_create_scene(vrms_server_t* server, char* name) {
+    vrms_server_active_t* active;
+    vrms_object_t* object;
     vrms_scene_t* scene = vrms_scene_create(name);
     scene->server = server;
-
-    server->scenes[server->next_scene_id] = scene;
-    scene->id = server->next_scene_id;
-    server->next_scene_id++;
+    vrms_scene_enable_jit(scene, server->scene_jit);
+    vrms_scene_enable_profile(scene, server->profile_dir ? 1 : 0);
+
+    object = vrms_object_create();
+    object->type = VRMS_OBJECT_SCENE;
+    object->object.object_scene = scene;
+
+    pthread_mutex_lock(&server->registry_lock);
+    scene->id = vrms_object_table_add(server->scenes, object);
+    if (!scene->id) {
+        pthread_mutex_unlock(&server->registry_lock);
+        debug_print("scene table full\n");
+        free(object);
+        vrms_scene_destroy(scene);
+        return 0;
+    }
+    active = vrms_server_active_create(server->active->nr_scenes + 1);
+    memcpy(active->scenes, server->active->scenes, sizeof(vrms_scene_t*) * server->active->nr_scenes);
+    active->scenes[server->active->nr_scenes] = scene;
+    vrms_server_publish(server, active, NULL);
+    pthread_mutex_unlock(&server->registry_lock);
 
     return scene->id;
 }
 
+void vrms_server_write_profile(vrms_server_t* server, vrms_scene_t* scene) {
+    char filename[PATH_MAX];
+    FILE* out;
+
+    snprintf(filename, sizeof(filename), "%s/scene-%d.prof", server->profile_dir, scene->id);
+    out = fopen(filename, "w");
+    if (!out) {
+        debug_print("unable to write profile %s\n", filename);
+        return;
+    }
+    vrms_scene_write_profile(scene, out);
+    fclose(out);
+}
+
 uint32_t vrms_server_destroy_scene(vrms_server_t* server, uint32_t scene_id) {
-    vrms_scene_t* scene = vrms_server_get_scene(server, scene_id);
-    if (!scene) {
+    vrms_server_active_t* active;
+    vrms_object_t* object;
+    vrms_scene_t* scene;
+    uint32_t i, nr_scenes;
+
+    pthread_mutex_lock(&server->registry_lock);
+    object = vrms_object_table_remove(server->scenes, scene_id);
+    if (!object) {
+        pthread_mutex_unlock(&server->registry_lock);
         debug_print("no scene found\n");
         return 0;
     }
+    scene = object->object.object_scene;
+
+    if (server->profile_dir) {
+        vrms_server_write_profile(server, scene);
+    }
+
+    active = vrms_server_active_create(server->active->nr_scenes - 1);
+    nr_scenes = 0;
+    for (i = 0; i < server->active->nr_scenes; i++) {
+        if (server->active->scenes[i] != scene) {
+            active->scenes[nr_scenes++] = server->active->scenes[i];
+        }
+    }
+
+    // The render thread may be part way through the scene, so it is only
+    // destroyed once a later frame has started.
+    vrms_server_publish(server, active, object);
+    pthread_mutex_unlock(&server->registry_lock);
 
-    server->scenes[scene_id] = NULL;
-    vrms_scene_destroy(scene);
     return 1;
 }
 
 uint32_t vrms_server_queue_add_data_load(vrms_server_t* server, uint32_t size, uint32_t scene_id, uint32_t object_id, vrms_data_type_t type, uint8_t* buffer) {
-    vrms_queue_item_data_load_t* data_load = SAFEMALLOC(sizeof(vrms_queue_item_data_load_t));
-    memset(data_load, 0, sizeof(vrms_queue_item_data_load_t));
-
-    data_load->size = size;
-    data_load->scene_id = scene_id;
-    data_load->object_id = object_id;
-    data_load->type = type;
-    data_load->buffer = buffer;
+    vrms_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_queue_item_t));
+
+    queue_item.type = VRMS_QUEUE_DATA_LOAD;
+    queue_item.item.data_load.size = size;
+    queue_item.item.data_load.scene_id = scene_id;
+    queue_item.item.data_load.object_id = object_id;
+    queue_item.item.data_load.type = type;
+    queue_item.item.data_load.buffer = buffer;
+
+    if (!vrms_ring_push(server->inbound_queue, &queue_item)) {
+        debug_print("vrms_server_queue_add_data_load(): inbound queue full\n");
+        return 0;
+    }
 
-    pthread_mutex_lock(&server->inbound_queue_lock);
-    uint32_t idx = server->inbound_queue_index;
-    vrms_queue_item_t* queue_item = &server->inbound_queue[idx];
-    server->inbound_queue_index++;
-    pthread_mutex_unlock(&server->inbound_queue_lock);
+    return 1;
+}
 
-    queue_item->type = VRMS_QUEUE_DATA_LOAD;
-    queue_item->item.data_load = data_load;
+uint32_t vrms_server_queue_add_texture_load(vrms_server_t* server, uint32_t size, uint32_t scene_id, uint32_t object_id, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type, uint8_t* buffer) {
+    vrms_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_queue_item_t));
+
+    queue_item.type = VRMS_QUEUE_TEXTURE_LOAD;
+    queue_item.item.texture_load.size = size;
+    queue_item.item.texture_load.scene_id = scene_id;
+    queue_item.item.texture_load.object_id = object_id;
+    queue_item.item.texture_load.width = width;
+    queue_item.item.texture_load.height = height;
+    queue_item.item.texture_load.format = format;
+    queue_item.item.texture_load.type = type;
+    queue_item.item.texture_load.buffer = buffer;
+
+    if (!vrms_ring_push(server->inbound_queue, &queue_item)) {
+        debug_print("vrms_server_queue_add_texture_load(): inbound queue full\n");
+        return 0;
+    }
 
-    return idx;
+    return 1;
 }
 
-uint32_t vrms_server_queue_add_texture_load(vrms_server_t* server, uint32_t size, uint32_t scene_id, uint32_t object_id, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type, uint8_t* buffer) {
-    vrms_queue_item_texture_load_t* texture_load = SAFEMALLOC(sizeof(vrms_queue_item_texture_load_t));
-    memset(texture_load, 0, sizeof(vrms_queue_item_texture_load_t));
+uint32_t vrms_server_queue_add_data_update(vrms_server_t* server, uint32_t scene_id, uint32_t object_id, uint32_t offset, uint32_t size, vrms_data_type_t type) {
+    vrms_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_queue_item_t));
 
-    texture_load->size = size;
-    texture_load->scene_id = scene_id;
-    texture_load->object_id = object_id;
-    texture_load->width = width;
-    texture_load->height = height;
-    texture_load->format = format;
-    texture_load->type = type;
-    texture_load->buffer = buffer;
+    queue_item.type = VRMS_QUEUE_DATA_UPDATE;
+    queue_item.item.data_update.scene_id = scene_id;
+    queue_item.item.data_update.object_id = object_id;
+    queue_item.item.data_update.offset = offset;
+    queue_item.item.data_update.size = size;
+    queue_item.item.data_update.type = type;
 
-    pthread_mutex_lock(&server->inbound_queue_lock);
-    uint32_t idx = server->inbound_queue_index;
-    vrms_queue_item_t* queue_item = &server->inbound_queue[idx];
-    server->inbound_queue_index++;
-    pthread_mutex_unlock(&server->inbound_queue_lock);
+    if (!vrms_ring_push(server->inbound_queue, &queue_item)) {
+        debug_print("vrms_server_queue_add_data_update(): inbound queue full\n");
+        return 0;
+    }
 
-    queue_item->type = VRMS_QUEUE_TEXTURE_LOAD;
-    queue_item->item.texture_load = texture_load;
+    return 1;
+}
 
-    return idx;
+uint32_t vrms_server_queue_add_texture_update(vrms_server_t* server, uint32_t scene_id, uint32_t object_id, uint32_t image_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vrms_texture_format_t format) {
+    vrms_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_queue_item_t));
+
+    queue_item.type = VRMS_QUEUE_TEXTURE_UPDATE;
+    queue_item.item.texture_update.scene_id = scene_id;
+    queue_item.item.texture_update.object_id = object_id;
+    queue_item.item.texture_update.image_width = image_width;
+    queue_item.item.texture_update.x = x;
+    queue_item.item.texture_update.y = y;
+    queue_item.item.texture_update.width = width;
+    queue_item.item.texture_update.height = height;
+    queue_item.item.texture_update.format = format;
+
+    if (!vrms_ring_push(server->inbound_queue, &queue_item)) {
+        debug_print("vrms_server_queue_add_texture_update(): inbound queue full\n");
+        return 0;
+    }
+
+    return 1;
 }
 
-void vrms_server_queue_update_system_matrix(vrms_server_t* server, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, uint8_t* buffer) {
-    vrms_queue_item_update_system_matrix_t* update_system_matrix = SAFEMALLOC(sizeof(vrms_queue_item_update_system_matrix_t));
-    memset(update_system_matrix, 0, sizeof(vrms_queue_item_update_system_matrix_t));
+uint32_t vrms_server_queue_update_system_matrix(vrms_server_t* server, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, uint8_t* buffer) {
+    vrms_queue_item_t queue_item;
+    memset(&queue_item, 0, sizeof(vrms_queue_item_t));
 
-    update_system_matrix->matrix_type = matrix_type;
-    update_system_matrix->update_type = update_type;
-    update_system_matrix->buffer = buffer;
+    queue_item.type = VRMS_QUEUE_UPDATE_SYSTEM_MATRIX;
+    queue_item.item.update_system_matrix.matrix_type = matrix_type;
+    queue_item.item.update_system_matrix.update_type = update_type;
+    queue_item.item.update_system_matrix.buffer = buffer;
 
-    pthread_mutex_lock(&server->inbound_queue_lock);
-    uint32_t idx = server->inbound_queue_index;
-    vrms_queue_item_t* queue_item = &server->inbound_queue[idx];
-    server->inbound_queue_index++;
-    pthread_mutex_unlock(&server->inbound_queue_lock);
+    if (!vrms_ring_push(server->inbound_queue, &queue_item)) {
+        debug_print("vrms_server_queue_update_system_matrix(): inbound queue full\n");
+        return 0;
+    }
 
-    queue_item->type = VRMS_QUEUE_UPDATE_SYSTEM_MATRIX;
-    queue_item->item.update_system_matrix = update_system_matrix;
+    return 1;
 }
 
 void vrms_server_draw_skybox(vrms_server_t* server, float view_matrix[16], float projection_matrix[16]) {
     vrms_gl_render_t render;
     vrms_gl_matrix_t matrix;
 
+    memset(&render, 0, sizeof(vrms_gl_render_t));
     mat4_copy(matrix.mvp, projection_matrix);
     mat4_multiply(matrix.mvp, view_matrix);
 
@@ -140,35 +293,187 @@ void vrms_server_draw_skybox(vrms_server_t* server, float view_matrix[16], float
     vrms_gl_draw_skybox(render, matrix);
 }
 
-void vrms_server_draw_scenes(vrms_server_t* server, float projection_matrix[16], float view_matrix[16], float model_matrix[16], float skybox_projection_matrix[16]) {
-    vrms_scene_t* scene;
+uint32_t vrms_server_usec_since(struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((now.tv_sec - start->tv_sec) * 1000000) + ((now.tv_nsec - start->tv_nsec) / 1000);
+}
 
-    if (server->skybox.texture_gl_id) {
-        vrms_server_draw_skybox(server, view_matrix, skybox_projection_matrix);
+void vrms_server_record_scene(void* data, uint32_t index) {
+    vrms_scene_t** order = (vrms_scene_t**)data;
+    vrms_scene_record(order[index]);
+}
+
+uint32_t vrms_server_record_scenes(vrms_server_t* server) {
+    struct timespec start;
+    uint32_t usec_elapsed;
+    vrms_server_active_t* active;
+    uint32_t nr_scenes;
+    uint32_t nr_order = 0;
+    uint32_t i;
+    vrms_scene_t* scene;
+    uint8_t demoted;
+
+    // Starting a frame drops everything held from the last one. The list
+    // loaded here is then used for recording and for drawing both eyes.
+    __atomic_add_fetch(&server->render_epoch, 1, __ATOMIC_SEQ_CST);
+    active = __atomic_load_n(&server->active, __ATOMIC_SEQ_CST);
+    server->frame_active = active;
+    vrms_gl_begin_frame();
+    if (!pthread_mutex_trylock(&server->registry_lock)) {
+        vrms_server_reclaim(server);
+        pthread_mutex_unlock(&server->registry_lock);
     }
 
-    // TODO: Dont loop through scenes like this, but do round robin on the VM calls
-    // across the scenes, so its not that one scene gets to draw everything, and
-    // other scenes starve. Sounds a bit like a task scheduler.
-    uint32_t si = 0;
-    uint32_t usec_elapsed = 0;
-    for (si = 1; si < server->next_scene_id; si++) {
-        mat4_identity(model_matrix);
-        scene = server->scenes[si];
-        if (NULL != scene) {
-            usec_elapsed += vrms_scene_draw(scene, projection_matrix, view_matrix, model_matrix, skybox_projection_matrix);
+    nr_scenes = active->nr_scenes;
+
+    // Scenes are handed to the workers round robin, starting one further
+    // along each frame so no scene is always first or always last. Scenes
+    // demoted for overrunning their allocation go after everyone else.
+    if (nr_scenes) {
+        server->record_offset = (server->record_offset + 1) % nr_scenes;
+    }
+    for (demoted = 0; demoted < 2; demoted++) {
+        for (i = 0; i < nr_scenes; i++) {
+            scene = active->scenes[(server->record_offset + i) % nr_scenes];
+            if (scene->demoted == demoted) {
+                active->order[nr_order++] = scene;
+            }
         }
-        if (si >= 2000) break;
     }
 
+    // Scenes only record draws, so their programs can all run at once. The
+    // GL calls happen later on this thread in vrms_server_draw_scenes().
+    // What the frame waited for is the wall time of the whole run, not the
+    // scenes' times added up.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    vrms_workers_run(server->workers, nr_order, vrms_server_record_scene, active->order);
+    usec_elapsed = vrms_server_usec_since(&start);
+
     // Maintain a list of NR_RENDER_AVG render times for calculating an average
-    uint8_t i = 0;
-    for (i = NR_RENDER_AVG; i > 0; i--) {
+    for (i = NR_RENDER_AVG - 1; i > 0; i--) {
         server->render_usecs[i] = server->render_usecs[i - 1];
         //fprintf(stderr, "%d ", server->render_usecs[i - 1]);
     }
     //fprintf(stderr, "%d\n", usec_elapsed);
     server->render_usecs[0] = usec_elapsed;
+
+    return usec_elapsed;
+}
+
+// Returns 0 if the arrays could not grow to size draws.
+uint8_t vrms_server_submit_reserve(vrms_server_submit_t* submit, uint32_t size) {
+    vrms_scene_t** scenes;
+    vrms_scene_draw_t** draws;
+    uint64_t* keys;
+    uint32_t* values;
+    uint64_t* tmp_keys;
+    uint32_t* tmp_values;
+
+    if (size <= submit->size) {
+        return 1;
+    }
+    size = (size > (submit->size * 2)) ? size : submit->size * 2;
+
+    scenes = realloc(submit->scenes, size * sizeof(vrms_scene_t*));
+    if (scenes) {
+        submit->scenes = scenes;
+    }
+    draws = realloc(submit->draws, size * sizeof(vrms_scene_draw_t*));
+    if (draws) {
+        submit->draws = draws;
+    }
+    keys = realloc(submit->keys, size * sizeof(uint64_t));
+    if (keys) {
+        submit->keys = keys;
+    }
+    values = realloc(submit->values, size * sizeof(uint32_t));
+    if (values) {
+        submit->values = values;
+    }
+    tmp_keys = realloc(submit->tmp_keys, size * sizeof(uint64_t));
+    if (tmp_keys) {
+        submit->tmp_keys = tmp_keys;
+    }
+    tmp_values = realloc(submit->tmp_values, size * sizeof(uint32_t));
+    if (tmp_values) {
+        submit->tmp_values = tmp_values;
+    }
+    if (!scenes || !draws || !keys || !values || !tmp_keys || !tmp_values) {
+        debug_print("vrms_server_submit_reserve(): unable to grow to %d draws\n", size);
+        return 0;
+    }
+
+    submit->size = size;
+    return 1;
+}
+
+// Draws every scene's recorded draws in one sorted run, so binds are shared
+// across scenes and opaque geometry goes front to back. Scenes stay locked
+// until all of it is submitted.
+void vrms_server_submit_draws(vrms_server_t* server, vrms_server_active_t* active, float view_matrix[16]) {
+    vrms_server_submit_t* submit = &server->submit;
+    vrms_scene_t** locked;
+    vrms_scene_t* scene;
+    uint32_t nr_locked = 0;
+    uint32_t i, j, index;
+
+    if (active->nr_scenes > submit->locked_size) {
+        locked = realloc(submit->locked, active->nr_scenes * sizeof(vrms_scene_t*));
+        if (!locked) {
+            return;
+        }
+        submit->locked = locked;
+        submit->locked_size = active->nr_scenes;
+    }
+
+    submit->nr_draws = 0;
+    for (i = 0; i < active->nr_scenes; i++) {
+        scene = active->scenes[i];
+        if (!vrms_scene_begin_submit(scene)) {
+            continue;
+        }
+        submit->locked[nr_locked++] = scene;
+        if (!vrms_server_submit_reserve(submit, submit->nr_draws + scene->drawing.nr_draws)) {
+            continue;
+        }
+        for (j = 0; j < scene->drawing.nr_draws; j++) {
+            index = submit->nr_draws++;
+            submit->scenes[index] = scene;
+            submit->draws[index] = &scene->drawing.draws[j];
+            submit->keys[index] = vrms_scene_draw_sort_key(submit->draws[index], view_matrix, index);
+            submit->values[index] = index;
+        }
+    }
+
+    vrms_sort_radix64(submit->keys, submit->values, submit->tmp_keys, submit->tmp_values, submit->nr_draws);
+
+    for (i = 0; i < submit->nr_draws; i++) {
+        index = submit->values[i];
+        vrms_scene_submit_draw(submit->scenes[index], submit->draws[index]);
+    }
+
+    for (i = 0; i < nr_locked; i++) {
+        vrms_scene_end_submit(submit->locked[i]);
+    }
+}
+
+void vrms_server_draw_scenes(vrms_server_t* server, float projection_matrix[16], float view_matrix[16], float model_matrix[16], float skybox_projection_matrix[16]) {
+    vrms_server_active_t* active = server->frame_active;
+
+    vrms_gl_reset_state();
+    vrms_gl_set_eye(projection_matrix, view_matrix);
+
+    if (server->skybox.texture_gl_id) {
+        vrms_server_draw_skybox(server, view_matrix, skybox_projection_matrix);
+    }
+
+    if (active) {
+        mat4_identity(model_matrix);
+        vrms_server_submit_draws(server, active, view_matrix);
+    }
+
+    vrms_gl_end_draws();
 }
 
 void vrms_queue_update_system_matrix(vrms_server_t* server, vrms_queue_item_update_system_matrix_t* update_system_matrix) {
@@ -180,61 +485,449 @@ void vrms_queue_update_system_matrix(vrms_server_t* server, vrms_queue_item_upda
     }
 }
 
-void vrms_server_queue_item_process(vrms_server_t* server, vrms_queue_item_t* queue_item) {
-    uint32_t gl_id;
+typedef enum vrms_server_upload_state {
+    VRMS_UPLOAD_WAITING,
+    VRMS_UPLOAD_PARTIAL,
+    VRMS_UPLOAD_DONE
+} vrms_server_upload_state_t;
+
+void vrms_server_upload_charge(uint32_t* budget_bytes, uint32_t bytes) {
+    *budget_bytes = (bytes < *budget_bytes) ? (*budget_bytes - bytes) : 0;
+}
+
+// Loads read client memory found by id with the scene locked, so an object
+// or memory destroyed while its load waits is never read. Such loads are
+// dropped.
+vrms_server_upload_state_t vrms_server_upload_data(vrms_server_t* server, vrms_server_upload_t* upload, uint32_t* budget_bytes) {
+    vrms_queue_item_data_load_t* data_load = &upload->item.item.data_load;
     vrms_scene_t* scene;
-    switch (queue_item->type) {
-        vrms_queue_item_data_load_t* data_load;
-        vrms_queue_item_texture_load_t* texture_load;
-        vrms_queue_item_update_system_matrix_t* update_system_matrix;
-        case VRMS_QUEUE_DATA_LOAD:
-            data_load = queue_item->item.data_load;
-            if (!data_load->buffer) {
+    uint8_t* buffer;
+    uint32_t gl_id = 0;
+
+    scene = vrms_server_get_scene(server, data_load->scene_id);
+    if (!scene) {
+        return VRMS_UPLOAD_DONE;
+    }
+    // This thread is the only producer for the scenes' outbound queues, so
+    // room seen here is still there after the load.
+    if (vrms_ring_full(scene->outbound_queue)) {
+        return VRMS_UPLOAD_WAITING;
+    }
+
+    pthread_mutex_lock(&scene->scene_lock);
+    buffer = vrms_scene_get_object_buffer(scene, data_load->object_id);
+    if (buffer) {
+        vrms_gl_load_buffer(buffer, &gl_id, data_load->size, data_load->type);
+    }
+    pthread_mutex_unlock(&scene->scene_lock);
+    if (!buffer) {
+        return VRMS_UPLOAD_DONE;
+    }
+
+    vrms_scene_queue_add_gl_loaded(scene, VRMS_OBJECT_DATA, data_load->object_id, gl_id, data_load->size, data_load->size);
+    vrms_server_upload_charge(budget_bytes, data_load->size);
+
+    return VRMS_UPLOAD_DONE;
+}
+
+vrms_server_upload_state_t vrms_server_upload_texture(vrms_server_t* server, vrms_server_upload_t* upload, uint32_t* budget_bytes) {
+    vrms_queue_item_texture_load_t* texture_load = &upload->item.item.texture_load;
+    vrms_scene_t* scene;
+    uint8_t* buffer = NULL;
+    uint32_t row_size;
+    uint32_t nr_rows;
+    uint32_t gl_id = 0;
+
+    // A texture part way up is looked up again for every chunk, as the
+    // client may have destroyed it or its memory since the last one.
+    scene = vrms_server_get_scene(server, texture_load->scene_id);
+    if (scene) {
+        if (vrms_ring_full(scene->outbound_queue)) {
+            return VRMS_UPLOAD_WAITING;
+        }
+        pthread_mutex_lock(&scene->scene_lock);
+        buffer = vrms_scene_get_object_buffer(scene, texture_load->object_id);
+    }
+    if (!buffer) {
+        if (scene) {
+            pthread_mutex_unlock(&scene->scene_lock);
+        }
+        if (upload->gl_id) {
+            vrms_gl_delete_texture(&upload->gl_id);
+        }
+        return VRMS_UPLOAD_DONE;
+    }
+
+    // Cube maps are six images in one and go up whole.
+    if (VRMS_TEXTURE_2D != texture_load->type) {
+        vrms_gl_load_texture_buffer(buffer, &gl_id, texture_load->width, texture_load->height, texture_load->format, texture_load->type);
+        pthread_mutex_unlock(&scene->scene_lock);
+        vrms_scene_queue_add_gl_loaded(scene, VRMS_OBJECT_TEXTURE, texture_load->object_id, gl_id, texture_load->size, texture_load->size);
+        vrms_server_upload_charge(budget_bytes, texture_load->size);
+        return VRMS_UPLOAD_DONE;
+    }
+
+    if (!upload->gl_id) {
+        vrms_gl_create_texture(&upload->gl_id, texture_load->width, texture_load->height, texture_load->format);
+        if (!upload->gl_id) {
+            pthread_mutex_unlock(&scene->scene_lock);
+            return VRMS_UPLOAD_DONE;
+        }
+    }
+
+    row_size = vrms_gl_texture_row_size(texture_load->width, texture_load->format);
+    nr_rows = ((*budget_bytes < UPLOAD_CHUNK_BYTES) ? *budget_bytes : UPLOAD_CHUNK_BYTES) / row_size;
+    if (0 == nr_rows) {
+        nr_rows = 1;
+    }
+    if (nr_rows > (texture_load->height - upload->next_row)) {
+        nr_rows = texture_load->height - upload->next_row;
+    }
+
+    vrms_gl_load_texture_rows(upload->gl_id, buffer, texture_load->width, upload->next_row, nr_rows, texture_load->format);
+    pthread_mutex_unlock(&scene->scene_lock);
+    upload->next_row += nr_rows;
+    vrms_server_upload_charge(budget_bytes, nr_rows * row_size);
+
+    vrms_scene_queue_add_gl_loaded(scene, VRMS_OBJECT_TEXTURE, texture_load->object_id, upload->gl_id, upload->next_row * row_size, texture_load->height * row_size);
+
+    return (upload->next_row < texture_load->height) ? VRMS_UPLOAD_PARTIAL : VRMS_UPLOAD_DONE;
+}
+
+// Works through the pending uploads of one type, smallest first, until the
+// frame's budget is spent. An upload is started whenever any
+// budget is left, so one larger than the whole budget still goes through.
+void vrms_server_upload_pass(vrms_server_t* server, vrms_queue_item_type_t type, struct timespec* start, uint32_t* budget_bytes) {
+    vrms_server_upload_state_t state;
+    vrms_server_upload_t* upload;
+    uint32_t i;
+
+    for (i = 0; i < server->nr_uploads; i++) {
+        upload = &server->uploads[i];
+        if (upload->done || (upload->item.type != type)) {
+            continue;
+        }
+        state = VRMS_UPLOAD_PARTIAL;
+        while (VRMS_UPLOAD_PARTIAL == state) {
+            if ((0 == *budget_bytes) || (vrms_server_usec_since(start) >= server->upload_budget_usec)) {
                 return;
             }
-            vrms_gl_load_buffer(data_load->buffer, &gl_id, data_load->size, data_load->type);
+            if (VRMS_QUEUE_DATA_LOAD == type) {
+                state = vrms_server_upload_data(server, upload, budget_bytes);
+            }
+            else {
+                state = vrms_server_upload_texture(server, upload, budget_bytes);
+            }
+        }
+        upload->done = (VRMS_UPLOAD_DONE == state);
+    }
+}
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+// Folds an update into a pending one for the same object where the two
+// overlap or touch, so each frame uploads every dirty byte once.
+uint8_t vrms_server_update_merge(vrms_queue_item_t* pending, vrms_queue_item_t* queue_item) {
+    vrms_queue_item_data_update_t* a;
+    vrms_queue_item_data_update_t* b;
+    vrms_queue_item_texture_update_t* r;
+    vrms_queue_item_texture_update_t* t;
+    uint32_t end;
+
+    if (pending->type != queue_item->type) {
+        return 0;
+    }
+    if (VRMS_QUEUE_DATA_UPDATE == queue_item->type) {
+        a = &pending->item.data_update;
+        b = &queue_item->item.data_update;
+        if ((a->scene_id != b->scene_id) || (a->object_id != b->object_id)) {
+            return 0;
+        }
+        if ((b->offset > (a->offset + a->size)) || (a->offset > (b->offset + b->size))) {
+            return 0;
+        }
+        end = MAX(a->offset + a->size, b->offset + b->size);
+        a->offset = MIN(a->offset, b->offset);
+        a->size = end - a->offset;
+        return 1;
+    }
+
+    r = &pending->item.texture_update;
+    t = &queue_item->item.texture_update;
+    if ((r->scene_id != t->scene_id) || (r->object_id != t->object_id)) {
+        return 0;
+    }
+    if ((t->x > (r->x + r->width)) || (r->x > (t->x + t->width)) || (t->y > (r->y + r->height)) || (r->y > (t->y + t->height))) {
+        return 0;
+    }
+    end = MAX(r->x + r->width, t->x + t->width);
+    r->x = MIN(r->x, t->x);
+    r->width = end - r->x;
+    end = MAX(r->y + r->height, t->y + t->height);
+    r->y = MIN(r->y, t->y);
+    r->height = end - r->y;
+    return 1;
+}
+
+// A merged update may now reach others pending for the same object, so
+// fold those into it too until none are left to merge.
+void vrms_server_update_coalesce(vrms_server_t* server, uint32_t index) {
+    uint32_t i = 0;
+
+    while (i < server->nr_updates) {
+        if ((i != index) && vrms_server_update_merge(&server->updates[index], &server->updates[i])) {
+            server->updates[i] = server->updates[--server->nr_updates];
+            if (index == server->nr_updates) {
+                index = i;
+            }
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+}
+
+// Returns 0 if the update list is full.
+uint8_t vrms_server_update_add(vrms_server_t* server, vrms_queue_item_t* queue_item) {
+    uint32_t i;
+
+    for (i = 0; i < server->nr_updates; i++) {
+        if (vrms_server_update_merge(&server->updates[i], queue_item)) {
+            vrms_server_update_coalesce(server, i);
+            return 1;
+        }
+    }
+    if (server->nr_updates >= VRMS_SERVER_INBOUND_QUEUE_SIZE) {
+        return 0;
+    }
+    server->updates[server->nr_updates++] = *queue_item;
+    return 1;
+}
+
+// Uploads the dirty ranges of objects that are on the GPU. Updates to
+// objects still loading wait for the load to finish, and updates to objects
+// or memory destroyed since are dropped. The scene stays locked while its
+// client memory is read, so neither can go away mid upload.
+void vrms_server_update_apply(vrms_server_t* server) {
+    vrms_queue_item_data_update_t* data_update;
+    vrms_queue_item_texture_update_t* texture_update;
+    vrms_queue_item_t* queue_item;
+    vrms_object_t* object;
+    vrms_scene_t* scene;
+    uint8_t* buffer;
+    uint32_t scene_id, object_id;
+    uint32_t i, nr_updates;
+
+    nr_updates = 0;
+    for (i = 0; i < server->nr_updates; i++) {
+        queue_item = &server->updates[i];
+        if (VRMS_QUEUE_DATA_UPDATE == queue_item->type) {
+            scene_id = queue_item->item.data_update.scene_id;
+            object_id = queue_item->item.data_update.object_id;
+        }
+        else {
+            scene_id = queue_item->item.texture_update.scene_id;
+            object_id = queue_item->item.texture_update.object_id;
+        }
+
+        scene = vrms_server_get_scene(server, scene_id);
+        if (!scene) {
+            continue;
+        }
+
+        pthread_mutex_lock(&scene->scene_lock);
+        object = vrms_object_table_get(scene->objects, object_id);
+        buffer = object ? vrms_scene_get_object_buffer(scene, object_id) : NULL;
+        if (!buffer) {
+            pthread_mutex_unlock(&scene->scene_lock);
+            continue;
+        }
+        if (!object->gl_id) {
+            pthread_mutex_unlock(&scene->scene_lock);
+            server->updates[nr_updates++] = *queue_item;
+            continue;
+        }
+
+        if (VRMS_QUEUE_DATA_UPDATE == queue_item->type) {
+            data_update = &queue_item->item.data_update;
+            vrms_gl_update_buffer(buffer, object->gl_id, data_update->offset, data_update->size, data_update->type);
+        }
+        else {
+            texture_update = &queue_item->item.texture_update;
+            vrms_gl_update_texture(buffer, object->gl_id, texture_update->image_width, texture_update->x, texture_update->y, texture_update->width, texture_update->height, texture_update->format);
+        }
+        pthread_mutex_unlock(&scene->scene_lock);
+    }
+    server->nr_updates = nr_updates;
+}
+
+// Hands pending uploads to the upload thread in order, as far as it has
+// room. The upload thread reads client memory without the scene lock, so
+// each load's memory is looked up now and pinned until it is uploaded.
+// Loads whose object or memory is already gone are dropped.
+void vrms_server_upload_forward(vrms_server_t* server) {
+    vrms_queue_item_t item;
+    vrms_queue_item_data_load_t* data_load;
+    vrms_queue_item_texture_load_t* texture_load;
+    vrms_object_memory_t* memory = NULL;
+    vrms_scene_t* scene;
+    uint8_t* buffer = NULL;
+    uint32_t i;
+
+    for (i = 0; i < server->nr_uploads; i++) {
+        item = server->uploads[i].item;
+        data_load = &item.item.data_load;
+        texture_load = &item.item.texture_load;
+
+        if (VRMS_QUEUE_DATA_LOAD == item.type) {
             scene = vrms_server_get_scene(server, data_load->scene_id);
-            if (scene) {
-                vrms_scene_queue_add_gl_loaded(scene, VRMS_OBJECT_DATA, data_load->object_id, gl_id);
+            buffer = scene ? vrms_scene_pin_object_buffer(scene, data_load->object_id, &memory) : NULL;
+            data_load->buffer = buffer;
+            data_load->memory = memory;
+        }
+        else {
+            scene = vrms_server_get_scene(server, texture_load->scene_id);
+            buffer = scene ? vrms_scene_pin_object_buffer(scene, texture_load->object_id, &memory) : NULL;
+            texture_load->buffer = buffer;
+            texture_load->memory = memory;
+        }
+        if (!buffer) {
+            server->uploads[i].done = 1;
+            continue;
+        }
+
+        if (!vrms_upload_push(server->upload, &item)) {
+            vrms_scene_unpin_memory(memory);
+            break;
+        }
+        server->uploads[i].done = 1;
+    }
+}
+
+// Gives scenes the uploads the upload thread has finished.
+void vrms_server_upload_collect(vrms_server_t* server) {
+    vrms_upload_result_t* result;
+    vrms_scene_t* scene;
+
+    while (NULL != (result = vrms_upload_peek_result(server->upload))) {
+        scene = vrms_server_get_scene(server, result->scene_id);
+        if (!scene) {
+            if (VRMS_OBJECT_TEXTURE == result->type) {
+                vrms_gl_delete_texture(&result->gl_id);
             }
-            free(data_load);
+            else {
+                vrms_gl_delete_buffer(&result->gl_id);
+            }
+        }
+        else if (vrms_ring_full(scene->outbound_queue)) {
             break;
+        }
+        else {
+            vrms_scene_queue_add_gl_loaded(scene, result->type, result->object_id, result->gl_id, result->size, result->size);
+        }
+        vrms_upload_pop_result(server->upload);
+    }
+}
+
+uint32_t vrms_server_upload_size(vrms_server_upload_t* upload) {
+    if (VRMS_QUEUE_DATA_LOAD == upload->item.type) {
+        return upload->item.item.data_load.size;
+    }
+    return upload->item.item.texture_load.size;
+}
+
+// Keeps the upload list in size order so small loads are not stuck behind
+// large textures. Loads already part way up keep their place ahead of it.
+void vrms_server_upload_insert(vrms_server_t* server, vrms_queue_item_t* queue_item) {
+    vrms_server_upload_t* upload;
+    uint32_t i = server->nr_uploads;
+
+    upload = &server->uploads[i];
+    memset(upload, 0, sizeof(vrms_server_upload_t));
+    upload->item = *queue_item;
+
+    while ((i > 0) && !server->uploads[i - 1].gl_id && (vrms_server_upload_size(&server->uploads[i - 1]) > vrms_server_upload_size(upload))) {
+        i--;
+    }
+    if (i < server->nr_uploads) {
+        memmove(&server->uploads[i + 1], &server->uploads[i], sizeof(vrms_server_upload_t) * (server->nr_uploads - i));
+        memset(&server->uploads[i], 0, sizeof(vrms_server_upload_t));
+        server->uploads[i].item = *queue_item;
+    }
+    server->nr_uploads++;
+}
+
+// System matrix updates are cheap and applied as they come off the queue.
+// Loads join the upload list and partial updates the update list. Returns
+// 0 if the item has to stay on the queue because its list is full.
+uint8_t vrms_server_queue_take(vrms_server_t* server, vrms_queue_item_t* queue_item) {
+    switch (queue_item->type) {
+        case VRMS_QUEUE_DATA_LOAD:
         case VRMS_QUEUE_TEXTURE_LOAD:
-            texture_load = queue_item->item.texture_load;
-            if (!texture_load->buffer) {
-                return;
+            if (server->nr_uploads >= VRMS_SERVER_INBOUND_QUEUE_SIZE) {
+                return 0;
             }
-            vrms_gl_load_texture_buffer(texture_load->buffer, &gl_id, texture_load->width, texture_load->height, texture_load->format, texture_load->type);
-            scene = vrms_server_get_scene(server, texture_load->scene_id);
-            if (scene) {
-                vrms_scene_queue_add_gl_loaded(scene, VRMS_OBJECT_TEXTURE, texture_load->object_id, gl_id);
-            }
-            free(texture_load);
+            vrms_server_upload_insert(server, queue_item);
             break;
+        case VRMS_QUEUE_DATA_UPDATE:
+        case VRMS_QUEUE_TEXTURE_UPDATE:
+            return vrms_server_update_add(server, queue_item);
         case VRMS_QUEUE_UPDATE_SYSTEM_MATRIX:
-            update_system_matrix = queue_item->item.update_system_matrix;
-            vrms_queue_update_system_matrix(server, update_system_matrix);
-            free(update_system_matrix);
+            vrms_queue_update_system_matrix(server, &queue_item->item.update_system_matrix);
             break;
         case VRMS_QUEUE_EVENT:
             debug_print("not supposed to get a VRMS_QUEUE_EVENT from a client\n");
             break;
         default:
-            debug_print("vrms_server_queue_item_process(): unknown type!!\n");
+            debug_print("vrms_server_queue_take(): unknown type!!\n");
     }
+    return 1;
 }
 
 void vrms_server_process_queue(vrms_server_t* server) {
-    if (!pthread_mutex_trylock(&server->inbound_queue_lock)) {
-        uint8_t idx;
-        for (idx = 0; idx < server->inbound_queue_index; idx++) {
-            vrms_server_queue_item_process(server, &server->inbound_queue[idx]);
+    vrms_queue_item_t* queue_item;
+    struct timespec start;
+    uint32_t budget_bytes;
+    uint32_t i, nr_uploads;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (NULL != (queue_item = vrms_ring_peek(server->inbound_queue))) {
+        if (!vrms_server_queue_take(server, queue_item)) {
+            break;
         }
-        server->inbound_queue_index = 0;
-        pthread_mutex_unlock(&server->inbound_queue_lock);
+        vrms_ring_pop(server->inbound_queue);
+    }
+
+    // Buffers are small next to textures and a mesh is no use without
+    // them, so they go first. Textures are spread over as many frames as
+    // the budget needs.
+    if (server->upload) {
+        vrms_server_upload_collect(server);
+        vrms_server_upload_forward(server);
     }
     else {
-        debug_print("vrms_server_process_queue(): lock on queue\n");
+        budget_bytes = server->upload_budget_bytes;
+        vrms_server_upload_pass(server, VRMS_QUEUE_DATA_LOAD, &start, &budget_bytes);
+        vrms_server_upload_pass(server, VRMS_QUEUE_TEXTURE_LOAD, &start, &budget_bytes);
+    }
+
+    nr_uploads = 0;
+    for (i = 0; i < server->nr_uploads; i++) {
+        if (!server->uploads[i].done) {
+            server->uploads[nr_uploads++] = server->uploads[i];
+        }
+    }
+    server->nr_uploads = nr_uploads;
+
+    vrms_server_update_apply(server);
+}
+
+void vrms_server_start_upload_thread(vrms_server_t* server, vrms_upload_context_t make_current, void* data) {
+    server->upload = vrms_upload_create(make_current, data);
+    if (!server->upload) {
+        debug_print("vrms_server_start_upload_thread(): no shared context, uploading on the render thread\n");
     }
 }
 
@@ -268,11 +961,24 @@ vrms_server_t* vrms_server_create() {
     //vrms_server_t* server = SAFEMALLOC(-1UL);
     memset(server, 0, sizeof(vrms_server_t));
 
-    server->scenes = SAFEMALLOC(sizeof(vrms_scene_t) * 10);
-    memset(server->scenes, 0, sizeof(vrms_scene_t) * 10);
-    server->next_scene_id = 1;
+    server->scenes = vrms_object_table_create();
+    server->active = vrms_server_active_create(0);
+    pthread_mutex_init(&server->registry_lock, NULL);
+
+    server->inbound_queue = vrms_ring_create(VRMS_SERVER_INBOUND_QUEUE_SIZE, sizeof(vrms_queue_item_t));
+    server->uploads = SAFEMALLOC(sizeof(vrms_server_upload_t) * VRMS_SERVER_INBOUND_QUEUE_SIZE);
+    server->updates = SAFEMALLOC(sizeof(vrms_queue_item_t) * VRMS_SERVER_INBOUND_QUEUE_SIZE);
+    server->upload_budget_bytes = UPLOAD_BYTES_DEFAULT;
+    server->upload_budget_usec = UPLOAD_USEC_DEFAULT;
+
+    // Compile verified scene programs where the host supports it.
+    server->scene_jit = 1;
+
+    server->workers = vrms_workers_create(0);
 
-    server->inbound_queue_index = 0;
+    // Render programs are profiled when VRMS_PROFILE names a directory for
+    // the profiles, one per scene written as the scene goes away.
+    server->profile_dir = getenv("VRMS_PROFILE");
 
     mat4_identity(server->head_matrix);
     mat4_identity(server->body_matrix);
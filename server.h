@@ -2,22 +2,35 @@
 #define VRMS_SERVER_H
 
 #include "vroom.h"
+#include "upload.h"
 
 #define NR_RENDER_AVG 10
+#define VRMS_SERVER_INBOUND_QUEUE_SIZE 1024
 
 typedef struct vrms_scene vrms_scene_t;
+typedef struct vrms_scene_draw vrms_scene_draw_t;
+typedef struct vrms_workers vrms_workers_t;
+typedef struct vrms_object vrms_object_t;
+typedef struct vrms_object_table vrms_object_table_t;
+typedef struct vrms_object_memory vrms_object_memory_t;
+typedef struct vrms_ring vrms_ring_t;
 
 typedef enum vrms_queue_item_type {
     VRMS_QUEUE_DATA_LOAD,
     VRMS_QUEUE_TEXTURE_LOAD,
     VRMS_QUEUE_UPDATE_SYSTEM_MATRIX,
-    VRMS_QUEUE_EVENT
+    VRMS_QUEUE_EVENT,
+    VRMS_QUEUE_DATA_UPDATE,
+    VRMS_QUEUE_TEXTURE_UPDATE
 } vrms_queue_item_type_t;
 
+// Loads handed to the upload thread carry the memory holding buffer, pinned
+// until the upload is done with it.
 typedef struct vrms_queue_item_data_load {
     uint32_t scene_id;
     uint32_t object_id;
     uint8_t* buffer;
+    vrms_object_memory_t* memory;
     uint32_t size;
     vrms_data_type_t type;
 } vrms_queue_item_data_load_t;
@@ -26,6 +39,7 @@ typedef struct vrms_queue_item_texture_load {
     uint32_t scene_id;
     uint32_t object_id;
     uint8_t* buffer;
+    vrms_object_memory_t* memory;
     uint32_t size;
     uint32_t width;
     uint32_t height;
@@ -33,6 +47,29 @@ typedef struct vrms_queue_item_texture_load {
     vrms_texture_type_t type;
 } vrms_queue_item_texture_load_t;
 
+// A dirty byte range of a data object already on the GPU. The bytes are
+// read from client memory when the update is applied.
+typedef struct vrms_queue_item_data_update {
+    uint32_t scene_id;
+    uint32_t object_id;
+    uint32_t offset;
+    uint32_t size;
+    vrms_data_type_t type;
+} vrms_queue_item_data_update_t;
+
+// A dirty rectangle of a 2D texture already on the GPU, whose image is
+// image_width pixels wide.
+typedef struct vrms_queue_item_texture_update {
+    uint32_t scene_id;
+    uint32_t object_id;
+    uint32_t image_width;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    vrms_texture_format_t format;
+} vrms_queue_item_texture_update_t;
+
 typedef struct vrms_queue_item_update_system_matrix {
     vrms_matrix_type_t matrix_type;
     vrms_update_type_t update_type;
@@ -46,13 +83,25 @@ typedef struct vrms_queue_item_event {
 typedef struct vrms_queue_item {
     vrms_queue_item_type_t type;
     union {
-        vrms_queue_item_data_load_t* data_load;
-        vrms_queue_item_texture_load_t* texture_load;
-        vrms_queue_item_update_system_matrix_t* update_system_matrix;
-        vrms_queue_item_event_t* event;
+        vrms_queue_item_data_load_t data_load;
+        vrms_queue_item_texture_load_t texture_load;
+        vrms_queue_item_update_system_matrix_t update_system_matrix;
+        vrms_queue_item_event_t event;
+        vrms_queue_item_data_update_t data_update;
+        vrms_queue_item_texture_update_t texture_update;
     } item;
 } vrms_queue_item_t;
 
+// A buffer or texture load taken off the inbound queue, waiting for its
+// turn or part way through. Textures go up next_row onwards, a few rows a
+// frame.
+typedef struct vrms_server_upload {
+    vrms_queue_item_t item;
+    uint32_t gl_id;
+    uint32_t next_row;
+    uint8_t done;
+} vrms_server_upload_t;
+
 typedef void (*system_matrix_callback_t)(vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, float* matrix);
 
 typedef struct vrms_skybox {
@@ -65,20 +114,70 @@ typedef struct vrms_skybox {
     uint8_t realized;
 } vrms_skybox_t;
 
-typedef struct vrms_server {
-    uint32_t next_scene_id;
+// The live scenes in one flat array. The render thread walks whichever list
+// is current without a lock; creating or destroying a scene publishes a new
+// list instead of changing the old one. order is scratch space for the
+// render thread.
+typedef struct vrms_server_active {
+    uint32_t nr_scenes;
+    vrms_scene_t** scenes;
+    vrms_scene_t** order;
+} vrms_server_active_t;
+
+// A list or scene taken out of use while the render thread may still hold
+// it. It is freed once the render thread has started a frame after epoch.
+typedef struct vrms_server_retired {
+    vrms_server_active_t* active;
+    vrms_object_t* scene;
+    uint64_t epoch;
+    struct vrms_server_retired* next;
+} vrms_server_retired_t;
+
+// Draws of every scene gathered for one eye, with their sort keys. values
+// index scenes and draws. Grown as needed and kept between frames.
+typedef struct vrms_server_submit {
+    uint32_t size;
+    uint32_t nr_draws;
     vrms_scene_t** scenes;
-    vrms_queue_item_t inbound_queue[256];
-    uint8_t inbound_queue_index;
-    pthread_mutex_t inbound_queue_lock;
+    vrms_scene_draw_t** draws;
+    uint64_t* keys;
+    uint32_t* values;
+    uint64_t* tmp_keys;
+    uint32_t* tmp_values;
+    vrms_scene_t** locked;
+    uint32_t locked_size;
+} vrms_server_submit_t;
+
+typedef struct vrms_server {
+    vrms_object_table_t* scenes;
+    vrms_server_active_t* active;
+    vrms_server_active_t* frame_active;
+    uint64_t render_epoch;
+    vrms_server_retired_t* retired;
+    pthread_mutex_t registry_lock;
+    vrms_ring_t* inbound_queue;
+    vrms_server_upload_t* uploads;
+    uint32_t nr_uploads;
+    vrms_queue_item_t* updates;
+    uint32_t nr_updates;
+    uint32_t upload_budget_bytes;
+    uint32_t upload_budget_usec;
+    vrms_upload_t* upload;
     uint32_t color_shader_id;
     uint32_t texture_shader_id;
     uint32_t cubemap_shader_id;
+    uint32_t color_instanced_shader_id;
+    uint32_t texture_instanced_shader_id;
     float head_matrix[16];
     float body_matrix[16];
     system_matrix_callback_t system_matrix_update;
     uint32_t render_usecs[NR_RENDER_AVG];
     vrms_skybox_t skybox;
+    uint8_t scene_jit;
+    vrms_workers_t* workers;
+    uint32_t record_offset;
+    char* profile_dir;
+    vrms_server_submit_t submit;
 } vrms_server_t;
 
 vrms_server_t* vrms_server_create();
@@ -89,16 +188,31 @@ uint32_t vrms_server_create_scene(vrms_server_t* vrms_server, char* name);
 
 uint32_t vrms_server_destroy_scene(vrms_server_t* server, uint32_t scene_id);
 
+// Runs every scene's render program once for the frame. The recorded draws
+// are then drawn by vrms_server_draw_scenes() for each eye.
+// Returns how long recording took in usec of wall time.
+uint32_t vrms_server_record_scenes(vrms_server_t* vrms_server);
 void vrms_server_draw_scenes(vrms_server_t* vrms_server, float projection_matrix[16], float view_matrix[16], float model_matrix[16], float skybox_projection_matrix[16]);
 
 void vrms_queue_item_process(vrms_queue_item_t* queue_item);
 
 void vrms_server_process_queue(vrms_server_t* server);
 
+// Moves buffer and texture uploads off the render thread onto a thread with
+// its own shared GL context. Without one, uploads stay on the render thread
+// under the upload budget.
+void vrms_server_start_upload_thread(vrms_server_t* server, vrms_upload_context_t make_current, void* data);
+
+// The queue functions return 0 when the inbound queue is full and the item
+// was not added, so the caller can report it back to the client.
 uint32_t vrms_server_queue_add_data_load(vrms_server_t* server, uint32_t size, uint32_t scene_id, uint32_t object_id, vrms_data_type_t type, uint8_t* buffer);
 
 uint32_t vrms_server_queue_add_texture_load(vrms_server_t* server, uint32_t size, uint32_t scene_id, uint32_t object_id, uint32_t width, uint32_t height, vrms_texture_format_t format, vrms_texture_type_t type, uint8_t* buffer);
 
-void vrms_server_queue_update_system_matrix(vrms_server_t* server, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, uint8_t* buffer);
+uint32_t vrms_server_queue_add_data_update(vrms_server_t* server, uint32_t scene_id, uint32_t object_id, uint32_t offset, uint32_t size, vrms_data_type_t type);
+
+uint32_t vrms_server_queue_add_texture_update(vrms_server_t* server, uint32_t scene_id, uint32_t object_id, uint32_t image_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vrms_texture_format_t format);
+
+uint32_t vrms_server_queue_update_system_matrix(vrms_server_t* server, vrms_matrix_type_t matrix_type, vrms_update_type_t update_type, uint8_t* buffer);
 
 #endif
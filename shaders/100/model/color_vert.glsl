@@ -7,15 +7,18 @@ attribute vec3 b_vertex;
 attribute vec3 b_normal;
 attribute vec4 b_color;
 
-uniform mat4 m_mvp;
+uniform mat4 m_p;
+uniform mat4 m_v;
+uniform mat4 m_m;
 
 varying vec3 v_vertex;
 varying vec3 v_normal;
 varying vec4 v_color;
 
 void main(void) {
+    vec4 vert_ms = m_v * (m_m * vec4(b_vertex, 1.0));
     v_color = b_color;
-    v_normal = b_normal;
-    v_vertex = b_vertex;
-    gl_Position = m_mvp * vec4(b_vertex, 1.0);
+    v_normal = vec3(m_v * (m_m * vec4(b_normal, 0.0)));
+    v_vertex = vec3(vert_ms);
+    gl_Position = m_p * vert_ms;
 }
@@ -7,15 +7,18 @@ attribute vec3 b_vertex;
 attribute vec3 b_normal;
 attribute vec2 b_uv;
 
-uniform mat4 m_mvp;
+uniform mat4 m_p;
+uniform mat4 m_v;
+uniform mat4 m_m;
 
 varying vec3 v_vertex;
 varying vec3 v_normal;
 varying vec2 v_uv;
 
 void main(void) {
-    v_vertex = b_vertex;
-    v_normal = b_normal;
+    vec4 vert_ms = m_v * (m_m * vec4(b_vertex, 1.0));
+    v_vertex = vec3(vert_ms);
+    v_normal = vec3(m_v * (m_m * vec4(b_normal, 0.0)));
     v_uv = b_uv;
-    gl_Position = m_mvp * vec4(b_vertex, 1.0);
+    gl_Position = m_p * vert_ms;
 }
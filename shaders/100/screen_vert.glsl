@@ -3,14 +3,25 @@
 precision mediump int;
 precision mediump float;
 
-attribute vec3 b_vertex;
-attribute vec2 b_text;
+attribute vec2 b_vertex;
+attribute vec2 b_text_r;
+attribute vec2 b_text_g;
+attribute vec2 b_text_b;
+attribute float b_fade;
 
 uniform mat4 m_projection;
+// Part of the render texture the eyes were drawn to.
+uniform vec2 uv_scale;
 
-varying vec2 v_texcoord;
+varying vec2 v_text_r;
+varying vec2 v_text_g;
+varying vec2 v_text_b;
+varying float v_fade;
 
 void main() {
-    v_texcoord = b_text;
-    gl_Position = m_projection * vec4(b_vertex, 1);
+    v_text_r = b_text_r * uv_scale;
+    v_text_g = b_text_g * uv_scale;
+    v_text_b = b_text_b * uv_scale;
+    v_fade = b_fade;
+    gl_Position = m_projection * vec4(b_vertex, 0.0, 1.0);
 }
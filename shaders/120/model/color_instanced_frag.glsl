@@ -0,0 +1,17 @@
+#version 120
+
+varying vec4 v_color;
+varying vec3 v_normal;
+varying vec3 v_vertex;
+
+void main(void) {
+    vec3 normal_ms = normalize(v_normal);
+    vec3 light_ms = vec3(0.0, 0.0, 0.0);
+    vec3 stl = light_ms - v_vertex;
+
+    float brightness = dot(normal_ms, stl) / (length(stl) * length(normal_ms));
+    brightness = clamp(brightness, 0.0, 1.0);
+
+    vec3 d_color = vec3(v_color) * brightness;
+    gl_FragColor = vec4(d_color, 1.0);
+}
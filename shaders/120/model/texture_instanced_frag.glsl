@@ -0,0 +1,18 @@
+#version 120
+
+varying vec3 v_vertex;
+varying vec3 v_normal;
+
+uniform sampler2D s_tex;
+varying vec2 v_uv;
+
+void main(void) {
+    vec3 normal_ms = normalize(v_normal);
+    vec3 light_ms = vec3(0.0, 0.0, 0.0);
+    vec3 stl = light_ms - v_vertex;
+
+    float brightness = dot(normal_ms, stl) / (length(stl) * length(normal_ms));
+    brightness = clamp(brightness, 0.0, 1.0);
+
+    gl_FragColor = texture2D(s_tex, v_uv) * brightness;
+}
@@ -0,0 +1,21 @@
+#version 120
+
+attribute vec3 b_vertex;
+attribute vec3 b_normal;
+attribute vec2 b_uv;
+attribute mat4 b_model;
+
+uniform mat4 m_p;
+uniform mat4 m_v;
+
+varying vec3 v_vertex;
+varying vec3 v_normal;
+varying vec2 v_uv;
+
+void main(void) {
+    vec4 vert_ms = m_v * (b_model * vec4(b_vertex, 1.0));
+    v_vertex = vec3(vert_ms);
+    v_normal = vec3(m_v * (b_model * vec4(b_normal, 0.0)));
+    v_uv = b_uv;
+    gl_Position = m_p * vert_ms;
+}
@@ -1,31 +1,18 @@
 #version 120
 
-const float PI = 3.1415926535;
-uniform float barrel_power;
-
+// The lens distortion is baked into the screen mesh, with one set of
+// texture coordinates per color channel.
 uniform sampler2D tex0;
-varying vec2 v_texcoord;
-
-vec2 Distort(vec2 p) {
-    float theta = atan(p.y, p.x);
-    float radius = length(p);
-    radius = pow(radius, barrel_power);
-    p.x = radius * cos(theta);
-    p.y = radius * sin(theta);
-    return 0.5 * (p + 1.0);
-}
+varying vec2 v_text_r;
+varying vec2 v_text_g;
+varying vec2 v_text_b;
+varying float v_fade;
 
 void main() {
-    vec2 xy = 2.0 * v_texcoord - 1.0;
-    vec2 uv;
-    vec4 color;
-    float d = length(xy);
-    if (d < 1.15) {
-        uv = Distort(xy);
-        color = texture2D(tex0, uv);
-    }
-    else {
-        color = vec4(0.0, 0.0, 0.0, 1.0);
-    }
-    gl_FragColor = color;
+    vec3 color = vec3(
+        texture2D(tex0, v_text_r).r,
+        texture2D(tex0, v_text_g).g,
+        texture2D(tex0, v_text_b).b
+    );
+    gl_FragColor = vec4(color * v_fade, 1.0);
 }
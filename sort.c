@@ -0,0 +1,60 @@
+#include <string.h>
+#include "sort.h"
+
+void vrms_sort_radix64(uint64_t* keys, uint32_t* values, uint64_t* tmp_keys, uint32_t* tmp_values, uint32_t nr) {
+    uint32_t counts[8][256];
+    uint64_t* src_keys = keys;
+    uint32_t* src_values = values;
+    uint64_t* dst_keys = tmp_keys;
+    uint32_t* dst_values = tmp_values;
+    uint64_t* swap_keys;
+    uint32_t* swap_values;
+    uint32_t offset, count;
+    uint32_t i, pass;
+    uint8_t byte;
+
+    if (nr < 2) {
+        return;
+    }
+
+    // One read of the keys counts all eight bytes.
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < nr; i++) {
+        for (pass = 0; pass < 8; pass++) {
+            counts[pass][(keys[i] >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    for (pass = 0; pass < 8; pass++) {
+        byte = (keys[0] >> (pass * 8)) & 0xff;
+        if (counts[pass][byte] == nr) {
+            continue;
+        }
+
+        offset = 0;
+        for (i = 0; i < 256; i++) {
+            count = counts[pass][i];
+            counts[pass][i] = offset;
+            offset += count;
+        }
+
+        for (i = 0; i < nr; i++) {
+            byte = (src_keys[i] >> (pass * 8)) & 0xff;
+            offset = counts[pass][byte]++;
+            dst_keys[offset] = src_keys[i];
+            dst_values[offset] = src_values[i];
+        }
+
+        swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+        swap_values = src_values;
+        src_values = dst_values;
+        dst_values = swap_values;
+    }
+
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, nr * sizeof(uint64_t));
+        memcpy(values, src_values, nr * sizeof(uint32_t));
+    }
+}
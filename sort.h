@@ -0,0 +1,12 @@
+#ifndef VRMS_SORT_H
+#define VRMS_SORT_H
+
+#include <stdint.h>
+
+// Sorts nr 64 bit keys into ascending order, carrying a 32 bit value along
+// with each. The sort is stable, so equal keys keep their order. tmp_keys
+// and tmp_values must hold nr items too. Passes over bytes every key has in
+// common are skipped, so keys that only use their low bits sort quickly.
+void vrms_sort_radix64(uint64_t* keys, uint32_t* values, uint64_t* tmp_keys, uint32_t* tmp_values, uint32_t nr);
+
+#endif
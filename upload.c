@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "safemalloc.h"
+#include "gl.h"
+#include "object.h"
+#include "scene.h"
+#include "server.h"
+#include "ring.h"
+#include "upload.h"
+
+#define DEBUG 0
+#define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+
+#define VRMS_UPLOAD_QUEUE_SIZE 256
+#define VRMS_UPLOAD_MAX_FLIGHTS 64
+#define VRMS_UPLOAD_POLL_USEC 500
+
+static void vrms_upload_item(vrms_upload_t* upload, vrms_queue_item_t* queue_item) {
+    vrms_upload_flight_t* flight = &upload->flights[upload->nr_flights];
+    vrms_queue_item_data_load_t* data_load;
+    vrms_queue_item_texture_load_t* texture_load;
+
+    memset(flight, 0, sizeof(vrms_upload_flight_t));
+    switch (queue_item->type) {
+        case VRMS_QUEUE_DATA_LOAD:
+            data_load = &queue_item->item.data_load;
+            vrms_gl_load_buffer(data_load->buffer, &flight->result.gl_id, data_load->size, data_load->type);
+            flight->result.scene_id = data_load->scene_id;
+            flight->result.object_id = data_load->object_id;
+            flight->result.type = VRMS_OBJECT_DATA;
+            flight->result.size = data_load->size;
+            flight->memory = data_load->memory;
+            break;
+        case VRMS_QUEUE_TEXTURE_LOAD:
+            texture_load = &queue_item->item.texture_load;
+            vrms_gl_load_texture_buffer(texture_load->buffer, &flight->result.gl_id, texture_load->width, texture_load->height, texture_load->format, texture_load->type);
+            flight->result.scene_id = texture_load->scene_id;
+            flight->result.object_id = texture_load->object_id;
+            flight->result.type = VRMS_OBJECT_TEXTURE;
+            flight->result.size = texture_load->size;
+            flight->memory = texture_load->memory;
+            break;
+        default:
+            debug_print("C|DEBUG|upload.c|vrms_upload_item(): not a load\n");
+            return;
+    }
+
+    // The render thread may only use the object once the copy has landed,
+    // and the client memory stays pinned until then too.
+    flight->fence = vrms_gl_fence();
+    upload->nr_flights++;
+}
+
+// Passes on uploads whose fences have signalled, oldest first. Returns the
+// number passed on.
+static uint32_t vrms_upload_land(vrms_upload_t* upload) {
+    vrms_upload_flight_t* flight;
+    uint32_t nr_landed = 0;
+
+    while (nr_landed < upload->nr_flights) {
+        flight = &upload->flights[nr_landed];
+        if (!vrms_gl_fence_done(flight->fence)) {
+            break;
+        }
+        if (!vrms_ring_push(upload->results, &flight->result)) {
+            break;
+        }
+        vrms_gl_fence_destroy(flight->fence);
+        if (flight->memory) {
+            vrms_scene_unpin_memory(flight->memory);
+        }
+        nr_landed++;
+    }
+
+    if (nr_landed) {
+        upload->nr_flights -= nr_landed;
+        memmove(upload->flights, &upload->flights[nr_landed], sizeof(vrms_upload_flight_t) * upload->nr_flights);
+    }
+
+    return nr_landed;
+}
+
+static void* vrms_upload_thread(void* data) {
+    vrms_upload_t* upload = (vrms_upload_t*)data;
+    vrms_queue_item_t* queue_item;
+    uint32_t nr_taken;
+
+    pthread_mutex_lock(&upload->lock);
+    upload->running = upload->make_current(upload->context_data);
+    upload->started = 1;
+    pthread_cond_broadcast(&upload->wake);
+    pthread_mutex_unlock(&upload->lock);
+
+    while (1) {
+        pthread_mutex_lock(&upload->lock);
+        while (upload->running && (0 == upload->nr_flights) && !vrms_ring_peek(upload->inbound)) {
+            pthread_cond_wait(&upload->wake, &upload->lock);
+        }
+        if (!upload->running) {
+            pthread_mutex_unlock(&upload->lock);
+            break;
+        }
+        pthread_mutex_unlock(&upload->lock);
+
+        nr_taken = 0;
+        while (upload->nr_flights < VRMS_UPLOAD_MAX_FLIGHTS) {
+            queue_item = vrms_ring_peek(upload->inbound);
+            if (!queue_item) {
+                break;
+            }
+            vrms_upload_item(upload, queue_item);
+            vrms_ring_pop(upload->inbound);
+            nr_taken++;
+        }
+
+        if (!vrms_upload_land(upload) && !nr_taken) {
+            // Waiting on the GPU or on the render thread to take results.
+            usleep(VRMS_UPLOAD_POLL_USEC);
+        }
+    }
+
+    return NULL;
+}
+
+vrms_upload_t* vrms_upload_create(vrms_upload_context_t make_current, void* data) {
+    vrms_upload_t* upload = SAFEMALLOC(sizeof(vrms_upload_t));
+    memset(upload, 0, sizeof(vrms_upload_t));
+
+    upload->make_current = make_current;
+    upload->context_data = data;
+    upload->inbound = vrms_ring_create(VRMS_UPLOAD_QUEUE_SIZE, sizeof(vrms_queue_item_t));
+    upload->results = vrms_ring_create(VRMS_UPLOAD_QUEUE_SIZE, sizeof(vrms_upload_result_t));
+    upload->flights = SAFEMALLOC(sizeof(vrms_upload_flight_t) * VRMS_UPLOAD_MAX_FLIGHTS);
+    pthread_mutex_init(&upload->lock, NULL);
+    pthread_cond_init(&upload->wake, NULL);
+
+    if (0 != pthread_create(&upload->thread, NULL, vrms_upload_thread, upload)) {
+        debug_print("C|DEBUG|upload.c|vrms_upload_create(): unable to start thread\n");
+        upload->started = 1;
+    }
+    else {
+        pthread_mutex_lock(&upload->lock);
+        while (!upload->started) {
+            pthread_cond_wait(&upload->wake, &upload->lock);
+        }
+        pthread_mutex_unlock(&upload->lock);
+        if (!upload->running) {
+            pthread_join(upload->thread, NULL);
+        }
+    }
+
+    if (!upload->running) {
+        debug_print("C|DEBUG|upload.c|vrms_upload_create(): no upload context\n");
+        pthread_cond_destroy(&upload->wake);
+        pthread_mutex_destroy(&upload->lock);
+        vrms_ring_destroy(upload->inbound);
+        vrms_ring_destroy(upload->results);
+        free(upload->flights);
+        free(upload);
+        return NULL;
+    }
+
+    return upload;
+}
+
+void vrms_upload_destroy(vrms_upload_t* upload) {
+    pthread_mutex_lock(&upload->lock);
+    upload->running = 0;
+    pthread_cond_broadcast(&upload->wake);
+    pthread_mutex_unlock(&upload->lock);
+    pthread_join(upload->thread, NULL);
+
+    pthread_cond_destroy(&upload->wake);
+    pthread_mutex_destroy(&upload->lock);
+    vrms_ring_destroy(upload->inbound);
+    vrms_ring_destroy(upload->results);
+    free(upload->flights);
+    free(upload);
+}
+
+uint8_t vrms_upload_push(vrms_upload_t* upload, vrms_queue_item_t* queue_item) {
+    if (!vrms_ring_push(upload->inbound, queue_item)) {
+        return 0;
+    }
+    pthread_mutex_lock(&upload->lock);
+    pthread_cond_signal(&upload->wake);
+    pthread_mutex_unlock(&upload->lock);
+    return 1;
+}
+
+vrms_upload_result_t* vrms_upload_peek_result(vrms_upload_t* upload) {
+    return vrms_ring_peek(upload->results);
+}
+
+void vrms_upload_pop_result(vrms_upload_t* upload) {
+    vrms_ring_pop(upload->results);
+}
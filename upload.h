@@ -0,0 +1,61 @@
+#ifndef VRMS_UPLOAD_H
+#define VRMS_UPLOAD_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "vroom.h"
+
+typedef struct vrms_queue_item vrms_queue_item_t;
+typedef struct vrms_ring vrms_ring_t;
+typedef struct vrms_object_memory vrms_object_memory_t;
+
+// Makes a GL context that shares objects with the render context current on
+// the calling thread. Returns 0 if there is none, in which case uploads stay
+// on the render thread.
+typedef uint8_t (*vrms_upload_context_t)(void* data);
+
+// A finished upload, handed back to the render thread to pass on to its
+// scene. The GPU copy is complete by the time it shows up.
+typedef struct vrms_upload_result {
+    uint32_t scene_id;
+    uint32_t object_id;
+    vrms_object_type_t type;
+    uint32_t gl_id;
+    uint32_t size;
+} vrms_upload_result_t;
+
+typedef struct vrms_upload_flight {
+    vrms_upload_result_t result;
+    vrms_object_memory_t* memory;
+    void* fence;
+} vrms_upload_flight_t;
+
+typedef struct vrms_upload {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    uint8_t running;
+    uint8_t started;
+    vrms_upload_context_t make_current;
+    void* context_data;
+    vrms_ring_t* inbound;
+    vrms_ring_t* results;
+    vrms_upload_flight_t* flights;
+    uint32_t nr_flights;
+} vrms_upload_t;
+
+// Starts the upload thread and makes its context current. Returns NULL if
+// the context could not be made current.
+vrms_upload_t* vrms_upload_create(vrms_upload_context_t make_current, void* data);
+
+void vrms_upload_destroy(vrms_upload_t* upload);
+
+// Hands a data or texture load to the upload thread. Returns 0 if it has no
+// room, the caller keeping the item for later.
+uint8_t vrms_upload_push(vrms_upload_t* upload, vrms_queue_item_t* queue_item);
+
+// Finished uploads in the order they completed, for the render thread.
+vrms_upload_result_t* vrms_upload_peek_result(vrms_upload_t* upload);
+void vrms_upload_pop_result(vrms_upload_t* upload);
+
+#endif
@@ -42,6 +42,8 @@ void fill_interface() {
     client_interface.attach_memory = vroom_client_attach_memory;
     client_interface.run_program = vroom_client_run_program;
     client_interface.set_skybox = vroom_client_set_skybox;
+    client_interface.update_data = vroom_client_update_data;
+    client_interface.update_texture = vroom_client_update_texture;
     client_interface.destroy_scene = vroom_client_destroy_scene;
     //client_interface.destroy_object = vroom_client_destroy_object;
 }
@@ -312,6 +314,52 @@ uint32_t vroom_client_set_skybox(vroom_client_t* client, uint32_t texture_id) {
     return ret;
 }
 
+uint32_t vroom_client_update_data(vroom_client_t* client, uint32_t data_id, uint32_t offset, uint32_t length) {
+    uint32_t ret;
+    UpdateData msg = UPDATE_DATA__INIT;
+    void* buf;
+    uint32_t msg_length;
+
+    msg.scene_id = client->scene_id;
+    msg.data_id = data_id;
+    msg.offset = offset;
+    msg.length = length;
+
+    msg_length = update_data__get_packed_size(&msg);
+
+    buf = SAFEMALLOC(msg_length);
+    update_data__pack(&msg, buf);
+
+    ret = vroom_client_send_message(client, VROOM_UPDATEDATA, buf, msg_length, 0);
+
+    free(buf);
+    return ret;
+}
+
+uint32_t vroom_client_update_texture(vroom_client_t* client, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    uint32_t ret;
+    UpdateTexture msg = UPDATE_TEXTURE__INIT;
+    void* buf;
+    uint32_t length;
+
+    msg.scene_id = client->scene_id;
+    msg.texture_id = texture_id;
+    msg.x = x;
+    msg.y = y;
+    msg.width = width;
+    msg.height = height;
+
+    length = update_texture__get_packed_size(&msg);
+
+    buf = SAFEMALLOC(length);
+    update_texture__pack(&msg, buf);
+
+    ret = vroom_client_send_message(client, VROOM_UPDATETEXTURE, buf, length, 0);
+
+    free(buf);
+    return ret;
+}
+
 int32_t vroom_client_connect_socket(vroom_client_t* client) {
     int socket_name_length;
     struct sockaddr_un remote;
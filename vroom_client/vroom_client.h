@@ -67,7 +67,9 @@ typedef enum vroom_protocol_type {
     VROOM_DESTROYOBJECT,
     VROOM_ATTACHMEMORY,
     VROOM_RUNPROGRAM,
-    VROOM_SETSKYBOX
+    VROOM_SETSKYBOX,
+    VROOM_UPDATEDATA,
+    VROOM_UPDATETEXTURE
 } vroom_protocol_type_t;
 
 typedef enum vroom_protocol_error {
@@ -93,6 +95,8 @@ typedef struct vroom_client_interface {
     uint32_t (*attach_memory)(vroom_client_t* client, uint32_t data_id);
     uint32_t (*run_program)(vroom_client_t* client, uint32_t program_id, uint32_t register_id);
     uint32_t (*set_skybox)(vroom_client_t* client, uint32_t texture_id);
+    uint32_t (*update_data)(vroom_client_t* client, uint32_t data_id, uint32_t offset, uint32_t length);
+    uint32_t (*update_texture)(vroom_client_t* client, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
     uint32_t (*destroy_scene)(vroom_client_t* client);
     uint32_t (*destroy_object)(vroom_client_t* client, uint32_t object_id);
 } vroom_client_interface_t;
@@ -238,6 +242,41 @@ uint32_t vroom_client_run_program(vroom_client_t* client, uint32_t program_id, u
  */
 uint32_t vroom_client_set_skybox(vroom_client_t* client, uint32_t texture_id);
 
+/**
+ * @brief Update part of a data object
+ *
+ * Tells the server that a byte range of a data object has changed in shared
+ * memory. Only that range is uploaded to the GPU again. Ranges that overlap
+ * within a frame are uploaded once.
+ *
+ * @code{.c}
+ * uint32_t ok = vroom_client_update_data(client, data_id, offset, length);
+ * @endcode
+ * @param data_id Object id of the data object
+ * @param offset Offset in bytes from the start of the data object
+ * @param length Number of bytes changed
+ * @return A status
+ */
+uint32_t vroom_client_update_data(vroom_client_t* client, uint32_t data_id, uint32_t offset, uint32_t length);
+
+/**
+ * @brief Update part of a texture
+ *
+ * Tells the server that a rectangle of a 2D texture has changed in the data
+ * object it was created from. Only that rectangle is uploaded again.
+ *
+ * @code{.c}
+ * uint32_t ok = vroom_client_update_texture(client, texture_id, x, y, width, height);
+ * @endcode
+ * @param texture_id Object id of a 2D texture
+ * @param x Left edge of the rectangle in pixels
+ * @param y Top edge of the rectangle in pixels
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ * @return A status
+ */
+uint32_t vroom_client_update_texture(vroom_client_t* client, uint32_t texture_id, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
 /**
  * @brief Destroy an object
  *
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "safemalloc.h"
+#include "workers.h"
+
+#define DEBUG 0
+#define debug_print(fmt, ...) do { if (DEBUG) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+
+#define VRMS_WORKERS_MAX 16
+
+static void vrms_workers_take(vrms_workers_t* workers) {
+    uint32_t index;
+
+    while ((index = __atomic_fetch_add(&workers->next_item, 1, __ATOMIC_RELAXED)) < workers->nr_items) {
+        workers->job(workers->data, index);
+    }
+}
+
+static void* vrms_workers_thread(void* data) {
+    vrms_workers_t* workers = (vrms_workers_t*)data;
+    uint32_t generation = 0;
+
+    pthread_mutex_lock(&workers->lock);
+    while (1) {
+        while (workers->running && (generation == workers->generation)) {
+            pthread_cond_wait(&workers->start, &workers->lock);
+        }
+        if (!workers->running) {
+            break;
+        }
+        generation = workers->generation;
+        pthread_mutex_unlock(&workers->lock);
+
+        vrms_workers_take(workers);
+
+        pthread_mutex_lock(&workers->lock);
+        workers->nr_active--;
+        if (0 == workers->nr_active) {
+            pthread_cond_signal(&workers->done);
+        }
+    }
+    pthread_mutex_unlock(&workers->lock);
+
+    return NULL;
+}
+
+vrms_workers_t* vrms_workers_create(uint32_t nr_threads) {
+    vrms_workers_t* workers = SAFEMALLOC(sizeof(vrms_workers_t));
+    memset(workers, 0, sizeof(vrms_workers_t));
+
+    if (0 == nr_threads) {
+        long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nr_threads = (nr_cpus > 1) ? (uint32_t)(nr_cpus - 1) : 0;
+    }
+    if (nr_threads > VRMS_WORKERS_MAX) {
+        nr_threads = VRMS_WORKERS_MAX;
+    }
+
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->start, NULL);
+    pthread_cond_init(&workers->done, NULL);
+    workers->running = 1;
+
+    if (nr_threads) {
+        workers->threads = SAFEMALLOC(sizeof(pthread_t) * nr_threads);
+    }
+    for (workers->nr_threads = 0; workers->nr_threads < nr_threads; workers->nr_threads++) {
+        if (0 != pthread_create(&workers->threads[workers->nr_threads], NULL, vrms_workers_thread, workers)) {
+            debug_print("C|DEBUG|workers.c|vrms_workers_create(): unable to start worker %d\n", workers->nr_threads);
+            break;
+        }
+    }
+    debug_print("C|DEBUG|workers.c|vrms_workers_create(): started %d workers\n", workers->nr_threads);
+
+    return workers;
+}
+
+void vrms_workers_destroy(vrms_workers_t* workers) {
+    uint32_t i;
+
+    pthread_mutex_lock(&workers->lock);
+    workers->running = 0;
+    pthread_cond_broadcast(&workers->start);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (i = 0; i < workers->nr_threads; i++) {
+        pthread_join(workers->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&workers->done);
+    pthread_cond_destroy(&workers->start);
+    pthread_mutex_destroy(&workers->lock);
+    free(workers->threads);
+    free(workers);
+}
+
+void vrms_workers_run(vrms_workers_t* workers, uint32_t nr_items, vrms_workers_job_t job, void* data) {
+    pthread_mutex_lock(&workers->lock);
+    workers->job = job;
+    workers->data = data;
+    workers->nr_items = nr_items;
+    workers->next_item = 0;
+    workers->nr_active = workers->nr_threads;
+    workers->generation++;
+    pthread_cond_broadcast(&workers->start);
+    pthread_mutex_unlock(&workers->lock);
+
+    vrms_workers_take(workers);
+
+    pthread_mutex_lock(&workers->lock);
+    while (workers->nr_active > 0) {
+        pthread_cond_wait(&workers->done, &workers->lock);
+    }
+    pthread_mutex_unlock(&workers->lock);
+}
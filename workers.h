@@ -0,0 +1,36 @@
+#ifndef VRMS_WORKERS_H
+#define VRMS_WORKERS_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+typedef void (*vrms_workers_job_t)(void* data, uint32_t index);
+
+typedef struct vrms_workers {
+    pthread_t* threads;
+    uint32_t nr_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint32_t generation;
+    uint32_t nr_active;
+    uint8_t running;
+    vrms_workers_job_t job;
+    void* data;
+    uint32_t nr_items;
+    uint32_t next_item;
+} vrms_workers_t;
+
+// Creates a pool of nr_threads worker threads. With nr_threads 0 one is
+// started for each online CPU but the calling thread, which also works on
+// the jobs.
+vrms_workers_t* vrms_workers_create(uint32_t nr_threads);
+
+void vrms_workers_destroy(vrms_workers_t* workers);
+
+// Calls job once for each index below nr_items, spread across the workers
+// and the calling thread, and returns when all have finished. Workers take
+// the next free index as they go, so a slow item does not hold up the rest.
+void vrms_workers_run(vrms_workers_t* workers, uint32_t nr_items, vrms_workers_job_t job, void* data);
+
+#endif